@@ -20,13 +20,24 @@
  *                                                                     *
  ***********************************************************************/
 
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <elf.h>
 
 #include <libfdt.h>
 
 #include "lib_avm_kernel_config.h"
 #include "memory_mapped_file.h"
+#include "elf32_writer.h"
+#include "../include/tool_statistics.h"
+
+#ifndef EF_MIPS_ABI_O32
+#define EF_MIPS_ABI_O32 0x00001000
+#endif
 
 void usage()
 {
@@ -37,13 +48,23 @@ void usage()
 	fprintf(stderr, "\n");
 	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
 	fprintf(stderr, "Usage:\n\n");
-	fprintf(stderr, "avm_kernel_config.bin2asm <binary_config_area_file>\n");
+	fprintf(stderr, "avm_kernel_config.bin2asm [ -e [ -m <mips|arm> ] [ -F <ELF flags> ] ] [ --stats ] <binary_config_area_file>\n");
 	fprintf(stderr, "\nThe configuration area dump is read and an assembler source file");
 	fprintf(stderr, "\nis created from its content. This file may later be compiled into");
 	fprintf(stderr, "\nan object file ready to be included into an own kernel while");
 	fprintf(stderr, "\nlinking it.\n");
+	fprintf(stderr, "\nWith the -e (--elf) option, a relocatable ELF32 object file with the");
+	fprintf(stderr, "\nsame content is written instead, so the assembler run may be skipped.");
+	fprintf(stderr, "\nThe byte order is taken from the dump, the machine defaults to MIPS");
+	fprintf(stderr, "\nfor big endian and ARM for little endian dumps and may be changed");
+	fprintf(stderr, "\nwith -m (--machine=). The ELF header flags default to o32/MIPS32r2");
+	fprintf(stderr, "\n(MIPS) or EABI version 5 (ARM) and may be overwritten with -F");
+	fprintf(stderr, "\n(--elf-flags=) to match the flags of the other kernel objects.\n");
 	fprintf(stderr, "\nThe output is written to STDOUT, so you've to redirect it to the");
 	fprintf(stderr, "\nproper location.\n");
+	fprintf(stderr, "\nThe dump is read from STDIN, if '-' is used as its name.\n");
+	fprintf(stderr, "\nWith --stats (or YF_TOOL_STATS set in the environment), the time needed");
+	fprintf(stderr, "\nfor each phase and some counters are written as a JSON line to STDERR.\n");
 
 }
 
@@ -125,14 +146,10 @@ void derive_avm_kernel_config_tags(
 	}
 }
 
-int processConfigArea(struct _avm_kernel_config * *configArea)
-{
-	struct _avm_kernel_config *moduleMemoryEntry = findEntryByTag(configArea, avm_kernel_config_tags_modulememory);
-	struct _avm_kernel_config *versionInfoEntry  = findEntryByTag(configArea, avm_kernel_config_tags_version_info);
-
-	enum _avm_kernel_config_tags derived_device_tree_subrev_0;
-	enum _avm_kernel_config_tags derived_last;
-	derive_avm_kernel_config_tags(configArea, &derived_device_tree_subrev_0, &derived_last);
+void check_derived_avm_kernel_config_tags(
+	enum _avm_kernel_config_tags derived_device_tree_subrev_0,
+	enum _avm_kernel_config_tags derived_last
+) {
 #if !defined(USE_STRIPPED_AVM_KERNEL_CONFIG_H)
 	if (derived_device_tree_subrev_0 != avm_kernel_config_tags_device_tree_subrev_0)
 	{
@@ -144,7 +161,21 @@ int processConfigArea(struct _avm_kernel_config * *configArea)
 		fprintf(stderr, "derived_last is expected to be equal to avm_kernel_config_tags_last. Check the reasons and adjust the code if necessary.\n");
 		exit(2);
 	}
+#else
+	(void) derived_device_tree_subrev_0;
+	(void) derived_last;
 #endif
+}
+
+int processConfigArea(struct _avm_kernel_config * *configArea)
+{
+	struct _avm_kernel_config *moduleMemoryEntry = findEntryByTag(configArea, avm_kernel_config_tags_modulememory);
+	struct _avm_kernel_config *versionInfoEntry  = findEntryByTag(configArea, avm_kernel_config_tags_version_info);
+
+	enum _avm_kernel_config_tags derived_device_tree_subrev_0;
+	enum _avm_kernel_config_tags derived_last;
+	derive_avm_kernel_config_tags(configArea, &derived_device_tree_subrev_0, &derived_last);
+	check_derived_avm_kernel_config_tags(derived_device_tree_subrev_0, derived_last);
 
 	fprintf(stdout, "#include \"avm_kernel_config_macros.h\"\n\n");
 
@@ -182,32 +213,284 @@ int processConfigArea(struct _avm_kernel_config * *configArea)
 	return 0;
 }
 
+static size_t alignedOffset(size_t offset, size_t alignment)
+{
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static size_t boundedLength(const char *string, size_t maxLength)
+{
+	const char *end = memchr(string, 0, maxLength);
+
+	return (end ? (size_t)(end - string) : maxLength);
+}
+
+int processConfigAreaElf(struct _avm_kernel_config * *configArea, bool bigEndian, uint16_t machine, uint32_t flags)
+{
+	struct _avm_kernel_config *moduleMemoryEntry = findEntryByTag(configArea, avm_kernel_config_tags_modulememory);
+	struct _avm_kernel_config *versionInfoEntry  = findEntryByTag(configArea, avm_kernel_config_tags_version_info);
+
+	enum _avm_kernel_config_tags derived_device_tree_subrev_0;
+	enum _avm_kernel_config_tags derived_last;
+	derive_avm_kernel_config_tags(configArea, &derived_device_tree_subrev_0, &derived_last);
+	check_derived_avm_kernel_config_tags(derived_device_tree_subrev_0, derived_last);
+
+	struct elf32Object object;
+	initElf32Object(&object, bigEndian, machine, flags, (machine == EM_MIPS ? R_MIPS_32 : R_ARM_ABS32));
+
+	// the layout has to be the same as the one created by the assembler from the output of
+	// processConfigArea() with the macros from avm_kernel_config_macros.h, '.align n' means
+	// an alignment to 2^n bytes for MIPS and ARM
+	size_t area = addElf32Section(&object, "configarea", SHF_ALLOC);
+	size_t strings = 0;
+	bool stringsAdded = false;
+
+	size_t entries = 1; // entry with avm_kernel_config_tags_last
+	size_t dtbsSize = 0;
+	for (struct _avm_kernel_config * entry = *configArea; entry->config != NULL; entry++)
+	{
+		if (isDeviceTreeEntry(entry))
+		{
+			entries++;
+			dtbsSize += fdt_totalsize(entry->config);
+		}
+	}
+	if (moduleMemoryEntry)
+		entries++;
+	if (versionInfoEntry)
+		entries++;
+
+	size_t entriesOffset = 16;                                              // AVM_KERNEL_CONFIG_PTR
+	size_t dtbOffset = alignedOffset(entriesOffset + entries * 8, 16);      // AVM_KERNEL_CONFIG_ENTRY with NULL
+	size_t versionInfoOffset = alignedOffset(dtbOffset + dtbsSize, 8);      // AVM_VERSION_INFO
+	size_t moduleMemoryOffset = (versionInfoEntry ? versionInfoOffset + sizeof(struct _avm_kernel_version_info) : dtbOffset + dtbsSize);
+
+	appendElf32Pointer(&object, area, area, entriesOffset);
+	alignElf32Section(&object, area, 16);
+
+	if (moduleMemoryEntry)
+	{
+		appendElf32Word(&object, area, avm_kernel_config_tags_modulememory);
+		appendElf32Pointer(&object, area, area, moduleMemoryOffset);
+	}
+	if (versionInfoEntry)
+	{
+		appendElf32Word(&object, area, avm_kernel_config_tags_version_info);
+		appendElf32Pointer(&object, area, area, versionInfoOffset);
+	}
+	for (struct _avm_kernel_config * entry = *configArea; entry->config != NULL; entry++)
+	{
+		if (isDeviceTreeEntry(entry))
+		{
+			appendElf32Word(&object, area, entry->tag);
+			appendElf32Pointer(&object, area, area, dtbOffset);
+			dtbOffset += fdt_totalsize(entry->config);
+		}
+	}
+	appendElf32Word(&object, area, derived_last);
+	appendElf32Word(&object, area, 0);
+	alignElf32Section(&object, area, 16);
+
+	for (struct _avm_kernel_config * entry = *configArea; entry->config != NULL; entry++)
+	{
+		if (isDeviceTreeEntry(entry))
+		{
+			appendElf32Bytes(&object, area, entry->config, fdt_totalsize(entry->config));
+		}
+	}
+
+	if (versionInfoEntry)
+	{
+		struct _avm_kernel_version_info * version = (struct _avm_kernel_version_info *) versionInfoEntry->config;
+		size_t length;
+
+		alignElf32Section(&object, area, 8);
+		length = boundedLength(version->buildnumber, sizeof(version->buildnumber));
+		appendElf32Bytes(&object, area, version->buildnumber, length);
+		appendElf32Zeros(&object, area, sizeof(version->buildnumber) - length);
+		length = boundedLength(version->svnversion, sizeof(version->svnversion));
+		appendElf32Bytes(&object, area, version->svnversion, length);
+		appendElf32Zeros(&object, area, sizeof(version->svnversion) - length);
+		length = boundedLength(version->firmwarestring, sizeof(version->firmwarestring));
+		appendElf32Bytes(&object, area, version->firmwarestring, length);
+		appendElf32Zeros(&object, area, sizeof(version->firmwarestring) - length);
+	}
+
+	if (moduleMemoryEntry)
+	{
+		struct _kernel_modulmemory_config * module = (struct _kernel_modulmemory_config *) moduleMemoryEntry->config;
+
+		while (module->name != NULL)
+		{
+			if (!stringsAdded)
+			{
+				strings = addElf32Section(&object, "configareastrings", SHF_ALLOC);
+				stringsAdded = true;
+			}
+
+			appendElf32Pointer(&object, area, strings, getElf32SectionSize(&object, strings));
+			appendElf32Word(&object, area, module->size);
+
+			appendElf32Bytes(&object, strings, module->name, strlen(module->name) + 1);
+			alignElf32Section(&object, strings, 4);
+
+			module++;
+		}
+		appendElf32Word(&object, area, 0);
+		appendElf32Word(&object, area, 0);
+	}
+
+	int returnCode = 0;
+	if (!writeElf32Object(&object, 1))
+	{
+		fprintf(stderr, "Error writing ELF object file.\n");
+		returnCode = 1;
+	}
+	freeElf32Object(&object);
+
+	return returnCode;
+}
+
 int main(int argc, char * argv[])
 {
 	int returnCode = 1;
 	struct memoryMappedFile input;
+	bool elfOutput = false;
+	const char *machineName = NULL;
+	const char *flagsString = NULL;
+	bool statistics = false;
+	struct toolStatistics stats;
+	int i = 1;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc)
+	{
+		if ((strcmp(argv[i], "-e") == 0) || (strcmp(argv[i], "--elf") == 0))
+		{
+			elfOutput = true;
+			i += 1;
+		}
+		else if (isToolStatisticsOption(argv[i]))
+		{
+			statistics = true;
+			i += 1;
+		}
+		else if ((strcmp(argv[i], "-m") == 0) || (strcmp(argv[i], "-F") == 0))
+		{
+			if (i + 1 >= argc)
+			{
+				fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+				exit(2);
+			}
+			if (argv[i][1] == 'm')
+				machineName = argv[i + 1];
+			else
+				flagsString = argv[i + 1];
+			i += 2;
+		}
+		else if (strncmp(argv[i], "--machine=", 10) == 0)
+		{
+			machineName = argv[i] + 10;
+			i += 1;
+		}
+		else if (strncmp(argv[i], "--elf-flags=", 12) == 0)
+		{
+			flagsString = argv[i] + 12;
+			i += 1;
+		}
+		else
+		{
+			break;
+		}
+	}
 
-	if (argc < 2)
+	if (argc - i < 1)
 	{
 		usage();
 		exit(1);
 	}
 
-	if (openMemoryMappedFile(&input, argv[1], "input", O_RDONLY | O_SYNC, PROT_WRITE, MAP_PRIVATE))
+	if (machineName != NULL && strcmp(machineName, "mips") != 0 && strcmp(machineName, "arm") != 0)
 	{
-		struct _avm_kernel_config ** configArea = relocateConfigArea(input.fileBuffer, input.fileStat.st_size);
+		fprintf(stderr, "Unsupported machine '%s', use 'mips' or 'arm'.\n", machineName);
+		exit(2);
+	}
+
+	initToolStatistics(&stats, "avm_kernel_config.bin2asm", statistics);
+
+	beginToolPhase(&stats, "mmap");
+	if (openMemoryMappedFile(&input, argv[i], "input", O_RDONLY, PROT_READ, MAP_SHARED, memoryMappedFileWillNeed))
+	{
+		struct avmKernelConfigContext context;
+		enum avmKernelConfigResult result;
+
+		addToolBytes(&stats, input.fileSize);
+		beginToolPhase(&stats, "relocate");
+		initAvmKernelConfigContext(&context);
+		result = loadAvmKernelConfig(&context, input.fileBuffer, input.fileSize);
 
-		if (configArea != NULL)
+		if (result == avmKernelConfigOk)
 		{
-			returnCode = processConfigArea(configArea);
+			struct _avm_kernel_config ** configArea = context.configArea;
+			bool swapNeeded = context.swapNeeded;
+			uint64_t entries = 0;
+			uint64_t deviceTrees = 0;
+
+			for (struct _avm_kernel_config * entry = *configArea; stats.enabled && entry->config != NULL; entry++)
+			{
+				entries++;
+				if (isDeviceTreeEntry(entry))
+					deviceTrees++;
+			}
+			addToolCounter(&stats, "entries", entries);
+			addToolCounter(&stats, "device_trees", deviceTrees);
+			beginToolPhase(&stats, "emit");
+
+			if (elfOutput)
+			{
+				const uint16_t probe = 0x0102;
+				bool hostBigEndian = (*((const uint8_t *) &probe) == 0x01);
+				bool bigEndian = (hostBigEndian != swapNeeded);
+				uint16_t machine = (machineName ? (strcmp(machineName, "mips") == 0 ? EM_MIPS : EM_ARM) : (bigEndian ? EM_MIPS : EM_ARM));
+				uint32_t flags = (machine == EM_MIPS ? EF_MIPS_ARCH_32R2 | EF_MIPS_ABI_O32 : EF_ARM_EABI_VER5);
+
+				if (flagsString != NULL)
+				{
+					char *firstInvalidChar;
+
+					flags = strtoul(flagsString, &firstInvalidChar, 0);
+					if (*flagsString == '\0' || *firstInvalidChar != '\0')
+					{
+						fprintf(stderr, "Missing or invalid numeric value for ELF flags option.\n");
+						exit(2);
+					}
+				}
+
+				if (isatty(1))
+				{
+					fprintf(stderr, "The ELF object will be written to STDOUT, please redirect it to any location.\n");
+					returnCode = 1;
+				}
+				else
+				{
+					returnCode = processConfigAreaElf(configArea, bigEndian, machine, flags);
+				}
+			}
+			else
+			{
+				returnCode = processConfigArea(configArea);
+			}
 		}
 		else
 		{
-			fprintf(stderr, "Unable to identify and relocate the specified config area dump file, may be it's empty.\n");
+			fprintf(stderr, "Unable to identify and relocate the specified config area dump file (%s), may be it's empty.\n", avmKernelConfigResultText(result));
 			returnCode = 1;
 		}
+		freeAvmKernelConfigContext(&context);
 		closeMemoryMappedFile(&input);
 	}
 
+	writeToolStatistics(&stats);
+
 	exit(returnCode);
 }
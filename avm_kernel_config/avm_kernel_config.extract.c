@@ -20,6 +20,8 @@
  *                                                                     *
  ***********************************************************************/
 
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
@@ -29,6 +31,9 @@
 
 #include "lib_avm_kernel_config.h"
 #include "memory_mapped_file.h"
+#include "config_area_hints.h"
+#include "word_pattern_search.h"
+#include "../include/tool_statistics.h"
 
 void usage()
 {
@@ -38,20 +43,35 @@ void usage()
 	fprintf(stderr, "\n");
 	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
 	fprintf(stderr, "Usage:\n\n");
-	fprintf(stderr, "avm_kernel_config.extract [ -s <size in KByte> ] [ -l <kernel load address> ] <unpacked_kernel> [<dtb_file>]\n");
+	fprintf(stderr, "avm_kernel_config.extract [ -s <size in KByte> ] [ -f ] [ -l <kernel load address> ] [ -H <hints_file> [ -n ] ] [ --stats ] <unpacked_kernel> [<dtb_file> ...]\n");
 	fprintf(stderr, "\nThe specified DTB content (a compiled OF device tree BLOB) is");
 	fprintf(stderr, "\nsearched in the unpacked kernel and the place, where it's found");
 	fprintf(stderr, "\nis assumed to be within the original kernel config area.\n");
+	fprintf(stderr, "\nMore than one DTB file may be specified, all of them are searched");
+	fprintf(stderr, "\nwith a single pass over the kernel and the location of each found");
+	fprintf(stderr, "\nDTB is reported on STDERR.\n");
 	fprintf(stderr, "\nIf the DTB file is omitted, the kernel will be searched");
 	fprintf(stderr, "\nfor the FDT signature (0xD00DFEED in BE) and some checks");
 	fprintf(stderr, "\nare performed to guess the correct location.\n");
 	fprintf(stderr, "\nThe output is written to STDOUT, so you've to redirect it to the");
 	fprintf(stderr, "\nproper location.\n");
+	fprintf(stderr, "\nUse '-' as name of the unpacked kernel to read it from STDIN, e.g. with");
+	fprintf(stderr, "\n'zcat kernel.gz | avm_kernel_config.extract - >config_area.bin'.\n");
 	fprintf(stderr, "\nTo support different models with changing sizes of the embedded");
 	fprintf(stderr, "\nconfiguration area, a default size of 64 KB for this area is used,");
-	fprintf(stderr, "\nwhich may be overwritten with the -s option.\n");
+	fprintf(stderr, "\nwhich may be overwritten with the -s option. Only the part of this");
+	fprintf(stderr, "\nwindow, which is really used by the config area (entry array, DTBs,");
+	fprintf(stderr, "\nversion info and module memory), is written to the output. Use the");
+	fprintf(stderr, "\n-f (--fixed-size) option to get the whole window instead.\n");
 	fprintf(stderr, "\nFor kernels loaded at addresses not aligned at 4K boundaries (GRX5 boxes)");
 	fprintf(stderr, "\n-l option must be used to make guessing the config area location possible.\n");
+	fprintf(stderr, "\nIf a hints file is specified with -H (--hints=), the offsets listed there");
+	fprintf(stderr, "\nfor the kernel size, the load address or a version prefix are probed first");
+	fprintf(stderr, "\nand the kernel is only scanned, if none of them matches. Offsets found by");
+	fprintf(stderr, "\na scan are added to the hints file, unless -n (--no-learn) is used. Hints");
+	fprintf(stderr, "\nare not used, if DTB files were specified.\n");
+	fprintf(stderr, "\nWith --stats (or YF_TOOL_STATS set in the environment), the time needed");
+	fprintf(stderr, "\nfor each phase and some counters are written as a JSON line to STDERR.\n");
 }
 
 void * findConfigArea(void *kernelBuffer, void *dtbLocation, uint32_t kernelLoadAddr /* target address space */, size_t size)
@@ -68,110 +88,20 @@ void * findConfigArea(void *kernelBuffer, void *dtbLocation, uint32_t kernelLoad
 	return NULL;
 }
 
-void * findDeviceTreeImage(void *haystack, size_t haystackSize, void *needle, size_t needleSize)
-{
-	void *		location = NULL;
-	size_t		toSearch = haystackSize / sizeof(uint32_t);
-	size_t		offsetMatched = 0;
-	bool		matchedSoFar = false;
-	uint32_t *	resetSliding;
-	size_t		resetToSearch;
-
-	if (toSearch > 0)
-	{
-		uint32_t *	sliding = haystack;
-		uint32_t *	lookFor = needle;
-
-		while (toSearch > 0)
-		{
-			while (*sliding != *lookFor)
-			{
-				toSearch--;
-				sliding++;
-				if (toSearch == 0) break;
-			}
-
-			if (toSearch > 0) // match found for first uint32
-			{
-				matchedSoFar = true;
-				resetToSearch = --toSearch;
-				resetSliding = ++sliding;
-				offsetMatched = sizeof(uint32_t);
-
-				if ((needleSize - offsetMatched) > sizeof(uint32_t))
-				{
-					while (offsetMatched < needleSize)
-					{
-						if (*(lookFor + (offsetMatched / sizeof(uint32_t))) != *sliding) // difference found, reset match
-						{
-							matchedSoFar = false;
-							sliding = resetSliding;
-							toSearch = resetToSearch;
-							break;
-						}
-
-						offsetMatched += sizeof(uint32_t);
-						sliding++;
-						toSearch--;
-
-						if (toSearch == 0) break; // end of kernel reached, DTB isn't expected at the very end
-						if ((needleSize - offsetMatched) < sizeof(uint32_t)) break;
-					}
-				}
-
-				if (matchedSoFar) // compare remaining bytes
-				{
-					uint8_t *	remHaystack = (uint8_t *) sliding;
-					uint8_t *	remNeedle = (uint8_t *)needle + offsetMatched;
-					size_t		remSize = needleSize - offsetMatched;
-
-					while (remSize > 0)
-					{
-						if (*remHaystack != *remNeedle) // difference found
-						{
-							matchedSoFar = false;
-							sliding = resetSliding;
-							toSearch = resetToSearch;
-							break;
-						}
-
-						remHaystack++;
-						remNeedle++;
-						remSize--;
-					}
-
-					if (remSize == 0) // match completed
-					{
-						location = (void *) --resetSliding;
-						break;
-					}
-				}
-			}
-		}
-	}
-
-	return location;
-}
-
-void * locateDeviceTreeSignature(void *kernelBuffer, size_t kernelSize)
-{
-	for (char *ptr = (char *)kernelBuffer; ptr < (char *)kernelBuffer + kernelSize; ptr+=4)
-	{
-		if ((fdt_magic(ptr) == FDT_MAGIC) && (fdt_check_header(ptr) == 0))
-			return ptr;
-	}
-
-	return NULL;
-}
-
 int main(int argc, char * argv[])
 {
 	int						returnCode = 1;
 	struct memoryMappedFile	kernel;
-	struct memoryMappedFile	dtb;
 	void *					dtbLocation = NULL;
 	uint32_t				kernelLoadAddr = 0;
 	ssize_t					size = 64 * 1024;
+	bool					fixedSize = false;
+	const char *			hintsFile = NULL;
+	bool					learnHints = true;
+	struct configAreaHints	hints;
+	void *					configArea = NULL;
+	bool					statistics = false;
+	struct toolStatistics	stats;
 	int						i = 1;
 
 	/* no reason to use a getopt implementation for our simple calling convention */
@@ -183,6 +113,46 @@ int main(int argc, char * argv[])
 		int longL  = (strncmp(argv[i], "--loadaddr=", 11) == 0);
 		char * optParamString = NULL;
 
+		if ((strcmp(argv[i], "-f") == 0) || (strcmp(argv[i], "--fixed-size") == 0))
+		{
+			fixedSize = true;
+			i += 1;
+			continue;
+		}
+
+		if (isToolStatisticsOption(argv[i]))
+		{
+			statistics = true;
+			i += 1;
+			continue;
+		}
+
+		if ((strcmp(argv[i], "-n") == 0) || (strcmp(argv[i], "--no-learn") == 0))
+		{
+			learnHints = false;
+			i += 1;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-H") == 0)
+		{
+			if (i + 1 >= argc)
+			{
+				fprintf(stderr, "Missing file name after option '%s'.\n", argv[i]);
+				exit(2);
+			}
+			hintsFile = argv[i + 1];
+			i += 2;
+			continue;
+		}
+
+		if (strncmp(argv[i], "--hints=", 8) == 0)
+		{
+			hintsFile = argv[i] + 8;
+			i += 1;
+			continue;
+		}
+
 		if (shortS || shortL)
 		{
 			if (i + 1 < argc)
@@ -243,50 +213,166 @@ int main(int argc, char * argv[])
 		}
 	}
 
-	if (!(1 <= (argc - i) && (argc - i) <= 2))
+	if (!(1 <= (argc - i)))
 	{
 		usage();
 		exit(1);
 	}
 
-	if (openMemoryMappedFile(&kernel, argv[i], "unpacked kernel", O_RDONLY | O_SYNC, PROT_READ, MAP_SHARED))
+	initToolStatistics(&stats, "avm_kernel_config.extract", statistics);
+
+	if (hintsFile != NULL && !loadConfigAreaHints(&hints, hintsFile))
+		exit(1);
+
+	beginToolPhase(&stats, "mmap");
+	if (openMemoryMappedFile(&kernel, argv[i], "unpacked kernel", O_RDONLY, PROT_READ, MAP_SHARED, memoryMappedFileSequential | memoryMappedFileWillNeed))
 	{
+		addToolCounter(&stats, "kernel_bytes", kernel.fileSize);
+		addToolBytes(&stats, kernel.fileSize);
+		beginToolPhase(&stats, "scan");
+
 		if (i + 1 < argc)
 		{
-			if (openMemoryMappedFile(&dtb, argv[i + 1], "device tree BLOB", O_RDONLY | O_SYNC, PROT_READ, MAP_SHARED))
+			size_t						dtbCount = argc - i - 1;
+			struct memoryMappedFile *	dtbs = calloc(dtbCount, sizeof(struct memoryMappedFile));
+			struct wordPattern *		patterns = calloc(dtbCount, sizeof(struct wordPattern));
+			size_t						opened = 0;
+			bool						dtbsValid = (dtbs != NULL && patterns != NULL);
+
+			if (!dtbsValid)
+				fprintf(stderr, "Error allocating memory for %u device tree BLOBs.\n", (unsigned int) dtbCount);
+
+			for (; dtbsValid && opened < dtbCount; opened++)
 			{
-				if (fdt_check_header(dtb.fileBuffer) == 0)
+				struct memoryMappedFile * dtb = &dtbs[opened];
+
+				if (!openMemoryMappedFile(dtb, argv[i + 1 + opened], "device tree BLOB", O_RDONLY, PROT_READ, MAP_SHARED, memoryMappedFileWillNeed))
 				{
-					if ((dtbLocation = findDeviceTreeImage(kernel.fileBuffer, kernel.fileStat.st_size, dtb.fileBuffer, dtb.fileStat.st_size)) == NULL)
+					dtbsValid = false;
+					break;
+				}
+
+				if (fdt_check_header(dtb->fileBuffer) != 0)
+				{
+					fprintf(stderr, "The specified device tree BLOB file '%s' seems to be invalid.\n", dtb->fileName);
+					dtbsValid = false;
+				}
+
+				patterns[opened].data = dtb->fileBuffer;
+				patterns[opened].size = dtb->fileSize;
+			}
+
+			if (dtbsValid)
+			{
+				if (findWordPatterns(kernel.fileBuffer, kernel.fileSize, patterns, dtbCount))
+				{
+					void *	inconsistentLocation = NULL;
+
+					// report each DTB and use the first one (in kernel order), which leads to a consistent config area
+					for (size_t d = 0; d < dtbCount; d++)
 					{
-						fprintf(stderr, "The specified device tree BLOB was not found in the kernel image.\n");
+						void *	location = patterns[d].location;
+
+						if (location == NULL)
+						{
+							fprintf(stderr, "Device tree BLOB '%s' was not found in the kernel image.\n", dtbs[d].fileName);
+							continue;
+						}
+
+						fprintf(stderr, "Device tree BLOB '%s' found at offset 0x%08x.\n", dtbs[d].fileName, (unsigned int) ((char *) location - (char *) kernel.fileBuffer));
+
+						addToolCounter(&stats, "dtbs_found", 1);
+
+						if (findConfigArea(kernel.fileBuffer, location, kernelLoadAddr, size) != NULL)
+						{
+							if (dtbLocation == NULL || (char *) location < (char *) dtbLocation)
+								dtbLocation = location;
+						}
+						else
+						{
+							addToolCounter(&stats, "candidates_rejected", 1);
+							if (inconsistentLocation == NULL || (char *) location < (char *) inconsistentLocation)
+								inconsistentLocation = location;
+						}
+					}
+
+					if (dtbLocation == NULL)
+						dtbLocation = inconsistentLocation;
+
+					if (dtbLocation == NULL)
+					{
+						fprintf(stderr, "None of the specified device tree BLOBs was found in the kernel image.\n");
 					}
 				}
 				else
 				{
-					fprintf(stderr, "The specified device tree BLOB file '%s' seems to be invalid.\n", dtb.fileName);
+					fprintf(stderr, "Error allocating memory to search for the device tree BLOBs.\n");
 				}
 			}
-			closeMemoryMappedFile(&dtb);
+
+			addToolCounter(&stats, "dtb_files", opened);
+			for (size_t d = 0; d < opened; d++)
+				closeMemoryMappedFile(&dtbs[d]);
+			free(dtbs);
+			free(patterns);
+		}
+		else if (hintsFile != NULL && (configArea = probeConfigAreaHints(&hints, kernel.fileBuffer, kernel.fileSize, kernelLoadAddr, size)) != NULL)
+		{
+			// found at a hinted offset, no need to scan the kernel
+			addToolCounter(&stats, "hint_hits", 1);
 		}
 		else
 		{
-			if ((dtbLocation = locateDeviceTreeSignature(kernel.fileBuffer, kernel.fileStat.st_size)) == NULL)
+			// each FDT signature in the kernel is tried, until a consistent config area is found
+			size_t rejected = 0;
+			enum avmKernelConfigResult result = locateAvmKernelConfig(kernel.fileBuffer, kernel.fileSize, kernelLoadAddr, size, &configArea, NULL, &rejected);
+
+			addToolCounter(&stats, "candidates_rejected", rejected);
+
+			if (result != avmKernelConfigOk)
+			{
+				fprintf(stderr, "Unable to locate the config area in the specified kernel image (%s).\n", avmKernelConfigResultText(result));
+			}
+			else if (hintsFile != NULL && learnHints)
 			{
-				fprintf(stderr, "Unable to locate the config area in the specified kernel image.\n");
+				size_t remaining = (char *)kernel.fileBuffer + kernel.fileSize - (char *)configArea;
+
+				learnConfigAreaHints(&hints, kernel.fileBuffer, kernel.fileSize, kernelLoadAddr, configArea, ((size_t) size > remaining ? remaining : (size_t) size));
 			}
 		}
 
+		beginToolPhase(&stats, "validate");
 		if (dtbLocation != NULL)
 		{
-			void *configArea = findConfigArea(kernel.fileBuffer, dtbLocation, kernelLoadAddr, size);
+			configArea = findConfigArea(kernel.fileBuffer, dtbLocation, kernelLoadAddr, size);
+		}
 
+		if (dtbLocation != NULL || configArea != NULL)
+		{
 			if (configArea != NULL)
 			{
-				ssize_t written = write(1, configArea, size);
+				ssize_t written;
+				size_t remaining;
+
+				// the window may not exceed the end of the kernel image
+				remaining = (char *)kernel.fileBuffer + kernel.fileSize - (char *)configArea;
+				if ((size_t) size > remaining)
+					size = remaining;
+
+				if (!fixedSize)
+				{
+					size_t extent = determineConfigAreaExtent(configArea, size);
+
+					if (extent > 0)
+						size = extent;
+				}
+
+				beginToolPhase(&stats, "emit");
+				written = write(1, configArea, size);
 
 				if (written == size)
 				{
+					addToolCounter(&stats, "config_bytes", size);
 					returnCode = 0;
 				}
 				else
@@ -302,6 +388,11 @@ int main(int argc, char * argv[])
 		closeMemoryMappedFile(&kernel);
 	}
 
+	if (hintsFile != NULL)
+		freeConfigAreaHints(&hints);
+
+	writeToolStatistics(&stats);
+
 	exit(returnCode);
 }
 
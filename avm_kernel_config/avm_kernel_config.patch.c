@@ -0,0 +1,764 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <libfdt.h>
+
+#include "lib_avm_kernel_config.h"
+#include "memory_mapped_file.h"
+#include "../include/tool_statistics.h"
+
+#define SEGMENT_SIZE				4096
+#define DEVICE_TREE_ALIGNMENT		16
+
+enum patchType
+{
+	patchModuleMemory,
+	patchVersionInfo,
+	patchDeviceTree,
+};
+
+struct patch
+{
+	enum patchType			type;
+	const char *			argument;		// the option value, for messages
+	char *					name;			// module name or version info field
+	uint32_t				value;			// module size or device tree subrevision
+	const char *			string;			// version info value
+	struct memoryMappedFile	dtb;
+	bool					dtbOpened;
+};
+
+//	The config area is patched without relocation, all pointers and sizes
+//	are read and written in the byte order of the target. 'limit' is the
+//	end of the 4K segment containing the last used byte of the area, if all
+//	bytes behind the used extent are zeros - that's the space a device tree
+//	may be moved to, if it doesn't fit into its old location.
+
+struct patchArea
+{
+	char *					area;
+	size_t					windowSize;
+	size_t					extent;
+	size_t					limit;
+	uint32_t				segment;
+	bool					swapNeeded;
+};
+
+void usage()
+{
+	fprintf(stderr, "avm_kernel_config.patch - change the kernel config area of an unpacked kernel in place\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "avm_kernel_config.patch [ -s <size in KByte> ] [ -l <kernel load address> ] [ -n ] [ --stats ] <patch> [ <patch> ... ] <unpacked_kernel>\n");
+	fprintf(stderr, "\nThe config area is located like with avm_kernel_config.extract and the");
+	fprintf(stderr, "\nspecified changes are written to the kernel file in the byte order of the");
+	fprintf(stderr, "\ntarget, without the need to rebuild the kernel. Supported patches are:\n");
+	fprintf(stderr, "\n-m <module>=<size>  (--module=)   set the memory size of a kernel module");
+	fprintf(stderr, "\n-v <field>=<value>  (--version=)  set a field of the version info, the field");
+	fprintf(stderr, "\n                                  is 'buildnumber', 'svnversion' or");
+	fprintf(stderr, "\n                                  'firmwarestring'");
+	fprintf(stderr, "\n-d <subrev>=<file>  (--dtb=)      replace the device tree BLOB for the specified");
+	fprintf(stderr, "\n                                  subrevision with the content of the file\n");
+	fprintf(stderr, "\nOnly existing entries may be changed. A device tree BLOB is written to the");
+	fprintf(stderr, "\nlocation of the old one, if it fits there. Otherwise it's moved behind the");
+	fprintf(stderr, "\nlast used byte of the config area - this is only possible, if the rest of");
+	fprintf(stderr, "\nthe 4K segment contains zeros only, which are assumed to be unused then.\n");
+	fprintf(stderr, "\nAll changes are validated afterwards (the config area has to be consistent");
+	fprintf(stderr, "\nand it has to be found again at the same location). If anything fails, the");
+	fprintf(stderr, "\nkernel file is left unchanged. With -n (--dry-run) the changes are checked");
+	fprintf(stderr, "\nonly and the file isn't written.\n");
+	fprintf(stderr, "\nThe -s and -l options have the same meaning as for avm_kernel_config.extract.\n");
+	fprintf(stderr, "\nWith --stats (or YF_TOOL_STATS set in the environment), the time needed");
+	fprintf(stderr, "\nfor each phase and some counters are written as a JSON line to STDERR.\n");
+}
+
+static uint32_t getTargetWord(struct patchArea *patchArea, void *location)
+{
+	uint32_t value;
+
+	memcpy(&value, location, sizeof(value));
+	return (patchArea->swapNeeded ? __builtin_bswap32(value) : value);
+}
+
+static void putTargetWord(struct patchArea *patchArea, void *location, uint32_t value)
+{
+	if (patchArea->swapNeeded)
+		value = __builtin_bswap32(value);
+	memcpy(location, &value, sizeof(value));
+}
+
+static char * hostPointer(struct patchArea *patchArea, uint32_t targetPointer)
+{
+	return (char *) targetPtr2HostPtr(targetPointer, patchArea->segment, patchArea->area);
+}
+
+static bool isWithinLimit(struct patchArea *patchArea, char *location, size_t size)
+{
+	return (location >= patchArea->area && size <= patchArea->limit && (size_t) (location - patchArea->area) <= patchArea->limit - size);
+}
+
+static uint32_t * entryArray(struct patchArea *patchArea)
+{
+	return (uint32_t *) hostPointer(patchArea, getTargetWord(patchArea, patchArea->area));
+}
+
+bool openPatchArea(struct patchArea *patchArea, char *area, size_t windowSize)
+{
+	memset(patchArea, 0, sizeof(struct patchArea));
+
+	if (!isConsistentConfigArea(area, windowSize, &patchArea->swapNeeded))
+		return false;
+
+	patchArea->area = area;
+	patchArea->windowSize = windowSize;
+	patchArea->segment = determineConfigAreaKernelSegment(getTargetWord(patchArea, area));
+	patchArea->extent = determineConfigAreaExtent(area, windowSize);
+	patchArea->limit = patchArea->extent;
+
+	// the whole window is used, if the extent couldn't be determined - there's no space left then
+	if (patchArea->extent == 0 || patchArea->extent == windowSize)
+	{
+		patchArea->extent = patchArea->limit = windowSize;
+		return true;
+	}
+
+	while (patchArea->limit < windowSize && (patchArea->limit % SEGMENT_SIZE) != 0 && area[patchArea->limit] == 0)
+		patchArea->limit++;
+
+	// non-zero content in the same segment has an unknown meaning
+	if ((patchArea->limit % SEGMENT_SIZE) != 0 && patchArea->limit < windowSize)
+		patchArea->limit = patchArea->extent;
+
+	return true;
+}
+
+static uint32_t * findModule(struct patchArea *patchArea, const char *name)
+{
+	uint32_t *	module = findUnrelocatedEntry(patchArea->area, patchArea->windowSize, avm_kernel_config_tags_modulememory);
+
+	if (module == NULL)
+		return NULL;
+
+	for (; isWithinLimit(patchArea, (char *) module, 2 * sizeof(uint32_t)) && module[0] != 0; module += 2)
+	{
+		char *	moduleName = hostPointer(patchArea, getTargetWord(patchArea, module));
+
+		if (isWithinLimit(patchArea, moduleName, strlen(name) + 1) && strcmp(moduleName, name) == 0)
+			return module;
+	}
+
+	return NULL;
+}
+
+static char * findVersionField(struct patchArea *patchArea, const char *field, size_t *fieldSize)
+{
+	struct _avm_kernel_version_info *	version = findUnrelocatedEntry(patchArea->area, patchArea->windowSize, avm_kernel_config_tags_version_info);
+
+	if (version == NULL)
+		return NULL;
+
+	if (strcmp(field, "buildnumber") == 0)
+	{
+		*fieldSize = sizeof(version->buildnumber);
+		return version->buildnumber;
+	}
+	if (strcmp(field, "svnversion") == 0)
+	{
+		*fieldSize = sizeof(version->svnversion);
+		return version->svnversion;
+	}
+	if (strcmp(field, "firmwarestring") == 0)
+	{
+		*fieldSize = sizeof(version->firmwarestring);
+		return version->firmwarestring;
+	}
+
+	return NULL;
+}
+
+static uint32_t * findDeviceTreeEntry(struct patchArea *patchArea, uint32_t subRevision)
+{
+	uint32_t *	entry;
+	uint32_t	subRevision0 = ~((uint32_t) 0);
+
+#ifdef USE_STRIPPED_AVM_KERNEL_CONFIG_H
+	// smallest tag of a device tree is assumed to be device_tree_subrev_0, like in bin2asm
+	for (entry = entryArray(patchArea); entry[1] != 0; entry += 2)
+	{
+		uint32_t	tag = getTargetWord(patchArea, entry);
+		char *		config = hostPointer(patchArea, getTargetWord(patchArea, entry + 1));
+
+		if (tag < subRevision0 && isWithinLimit(patchArea, config, sizeof(struct fdt_header)) && fdt_magic(config) == FDT_MAGIC)
+			subRevision0 = tag;
+	}
+#else
+	subRevision0 = avm_kernel_config_tags_device_tree_subrev_0;
+#endif
+
+	for (entry = entryArray(patchArea); entry[1] != 0; entry += 2)
+	{
+		if (getTargetWord(patchArea, entry) == subRevision0 + subRevision)
+			return entry;
+	}
+
+	return NULL;
+}
+
+bool applyModulePatch(struct patchArea *patchArea, struct patch *patch)
+{
+	uint32_t *	module = findModule(patchArea, patch->name);
+
+	if (module == NULL)
+	{
+		fprintf(stderr, "There's no module memory entry for '%s' in the config area.\n", patch->name);
+		return false;
+	}
+
+	fprintf(stderr, "Module memory size of '%s' changed from %u to %u.\n", patch->name, getTargetWord(patchArea, module + 1), patch->value);
+	putTargetWord(patchArea, module + 1, patch->value);
+
+	return true;
+}
+
+bool applyVersionPatch(struct patchArea *patchArea, struct patch *patch)
+{
+	size_t		fieldSize;
+	char *		field = findVersionField(patchArea, patch->name, &fieldSize);
+
+	if (field == NULL)
+	{
+		fprintf(stderr, "There's no version info field '%s' in the config area.\n", patch->name);
+		return false;
+	}
+
+	// the field has to keep a terminating zero, it's used as a string by the kernel
+	if (strlen(patch->string) >= fieldSize)
+	{
+		fprintf(stderr, "The value for version info field '%s' is too long, at most %zu characters are possible.\n", patch->name, fieldSize - 1);
+		return false;
+	}
+
+	fprintf(stderr, "Version info field '%s' changed from '%.*s' to '%s'.\n", patch->name, (int) fieldSize, field, patch->string);
+	memset(field, 0, fieldSize);
+	memcpy(field, patch->string, strlen(patch->string));
+
+	return true;
+}
+
+bool applyDeviceTreePatch(struct patchArea *patchArea, struct patch *patch)
+{
+	uint32_t *	entry = findDeviceTreeEntry(patchArea, patch->value);
+	char *		oldLocation;
+	size_t		oldSize;
+	char *		slotEnd;
+	bool		shared = false;
+	size_t		newSize = fdt_totalsize(patch->dtb.fileBuffer);
+	char *		newLocation;
+
+	if (entry == NULL)
+	{
+		fprintf(stderr, "There's no device tree entry for subrevision %u in the config area.\n", patch->value);
+		return false;
+	}
+
+	oldLocation = hostPointer(patchArea, getTargetWord(patchArea, entry + 1));
+	if (!isWithinLimit(patchArea, oldLocation, sizeof(struct fdt_header)) || fdt_magic(oldLocation) != FDT_MAGIC || fdt_check_header(oldLocation) != 0)
+	{
+		fprintf(stderr, "The entry for subrevision %u doesn't point to a valid device tree BLOB.\n", patch->value);
+		return false;
+	}
+	oldSize = fdt_totalsize(oldLocation);
+
+	if (patchArea->extent == patchArea->windowSize)
+	{
+		fprintf(stderr, "The config area contains entries with unknown content, device tree BLOBs can't be replaced.\n");
+		return false;
+	}
+
+	//	- the old location may be reused up to the start of the next object
+	//	  (any other entry or a module name) or, if the device tree is the
+	//	  last object, up to the end of the available space
+	//	- a device tree, which is used by more than one entry, is never
+	//	  overwritten
+
+	slotEnd = patchArea->area + patchArea->extent;
+	for (uint32_t *other = entryArray(patchArea); other[1] != 0; other += 2)
+	{
+		char *	config = hostPointer(patchArea, getTargetWord(patchArea, other + 1));
+
+		if (other != entry && config == oldLocation)
+			shared = true;
+		else if (config > oldLocation && config < slotEnd)
+			slotEnd = config;
+
+		if (getTargetWord(patchArea, other) == avm_kernel_config_tags_modulememory)
+		{
+			for (uint32_t *module = (uint32_t *) config; isWithinLimit(patchArea, (char *) module, 2 * sizeof(uint32_t)) && module[0] != 0; module += 2)
+			{
+				char *	name = hostPointer(patchArea, getTargetWord(patchArea, module));
+
+				if (name > oldLocation && name < slotEnd)
+					slotEnd = name;
+			}
+		}
+	}
+	if (slotEnd == patchArea->area + patchArea->extent)
+		slotEnd = patchArea->area + patchArea->limit;
+
+	if (!shared && newSize <= (size_t) (slotEnd - oldLocation))
+	{
+		memcpy(oldLocation, patch->dtb.fileBuffer, newSize);
+		if (oldSize > newSize)
+			memset(oldLocation + newSize, 0, oldSize - newSize);
+
+		fprintf(stderr, "Device tree BLOB for subrevision %u replaced in place (%zu bytes, %zu bytes before).\n", patch->value, newSize, oldSize);
+	}
+	else
+	{
+		newLocation = patchArea->area + ((patchArea->extent + DEVICE_TREE_ALIGNMENT - 1) & ~(DEVICE_TREE_ALIGNMENT - 1));
+		if (!isWithinLimit(patchArea, newLocation, newSize))
+		{
+			fprintf(stderr, "The device tree BLOB '%s' (%zu bytes) doesn't fit into the config area, only %zu bytes are available.\n", patch->dtb.fileName, newSize,
+					(shared ? (size_t) 0 : (size_t) (slotEnd - oldLocation)) + (patchArea->limit - patchArea->extent));
+			return false;
+		}
+
+		memcpy(newLocation, patch->dtb.fileBuffer, newSize);
+		putTargetWord(patchArea, entry + 1, patchArea->segment + (uint32_t) (newLocation - patchArea->area));
+		if (!shared)
+			memset(oldLocation, 0, oldSize);
+
+		fprintf(stderr, "Device tree BLOB for subrevision %u moved from offset 0x%04x to 0x%04x (%zu bytes, %zu bytes before).\n", patch->value,
+				(unsigned int) (oldLocation - patchArea->area), (unsigned int) (newLocation - patchArea->area), newSize, oldSize);
+	}
+
+	// the used extent may have changed
+	patchArea->extent = determineConfigAreaExtent(patchArea->area, patchArea->windowSize);
+	if (patchArea->extent == 0 || patchArea->extent > patchArea->limit)
+	{
+		fprintf(stderr, "The config area is inconsistent after replacing the device tree BLOB for subrevision %u.\n", patch->value);
+		return false;
+	}
+
+	return true;
+}
+
+bool isPatchApplied(struct patchArea *patchArea, struct patch *patch)
+{
+	switch (patch->type)
+	{
+		case patchModuleMemory:
+		{
+			uint32_t *	module = findModule(patchArea, patch->name);
+
+			return (module != NULL && getTargetWord(patchArea, module + 1) == patch->value);
+		}
+
+		case patchVersionInfo:
+		{
+			size_t		fieldSize;
+			char *		field = findVersionField(patchArea, patch->name, &fieldSize);
+
+			return (field != NULL && strncmp(field, patch->string, fieldSize) == 0);
+		}
+
+		case patchDeviceTree:
+		{
+			uint32_t *	entry = findDeviceTreeEntry(patchArea, patch->value);
+			char *		config;
+			size_t		size = fdt_totalsize(patch->dtb.fileBuffer);
+
+			if (entry == NULL)
+				return false;
+			config = hostPointer(patchArea, getTargetWord(patchArea, entry + 1));
+			return (isWithinLimit(patchArea, config, size) && fdt_check_header(config) == 0 && memcmp(config, patch->dtb.fileBuffer, size) == 0);
+		}
+	}
+
+	return false;
+}
+
+bool validatePatchedArea(struct patchArea *patchArea, struct patch *patches, size_t patchCount, struct memoryMappedFile *kernel, uint32_t kernelLoadAddr)
+{
+	void *		configArea = NULL;
+	size_t		extent;
+
+	//	- the area has to be consistent and each device tree has to be valid
+	//	- it has to be found at the same location again, a moved device tree
+	//	  may not confuse the search
+	//	- each patch has to be visible (a later one may have overwritten an
+	//	  earlier change for the same entry, that's an error, too)
+
+	if (!isConsistentConfigArea(patchArea->area, patchArea->windowSize, NULL) || (extent = determineConfigAreaExtent(patchArea->area, patchArea->windowSize)) == 0)
+	{
+		fprintf(stderr, "The config area is inconsistent after patching.\n");
+		return false;
+	}
+
+	for (uint32_t *entry = entryArray(patchArea); entry[1] != 0; entry += 2)
+	{
+		char *	config = hostPointer(patchArea, getTargetWord(patchArea, entry + 1));
+
+		if (isWithinLimit(patchArea, config, sizeof(struct fdt_header)) && fdt_magic(config) == FDT_MAGIC && fdt_check_header(config) != 0)
+		{
+			fprintf(stderr, "The device tree BLOB at offset 0x%04x of the config area is invalid after patching.\n", (unsigned int) (config - patchArea->area));
+			return false;
+		}
+	}
+
+	if (locateAvmKernelConfig(kernel->fileBuffer, kernel->fileSize, kernelLoadAddr, patchArea->windowSize, &configArea, NULL, NULL) != avmKernelConfigOk || configArea != patchArea->area)
+	{
+		fprintf(stderr, "The config area isn't found at the same location after patching.\n");
+		return false;
+	}
+
+	for (size_t i = 0; i < patchCount; i++)
+	{
+		if (!isPatchApplied(patchArea, &patches[i]))
+		{
+			fprintf(stderr, "The patch '%s' isn't visible in the config area after patching.\n", patches[i].argument);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool parsePatch(struct patch *patch, enum patchType type, const char *argument)
+{
+	const char *	equalSign = strchr(argument, '=');
+	char *					firstInvalidChar;
+	unsigned long long		number;
+
+	memset(patch, 0, sizeof(struct patch));
+	patch->type = type;
+	patch->argument = argument;
+
+	if (equalSign == NULL || equalSign == argument)
+	{
+		fprintf(stderr, "Invalid patch '%s', expected is '<name>=<value>'.\n", argument);
+		return false;
+	}
+
+	if ((patch->name = strndup(argument, equalSign - argument)) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for patch '%s'.\n", argument);
+		return false;
+	}
+	patch->string = equalSign + 1;
+
+	if (type == patchVersionInfo)
+		return true;
+
+	if (type == patchDeviceTree)
+	{
+		number = strtoull(patch->name, &firstInvalidChar, 10);
+		if (*firstInvalidChar != '\0' || number > 255)
+		{
+			fprintf(stderr, "Invalid device tree subrevision '%s', expected is a number from 0 to 255.\n", patch->name);
+			return false;
+		}
+		patch->value = (uint32_t) number;
+
+		if (!openMemoryMappedFile(&patch->dtb, patch->string, "device tree BLOB", O_RDONLY, PROT_READ, MAP_SHARED, memoryMappedFileWillNeed))
+			return false;
+		patch->dtbOpened = true;
+
+		if (patch->dtb.fileSize < sizeof(struct fdt_header) || fdt_check_header(patch->dtb.fileBuffer) != 0 || fdt_totalsize(patch->dtb.fileBuffer) > patch->dtb.fileSize)
+		{
+			fprintf(stderr, "The specified device tree BLOB file '%s' seems to be invalid.\n", patch->dtb.fileName);
+			return false;
+		}
+
+		return true;
+	}
+
+	number = strtoull(patch->string, &firstInvalidChar, 0);
+	if (*patch->string == '\0' || *firstInvalidChar != '\0' || number > 0xFFFFFFFF)
+	{
+		fprintf(stderr, "Missing or invalid numeric value for module '%s'.\n", patch->name);
+		return false;
+	}
+	patch->value = (uint32_t) number;
+
+	return true;
+}
+
+bool writeConfigArea(struct memoryMappedFile *kernel, void *configArea, size_t size)
+{
+	off_t		offset = (off_t) ((char *) configArea - (char *) kernel->fileBuffer);
+	char *		data = configArea;
+
+	//	The kernel is mapped privately, the patched area is written to the
+	//	file at the same offset, after all changes were validated.
+
+	while (size > 0)
+	{
+		ssize_t	written = pwrite(kernel->fileDescriptor, data, size, offset);
+
+		if (written == -1 && errno == EINTR)
+			continue;
+
+		if (written <= 0)
+		{
+			fprintf(stderr, "Error %d writing the changed config area to the kernel file.\n", (written == -1 ? errno : EIO));
+			return false;
+		}
+
+		data += written;
+		offset += written;
+		size -= written;
+	}
+
+	if (fsync(kernel->fileDescriptor) == -1)
+	{
+		fprintf(stderr, "Error %d writing the changed config area to the kernel file.\n", errno);
+		return false;
+	}
+
+	return true;
+}
+
+void freePatches(struct patch *patches, size_t patchCount)
+{
+	for (size_t i = 0; i < patchCount; i++)
+	{
+		if (patches[i].dtbOpened)
+			closeMemoryMappedFile(&patches[i].dtb);
+		free(patches[i].name);
+	}
+	free(patches);
+}
+
+int main(int argc, char * argv[])
+{
+	int						returnCode = 1;
+	struct memoryMappedFile	kernel;
+	uint32_t				kernelLoadAddr = 0;
+	size_t					size = 64 * 1024;
+	bool					dryRun = false;
+	struct patch *			patches;
+	size_t					patchCount = 0;
+	bool					patchesValid = true;
+	bool					statistics = false;
+	struct toolStatistics	stats;
+	int						i = 1;
+
+	if ((patches = calloc(argc, sizeof(struct patch))) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for %d patches.\n", argc);
+		exit(1);
+	}
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc - 1)
+	{
+		const char *	optParamString = NULL;
+		int				optionType = -1;
+
+		if ((strcmp(argv[i], "-n") == 0) || (strcmp(argv[i], "--dry-run") == 0))
+		{
+			dryRun = true;
+			i += 1;
+			continue;
+		}
+
+		if (isToolStatisticsOption(argv[i]))
+		{
+			statistics = true;
+			i += 1;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "-d") == 0)
+		{
+			if (i + 2 >= argc)
+			{
+				fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+				exit(2);
+			}
+			optionType = argv[i][1];
+			optParamString = argv[i + 1];
+			i += 2;
+		}
+		else if (strncmp(argv[i], "--size=", 7) == 0 || strncmp(argv[i], "--loadaddr=", 11) == 0 || strncmp(argv[i], "--module=", 9) == 0 ||
+				 strncmp(argv[i], "--version=", 10) == 0 || strncmp(argv[i], "--dtb=", 6) == 0)
+		{
+			optionType = argv[i][2];
+			optParamString = strchr(argv[i], '=') + 1;
+			i += 1;
+		}
+		else
+		{
+			break;
+		}
+
+		if (optionType == 's')
+		{
+			int				newSize = atoi(optParamString);
+
+			if (newSize < 16 || newSize > 1024 || (newSize & 0x0F) > 0)
+			{
+				fprintf(stderr, "Size value should be a multiple of 16 between 16 and 1024.\n");
+				exit(2);
+			}
+			size = newSize * 1024;
+		}
+		else if (optionType == 'l')
+		{
+			char *firstInvalidChar;
+
+			kernelLoadAddr = strtoul(optParamString, &firstInvalidChar, 0);
+			if (*optParamString=='\0' || *firstInvalidChar != '\0')
+			{
+				fprintf(stderr, "Missing or invalid numeric value for loadaddr option. Load address is expected to be a 32-bit hexadecimal or decimal value.\n");
+				exit(2);
+			}
+		}
+		else
+		{
+			enum patchType	type = (optionType == 'm' ? patchModuleMemory : (optionType == 'v' ? patchVersionInfo : patchDeviceTree));
+
+			if (!parsePatch(&patches[patchCount++], type, optParamString))
+			{
+				patchesValid = false;
+				break;
+			}
+		}
+	}
+
+	if (!patchesValid)
+	{
+		freePatches(patches, patchCount);
+		exit(2);
+	}
+
+	if (i != argc - 1 || patchCount == 0)
+	{
+		usage();
+		freePatches(patches, patchCount);
+		exit(1);
+	}
+
+	initToolStatistics(&stats, "avm_kernel_config.patch", statistics);
+
+	// the patches are applied to a private mapping, only a validated config
+	// area is written back to the file - a failed patch or validation can't
+	// leave a partially patched kernel behind
+	beginToolPhase(&stats, "mmap");
+	if (openMemoryMappedFile(&kernel, argv[i], "unpacked kernel", (dryRun ? O_RDONLY : O_RDWR), PROT_READ | PROT_WRITE, MAP_PRIVATE, memoryMappedFileNoHints))
+	{
+		void *						configArea = NULL;
+		enum avmKernelConfigResult	result;
+
+		addToolCounter(&stats, "kernel_bytes", kernel.fileSize);
+		addToolBytes(&stats, kernel.fileSize);
+
+		beginToolPhase(&stats, "scan");
+		if (!dryRun && !S_ISREG(kernel.fileStat.st_mode))
+		{
+			fprintf(stderr, "The unpacked kernel file '%s' can't be changed, because it's not a regular file.\n", kernel.fileName);
+		}
+		else if ((result = locateAvmKernelConfig(kernel.fileBuffer, kernel.fileSize, kernelLoadAddr, size, &configArea, NULL, NULL)) != avmKernelConfigOk)
+		{
+			fprintf(stderr, "Unable to locate the config area in the specified kernel image (%s).\n", avmKernelConfigResultText(result));
+		}
+		else
+		{
+			struct patchArea	patchArea;
+			size_t				remaining = (char *) kernel.fileBuffer + kernel.fileSize - (char *) configArea;
+
+			if (size > remaining)
+				size = remaining;
+
+			beginToolPhase(&stats, "patch");
+			if (!openPatchArea(&patchArea, configArea, size))
+			{
+				fprintf(stderr, "Unexpected config area content found, patching aborted.\n");
+			}
+			else
+			{
+				bool	success = true;
+
+				fprintf(stderr, "Config area found at offset 0x%08x, %zu bytes used, %zu bytes available.\n", (unsigned int) ((char *) configArea - (char *) kernel.fileBuffer),
+						patchArea.extent, patchArea.limit);
+
+				for (size_t p = 0; success && p < patchCount; p++)
+				{
+					switch (patches[p].type)
+					{
+						case patchModuleMemory:
+							success = applyModulePatch(&patchArea, &patches[p]);
+							break;
+
+						case patchVersionInfo:
+							success = applyVersionPatch(&patchArea, &patches[p]);
+							break;
+
+						case patchDeviceTree:
+							success = applyDeviceTreePatch(&patchArea, &patches[p]);
+							break;
+					}
+					if (success)
+						addToolCounter(&stats, "patches", 1);
+				}
+
+				beginToolPhase(&stats, "validate");
+				if (success && validatePatchedArea(&patchArea, patches, patchCount, &kernel, kernelLoadAddr))
+				{
+					if (dryRun)
+					{
+						fprintf(stderr, "All changes are valid, the kernel file wasn't changed (dry run).\n");
+						returnCode = 0;
+					}
+					else
+					{
+						beginToolPhase(&stats, "write");
+						if (writeConfigArea(&kernel, configArea, patchArea.limit))
+							returnCode = 0;
+					}
+				}
+				else
+				{
+					fprintf(stderr, "Patching failed, the kernel file is left unchanged.\n");
+				}
+			}
+		}
+		closeMemoryMappedFile(&kernel);
+	}
+
+	freePatches(patches, patchCount);
+
+	writeToolStatistics(&stats);
+
+	exit(returnCode);
+}
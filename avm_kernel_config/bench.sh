@@ -0,0 +1,192 @@
+#! /bin/sh
+#######################################################################################################
+#                                                                                                     #
+# measure the native tools on a synthetic corpus of firmware artifacts                                #
+#                                                                                                     #
+# - the corpus is created with 'bench_corpus', the file 'corpus.list' in the corpus directory lists   #
+#   the files and the values needed to verify the results                                             #
+# - each tool is called for each matching file of the corpus (as often as specified with -n) and the  #
+#   results are verified, a wrong result is reported and leads to an exit code of 1                   #
+#                                                                                                     #
+#######################################################################################################
+#                                                                                                     #
+# Copyright (C) 2026 YourFritz contributors                                                           #
+#                                                                                                     #
+# This program is free software; you can redistribute it and/or modify it under the terms of the GNU  #
+# General Public License as published by the Free Software Foundation; either version 2 of the        #
+# License, or (at your option) any later version.                                                     #
+#                                                                                                     #
+# This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without   #
+# even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU      #
+# General Public License under http://www.gnu.org/licenses/gpl-2.0.html for more details.             #
+#                                                                                                     #
+#######################################################################################################
+#                                                                                                     #
+# Usage: bench.sh [ -n <runs> ] <corpus_directory>                                                    #
+#                                                                                                     #
+# The tools are expected in the same directory as this script (extract and bin2asm) and in its        #
+# 'benchmark' subdirectory (crc32 and rle_decode), other locations may be set with the environment    #
+# variables EXTRACT, BIN2ASM, CRC32 and RLE_DECODE.                                                   #
+#                                                                                                     #
+# For each tool, one line with the following values is written to STDOUT:                             #
+#                                                                                                     #
+# - number of calls and processed data (MByte), kernel and config area sizes for extract and bin2asm, #
+#   file size for crc32 and decoded size for rle_decode                                               #
+# - throughput from wall clock time (including process startup) and from the time measured by the     #
+#   tool itself (the 'total_us' value of its '--stats' output)                                        #
+# - percentiles (50, 90, 99) and maximum of the wall clock time for a single call in milliseconds     #
+#                                                                                                     #
+# The wall clock time is read with 'date +%s%N', so GNU coreutils (or a compatible BusyBox) is needed.#
+#                                                                                                     #
+#######################################################################################################
+#                                                                                                     #
+# constants                                                                                           #
+#                                                                                                     #
+#######################################################################################################
+dir="${0%/*}"
+EXTRACT="${EXTRACT:-$dir/avm_kernel_config.extract}"
+BIN2ASM="${BIN2ASM:-$dir/avm_kernel_config.bin2asm}"
+CRC32="${CRC32:-$dir/benchmark/crc32}"
+RLE_DECODE="${RLE_DECODE:-$dir/benchmark/rle_decode}"
+tools="extract bin2asm crc32 rle_decode rle_decode_stream"
+#######################################################################################################
+#                                                                                                     #
+# subfunctions                                                                                        #
+#                                                                                                     #
+#######################################################################################################
+usage()
+{
+	printf "Usage: %s [ -n <runs> ] <corpus_directory>\n" "${0##*/}" 1>&2
+	exit 2
+}
+fail()
+{
+	printf "%s\n" "$*" 1>&2
+	failed=1
+}
+#######################################################################################################
+#                                                                                                     #
+# call a function and append the processed bytes, the wall clock time and the time reported by the    #
+# tool (both in microseconds) to the samples file for the specified tool                              #
+#                                                                                                     #
+# $1 - tool name                                                                                      #
+# $2 - number of bytes processed                                                                      #
+# $3 - function to call, all other arguments are passed to this function                              #
+#                                                                                                     #
+#######################################################################################################
+measure()
+{
+	name="$1"
+	bytes="$2"
+	shift 2
+	start=$(date +%s%N)
+	"$@" 2>"$tmp/stderr"
+	rc=$?
+	end=$(date +%s%N)
+	used=$(sed -n -e 's/^{"tool":"[^"]*","total_us":\([0-9]*\),.*$/\1/p' "$tmp/stderr" | tail -n 1)
+	printf "%s %s %s\n" "$bytes" $(( ( end - start ) / 1000 )) "${used:-0}" >>"$tmp/$name.samples"
+	[ $rc -ne 0 ] && fail "$name failed with exit code $rc for '$file':" && cat "$tmp/stderr" 1>&2
+	return $rc
+}
+run_extract()
+{
+	"$EXTRACT" -l "$1" "$2" >"$tmp/output"
+}
+run_bin2asm()
+{
+	"$BIN2ASM" "$1" >/dev/null
+}
+run_crc32()
+{
+	"$CRC32" <"$1" >"$tmp/output"
+}
+run_rle_decode()
+{
+	"$RLE_DECODE" "$1" "$tmp/output"
+}
+run_rle_decode_stream()
+{
+	"$RLE_DECODE" <"$1" >"$tmp/output"
+}
+check_crc()
+{
+	[ "$(YF_TOOL_STATS=0 "$CRC32" <"$tmp/output")" = "$2" ] || fail "$1 created unexpected content from '$file'"
+}
+#######################################################################################################
+#                                                                                                     #
+# check parameters                                                                                    #
+#                                                                                                     #
+#######################################################################################################
+runs=3
+if [ "$1" = "-n" ]; then
+	[ -z "$2" ] && usage
+	runs="$2"
+	shift 2
+fi
+[ $# -ne 1 ] && usage
+corpus="$1"
+if ! [ -f "$corpus/corpus.list" ]; then
+	printf "Missing file 'corpus.list' in directory '%s', use 'bench_corpus' to create it.\n" "$corpus" 1>&2
+	exit 1
+fi
+for tool in "$EXTRACT" "$BIN2ASM" "$CRC32" "$RLE_DECODE"; do
+	if ! [ -x "$tool" ]; then
+		printf "Missing executable file '%s'.\n" "$tool" 1>&2
+		exit 1
+	fi
+done
+#######################################################################################################
+#                                                                                                     #
+# call the tools for each file from the corpus                                                        #
+#                                                                                                     #
+#######################################################################################################
+tmp="$(mktemp -d)"
+trap 'rm -r "$tmp" 2>/dev/null' EXIT
+export YF_TOOL_STATS=1
+failed=0
+run=0
+while [ $run -lt $runs ]; do
+	while read type file arg1 arg2 arg3 arg4 arg5; do
+		case "$type" in
+			(kernel)
+				# arg1 = config area, arg2 = load address, arg5 = size
+				if measure extract $arg5 run_extract $arg2 "$corpus/$file"; then
+					cmp -s "$tmp/output" "$corpus/$arg1" || fail "extract found an unexpected config area in '$file'"
+				fi
+				measure bin2asm $(wc -c <"$corpus/$arg1") run_bin2asm "$corpus/$arg1"
+				;;
+			(tffs|export)
+				# arg1 = size, arg2 = CRC32
+				if measure crc32 $arg1 run_crc32 "$corpus/$file"; then
+					[ "$(cat "$tmp/output")" = "$arg2" ] || fail "crc32 computed an unexpected value for '$file'"
+				fi
+				;;
+			(rle)
+				# arg1 = decoded size, arg2 = CRC32 of decoded content
+				measure rle_decode $arg1 run_rle_decode "$corpus/$file" && check_crc rle_decode $arg2
+				measure rle_decode_stream $arg1 run_rle_decode_stream "$corpus/$file" && check_crc rle_decode_stream $arg2
+				;;
+		esac
+	done <"$corpus/corpus.list"
+	run=$(( run + 1 ))
+done
+#######################################################################################################
+#                                                                                                     #
+# summary                                                                                             #
+#                                                                                                     #
+#######################################################################################################
+printf "%-18s %6s %10s %11s %11s %9s %9s %9s %9s\n" "tool" "calls" "MByte" "MB/s(wall)" "MB/s(tool)" "p50 ms" "p90 ms" "p99 ms" "max ms"
+for tool in $tools; do
+	[ -f "$tmp/$tool.samples" ] || continue
+	sort -n -k 2 "$tmp/$tool.samples" | awk -v tool="$tool" '
+		function percentile(p,    i) { i = int((p * NR + 99) / 100); if (i < 1) i = 1; return latency[i] / 1000; }
+		function throughput(us) { return (us > 0 ? (bytes / 1048576) / (us / 1000000) : 0); }
+		{ bytes += $1; wall += $2; used += $3; latency[NR] = $2; }
+		END { printf "%-18s %6u %10.1f %11.1f %11.1f %9.2f %9.2f %9.2f %9.2f\n", tool, NR, bytes / 1048576, throughput(wall), throughput(used), percentile(50), percentile(90), percentile(99), latency[NR] / 1000; }'
+done
+exit $failed
+#######################################################################################################
+#                                                                                                     #
+# end of script                                                                                       #
+#                                                                                                     #
+#######################################################################################################
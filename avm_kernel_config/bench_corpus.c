@@ -0,0 +1,924 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "lib_avm_kernel_config.h"
+
+//	Generator for a synthetic corpus of firmware artifacts, which is used
+//	by 'bench.sh' to measure the native tools. All files are derived from
+//	a pseudo-random sequence with a fixed seed, so the same options create
+//	the same corpus again. The file 'corpus.list' in the output directory
+//	describes each file with the values needed to check the results:
+//
+//	kernel <file> <config area file> <load address> <big|little> <DTB count> <size>
+//	tffs <file> <size> <CRC32>
+//	rle <file> <decoded size> <CRC32 of decoded content>
+//	export <file> <size> <CRC32>
+//
+//	The kernels are random data with an embedded config area (entry array,
+//	1 to 30 DTBs, version info and module memory) in the byte order of the
+//	target and some DTBs without a config area in front as decoys. Every
+//	second pair of kernels uses an unaligned (GRX5 style) load address, the
+//	expected config area is written to a separate file. TFFS dumps contain
+//	environment values, counters and (stored) deflated files, including
+//	outdated node versions, export files contain text and binary parts with
+//	a valid checksum and recovery images use AVM's run-length encoding.
+
+#if defined(USE_STRIPPED_AVM_KERNEL_CONFIG_H)
+// the stripped header has no device tree tags, the values from 7580.06.53 are used
+#define DEVICE_TREE_TAG(subrev)		(avm_kernel_config_tags_cache_config + 1 + (subrev))
+#define LAST_TAG					(avm_kernel_config_tags_cache_config + 1 + 257)
+#else
+#define DEVICE_TREE_TAG(subrev)		(avm_kernel_config_tags_device_tree_subrev_0 + (subrev))
+#define LAST_TAG					(avm_kernel_config_tags_last)
+#endif
+
+#define CORPUS_LIST					"corpus.list"
+#define CONFIG_AREA_WINDOW			(64 * 1024)
+#define MAX_DEVICE_TREES			30
+#define VERSION_INFO_SIZE			(32 + 32 + 128)
+#define TFFS_FILL_PERCENT			75
+#define ALIGN4(value)				(((value) + 3) & ~3)
+
+struct corpusOptions
+{
+	unsigned int			kernels;
+	unsigned int			kernelSize;		// in KByte
+	unsigned int			tffsDumps;
+	unsigned int			tffsSize;
+	unsigned int			recoveryImages;
+	unsigned int			recoverySize;
+	unsigned int			exports;
+	unsigned int			exportSize;
+	uint64_t				seed;
+	const char *			directory;
+};
+
+static uint64_t				randomState;
+static uint32_t				crcTable[256];
+
+static const char *			settingNames[] = { "enabled", "mode", "name", "hostname", "ipaddr", "netmask", "dhcpc_use_static_dns", "mtu", "username", "passwd", "interval", "timeout", "port", "provider", "lease_time" };
+static const char *			moduleNames[] = { "kdsldmod", "avm_power", "ubik2", "isdn_fbox_fon5", "rpc_avm", "Piglet_noemif", "led_module", "tffs", "avm_dect", "capi_codec" };
+static const char *			configFileNames[] = { "ar7.cfg", "wlan.cfg", "voip.cfg", "tr069.cfg", "user.cfg", "vpn.cfg", "usb.cfg", "fx_conf" };
+
+void usage(void)
+{
+	fprintf(stderr, "bench_corpus - create a synthetic corpus of firmware artifacts for benchmarks\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "bench_corpus [ -k <kernels> ] [ -K <kernel size in KByte> ] [ -t <TFFS dumps> ] [ -T <TFFS size in KByte> ]\n");
+	fprintf(stderr, "             [ -r <recovery images> ] [ -R <decoded size in KByte> ] [ -e <exports> ] [ -E <export size in KByte> ]\n");
+	fprintf(stderr, "             [ -S <seed> ] <output_directory>\n");
+	fprintf(stderr, "\nThe files are created in the specified directory (it's created, if it");
+	fprintf(stderr, "\ndoesn't exist) and listed in the file '" CORPUS_LIST "' there, together");
+	fprintf(stderr, "\nwith the values needed to verify the results of the measured tools.\n");
+	fprintf(stderr, "\nThe default is a corpus of 8 kernels with 4096 KByte, 4 TFFS dumps with");
+	fprintf(stderr, "\n256 KByte, 2 recovery images with 32768 KByte (decoded) and 8 export");
+	fprintf(stderr, "\nfiles with 256 KByte each. A count of 0 skips the file type.\n");
+}
+
+static uint64_t nextRandom(void)
+{
+	// xorshift64*, good enough for synthetic content
+	randomState ^= randomState >> 12;
+	randomState ^= randomState << 25;
+	randomState ^= randomState >> 27;
+	return randomState * 0x2545F4914F6CDD1DULL;
+}
+
+static uint32_t randomBetween(uint32_t low, uint32_t high)
+{
+	return low + (uint32_t) (nextRandom() % ((uint64_t) high - low + 1));
+}
+
+static void fillRandom(unsigned char *buffer, size_t size)
+{
+	while (size >= sizeof(uint64_t))
+	{
+		uint64_t	value = nextRandom();
+
+		memcpy(buffer, &value, sizeof(value));
+		buffer += sizeof(value);
+		size -= sizeof(value);
+	}
+
+	while (size-- > 0)
+		*buffer++ = (unsigned char) nextRandom();
+}
+
+static void initCrcTable(void)
+{
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t	value = i;
+
+		for (int j = 0; j < 8; j++)
+			value = (value & 1 ? (value >> 1) ^ 0xEDB88320 : value >> 1);
+		crcTable[i] = value;
+	}
+}
+
+// the same CRC32 as zlib's crc32(), start with 0
+static uint32_t updateCrc(uint32_t crc, const unsigned char *data, size_t size)
+{
+	crc = ~crc;
+	while (size-- > 0)
+		crc = crcTable[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static uint32_t updateCrcRun(uint32_t crc, unsigned char value, size_t count)
+{
+	crc = ~crc;
+	while (count-- > 0)
+		crc = crcTable[(crc ^ value) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void putWord(unsigned char *buffer, uint32_t value, bool bigEndian)
+{
+	for (int i = 0; i < 4; i++)
+		buffer[i] = (unsigned char) (value >> (bigEndian ? (24 - (i * 8)) : (i * 8)));
+}
+
+static void putBigEndian16(unsigned char *buffer, uint16_t value)
+{
+	buffer[0] = (unsigned char) (value >> 8);
+	buffer[1] = (unsigned char) value;
+}
+
+static FILE * createFile(const char *directory, const char *name)
+{
+	char		fileName[4096];
+	FILE *		file;
+
+	snprintf(fileName, sizeof(fileName), "%s/%s", directory, name);
+
+	if ((file = fopen(fileName, "wb")) == NULL)
+		fprintf(stderr, "Error %d creating file '%s'.\n", errno, fileName);
+
+	return file;
+}
+
+static bool closeFile(FILE *file, const char *name)
+{
+	if (ferror(file) | fclose(file))
+	{
+		fprintf(stderr, "Error writing file '%s'.\n", name);
+		return false;
+	}
+
+	return true;
+}
+
+static bool writeFile(const char *directory, const char *name, const unsigned char *content, size_t size)
+{
+	FILE *		file;
+
+	if ((file = createFile(directory, name)) == NULL)
+		return false;
+
+	fwrite(content, 1, size, file);
+	return closeFile(file, name);
+}
+
+static size_t appendConfigText(char *buffer, size_t size)
+{
+	size_t		used = 0;
+	int			depth = 0;
+
+	// something looking like AVM's configuration files, lines are never split
+	while (true)
+	{
+		char		line[160];
+		int			length;
+		uint32_t	choice = randomBetween(0, 15);
+
+		if (choice == 0 && depth < 3)
+		{
+			length = snprintf(line, sizeof(line), "%*s%s {\n", depth * 8, "", settingNames[randomBetween(0, sizeof(settingNames) / sizeof(settingNames[0]) - 1)]);
+			depth++;
+		}
+		else if (choice == 1 && depth > 0)
+		{
+			depth--;
+			length = snprintf(line, sizeof(line), "%*s}\n", depth * 8, "");
+		}
+		else if (choice < 8)
+			length = snprintf(line, sizeof(line), "%*s%s = %u;\n", depth * 8, "", settingNames[randomBetween(0, sizeof(settingNames) / sizeof(settingNames[0]) - 1)], randomBetween(0, 65535));
+		else if (choice < 12)
+			length = snprintf(line, sizeof(line), "%*s%s = \"%08" PRIx64 "%08" PRIx64 "\";\n", depth * 8, "", settingNames[randomBetween(0, sizeof(settingNames) / sizeof(settingNames[0]) - 1)], nextRandom() & 0xFFFFFFFF, nextRandom() & 0xFFFFFFFF);
+		else
+			length = snprintf(line, sizeof(line), "%*s%s = %u.%u.%u.%u;\n", depth * 8, "", settingNames[randomBetween(0, sizeof(settingNames) / sizeof(settingNames[0]) - 1)], 192, 168, randomBetween(0, 255), randomBetween(1, 254));
+
+		if (used + length > size)
+			break;
+
+		memcpy(buffer + used, line, length);
+		used += length;
+	}
+
+	return used;
+}
+
+static size_t buildDeviceTree(unsigned char *buffer, unsigned int subrev, size_t fillerSize)
+{
+	static const char	strings[] = "compatible\0model\0avm,subrev\0avm,filler";
+	unsigned char *		ptr;
+	char				model[64];
+	size_t				structOffset = 40 + 16;	// header and an empty memory reservation map
+	size_t				structSize;
+	size_t				length;
+
+	//	A flattened device tree with only a root node and four properties,
+	//	it's always big endian - regardless of the target's byte order.
+
+	memset(buffer, 0, structOffset);
+	ptr = buffer + structOffset;
+
+	#define FDT_TOKEN(value)	{ putWord(ptr, (value), true); ptr += 4; }
+	#define FDT_PROPERTY(nameOffset, data, size) \
+		{ FDT_TOKEN(3); FDT_TOKEN((uint32_t) (size)); FDT_TOKEN(nameOffset); memcpy(ptr, (data), (size)); memset(ptr + (size), 0, ALIGN4(size) - (size)); ptr += ALIGN4(size); }
+
+	FDT_TOKEN(1);								// FDT_BEGIN_NODE
+	FDT_TOKEN(0);								// empty name of the root node
+	FDT_PROPERTY(0, "avm,fritzbox", sizeof("avm,fritzbox"));
+	length = snprintf(model, sizeof(model), "FRITZ!Box synthetic (subrev %u)", subrev) + 1;
+	FDT_PROPERTY(11, model, length);
+	{
+		unsigned char	value[4];
+
+		putWord(value, subrev, true);
+		FDT_PROPERTY(17, value, sizeof(value));
+	}
+	FDT_TOKEN(3);								// FDT_PROP with random content
+	FDT_TOKEN((uint32_t) fillerSize);
+	FDT_TOKEN(28);
+	fillRandom(ptr, fillerSize);
+	memset(ptr + fillerSize, 0, ALIGN4(fillerSize) - fillerSize);
+	ptr += ALIGN4(fillerSize);
+	FDT_TOKEN(2);								// FDT_END_NODE
+	FDT_TOKEN(9);								// FDT_END
+
+	#undef FDT_PROPERTY
+	#undef FDT_TOKEN
+
+	structSize = ptr - (buffer + structOffset);
+	memcpy(ptr, strings, sizeof(strings));
+
+	putWord(buffer, 0xD00DFEED, true);			// magic
+	putWord(buffer + 4, (uint32_t) (structOffset + structSize + sizeof(strings)), true);
+	putWord(buffer + 8, (uint32_t) structOffset, true);
+	putWord(buffer + 12, (uint32_t) (structOffset + structSize), true);
+	putWord(buffer + 16, 40, true);				// memory reservation map
+	putWord(buffer + 20, 17, true);				// version
+	putWord(buffer + 24, 16, true);				// last compatible version
+	putWord(buffer + 32, (uint32_t) sizeof(strings), true);
+	putWord(buffer + 36, (uint32_t) structSize, true);
+
+	return structOffset + structSize + sizeof(strings);
+}
+
+static size_t buildConfigArea(unsigned char *area, uint32_t segment, bool bigEndian, unsigned int deviceTrees)
+{
+	uint32_t			entries = 2 + deviceTrees + 1;
+	size_t				arrayOffset = 16;
+	size_t				offset = arrayOffset + (entries * 8);
+	unsigned char *		entry = area + arrayOffset;
+	size_t				versionOffset;
+	size_t				moduleOffset;
+	unsigned int		modules = randomBetween(3, sizeof(moduleNames) / sizeof(moduleNames[0]));
+	size_t				namesOffset;
+
+	//	Layout (all pointers in the target address space):
+	//
+	//	- pointer to the entry array, followed by zeros for alignment
+	//	- entry array: module memory, version info, DTBs, last tag
+	//	- the DTBs, the first one is located within the same 4K segment
+	//	- version info
+	//	- module memory array and the module names
+
+	memset(area, 0, CONFIG_AREA_WINDOW);
+	putWord(area, segment + (uint32_t) arrayOffset, bigEndian);
+
+	for (unsigned int subrev = 0; subrev < deviceTrees; subrev++)
+	{
+		putWord(entry + ((2 + subrev) * 8), DEVICE_TREE_TAG(subrev), bigEndian);
+		putWord(entry + ((2 + subrev) * 8) + 4, segment + (uint32_t) offset, bigEndian);
+		offset += ALIGN4(buildDeviceTree(area + offset, subrev, randomBetween(128, 1664)));
+	}
+
+	versionOffset = offset;
+	{
+		uint32_t	build = randomBetween(30000, 99999);
+		uint32_t	minor = randomBetween(1, 99);
+
+		snprintf((char *) area + versionOffset, 32, "%u", build);
+		snprintf((char *) area + versionOffset + 32, 32, "%u", build);
+		snprintf((char *) area + versionOffset + 64, 128, "1%02u.07.%02u-%u synthetic", randomBetween(13, 99), minor, build);
+	}
+	offset += VERSION_INFO_SIZE;
+
+	moduleOffset = offset;
+	namesOffset = moduleOffset + ((modules + 1) * 8);
+	for (unsigned int module = 0; module < modules; module++)
+	{
+		size_t		length = strlen(moduleNames[module]) + 1;
+
+		putWord(area + moduleOffset + (module * 8), segment + (uint32_t) namesOffset, bigEndian);
+		putWord(area + moduleOffset + (module * 8) + 4, randomBetween(1, 64) * 4096, bigEndian);
+		memcpy(area + namesOffset, moduleNames[module], length);
+		namesOffset += length;
+	}
+	offset = namesOffset;
+
+	putWord(entry, avm_kernel_config_tags_modulememory, bigEndian);
+	putWord(entry + 4, segment + (uint32_t) moduleOffset, bigEndian);
+	putWord(entry + 8, avm_kernel_config_tags_version_info, bigEndian);
+	putWord(entry + 12, segment + (uint32_t) versionOffset, bigEndian);
+	putWord(entry + ((entries - 1) * 8), LAST_TAG, bigEndian);
+
+	return ALIGN4(offset);
+}
+
+static bool createKernel(struct corpusOptions *options, FILE *list, unsigned int index)
+{
+	size_t				kernelSize = (size_t) options->kernelSize * 1024;
+	unsigned char *		kernel;
+	unsigned char *		area;
+	bool				bigEndian = ((index & 1) == 0);
+	bool				unaligned = ((index & 2) != 0);
+	unsigned int		deviceTrees = (options->kernels > 1 ? 1 + (index * (MAX_DEVICE_TREES - 1)) / (options->kernels - 1) : 1);
+	unsigned int		decoys = index % 3;
+	uint32_t			loadAddr;
+	uint32_t			segment;
+	size_t				areaOffset;
+	size_t				areaSize;
+	char				kernelName[64];
+	char				areaName[64];
+	bool				result = false;
+
+	if ((kernel = malloc(kernelSize)) == NULL || (area = malloc(CONFIG_AREA_WINDOW)) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for a kernel of %u KByte.\n", options->kernelSize);
+		free(kernel);
+		return false;
+	}
+
+	fillRandom(kernel, kernelSize);
+
+	// GRX5 kernels are loaded at addresses, which aren't aligned to 4K
+	loadAddr = (unaligned ? 0x60000000 + (randomBetween(1, 1023) * 4) : (bigEndian ? 0x80002000 : 0xC0008000));
+
+	// the area starts at a 4K boundary (in the target address space) somewhere in the second half
+	segment = (loadAddr + (uint32_t) (kernelSize / 2) + randomBetween(0, (uint32_t) (kernelSize / 4)) + 4095) & ~4095;
+	areaOffset = segment - loadAddr;
+	areaSize = buildConfigArea(area, segment, bigEndian, deviceTrees);
+	memcpy(kernel + areaOffset, area, areaSize);
+
+	// DTBs without a config area in front of them are found first, while scanning the kernel
+	for (unsigned int decoy = 0; decoy < decoys; decoy++)
+		buildDeviceTree(kernel + (randomBetween(1, (uint32_t) (kernelSize / 16)) * 4), 255, randomBetween(128, 1024));
+
+	snprintf(kernelName, sizeof(kernelName), "kernel_%02u.bin", index);
+	snprintf(areaName, sizeof(areaName), "kernel_%02u.area", index);
+
+	if (writeFile(options->directory, kernelName, kernel, kernelSize) && writeFile(options->directory, areaName, area, areaSize))
+	{
+		fprintf(list, "kernel %s %s 0x%08x %s %u %zu\n", kernelName, areaName, loadAddr, (bigEndian ? "big" : "little"), deviceTrees, kernelSize);
+		result = true;
+	}
+
+	free(area);
+	free(kernel);
+	return result;
+}
+
+static size_t addTffsNode(unsigned char *dump, size_t offset, uint16_t id, const unsigned char *data, size_t size)
+{
+	putBigEndian16(dump + offset, id);
+	putBigEndian16(dump + offset + 2, (uint16_t) size);
+	memcpy(dump + offset + 4, data, size);
+	memset(dump + offset + 4 + size, 0, ALIGN4(size) - size);
+
+	return offset + 4 + ALIGN4(size);
+}
+
+static bool createTffsDump(struct corpusOptions *options, FILE *list, unsigned int index)
+{
+	size_t				dumpSize = (size_t) options->tffsSize * 1024;
+	size_t				limit = (dumpSize * TFFS_FILL_PERCENT) / 100;
+	unsigned char *		dump;
+	unsigned char *		node;
+	size_t				lastOffset[0x500];
+	size_t				offset;
+	char				name[64];
+	bool				result = false;
+
+	//	Nodes are written in big endian order, a node replaced by a newer
+	//	version gets the ID 0, the unused space is erased (0xFF).
+
+	if ((dump = malloc(dumpSize)) == NULL || (node = malloc(65536)) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for a TFFS dump of %u KByte.\n", options->tffsSize);
+		free(dump);
+		return false;
+	}
+
+	memset(dump, 0xFF, dumpSize);
+	memset(lastOffset, 0, sizeof(lastOffset));
+
+	memset(node, 0xFF, 3);
+	node[3] = 0xFE;
+	offset = addTffsNode(dump, 0, 1, node, 4);
+
+	while (true)
+	{
+		uint32_t	choice = randomBetween(0, 9);
+		uint16_t	id;
+		size_t		size;
+
+		if (choice < 5)
+		{
+			// environment value
+			id = (uint16_t) randomBetween(0x100, 0x1FE);
+			size = snprintf((char *) node, 256, "%02X:%02X:%02X:%02X:%02X:%02X", 0x3C, 0xA6, 0x2F, randomBetween(0, 255), randomBetween(0, 255), randomBetween(0, 255)) + 1;
+		}
+		else if (choice < 7)
+		{
+			// counter
+			id = (uint16_t) randomBetween(0x400, 0x407);
+			putWord(node, randomBetween(0, 100000), true);
+			size = 4;
+		}
+		else
+		{
+			// file with deflated content, stored blocks only
+			size_t	textSize = appendConfigText((char *) node + 5, randomBetween(512, 16384));
+
+			id = (uint16_t) randomBetween(0x1D, 0x60);
+			node[0] = 0x01;							// final block, not compressed
+			node[1] = (unsigned char) textSize;
+			node[2] = (unsigned char) (textSize >> 8);
+			node[3] = (unsigned char) ~node[1];
+			node[4] = (unsigned char) ~node[2];
+			size = textSize + 5;
+		}
+
+		if (offset + 4 + ALIGN4(size) > limit)
+			break;
+
+		if (lastOffset[id] != 0)
+			putBigEndian16(dump + lastOffset[id], 0);
+		lastOffset[id] = offset;
+		offset = addTffsNode(dump, offset, id, node, size);
+	}
+
+	snprintf(name, sizeof(name), "tffs_%02u.bin", index);
+
+	if (writeFile(options->directory, name, dump, dumpSize))
+	{
+		fprintf(list, "tffs %s %zu %08X\n", name, dumpSize, updateCrc(0, dump, dumpSize));
+		result = true;
+	}
+
+	free(node);
+	free(dump);
+	return result;
+}
+
+static void emitLiteral(FILE *file, const unsigned char *data, size_t count, uint32_t *crc)
+{
+	*crc = updateCrc(*crc, data, count);
+
+	while (count > 0)
+	{
+		size_t	chunk = (count > 0x7F ? 0x7F : count);
+
+		fputc((int) chunk, file);
+		fwrite(data, 1, chunk, file);
+		data += chunk;
+		count -= chunk;
+	}
+}
+
+static void emitRun(FILE *file, unsigned char value, size_t count, uint32_t *crc)
+{
+	*crc = updateCrcRun(*crc, value, count);
+
+	while (count > 0)
+	{
+		size_t	chunk;
+
+		if (count > 255)
+		{
+			chunk = (count > 0xFFFF ? 0xFFFF : count);
+			fputc(0x81, file);
+			fputc((int) (chunk & 0xFF), file);
+			fputc((int) (chunk >> 8), file);
+			fputc(value, file);
+		}
+		else
+		{
+			chunk = count;
+			if (value == 0x00)
+			{
+				fputc(0x00, file);
+				fputc((int) chunk, file);
+			}
+			else if (value == 0x20)
+			{
+				fputc(0x82, file);
+				fputc((int) chunk, file);
+			}
+			else if (chunk >= 3 && chunk <= 0x7F)
+			{
+				fputc((int) (0x80 + chunk), file);
+				fputc(value, file);
+			}
+			else
+			{
+				fputc(0x80, file);
+				fputc((int) chunk, file);
+				fputc(value, file);
+			}
+		}
+
+		count -= chunk;
+	}
+}
+
+static bool createRecoveryImage(struct corpusOptions *options, FILE *list, unsigned int index)
+{
+	uint64_t			decodedSize = (uint64_t) options->recoverySize * 1024;
+	uint64_t			written = 0;
+	uint32_t			crc = 0;
+	unsigned char *		buffer;
+	FILE *				file;
+	char				name[64];
+
+	//	The decoded content is a mix of erased flash, zero filled areas,
+	//	configuration text with space padding and (random) compressed data.
+
+	if ((buffer = malloc(512 * 1024)) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for a recovery image.\n");
+		return false;
+	}
+
+	snprintf(name, sizeof(name), "recovery_%02u.rle", index);
+
+	if ((file = createFile(options->directory, name)) == NULL)
+	{
+		free(buffer);
+		return false;
+	}
+
+	while (written < decodedSize)
+	{
+		uint64_t	remaining = decodedSize - written;
+		uint32_t	choice = randomBetween(0, 9);
+		size_t		count;
+
+		if (choice < 2)
+		{
+			count = randomBetween(1024, 256 * 1024);
+			count = (count > remaining ? (size_t) remaining : count);
+			emitRun(file, 0x00, count, &crc);
+		}
+		else if (choice < 4)
+		{
+			count = randomBetween(1024, 64 * 1024);
+			count = (count > remaining ? (size_t) remaining : count);
+			emitRun(file, 0xFF, count, &crc);
+		}
+		else if (choice < 6)
+		{
+			count = appendConfigText((char *) buffer, randomBetween(256, 4096));
+			count = (count > remaining ? (size_t) remaining : count);
+			emitLiteral(file, buffer, count, &crc);
+			written += count;
+			remaining -= count;
+			count = randomBetween(1, 600);
+			count = (count > remaining ? (size_t) remaining : count);
+			emitRun(file, 0x20, count, &crc);
+		}
+		else if (choice < 9)
+		{
+			count = randomBetween(4096, 512 * 1024);
+			count = (count > remaining ? (size_t) remaining : count);
+			fillRandom(buffer, count);
+			emitLiteral(file, buffer, count, &crc);
+		}
+		else
+		{
+			count = randomBetween(1, 127);
+			count = (count > remaining ? (size_t) remaining : count);
+			emitRun(file, (unsigned char) randomBetween(0x21, 0xFE), count, &crc);
+		}
+
+		written += count;
+	}
+
+	// end of content
+	fputc(0x00, file);
+	fputc(0x00, file);
+
+	free(buffer);
+
+	if (!closeFile(file, name))
+		return false;
+
+	fprintf(list, "rle %s %" PRIu64 " %08X\n", name, decodedSize, crc);
+	return true;
+}
+
+static bool appendExport(char **buffer, size_t *used, size_t *allocated, const char *data, size_t size)
+{
+	if (*used + size > *allocated)
+	{
+		size_t	newAllocated = (*allocated ? *allocated : 65536);
+		char *	newBuffer;
+
+		while (*used + size > newAllocated)
+			newAllocated *= 2;
+
+		if ((newBuffer = realloc(*buffer, newAllocated)) == NULL)
+		{
+			fprintf(stderr, "Error allocating memory for an export file.\n");
+			return false;
+		}
+
+		*buffer = newBuffer;
+		*allocated = newAllocated;
+	}
+
+	memcpy(*buffer + *used, data, size);
+	*used += size;
+	return true;
+}
+
+static bool createExport(struct corpusOptions *options, FILE *list, unsigned int index)
+{
+	size_t				exportSize = (size_t) options->exportSize * 1024;
+	char *				content = NULL;
+	size_t				used = 0;
+	size_t				allocated = 0;
+	uint32_t			checksum = 0;
+	char				line[256];
+	char *				part;
+	unsigned int		files = 0;
+	char				name[64];
+	bool				result = false;
+	static const char *	header[] = { "FirmwareVersion=113.07.29", "CONFIG_INSTALL_TYPE=iks_16MB_xilinx_4geth_2ab_isdn_nt_te_pots_wlan_mimo_usb_host_dect_multiannex_13589", "OEM=avm", "Language=de", "NoChecks=yes" };
+
+	//	The checksum is computed like the 'checksum' script does it: header
+	//	lines without the first equal sign and each file name with a NUL
+	//	byte, followed by the file content (without the empty line at the
+	//	end of text files).
+
+	if ((part = malloc(32 * 1024)) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for an export file.\n");
+		return false;
+	}
+
+	snprintf(line, sizeof(line), "**** FRITZ!Box 7490 CONFIGURATION EXPORT\n");
+	if (!appendExport(&content, &used, &allocated, line, strlen(line)))
+		goto exit;
+
+	snprintf(line, sizeof(line), "Password=$$$$%016" PRIX64 "%016" PRIX64 "\n", nextRandom(), nextRandom());
+	for (size_t i = 0; i <= sizeof(header) / sizeof(header[0]); i++)
+	{
+		char *	value;
+
+		if (i > 0)
+			snprintf(line, sizeof(line), "%s\n", header[i - 1]);
+		if (!appendExport(&content, &used, &allocated, line, strlen(line)))
+			goto exit;
+
+		value = strchr(line, '=');
+		checksum = updateCrc(checksum, (unsigned char *) line, value - line);
+		checksum = updateCrc(checksum, (unsigned char *) value + 1, strlen(value + 1) - 1);
+		checksum = updateCrc(checksum, (unsigned char *) "", 1);
+	}
+
+	while (used < exportSize)
+	{
+		size_t	size;
+		bool	binary = ((files % 3) == 2);
+
+		if (binary)
+			snprintf(name, sizeof(name), "dect_eeprom_%u.bin", files);
+		else if (files < sizeof(configFileNames) / sizeof(configFileNames[0]))
+			snprintf(name, sizeof(name), "%s", configFileNames[files]);
+		else
+			snprintf(name, sizeof(name), "synthetic_%u.cfg", files);
+
+		snprintf(line, sizeof(line), "**** %s:%s\n", (binary ? "BINFILE" : "CFGFILE"), name);
+		if (!appendExport(&content, &used, &allocated, line, strlen(line)))
+			goto exit;
+
+		checksum = updateCrc(checksum, (unsigned char *) name, strlen(name) + 1);
+
+		if (binary)
+		{
+			size = randomBetween(1024, 8192);
+			fillRandom((unsigned char *) part, size);
+			checksum = updateCrc(checksum, (unsigned char *) part, size);
+
+			// 40 bytes per line, as hexadecimal digits
+			for (size_t offset = 0; offset < size; offset += 40)
+			{
+				size_t	length = 0;
+
+				for (size_t i = offset; i < size && i < offset + 40; i++)
+					length += snprintf(line + length, sizeof(line) - length, "%02X", (unsigned char) part[i]);
+				line[length++] = '\n';
+				if (!appendExport(&content, &used, &allocated, line, length))
+					goto exit;
+			}
+		}
+		else
+		{
+			size = appendConfigText(part, randomBetween(1024, 32 * 1024 - 1));
+			checksum = updateCrc(checksum, (unsigned char *) part, size);
+			part[size++] = '\n';
+			if (!appendExport(&content, &used, &allocated, part, size))
+				goto exit;
+		}
+
+		snprintf(line, sizeof(line), "**** END OF FILE ****\n");
+		if (!appendExport(&content, &used, &allocated, line, strlen(line)))
+			goto exit;
+
+		files++;
+	}
+
+	snprintf(line, sizeof(line), "**** END OF EXPORT %08X ****\n", checksum);
+	if (!appendExport(&content, &used, &allocated, line, strlen(line)))
+		goto exit;
+
+	snprintf(name, sizeof(name), "export_%02u.export", index);
+
+	if (writeFile(options->directory, name, (unsigned char *) content, used))
+	{
+		fprintf(list, "export %s %zu %08X\n", name, used, updateCrc(0, (unsigned char *) content, used));
+		result = true;
+	}
+
+exit:
+	free(part);
+	free(content);
+	return result;
+}
+
+int main(int argc, char * argv[])
+{
+	struct corpusOptions	options = { 8, 4096, 4, 256, 2, 32768, 8, 256, 1, NULL };
+	FILE *					list;
+	bool					success = true;
+	int						i = 1;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0')
+	{
+		unsigned int *	target = NULL;
+		char *			firstInvalidChar;
+		unsigned long	value;
+
+		if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+		{
+			usage();
+			exit(1);
+		}
+
+		if (i + 1 >= argc)
+		{
+			fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+			exit(2);
+		}
+
+		value = strtoul(argv[i + 1], &firstInvalidChar, 0);
+		if (*argv[i + 1] == '\0' || *firstInvalidChar != '\0')
+		{
+			fprintf(stderr, "Missing or invalid numeric value for option '%s'.\n", argv[i]);
+			exit(2);
+		}
+
+		if (strcmp(argv[i], "-S") == 0)
+			options.seed = value;
+		else if (strcmp(argv[i], "-k") == 0)
+			target = &options.kernels;
+		else if (strcmp(argv[i], "-K") == 0)
+			target = &options.kernelSize;
+		else if (strcmp(argv[i], "-t") == 0)
+			target = &options.tffsDumps;
+		else if (strcmp(argv[i], "-T") == 0)
+			target = &options.tffsSize;
+		else if (strcmp(argv[i], "-r") == 0)
+			target = &options.recoveryImages;
+		else if (strcmp(argv[i], "-R") == 0)
+			target = &options.recoverySize;
+		else if (strcmp(argv[i], "-e") == 0)
+			target = &options.exports;
+		else if (strcmp(argv[i], "-E") == 0)
+			target = &options.exportSize;
+		else
+		{
+			fprintf(stderr, "Unknown option '%s'.\n", argv[i]);
+			exit(2);
+		}
+
+		if (target != NULL)
+		{
+			if (value > 1024 * 1024)
+			{
+				fprintf(stderr, "Value for option '%s' is too large.\n", argv[i]);
+				exit(2);
+			}
+			*target = (unsigned int) value;
+		}
+
+		i += 2;
+	}
+
+	if (i + 1 != argc)
+	{
+		usage();
+		exit(2);
+	}
+
+	// the config area window has to fit into the second half of the kernel
+	if (options.kernels > 0 && options.kernelSize < 4 * (CONFIG_AREA_WINDOW / 1024))
+	{
+		fprintf(stderr, "The kernel size has to be %u KByte at least.\n", 4 * (CONFIG_AREA_WINDOW / 1024));
+		exit(2);
+	}
+
+	// at least the segment header and one node
+	if (options.tffsDumps > 0 && options.tffsSize < 32)
+	{
+		fprintf(stderr, "The TFFS size has to be 32 KByte at least.\n");
+		exit(2);
+	}
+
+	options.directory = argv[i];
+	if (mkdir(options.directory, 0755) != 0 && errno != EEXIST)
+	{
+		fprintf(stderr, "Error %d creating directory '%s'.\n", errno, options.directory);
+		exit(1);
+	}
+
+	if ((list = createFile(options.directory, CORPUS_LIST)) == NULL)
+		exit(1);
+
+	// xorshift needs a non-zero state
+	randomState = (options.seed ? options.seed : 1) * 0x9E3779B97F4A7C15ULL;
+	initCrcTable();
+
+	for (unsigned int index = 0; success && index < options.kernels; index++)
+		success = createKernel(&options, list, index);
+
+	for (unsigned int index = 0; success && index < options.tffsDumps; index++)
+		success = createTffsDump(&options, list, index);
+
+	for (unsigned int index = 0; success && index < options.recoveryImages; index++)
+		success = createRecoveryImage(&options, list, index);
+
+	for (unsigned int index = 0; success && index < options.exports; index++)
+		success = createExport(&options, list, index);
+
+	if (!closeFile(list, CORPUS_LIST))
+		success = false;
+
+	exit(success ? 0 : 1);
+}
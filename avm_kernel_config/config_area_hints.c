@@ -0,0 +1,321 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "lib_avm_kernel_config.h"
+#include "config_area_hints.h"
+
+//	The hints file is a simple text file with one hint per line:
+//
+//	size <offset> <kernel size>
+//	loadaddr <offset> <kernel load address>
+//	version <offset> <version_info prefix>
+//
+//	Empty lines and lines starting with '#' are ignored. Numbers may be
+//	specified as decimal or hexadecimal (with 0x prefix) values, the
+//	version prefix is the remaining part of the line and is compared with
+//	the start of the 'buildnumber' and 'firmwarestring' members of the
+//	version info from the config area at the hinted offset. An offset is
+//	only used, if it passes the same checks as a candidate of the scan: a
+//	consistent config area in front of a DTB with a valid header.
+
+static const char *	hintKeyNames[] = { "size", "loadaddr", "version" };
+
+static bool addHint(struct configAreaHints *hints, enum configAreaHintKey key, uint32_t offset, uint32_t number, const char *version)
+{
+	struct configAreaHint *	hint;
+
+	if (hints->count == hints->allocated)
+	{
+		size_t					newAllocated = (hints->allocated ? hints->allocated * 2 : 16);
+		struct configAreaHint *	newHints = realloc(hints->hints, newAllocated * sizeof(struct configAreaHint));
+
+		if (newHints == NULL)
+			return false;
+
+		hints->hints = newHints;
+		hints->allocated = newAllocated;
+	}
+
+	hint = &hints->hints[hints->count];
+	hint->key = key;
+	hint->offset = offset;
+	hint->number = number;
+	hint->version = NULL;
+
+	if (version != NULL)
+	{
+		if ((hint->version = malloc(strlen(version) + 1)) == NULL)
+			return false;
+		strcpy(hint->version, version);
+	}
+
+	hints->count++;
+	return true;
+}
+
+bool loadConfigAreaHints(struct configAreaHints *hints, const char *fileName)
+{
+	FILE *		file;
+	char		line[512];
+	int			lineNumber = 0;
+	bool		result = true;
+
+	hints->fileName = fileName;
+	hints->hints = NULL;
+	hints->count = 0;
+	hints->allocated = 0;
+
+	if ((file = fopen(fileName, "r")) == NULL)
+	{
+		// a missing file is the same as an empty one, it may be created while learning
+		if (errno == ENOENT)
+			return true;
+
+		fprintf(stderr, "Error %d opening hints file '%s'.\n", errno, fileName);
+		return false;
+	}
+
+	while (result && fgets(line, sizeof(line), file) != NULL)
+	{
+		char *		keyName;
+		char *		offsetString;
+		char *		value;
+		char *		firstInvalidChar;
+		uint32_t	offset;
+		uint32_t	number = 0;
+		size_t		key;
+
+		lineNumber++;
+		line[strcspn(line, "\r\n")] = '\0';
+
+		keyName = line + strspn(line, " \t");
+		if (*keyName == '\0' || *keyName == '#')
+			continue;
+
+		offsetString = keyName + strcspn(keyName, " \t");
+		if (*offsetString != '\0')
+			*offsetString++ = '\0';
+		offsetString += strspn(offsetString, " \t");
+
+		value = offsetString + strcspn(offsetString, " \t");
+		if (*value != '\0')
+			*value++ = '\0';
+		value += strspn(value, " \t");
+
+		for (key = 0; key < sizeof(hintKeyNames) / sizeof(hintKeyNames[0]); key++)
+		{
+			if (strcmp(keyName, hintKeyNames[key]) == 0)
+				break;
+		}
+
+		offset = strtoul(offsetString, &firstInvalidChar, 0);
+		if (key == sizeof(hintKeyNames) / sizeof(hintKeyNames[0]) || *offsetString == '\0' || *firstInvalidChar != '\0' || *value == '\0')
+		{
+			fprintf(stderr, "Invalid entry in line %d of hints file '%s' ignored.\n", lineNumber, fileName);
+			continue;
+		}
+
+		if ((enum configAreaHintKey) key != configAreaHintVersion)
+		{
+			number = strtoul(value, &firstInvalidChar, 0);
+			if (*firstInvalidChar != '\0')
+			{
+				fprintf(stderr, "Invalid entry in line %d of hints file '%s' ignored.\n", lineNumber, fileName);
+				continue;
+			}
+			value = NULL;
+		}
+
+		if (!addHint(hints, (enum configAreaHintKey) key, offset, number, value))
+		{
+			fprintf(stderr, "Error allocating memory for hints from file '%s'.\n", fileName);
+			result = false;
+		}
+	}
+
+	fclose(file);
+
+	if (!result)
+		freeConfigAreaHints(hints);
+
+	return result;
+}
+
+void freeConfigAreaHints(struct configAreaHints *hints)
+{
+	for (size_t i = 0; i < hints->count; i++)
+		free(hints->hints[i].version);
+
+	free(hints->hints);
+	hints->hints = NULL;
+	hints->count = 0;
+	hints->allocated = 0;
+}
+
+static bool matchesVersion(void *configArea, size_t size, const char *prefix)
+{
+	struct _avm_kernel_version_info *	version = findUnrelocatedEntry(configArea, size, avm_kernel_config_tags_version_info);
+	size_t								prefixLength = strlen(prefix);
+
+	if (version == NULL || (char *) version + sizeof(*version) > (char *) configArea + size)
+		return false;
+
+	if (prefixLength <= sizeof(version->buildnumber) && strncmp(version->buildnumber, prefix, prefixLength) == 0)
+		return true;
+
+	if (prefixLength <= sizeof(version->firmwarestring) && strncmp(version->firmwarestring, prefix, prefixLength) == 0)
+		return true;
+
+	return false;
+}
+
+static void * probeOffset(void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, uint32_t offset, size_t size)
+{
+	void *	configArea = (char *) kernelBuffer + offset;
+
+	if (offset >= kernelSize)
+		return NULL;
+
+	if (size > kernelSize - offset)
+		size = kernelSize - offset;
+
+	// a hinted offset has to pass the same device tree check as a scanned one
+	return (hasValidDeviceTree(kernelBuffer, kernelSize, kernelLoadAddr, configArea, size) ? configArea : NULL);
+}
+
+void * probeConfigAreaHints(struct configAreaHints *hints, void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, size_t size)
+{
+	// the most specific hints are tried first: load address, kernel size and finally the
+	// version prefix, which has to be verified against the found config area
+
+	static const enum configAreaHintKey	order[] = { configAreaHintLoadAddress, configAreaHintKernelSize, configAreaHintVersion };
+
+	for (size_t pass = 0; pass < sizeof(order) / sizeof(order[0]); pass++)
+	{
+		for (size_t i = 0; i < hints->count; i++)
+		{
+			struct configAreaHint *	hint = &hints->hints[i];
+			void *					configArea;
+
+			if (hint->key != order[pass])
+				continue;
+
+			if (hint->key == configAreaHintLoadAddress && (kernelLoadAddr == 0 || hint->number != kernelLoadAddr))
+				continue;
+
+			if (hint->key == configAreaHintKernelSize && hint->number != kernelSize)
+				continue;
+
+			if ((configArea = probeOffset(kernelBuffer, kernelSize, kernelLoadAddr, hint->offset, size)) == NULL)
+				continue;
+
+			if (hint->key == configAreaHintVersion)
+			{
+				size_t	available = kernelSize - hint->offset;
+
+				if (!matchesVersion(configArea, (size < available ? size : available), hint->version))
+					continue;
+			}
+
+			return configArea;
+		}
+	}
+
+	return NULL;
+}
+
+static bool isKnownHint(struct configAreaHints *hints, enum configAreaHintKey key, uint32_t offset, uint32_t number, const char *version)
+{
+	for (size_t i = 0; i < hints->count; i++)
+	{
+		struct configAreaHint *	hint = &hints->hints[i];
+
+		if (hint->key != key || hint->offset != offset)
+			continue;
+
+		if (key == configAreaHintVersion ? (strcmp(hint->version, version) == 0) : (hint->number == number))
+			return true;
+	}
+
+	return false;
+}
+
+bool learnConfigAreaHints(struct configAreaHints *hints, void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, void *configArea, size_t size)
+{
+	FILE *								file;
+	uint32_t							offset = (uint32_t) ((char *) configArea - (char *) kernelBuffer);
+	struct _avm_kernel_version_info *	version = findUnrelocatedEntry(configArea, size, avm_kernel_config_tags_version_info);
+	char								firmware[sizeof(version->firmwarestring) + 1] = "";
+	bool								learnSize;
+	bool								learnLoadAddr;
+	bool								learnVersion;
+
+	if (version != NULL && (char *) version + sizeof(*version) <= (char *) configArea + size)
+	{
+		// strings with white space at the start can't be stored, they would be stripped while loading
+		memcpy(firmware, version->firmwarestring, sizeof(version->firmwarestring));
+		firmware[strcspn(firmware, "\r\n")] = '\0';
+		if (strspn(firmware, " \t") > 0)
+			firmware[0] = '\0';
+	}
+
+	learnSize = !isKnownHint(hints, configAreaHintKernelSize, offset, kernelSize, NULL);
+	learnLoadAddr = (kernelLoadAddr != 0) && !isKnownHint(hints, configAreaHintLoadAddress, offset, kernelLoadAddr, NULL);
+	learnVersion = (firmware[0] != '\0') && !isKnownHint(hints, configAreaHintVersion, offset, 0, firmware);
+
+	if (!learnSize && !learnLoadAddr && !learnVersion)
+		return true;
+
+	if ((file = fopen(hints->fileName, "a")) == NULL)
+	{
+		fprintf(stderr, "Error %d opening hints file '%s' for writing.\n", errno, hints->fileName);
+		return false;
+	}
+
+	if (learnSize)
+	{
+		fprintf(file, "%s 0x%08x %u\n", hintKeyNames[configAreaHintKernelSize], offset, (uint32_t) kernelSize);
+		addHint(hints, configAreaHintKernelSize, offset, kernelSize, NULL);
+	}
+	if (learnLoadAddr)
+	{
+		fprintf(file, "%s 0x%08x 0x%08x\n", hintKeyNames[configAreaHintLoadAddress], offset, kernelLoadAddr);
+		addHint(hints, configAreaHintLoadAddress, offset, kernelLoadAddr, NULL);
+	}
+	if (learnVersion)
+	{
+		fprintf(file, "%s 0x%08x %s\n", hintKeyNames[configAreaHintVersion], offset, firmware);
+		addHint(hints, configAreaHintVersion, offset, 0, firmware);
+	}
+
+	if (fclose(file) != 0)
+	{
+		fprintf(stderr, "Error %d writing hints file '%s'.\n", errno, hints->fileName);
+		return false;
+	}
+
+	return true;
+}
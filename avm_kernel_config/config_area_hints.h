@@ -0,0 +1,37 @@
+// vi: set tabstop=4 syntax=c :
+#ifndef CONFIG_AREA_HINTS_H
+#define CONFIG_AREA_HINTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+enum configAreaHintKey
+{
+	configAreaHintKernelSize,
+	configAreaHintLoadAddress,
+	configAreaHintVersion,
+};
+
+struct configAreaHint
+{
+	enum configAreaHintKey	key;
+	uint32_t				offset;
+	uint32_t				number;		// kernel size or load address
+	char *					version;	// version_info prefix
+};
+
+struct configAreaHints
+{
+	const char *			fileName;
+	struct configAreaHint *	hints;
+	size_t					count;
+	size_t					allocated;
+};
+
+bool loadConfigAreaHints(struct configAreaHints *hints, const char *fileName);
+void freeConfigAreaHints(struct configAreaHints *hints);
+void * probeConfigAreaHints(struct configAreaHints *hints, void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, size_t size);
+bool learnConfigAreaHints(struct configAreaHints *hints, void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, void *configArea, size_t size);
+
+#endif
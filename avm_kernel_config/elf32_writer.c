@@ -0,0 +1,398 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <elf.h>
+
+#include "elf32_writer.h"
+
+//	A minimal writer for relocatable ELF32 objects, as they would be
+//	created by an assembler for data-only sources:
+//
+//	- each section is a SHT_PROGBITS section with its content built in
+//	  memory, relocations are absolute 32-bit references to the start
+//	  of another (or the same) section with the addend stored in place
+//	  (SHT_REL, like the MIPS and ARM assemblers do it)
+//	- the symbol table contains only the section symbols, which are
+//	  referenced by the relocations
+//	- the output is written in the target byte order
+
+static void growBuffer(struct elf32Object *object, void **buffer, size_t *allocated, size_t needed, size_t elementSize)
+{
+	size_t	newAllocated;
+	void *	newBuffer;
+
+	if (object->failed || needed <= *allocated)
+		return;
+
+	newAllocated = (*allocated ? *allocated : 256);
+	while (newAllocated < needed)
+		newAllocated *= 2;
+
+	if ((newBuffer = realloc(*buffer, newAllocated * elementSize)) == NULL)
+	{
+		object->failed = true;
+		return;
+	}
+
+	*buffer = newBuffer;
+	*allocated = newAllocated;
+}
+
+static void put16(uint8_t *ptr, uint16_t value, bool bigEndian)
+{
+	if (bigEndian)
+	{
+		ptr[0] = (uint8_t) (value >> 8);
+		ptr[1] = (uint8_t) value;
+	}
+	else
+	{
+		ptr[0] = (uint8_t) value;
+		ptr[1] = (uint8_t) (value >> 8);
+	}
+}
+
+static void put32(uint8_t *ptr, uint32_t value, bool bigEndian)
+{
+	if (bigEndian)
+	{
+		put16(ptr, (uint16_t) (value >> 16), true);
+		put16(ptr + 2, (uint16_t) value, true);
+	}
+	else
+	{
+		put16(ptr, (uint16_t) value, false);
+		put16(ptr + 2, (uint16_t) (value >> 16), false);
+	}
+}
+
+void initElf32Object(struct elf32Object *object, bool bigEndian, uint16_t machine, uint32_t flags, uint32_t relocationType)
+{
+	memset(object, 0, sizeof(*object));
+	object->bigEndian = bigEndian;
+	object->machine = machine;
+	object->flags = flags;
+	object->relocationType = relocationType;
+}
+
+void freeElf32Object(struct elf32Object *object)
+{
+	for (size_t i = 0; i < object->sectionCount; i++)
+	{
+		free(object->sections[i].data);
+		free(object->sections[i].relocations);
+	}
+	object->sectionCount = 0;
+}
+
+size_t addElf32Section(struct elf32Object *object, const char *name, uint32_t flags)
+{
+	struct elf32Section *	section;
+
+	if (object->sectionCount == ELF32_WRITER_MAX_SECTIONS)
+	{
+		object->failed = true;
+		return 0;
+	}
+
+	section = &object->sections[object->sectionCount];
+	memset(section, 0, sizeof(*section));
+	section->name = name;
+	section->flags = flags;
+	section->alignment = 1;
+
+	return object->sectionCount++;
+}
+
+void appendElf32Bytes(struct elf32Object *object, size_t section, const void *data, size_t size)
+{
+	struct elf32Section *	s = &object->sections[section];
+
+	growBuffer(object, (void **) &s->data, &s->allocated, s->size + size, 1);
+	if (object->failed)
+		return;
+
+	if (data != NULL)
+		memcpy(s->data + s->size, data, size);
+	else
+		memset(s->data + s->size, 0, size);
+	s->size += size;
+}
+
+void appendElf32Zeros(struct elf32Object *object, size_t section, size_t size)
+{
+	appendElf32Bytes(object, section, NULL, size);
+}
+
+void alignElf32Section(struct elf32Object *object, size_t section, uint32_t alignment)
+{
+	struct elf32Section *	s = &object->sections[section];
+
+	// section alignment is the maximum of all alignments used within it
+	if (alignment > s->alignment)
+		s->alignment = alignment;
+
+	if (s->size % alignment)
+		appendElf32Zeros(object, section, alignment - (s->size % alignment));
+}
+
+void appendElf32Word(struct elf32Object *object, size_t section, uint32_t value)
+{
+	uint8_t		word[4];
+
+	put32(word, value, object->bigEndian);
+	appendElf32Bytes(object, section, word, sizeof(word));
+}
+
+void appendElf32Pointer(struct elf32Object *object, size_t section, size_t target, uint32_t targetOffset)
+{
+	struct elf32Section *	s = &object->sections[section];
+
+	growBuffer(object, (void **) &s->relocations, &s->relocationsAllocated, s->relocationCount + 1, sizeof(struct elf32Relocation));
+	if (object->failed)
+		return;
+
+	s->relocations[s->relocationCount].offset = (uint32_t) s->size;
+	s->relocations[s->relocationCount].target = target;
+	s->relocationCount++;
+
+	// REL relocations use the word at the relocated location as addend
+	appendElf32Word(object, section, targetOffset);
+}
+
+uint32_t getElf32SectionSize(struct elf32Object *object, size_t section)
+{
+	return (uint32_t) object->sections[section].size;
+}
+
+static size_t alignOffset(size_t offset, size_t alignment)
+{
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+bool writeElf32Object(struct elf32Object *object, int fd)
+{
+	// output section indices: 0 = NULL, then each section followed by its
+	// relocation section (if any), then .symtab, .strtab and .shstrtab
+	size_t		sectionIndex[ELF32_WRITER_MAX_SECTIONS];
+	size_t		sectionOffset[ELF32_WRITER_MAX_SECTIONS];
+	size_t		relocationOffset[ELF32_WRITER_MAX_SECTIONS];
+	size_t		nameOffset[ELF32_WRITER_MAX_SECTIONS];
+	size_t		relocationNameOffset[ELF32_WRITER_MAX_SECTIONS];
+	size_t		outputSections = 1;
+	size_t		symtabIndex, strtabIndex, shstrtabIndex;
+	size_t		symtabOffset, strtabOffset, shstrtabOffset, headersOffset;
+	size_t		symtabSize = (object->sectionCount + 1) * 16;
+	size_t		shstrtabSize = 1;
+	size_t		symtabNameOffset, strtabNameOffset, shstrtabNameOffset;
+	size_t		fileSize;
+	size_t		offset;
+	uint8_t *	file;
+	uint8_t *	header;
+	bool		result = true;
+
+	if (object->failed)
+		return false;
+
+	// assign section indices and names
+	for (size_t i = 0; i < object->sectionCount; i++)
+	{
+		sectionIndex[i] = outputSections++;
+		nameOffset[i] = shstrtabSize;
+		shstrtabSize += strlen(object->sections[i].name) + 1;
+
+		if (object->sections[i].relocationCount > 0)
+		{
+			outputSections++;
+			relocationNameOffset[i] = shstrtabSize;
+			shstrtabSize += 4 + strlen(object->sections[i].name) + 1;
+		}
+	}
+	symtabIndex = outputSections++;
+	strtabIndex = outputSections++;
+	shstrtabIndex = outputSections++;
+	symtabNameOffset = shstrtabSize;
+	shstrtabSize += sizeof(".symtab");
+	strtabNameOffset = shstrtabSize;
+	shstrtabSize += sizeof(".strtab");
+	shstrtabNameOffset = shstrtabSize;
+	shstrtabSize += sizeof(".shstrtab");
+
+	// file layout
+	offset = 52; // sizeof(Elf32_Ehdr)
+	for (size_t i = 0; i < object->sectionCount; i++)
+	{
+		offset = alignOffset(offset, object->sections[i].alignment);
+		sectionOffset[i] = offset;
+		offset += object->sections[i].size;
+	}
+	for (size_t i = 0; i < object->sectionCount; i++)
+	{
+		if (object->sections[i].relocationCount == 0)
+			continue;
+		offset = alignOffset(offset, 4);
+		relocationOffset[i] = offset;
+		offset += object->sections[i].relocationCount * 8;
+	}
+	offset = alignOffset(offset, 4);
+	symtabOffset = offset;
+	offset += symtabSize;
+	strtabOffset = offset;
+	offset += 1;
+	shstrtabOffset = offset;
+	offset += shstrtabSize;
+	headersOffset = alignOffset(offset, 4);
+	fileSize = headersOffset + outputSections * 40;
+
+	if ((file = calloc(1, fileSize)) == NULL)
+		return false;
+
+	// ELF header
+	memcpy(file, ELFMAG, SELFMAG);
+	file[EI_CLASS] = ELFCLASS32;
+	file[EI_DATA] = (object->bigEndian ? ELFDATA2MSB : ELFDATA2LSB);
+	file[EI_VERSION] = EV_CURRENT;
+	file[EI_OSABI] = ELFOSABI_SYSV;
+	put16(file + 16, ET_REL, object->bigEndian);
+	put16(file + 18, object->machine, object->bigEndian);
+	put32(file + 20, EV_CURRENT, object->bigEndian);
+	put32(file + 32, (uint32_t) headersOffset, object->bigEndian);
+	put32(file + 36, object->flags, object->bigEndian);
+	put16(file + 40, 52, object->bigEndian);
+	put16(file + 46, 40, object->bigEndian);
+	put16(file + 48, (uint16_t) outputSections, object->bigEndian);
+	put16(file + 50, (uint16_t) shstrtabIndex, object->bigEndian);
+
+	// section content and relocations
+	for (size_t i = 0; i < object->sectionCount; i++)
+	{
+		struct elf32Section *	s = &object->sections[i];
+
+		if (s->size > 0)
+			memcpy(file + sectionOffset[i], s->data, s->size);
+
+		for (size_t r = 0; r < s->relocationCount; r++)
+		{
+			uint8_t *	entry = file + relocationOffset[i] + r * 8;
+			// symbol 0 is the null symbol, section symbols follow in section order
+			uint32_t	symbol = (uint32_t) s->relocations[r].target + 1;
+
+			put32(entry, s->relocations[r].offset, object->bigEndian);
+			put32(entry + 4, ELF32_R_INFO(symbol, object->relocationType), object->bigEndian);
+		}
+	}
+
+	// symbol table with the section symbols (all local, so sh_info is the symbol count)
+	for (size_t i = 0; i < object->sectionCount; i++)
+	{
+		uint8_t *	symbol = file + symtabOffset + (i + 1) * 16;
+
+		symbol[12] = ELF32_ST_INFO(STB_LOCAL, STT_SECTION);
+		put16(symbol + 14, (uint16_t) sectionIndex[i], object->bigEndian);
+	}
+
+	// section names
+	for (size_t i = 0; i < object->sectionCount; i++)
+	{
+		strcpy((char *) file + shstrtabOffset + nameOffset[i], object->sections[i].name);
+		if (object->sections[i].relocationCount > 0)
+		{
+			strcpy((char *) file + shstrtabOffset + relocationNameOffset[i], ".rel");
+			strcat((char *) file + shstrtabOffset + relocationNameOffset[i], object->sections[i].name);
+		}
+	}
+	strcpy((char *) file + shstrtabOffset + symtabNameOffset, ".symtab");
+	strcpy((char *) file + shstrtabOffset + strtabNameOffset, ".strtab");
+	strcpy((char *) file + shstrtabOffset + shstrtabNameOffset, ".shstrtab");
+
+	// section headers
+	header = file + headersOffset + 40; // first one is the NULL section
+	for (size_t i = 0; i < object->sectionCount; i++)
+	{
+		struct elf32Section *	s = &object->sections[i];
+
+		put32(header, (uint32_t) nameOffset[i], object->bigEndian);
+		put32(header + 4, SHT_PROGBITS, object->bigEndian);
+		put32(header + 8, s->flags, object->bigEndian);
+		put32(header + 16, (uint32_t) sectionOffset[i], object->bigEndian);
+		put32(header + 20, (uint32_t) s->size, object->bigEndian);
+		put32(header + 32, s->alignment, object->bigEndian);
+		header += 40;
+
+		if (s->relocationCount > 0)
+		{
+			put32(header, (uint32_t) relocationNameOffset[i], object->bigEndian);
+			put32(header + 4, SHT_REL, object->bigEndian);
+			put32(header + 8, SHF_INFO_LINK, object->bigEndian);
+			put32(header + 16, (uint32_t) relocationOffset[i], object->bigEndian);
+			put32(header + 20, (uint32_t) (s->relocationCount * 8), object->bigEndian);
+			put32(header + 24, (uint32_t) symtabIndex, object->bigEndian);
+			put32(header + 28, (uint32_t) sectionIndex[i], object->bigEndian);
+			put32(header + 32, 4, object->bigEndian);
+			put32(header + 36, 8, object->bigEndian);
+			header += 40;
+		}
+	}
+
+	put32(header, (uint32_t) symtabNameOffset, object->bigEndian);
+	put32(header + 4, SHT_SYMTAB, object->bigEndian);
+	put32(header + 16, (uint32_t) symtabOffset, object->bigEndian);
+	put32(header + 20, (uint32_t) symtabSize, object->bigEndian);
+	put32(header + 24, (uint32_t) strtabIndex, object->bigEndian);
+	put32(header + 28, (uint32_t) (object->sectionCount + 1), object->bigEndian);
+	put32(header + 32, 4, object->bigEndian);
+	put32(header + 36, 16, object->bigEndian);
+	header += 40;
+
+	put32(header, (uint32_t) strtabNameOffset, object->bigEndian);
+	put32(header + 4, SHT_STRTAB, object->bigEndian);
+	put32(header + 16, (uint32_t) strtabOffset, object->bigEndian);
+	put32(header + 20, 1, object->bigEndian);
+	put32(header + 32, 1, object->bigEndian);
+	header += 40;
+
+	put32(header, (uint32_t) shstrtabNameOffset, object->bigEndian);
+	put32(header + 4, SHT_STRTAB, object->bigEndian);
+	put32(header + 16, (uint32_t) shstrtabOffset, object->bigEndian);
+	put32(header + 20, (uint32_t) shstrtabSize, object->bigEndian);
+	put32(header + 32, 1, object->bigEndian);
+
+	for (offset = 0; offset < fileSize; )
+	{
+		ssize_t	written = write(fd, file + offset, fileSize - offset);
+
+		if (written <= 0)
+		{
+			if (written == -1 && errno == EINTR)
+				continue;
+			result = false;
+			break;
+		}
+		offset += written;
+	}
+
+	free(file);
+	return result;
+}
@@ -0,0 +1,54 @@
+// vi: set tabstop=4 syntax=c :
+#ifndef ELF32_WRITER_H
+#define ELF32_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+#define ELF32_WRITER_MAX_SECTIONS	8
+
+struct elf32Relocation
+{
+	uint32_t				offset;		// location within the section
+	size_t					target;		// index of the referenced section
+};
+
+struct elf32Section
+{
+	const char *			name;
+	uint32_t				flags;
+	uint32_t				alignment;
+	uint8_t *				data;
+	size_t					size;
+	size_t					allocated;
+	struct elf32Relocation *relocations;
+	size_t					relocationCount;
+	size_t					relocationsAllocated;
+};
+
+struct elf32Object
+{
+	bool					bigEndian;
+	uint16_t				machine;
+	uint32_t				flags;
+	uint32_t				relocationType;
+	struct elf32Section		sections[ELF32_WRITER_MAX_SECTIONS];
+	size_t					sectionCount;
+	bool					failed;		// set on any allocation error
+};
+
+void initElf32Object(struct elf32Object *object, bool bigEndian, uint16_t machine, uint32_t flags, uint32_t relocationType);
+void freeElf32Object(struct elf32Object *object);
+
+size_t addElf32Section(struct elf32Object *object, const char *name, uint32_t flags);
+void appendElf32Bytes(struct elf32Object *object, size_t section, const void *data, size_t size);
+void appendElf32Zeros(struct elf32Object *object, size_t section, size_t size);
+void alignElf32Section(struct elf32Object *object, size_t section, uint32_t alignment);
+void appendElf32Word(struct elf32Object *object, size_t section, uint32_t value);
+void appendElf32Pointer(struct elf32Object *object, size_t section, size_t target, uint32_t targetOffset);
+uint32_t getElf32SectionSize(struct elf32Object *object, size_t section);
+
+bool writeElf32Object(struct elf32Object *object, int fd);
+
+#endif
@@ -0,0 +1,200 @@
+#! /bin/sh
+#######################################################################################################
+#                                                                                                     #
+# compare the ELF object from 'avm_kernel_config.bin2asm -e' with the assembled source file output    #
+#                                                                                                     #
+# - for each config area dump, the source file is written by bin2asm, preprocessed with the macros    #
+#   from avm_kernel_config_macros.h and assembled for MIPS and ARM in the byte order of the dump      #
+# - the object file from '-e' (with the same machine and ELF header flags) has to be link-equivalent: #
+#   the same ELF class, byte order, machine and flags, the same allocated sections (type, flags,      #
+#   size, alignment and content), the same symbols and the same relocations                           #
+# - section indexes, file offsets, non-allocated sections (but relocations), the assembler's own      #
+#   metadata sections (register usage and ABI flags on MIPS) and the assembler local labels (.L...),   #
+#   which some assemblers keep in the symbol table, are ignored - they don't change the linked result  #
+#                                                                                                     #
+#######################################################################################################
+#                                                                                                     #
+# Copyright (C) 2026 YourFritz contributors                                                           #
+#                                                                                                     #
+# This program is free software; you can redistribute it and/or modify it under the terms of the GNU  #
+# General Public License as published by the Free Software Foundation; either version 2 of the        #
+# License, or (at your option) any later version.                                                     #
+#                                                                                                     #
+# This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without   #
+# even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU      #
+# General Public License under http://www.gnu.org/licenses/gpl-2.0.html for more details.             #
+#                                                                                                     #
+#######################################################################################################
+#                                                                                                     #
+# Usage: elf_compare.sh <config_area_dump> [ ... ]                                                    #
+#                                                                                                     #
+# The tool is expected in the same directory as this script, another location may be set with the     #
+# environment variable BIN2ASM. The preprocessor is called as "$CC -E" (gcc by default) and the       #
+# assembler is 'llvm-mc' (or LLVM_MC), because a single binary supports all four targets. 'readelf'   #
+# (or READELF) is used to dump the object files.                                                      #
+#                                                                                                     #
+# The differences are shown for each failed comparison, the exit code is 1, if any comparison failed. #
+#                                                                                                     #
+#######################################################################################################
+#                                                                                                     #
+# constants                                                                                           #
+#                                                                                                     #
+#######################################################################################################
+dir="${0%/*}"
+BIN2ASM="${BIN2ASM:-$dir/avm_kernel_config.bin2asm}"
+CC="${CC:-gcc}"
+LLVM_MC="${LLVM_MC:-llvm-mc}"
+READELF="${READELF:-readelf}"
+#######################################################################################################
+#                                                                                                     #
+# subfunctions                                                                                        #
+#                                                                                                     #
+#######################################################################################################
+usage()
+{
+	printf "Usage: %s <config_area_dump> [ ... ]\n" "${0##*/}" 1>&2
+	exit 2
+}
+fail()
+{
+	printf "%s\n" "$*" 1>&2
+	failed=1
+}
+#######################################################################################################
+#                                                                                                     #
+# write a normalized description of an object file to STDOUT                                          #
+#                                                                                                     #
+# $1 - object file                                                                                    #
+#                                                                                                     #
+#######################################################################################################
+describe()
+{
+	"$READELF" -hW "$1" | sed -n -e "s/^ *\(Class\|Data\|Type\|Machine\|Flags\): *\(.*\)\$/header \1 \2/p"
+	# sections: empty code/data sections from the assembler, non-allocated sections and the metadata
+	# of the assembler are skipped, the section of a relocation table is written by name instead of its
+	# index
+	"$READELF" -SW "$1" | sed -n -e "s/^ *\[ *\([0-9]*\)\] \(.*\)\$/\1 \2/p" | awk '
+		{
+			if (NF == 11) { flags = $8; info = $10; align = $11 } else { flags = ""; info = $9; align = $10 }
+			name[NR] = $2; type[NR] = $3; size[NR] = $6; entry[NR] = $7
+			flg[NR] = flags; inf[NR] = info; al[NR] = align; count = NR
+			number[$1] = NR
+		}
+		END {
+			for (i = 1; i <= count; i++)
+			{
+				if (type[i] == "MIPS_REGINFO" || type[i] == "MIPS_ABIFLAGS" || type[i] == "MIPS_OPTIONS") continue
+				if (size[i] == "000000" && (type[i] == "PROGBITS" || type[i] == "NOBITS")) continue
+				if (type[i] == "REL" || type[i] == "RELA")
+					printf "section %s %s %s %s for %s\n", name[i], type[i], size[i], entry[i], name[number[inf[i]]]
+				else if (flg[i] ~ /A/)
+					printf "section %s %s %s %s %s\n", name[i], type[i], size[i], flg[i], al[i]
+			}
+		}' | tee "$td/sections.txt"
+	"$READELF" -sW "$1" | awk '$1 ~ /^[0-9]+:$/ && $1 != "0:" && $8 !~ /^\.L/ { printf "symbol %s %s %s %s %s %s\n", $8, $2, $3, $4, $5, $6 }' | sort
+	"$READELF" -rW "$1" | awk '
+		/^Relocation section/ { section = $3; next }
+		$1 ~ /^[0-9a-f]+$/ && NF >= 5 { printf "relocation %s %s %s %s %s\n", section, $1, $3, $5, $6 }'
+	for section in $(sed -n -e "s/^section \([^ ]*\) PROGBITS .*\$/\1/p" "$td/sections.txt"); do
+		"$READELF" -x "$section" "$1" 2>/dev/null | sed -n -e "s/^ *\(0x[0-9a-f]* .*\)\$/content $section \1/p"
+	done
+}
+#######################################################################################################
+#                                                                                                     #
+# compare one dump for one machine                                                                    #
+#                                                                                                     #
+# $1 - config area dump                                                                               #
+# $2 - machine (mips or arm)                                                                          #
+# $3 - byte order (big or little)                                                                     #
+#                                                                                                     #
+#######################################################################################################
+compare()
+{
+	case "$2$3" in
+		(mipsbig)
+			triple="mips-linux-gnu"
+			;;
+		(mipslittle)
+			triple="mipsel-linux-gnu"
+			;;
+		(armbig)
+			triple="armeb-linux-gnueabi"
+			;;
+		(armlittle)
+			triple="arm-linux-gnueabi"
+			;;
+	esac
+	if ! "$BIN2ASM" "$1" >"$td/area.S"; then
+		fail "$1: bin2asm failed to write the source file"
+		return
+	fi
+	if ! "$CC" -E -P -x assembler-with-cpp -I"$dir" -o "$td/area.s" "$td/area.S"; then
+		fail "$1: preprocessing the source file failed"
+		return
+	fi
+	if ! "$LLVM_MC" -triple="$triple" -filetype=obj -o "$td/reference.o" "$td/area.s"; then
+		fail "$1: assembling the source file for $triple failed"
+		return
+	fi
+	flags=$("$READELF" -hW "$td/reference.o" | sed -n -e "s/^ *Flags: *\(0x[0-9a-fA-F]*\).*\$/\1/p")
+	if ! "$BIN2ASM" -e -m "$2" -F "$flags" "$1" >"$td/direct.o"; then
+		fail "$1: bin2asm failed to write the ELF object for $2"
+		return
+	fi
+	describe "$td/reference.o" >"$td/reference.txt"
+	describe "$td/direct.o" >"$td/direct.txt"
+	if ! diff -u "$td/reference.txt" "$td/direct.txt" >"$td/diff.txt"; then
+		fail "$1: the ELF object for $triple differs from the assembled source file"
+		cat "$td/diff.txt" 1>&2
+		return
+	fi
+	printf "%s: %s (%s) is link-equivalent, %u sections, %u relocations\n" "$1" "$2" "$3" \
+		$(grep -c "^section" "$td/direct.txt") $(grep -c "^relocation" "$td/direct.txt")
+}
+#######################################################################################################
+#                                                                                                     #
+# check parameters and tools                                                                          #
+#                                                                                                     #
+#######################################################################################################
+[ $# -eq 0 ] && usage
+for tool in "$BIN2ASM" "$LLVM_MC" "$READELF"; do
+	if ! command -v "$tool" >/dev/null 2>&1; then
+		printf "Missing tool '%s', set the corresponding variable to its location.\n" "$tool" 1>&2
+		exit 2
+	fi
+done
+td="$(mktemp -d)" || exit 1
+trap 'rm -r "$td"' EXIT
+failed=0
+#######################################################################################################
+#                                                                                                     #
+# the byte order is taken from the default ELF output, each dump is compared for both machines        #
+#                                                                                                     #
+#######################################################################################################
+for area in "$@"; do
+	if ! "$BIN2ASM" -e "$area" >"$td/probe.o"; then
+		fail "$area: bin2asm failed to write the ELF object"
+		continue
+	fi
+	case "$("$READELF" -hW "$td/probe.o" | sed -n -e "s/^ *Data: *.*\(big\|little\) endian\$/\1/p")" in
+		(big)
+			order=big
+			;;
+		(little)
+			order=little
+			;;
+		(*)
+			fail "$area: unknown byte order of the ELF object"
+			continue
+			;;
+	esac
+	for machine in mips arm; do
+		compare "$area" $machine $order
+	done
+done
+exit $failed
+#######################################################################################################
+#                                                                                                     #
+# end of script                                                                                       #
+#                                                                                                     #
+#######################################################################################################
@@ -21,6 +21,7 @@
  ***********************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <libfdt.h>
 
@@ -50,6 +51,7 @@ bool isConsistentConfigArea(void *configArea, size_t configSize, bool *swapNeede
 	struct _avm_kernel_config *	entry;
 
 	bool						assumeSwapped = false;
+	size_t						scanLimit = (configSize < 4096 ? configSize : 4096) / sizeof(uint32_t);
 
 	//	- a 32-bit value with more than one byte containing a non-zero value
 	//	  should be a pointer in the config area
@@ -61,16 +63,17 @@ bool isConsistentConfigArea(void *configArea, size_t configSize, bool *swapNeede
 	//	  reached the end of 'struct _avm_kernel_config' array, the tag at
 	//	  this array entry should be equal to avm_kernel_config_tags_last
 	//	- limit search to the first 4 KB as DTB and the config area array
-	//	  are located within the same 4 KB "segment"
+	//	  are located within the same 4 KB "segment" (or to the size of the
+	//	  area, if a shorter dump was provided)
 
 	ptr = (uint32_t *) configArea;
-	if (*ptr == 0) {
+	if (configSize < 4 * sizeof(uint32_t) || *ptr == 0) {
 		// 1st 32-bit word is the pointer to the config area array
 		// and is thus not allowed/expected to be NULL
 		return false;
 	}
 
-	while (++ptr < ((uint32_t *) configArea) + (4096 / sizeof(uint32_t)))
+	while (++ptr < ((uint32_t *) configArea) + scanLimit)
 	{
 		if (*ptr != 0)
 		{
@@ -149,16 +152,168 @@ bool isConsistentConfigArea(void *configArea, size_t configSize, bool *swapNeede
 	return true;
 }
 
+static bool extendUpTo(size_t *extent, char *areaStart, char *areaEnd, size_t configSize)
+{
+	if (areaEnd < areaStart || (size_t)(areaEnd - areaStart) > configSize)
+		return false;
+
+	if ((size_t)(areaEnd - areaStart) > *extent)
+		*extent = (size_t)(areaEnd - areaStart);
+
+	return true;
+}
+
+size_t determineConfigAreaExtent(void *configArea, size_t configSize)
+{
+	bool						swapNeeded;
+	uint32_t					kernelSegmentStart;
+	uint32_t					ptrValue;
+	uint32_t *					entry;
+	size_t						extent = 0;
+	char *						areaStart = (char *) configArea;
+
+	//	- the area isn't relocated yet, so all pointers and tags are still
+	//	  in target byte order and have to be converted on the fly
+	//	- the extent is the maximum of the end of the entry array, the end
+	//	  of each DTB (from its header), the end of the version info and
+	//	  the end of the module memory array and the strings it points to
+	//	- entries with other tags have an unknown size, the whole area
+	//	  is assumed to be needed then
+
+	if (!isConsistentConfigArea(configArea, configSize, &swapNeeded))
+		return 0;
+
+	ptrValue = *((uint32_t *)configArea);
+	swapEndianness(swapNeeded, &ptrValue);
+	kernelSegmentStart = determineConfigAreaKernelSegment(ptrValue);
+
+	for (entry = (uint32_t *) targetPtr2HostPtr(ptrValue, kernelSegmentStart, configArea); ; entry += 2)
+	{
+		uint32_t	tag = entry[0];
+		char *		config;
+
+		ptrValue = entry[1];
+		swapEndianness(swapNeeded, &tag);
+		swapEndianness(swapNeeded, &ptrValue);
+
+		if (ptrValue == 0)
+		{
+			// end of array, including the entry with avm_kernel_config_tags_last
+			if (!extendUpTo(&extent, areaStart, (char *) (entry + 2), configSize))
+				return 0;
+			break;
+		}
+
+		config = (char *) targetPtr2HostPtr(ptrValue, kernelSegmentStart, configArea);
+
+		if ((config + sizeof(struct fdt_header) <= areaStart + configSize) && (fdt_magic(config) == FDT_MAGIC) && (fdt_check_header(config) == 0))
+		{
+			if (!extendUpTo(&extent, areaStart, config + fdt_totalsize(config), configSize))
+				return 0;
+		}
+		else if (tag == avm_kernel_config_tags_version_info)
+		{
+			if (!extendUpTo(&extent, areaStart, config + sizeof(struct _avm_kernel_version_info), configSize))
+				return 0;
+		}
+		else if (tag == avm_kernel_config_tags_modulememory)
+		{
+			uint32_t *	module = (uint32_t *) config;
+
+			while (true)
+			{
+				char *	name;
+				char *	nameEnd;
+
+				if (!extendUpTo(&extent, areaStart, (char *) (module + 2), configSize))
+					return 0;
+
+				ptrValue = module[0];
+				swapEndianness(swapNeeded, &ptrValue);
+				if (ptrValue == 0)
+					break;
+
+				name = (char *) targetPtr2HostPtr(ptrValue, kernelSegmentStart, configArea);
+				if (name < areaStart || name >= areaStart + configSize)
+					return 0;
+
+				nameEnd = memchr(name, 0, configSize - (size_t)(name - areaStart));
+				if (nameEnd == NULL) // string isn't terminated within the area
+					return 0;
+
+				if (!extendUpTo(&extent, areaStart, nameEnd + 1, configSize))
+					return 0;
+
+				module += 2;
+			}
+		}
+		else
+		{
+			// unknown content, keep the whole area
+			return configSize;
+		}
+	}
+
+	// keep the last 32-bit word complete
+	extent = (extent + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+
+	return (extent > configSize ? configSize : extent);
+}
+
+void * findUnrelocatedEntry(void *configArea, size_t configSize, enum _avm_kernel_config_tags tag)
+{
+	bool						swapNeeded;
+	uint32_t					kernelSegmentStart;
+	uint32_t					ptrValue;
+	uint32_t *					entry;
+
+	// same as findEntryByTag, but usable on a config area, which wasn't relocated yet
+
+	if (!isConsistentConfigArea(configArea, configSize, &swapNeeded))
+		return NULL;
+
+	ptrValue = *((uint32_t *)configArea);
+	swapEndianness(swapNeeded, &ptrValue);
+	kernelSegmentStart = determineConfigAreaKernelSegment(ptrValue);
+
+	for (entry = (uint32_t *) targetPtr2HostPtr(ptrValue, kernelSegmentStart, configArea); entry[1] != 0; entry += 2)
+	{
+		uint32_t	entryTag = entry[0];
+
+		swapEndianness(swapNeeded, &entryTag);
+		if (entryTag == (uint32_t) tag)
+		{
+			ptrValue = entry[1];
+			swapEndianness(swapNeeded, &ptrValue);
+			return targetPtr2HostPtr(ptrValue, kernelSegmentStart, configArea);
+		}
+	}
+
+	return NULL;
+}
+
+static bool isInsideArea(void *configArea, size_t configSize, void *start, size_t size)
+{
+	char *	areaStart = (char *) configArea;
+	char *	ptr = (char *) start;
+
+	return (ptr >= areaStart && ptr <= areaStart + configSize && size <= (size_t)(areaStart + configSize - ptr));
+}
+
 struct _avm_kernel_config* * relocateConfigArea(void *configArea, size_t configSize)
 {
 	bool swapNeeded;
 	uint32_t kernelSegmentStart;
 	struct _avm_kernel_config * entry;
+	char * areaEnd = (char *) configArea + configSize;
 
 	//  - the configuration area is aligned on a 4K boundary and the first 32 bit contain a
 	//    pointer to an 'struct _avm_kernel_config' array
 	//  - we take the first 32 bit value from the dump and align this pointer to 4K to get
 	//    the start address of the area in the linked kernel
+	//  - each relocated pointer (and the data it points to, as far as its size is known) has
+	//    to be located within the area, otherwise NULL is returned and the area is left only
+	//    partially relocated - the caller has to discard it then
 
 	if (!isConsistentConfigArea(configArea, configSize, &swapNeeded))
 		return NULL;
@@ -167,6 +322,8 @@ struct _avm_kernel_config* * relocateConfigArea(void *configArea, size_t configS
 	kernelSegmentStart = determineConfigAreaKernelSegment(*((uint32_t *)configArea));
 
 	entry = (struct _avm_kernel_config *) targetPtr2HostPtr(*((uint32_t *)configArea), kernelSegmentStart, configArea);
+	if (!isInsideArea(configArea, configSize, entry, sizeof(struct _avm_kernel_config)))
+		return NULL;
 	*((struct _avm_kernel_config **)configArea) = entry;
 
 	swapEndianness(swapNeeded, &entry->tag);
@@ -175,23 +332,45 @@ struct _avm_kernel_config* * relocateConfigArea(void *configArea, size_t configS
 	{
 		swapEndianness(swapNeeded, (uint32_t *) &entry->config);
 		entry->config = (void *) targetPtr2HostPtr((uint32_t)entry->config, kernelSegmentStart, configArea);
+		if (!isInsideArea(configArea, configSize, entry->config, 1))
+			return NULL;
 
 		if ((int) entry->tag == avm_kernel_config_tags_modulememory)
 		{
 			// only _kernel_modulmemory_config entries need relocation of members
 			struct _kernel_modulmemory_config * module = (struct _kernel_modulmemory_config *) entry->config;
 
-			while (module->name != NULL)
+			while (true)
 			{
+				if (!isInsideArea(configArea, configSize, module, sizeof(struct _kernel_modulmemory_config)))
+					return NULL;
+				if (module->name == NULL)
+					break;
+
 				swapEndianness(swapNeeded, (uint32_t *) &module->name);
 				module->name = (char *) targetPtr2HostPtr((uint32_t)module->name, kernelSegmentStart, configArea);
+				if (!isInsideArea(configArea, configSize, module->name, 1) || memchr(module->name, 0, areaEnd - module->name) == NULL)
+					return NULL;
 				swapEndianness(swapNeeded, &module->size);
 
 				module++;
 			}
 		}
+		else if ((int) entry->tag == avm_kernel_config_tags_version_info)
+		{
+			if (!isInsideArea(configArea, configSize, entry->config, sizeof(struct _avm_kernel_version_info)))
+				return NULL;
+		}
+		else if (isInsideArea(configArea, configSize, entry->config, sizeof(struct fdt_header)) && fdt_magic(entry->config) == FDT_MAGIC)
+		{
+			// users read the whole BLOB, if it's a valid one
+			if (!isInsideArea(configArea, configSize, entry->config, fdt_totalsize(entry->config)))
+				return NULL;
+		}
 
 		entry++;
+		if (!isInsideArea(configArea, configSize, entry, sizeof(struct _avm_kernel_config)))
+			return NULL;
 		swapEndianness(swapNeeded, &entry->tag);
 	}
 
@@ -230,3 +409,208 @@ bool isDeviceTreeEntry(struct _avm_kernel_config* entry)
 	// entry->config is assumed to be already relocated
 	return (fdt_magic(entry->config) == FDT_MAGIC) && (fdt_check_header(entry->config) == 0);
 }
+
+static void * configAreaBeforeDeviceTree(void *kernelBuffer, size_t kernelSize, char *dtbLocation, uint32_t kernelLoadAddr, size_t *size)
+{
+	uint32_t					kernelSegmentStart;
+	char *						configArea;
+	size_t						remaining;
+
+	// the same computation as in 'findConfigArea' of the extract tool, but
+	// the window is limited to the end of the kernel buffer
+	kernelSegmentStart = determineConfigAreaKernelSegment(kernelLoadAddr + (uint32_t)(dtbLocation - (char *) kernelBuffer));
+	configArea = (char *) targetPtr2HostPtr(kernelSegmentStart, kernelLoadAddr, kernelBuffer);
+	if (configArea < (char *) kernelBuffer || configArea >= dtbLocation)
+		return NULL;
+
+	remaining = (char *) kernelBuffer + kernelSize - configArea;
+	if (*size > remaining)
+		*size = remaining;
+
+	return (isConsistentConfigArea(configArea, *size, NULL) ? configArea : NULL);
+}
+
+bool hasValidDeviceTree(void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, void *configArea, size_t configSize)
+{
+	bool						swapNeeded;
+	uint32_t					kernelSegmentStart;
+	uint32_t					ptrValue;
+	uint32_t *					entry;
+	char *						areaStart = (char *) configArea;
+
+	//	- the same check as for the candidates of 'locateAvmKernelConfig', but
+	//	  for an area at a known offset (e.g. from a hints file): an entry has
+	//	  to point to a DTB with a valid header and the config area in front
+	//	  of this DTB has to be the specified one
+	//	- 'configSize' may not exceed the end of the kernel buffer
+
+	if (!isConsistentConfigArea(configArea, configSize, &swapNeeded))
+		return false;
+
+	ptrValue = *((uint32_t *)configArea);
+	swapEndianness(swapNeeded, &ptrValue);
+	kernelSegmentStart = determineConfigAreaKernelSegment(ptrValue);
+
+	for (entry = (uint32_t *) targetPtr2HostPtr(ptrValue, kernelSegmentStart, configArea); entry[1] != 0; entry += 2)
+	{
+		char *	config;
+		size_t	size = configSize;
+
+		ptrValue = entry[1];
+		swapEndianness(swapNeeded, &ptrValue);
+		config = (char *) targetPtr2HostPtr(ptrValue, kernelSegmentStart, configArea);
+
+		if ((config + sizeof(struct fdt_header) > areaStart + configSize) || (fdt_magic(config) != FDT_MAGIC) || (fdt_check_header(config) != 0))
+			continue;
+
+		if (configAreaBeforeDeviceTree(kernelBuffer, kernelSize, config, kernelLoadAddr, &size) == configArea)
+			return true;
+	}
+
+	return false;
+}
+
+enum avmKernelConfigResult locateAvmKernelConfig(void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, size_t windowSize, void **configArea, size_t *configSize, size_t *rejected)
+{
+	char *						end;
+
+	if (kernelBuffer == NULL || configArea == NULL || windowSize == 0)
+		return avmKernelConfigInvalidArgument;
+
+	//	- each FDT signature is a candidate, the first one with a consistent
+	//	  config area in front of it is used
+	//	- the size is the used extent of the area, if it can be determined,
+	//	  and the (limited) window size otherwise
+	//	- the number of signatures without a config area is returned in
+	//	  'rejected', if the caller wants to know it
+
+	end = (char *) kernelBuffer + (kernelSize & ~(sizeof(uint32_t) - 1));
+	for (char *ptr = (char *) kernelBuffer; ptr + sizeof(struct fdt_header) <= end; ptr += 4)
+	{
+		size_t	size = windowSize;
+		size_t	extent;
+		void *	area;
+
+		if ((fdt_magic(ptr) != FDT_MAGIC) || (fdt_check_header(ptr) != 0))
+			continue;
+
+		if ((area = configAreaBeforeDeviceTree(kernelBuffer, kernelSize, ptr, kernelLoadAddr, &size)) == NULL)
+		{
+			if (rejected)
+				(*rejected)++;
+			continue;
+		}
+
+		extent = determineConfigAreaExtent(area, size);
+
+		*configArea = area;
+		if (configSize)
+			*configSize = (extent > 0 ? extent : size);
+
+		return avmKernelConfigOk;
+	}
+
+	return avmKernelConfigNotFound;
+}
+
+void initAvmKernelConfigContext(struct avmKernelConfigContext *context)
+{
+	memset(context, 0, sizeof(struct avmKernelConfigContext));
+	context->lastResult = avmKernelConfigNotLoaded;
+}
+
+void freeAvmKernelConfigContext(struct avmKernelConfigContext *context)
+{
+	free(context->buffer);
+	initAvmKernelConfigContext(context);
+}
+
+enum avmKernelConfigResult loadAvmKernelConfig(struct avmKernelConfigContext *context, const void *configArea, size_t configSize)
+{
+	void *						buffer;
+	bool						swapNeeded;
+
+	if (context == NULL)
+		return avmKernelConfigInvalidArgument;
+
+	freeAvmKernelConfigContext(context);
+
+	if (configArea == NULL || configSize == 0)
+		return (context->lastResult = avmKernelConfigInvalidArgument);
+
+	// the area is relocated in place, so the caller's buffer is copied first
+	if ((buffer = malloc(configSize)) == NULL)
+		return (context->lastResult = avmKernelConfigNoMemory);
+	memcpy(buffer, configArea, configSize);
+
+	if (!isConsistentConfigArea(buffer, configSize, &swapNeeded))
+	{
+		free(buffer);
+		return (context->lastResult = avmKernelConfigInconsistent);
+	}
+
+	// a pointer outside of the area is an inconsistency, too
+	if ((context->configArea = relocateConfigArea(buffer, configSize)) == NULL)
+	{
+		free(buffer);
+		return (context->lastResult = avmKernelConfigInconsistent);
+	}
+
+	context->buffer = buffer;
+	context->size = configSize;
+	context->swapNeeded = swapNeeded;
+
+	return (context->lastResult = avmKernelConfigOk);
+}
+
+enum avmKernelConfigResult extractAvmKernelConfig(struct avmKernelConfigContext *context, void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, size_t windowSize)
+{
+	enum avmKernelConfigResult	result;
+	void *						configArea;
+	size_t						configSize;
+
+	if (context == NULL)
+		return avmKernelConfigInvalidArgument;
+
+	if ((result = locateAvmKernelConfig(kernelBuffer, kernelSize, kernelLoadAddr, windowSize, &configArea, &configSize, NULL)) != avmKernelConfigOk)
+	{
+		freeAvmKernelConfigContext(context);
+		return (context->lastResult = result);
+	}
+
+	return loadAvmKernelConfig(context, configArea, configSize);
+}
+
+struct _avm_kernel_config* getAvmKernelConfigEntry(struct avmKernelConfigContext *context, enum _avm_kernel_config_tags tag)
+{
+	if (context == NULL || context->configArea == NULL)
+		return NULL;
+
+	return findEntryByTag(context->configArea, tag);
+}
+
+const char * avmKernelConfigResultText(enum avmKernelConfigResult result)
+{
+	switch (result)
+	{
+		case avmKernelConfigOk:
+			return "success";
+
+		case avmKernelConfigInvalidArgument:
+			return "invalid argument";
+
+		case avmKernelConfigNoMemory:
+			return "out of memory";
+
+		case avmKernelConfigNotFound:
+			return "no config area found";
+
+		case avmKernelConfigInconsistent:
+			return "inconsistent config area";
+
+		case avmKernelConfigNotLoaded:
+			return "no config area loaded";
+	}
+
+	return "unknown error";
+}
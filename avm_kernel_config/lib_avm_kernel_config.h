@@ -3,6 +3,7 @@
 #define LIB_AVM_KERNEL_CONFIG_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <inttypes.h>
 
 #ifdef USE_STRIPPED_AVM_KERNEL_CONFIG_H
@@ -11,7 +12,53 @@
 #include "linux/include/uapi/linux/avm_kernel_config.h"
 #endif
 
+//	The config area is accessed through the structures from the kernel's
+//	'avm_kernel_config.h' and the relocated pointers are stored in place of
+//	the 32-bit target pointers, so the library (and each program using it)
+//	has to be built for a host with 32-bit pointers ('-m32' like in the
+//	Makefile) - the layout of these structures doesn't match otherwise.
+//
+//	'relocateConfigArea' returns NULL, if any pointer (or the data it points
+//	to, if its size is known) isn't located within the area, the buffer is
+//	only partially relocated then and has to be discarded.
+
+//	Results of the context based functions, the context keeps a private
+//	(relocated) copy of the config area, so any number of contexts may be
+//	used concurrently from different threads, as long as each context is
+//	used by only one thread at a time. All other functions work only on the
+//	buffers specified by the caller and don't use any global state.
+
+enum avmKernelConfigResult
+{
+	avmKernelConfigOk,
+	avmKernelConfigInvalidArgument,
+	avmKernelConfigNoMemory,
+	avmKernelConfigNotFound,
+	avmKernelConfigInconsistent,
+	avmKernelConfigNotLoaded,
+};
+
+struct avmKernelConfigContext
+{
+	void *							buffer;
+	size_t							size;
+	bool							swapNeeded;
+	struct _avm_kernel_config * *	configArea;
+	enum avmKernelConfigResult		lastResult;
+};
+
+void initAvmKernelConfigContext(struct avmKernelConfigContext *context);
+void freeAvmKernelConfigContext(struct avmKernelConfigContext *context);
+enum avmKernelConfigResult loadAvmKernelConfig(struct avmKernelConfigContext *context, const void *configArea, size_t configSize);
+enum avmKernelConfigResult extractAvmKernelConfig(struct avmKernelConfigContext *context, void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, size_t windowSize);
+enum avmKernelConfigResult locateAvmKernelConfig(void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, size_t windowSize, void **configArea, size_t *configSize, size_t *rejected);
+struct _avm_kernel_config* getAvmKernelConfigEntry(struct avmKernelConfigContext *context, enum _avm_kernel_config_tags tag);
+const char * avmKernelConfigResultText(enum avmKernelConfigResult result);
+
 bool isConsistentConfigArea(void *configArea, size_t configSize, bool *swapNeeded);
+size_t determineConfigAreaExtent(void *configArea, size_t configSize);
+void * findUnrelocatedEntry(void *configArea, size_t configSize, enum _avm_kernel_config_tags tag);
+bool hasValidDeviceTree(void *kernelBuffer, size_t kernelSize, uint32_t kernelLoadAddr, void *configArea, size_t configSize);
 struct _avm_kernel_config* * relocateConfigArea(void *configArea, size_t configSize);
 
 uint32_t determineConfigAreaKernelSegment(uint32_t targetAddressSpacePtr);
@@ -20,39 +20,170 @@
  *                                                                     *
  ***********************************************************************/
 
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <inttypes.h>
 
 #include "memory_mapped_file.h"
 
-bool openMemoryMappedFile(struct memoryMappedFile *file, const char *fileName, const char *fileDescription, int openFlags, int prot, int flags)
+#define READ_BUFFER_INITIAL_SIZE	(1024 * 1024)
+
+//	- regular files are mapped into memory, the access hints are passed
+//	  to the kernel after mapping
+//	- a file name of "-" means STDIN, the content of STDIN, a pipe or any
+//	  other file, which can't be mapped, is read into a growing buffer, the
+//	  caller gets the same structure and may use 'fileBuffer' and 'fileSize'
+//	  without knowing, how the data was provided
+//	- a shared writable mapping is not possible for such files, the call
+//	  fails then
+
+static bool readWholeFile(struct memoryMappedFile *file)
+{
+	size_t			allocated = READ_BUFFER_INITIAL_SIZE;
+	size_t			used = 0;
+	char *			buffer;
+
+	if (S_ISREG(file->fileStat.st_mode) && file->fileStat.st_size > 0 && (uint64_t) file->fileStat.st_size < SIZE_MAX)
+		allocated = (size_t) file->fileStat.st_size + 1;
+
+	if ((buffer = malloc(allocated)) == NULL)
+	{
+		fprintf(stderr, "Error allocating %zu bytes for %s file '%s'.\n", allocated, file->fileDescription, file->fileName);
+		return false;
+	}
+
+	while (true)
+	{
+		ssize_t		got;
+
+		if (used == allocated)
+		{
+			size_t	newAllocated = allocated * 2;
+			char *	newBuffer;
+
+			if (newAllocated < allocated || (newBuffer = realloc(buffer, newAllocated)) == NULL)
+			{
+				fprintf(stderr, "Error allocating %zu bytes for %s file '%s'.\n", newAllocated, file->fileDescription, file->fileName);
+				free(buffer);
+				return false;
+			}
+			buffer = newBuffer;
+			allocated = newAllocated;
+		}
+
+		if ((got = read(file->fileDescriptor, buffer + used, allocated - used)) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "Error %d reading %s file '%s'.\n", errno, file->fileDescription, file->fileName);
+			free(buffer);
+			return false;
+		}
+		if (got == 0)
+			break;
+		used += got;
+	}
+
+	file->fileBuffer = buffer;
+	file->fileSize = used;
+	file->fileRead = true;
+
+	return true;
+}
+
+static void adviseAccess(struct memoryMappedFile *file, int hints)
+{
+	if (file->fileSize == 0)
+		return;
+
+#ifdef MADV_SEQUENTIAL
+	if (hints & memoryMappedFileSequential)
+		madvise(file->fileBuffer, file->fileSize, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+	if (hints & memoryMappedFileWillNeed)
+		madvise(file->fileBuffer, file->fileSize, MADV_WILLNEED);
+#endif
+#ifdef MADV_HUGEPAGE
+	if (hints & memoryMappedFileHugePages)
+		madvise(file->fileBuffer, file->fileSize, MADV_HUGEPAGE);
+#endif
+}
+
+bool openMemoryMappedFile(struct memoryMappedFile *file, const char *fileName, const char *fileDescription, int openFlags, int prot, int flags, int hints)
 {
 	bool			result = false;
+	bool			useStdin = (strcmp(fileName, "-") == 0);
 
 	file->fileMapped = false;
+	file->fileRead = false;
 	file->fileBuffer = NULL;
-	file->fileName = fileName;
+	file->fileSize = 0;
+	file->fileName = (useStdin ? "STDIN" : fileName);
 	file->fileDescription = fileDescription;
 
-	if ((file->fileDescriptor = open(file->fileName, openFlags)) != -1)
+	if ((file->fileDescriptor = (useStdin ? STDIN_FILENO : open(file->fileName, openFlags))) != -1)
 	{
 		if (fstat(file->fileDescriptor, &file->fileStat) != -1)
 		{
-			if ((file->fileBuffer = (void *) mmap(NULL, file->fileStat.st_size, prot, flags, file->fileDescriptor, 0)) != MAP_FAILED)
+			bool	mappable = S_ISREG(file->fileStat.st_mode) && file->fileStat.st_size > 0;
+
+			if (mappable && (uint64_t) file->fileStat.st_size > SIZE_MAX)
 			{
-				file->fileMapped = true;
-				result = true;
+				fprintf(stderr, "The %s file '%s' is too large (%" PRIu64 " bytes) to be mapped into memory.\n", file->fileDescription, file->fileName, (uint64_t) file->fileStat.st_size);
+			}
+			else if (mappable)
+			{
+				int		mapFlags = flags;
+
+#ifdef MAP_POPULATE
+				if (hints & memoryMappedFilePopulate)
+					mapFlags |= MAP_POPULATE;
+#endif
+				file->fileSize = (size_t) file->fileStat.st_size;
+				if ((file->fileBuffer = (void *) mmap(NULL, file->fileSize, prot, mapFlags, file->fileDescriptor, 0)) != MAP_FAILED)
+				{
+					file->fileMapped = true;
+					adviseAccess(file, hints);
+					result = true;
+				}
+				else
+				{
+					file->fileBuffer = NULL;
+					// some special files (e.g. in /proc) look like regular ones, but can't be mapped
+					if ((errno == ENODEV || errno == EINVAL) && !((prot & PROT_WRITE) && (flags & MAP_SHARED)))
+						result = readWholeFile(file);
+					else
+						fprintf(stderr, "Error %d mapping %zu bytes of %s file '%s' to memory.\n", errno, file->fileSize, file->fileDescription, file->fileName);
+				}
+			}
+			else if ((prot & PROT_WRITE) && (flags & MAP_SHARED))
+			{
+				fprintf(stderr, "The %s file '%s' can't be changed, because it's not a regular file.\n", file->fileDescription, file->fileName);
+			}
+			else
+			{
+				result = readWholeFile(file);
 			}
-			else fprintf(stderr, "Error %d mapping %u bytes of %s file '%s' to memory.\n", errno, (int) file->fileStat.st_size, file->fileDescription, file->fileName);
 		}
 		else fprintf(stderr, "Error %d getting file stats for '%s'.\n", errno, file->fileName);
 
 		if (result == false)
 		{
-			close(file->fileDescriptor);
+			if (!useStdin)
+				close(file->fileDescriptor);
+			file->fileDescriptor = -1;
+		}
+		else if (useStdin)
+		{
+			// STDIN isn't closed later
 			file->fileDescriptor = -1;
 		}
 	}
@@ -65,11 +196,18 @@ void closeMemoryMappedFile(struct memoryMappedFile *file)
 {
 	if (file->fileMapped)
 	{
-		munmap(file->fileBuffer, file->fileStat.st_size);
+		munmap(file->fileBuffer, file->fileSize);
 		file->fileBuffer = NULL;
 		file->fileMapped = false;
 	}
 
+	if (file->fileRead)
+	{
+		free(file->fileBuffer);
+		file->fileBuffer = NULL;
+		file->fileRead = false;
+	}
+
 	if (file->fileDescriptor != -1)
 	{
 		close(file->fileDescriptor);
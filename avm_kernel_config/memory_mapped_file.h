@@ -3,6 +3,11 @@
 #define MEMORY_MAPPED_FILE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+
+// 'struct stat' is part of the structure below, so all users have to agree on its
+// layout - with '-m32' the files have to be compiled with -D_FILE_OFFSET_BITS=64,
+// otherwise files above 2 GB can't be opened and their size can't be checked
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -10,6 +15,17 @@
 
 #include <sys/mman.h>
 
+// access hints, they're only advisory and ignored, if not supported
+
+enum memoryMappedFileHints
+{
+	memoryMappedFileNoHints = 0,
+	memoryMappedFileSequential = 1,		// MADV_SEQUENTIAL
+	memoryMappedFileWillNeed = 2,		// MADV_WILLNEED
+	memoryMappedFilePopulate = 4,		// MAP_POPULATE
+	memoryMappedFileHugePages = 8,		// MADV_HUGEPAGE
+};
+
 struct memoryMappedFile
 {
 	const char *		fileName;
@@ -17,10 +33,12 @@ struct memoryMappedFile
 	int					fileDescriptor;
 	struct stat			fileStat;
 	void *				fileBuffer;
+	size_t				fileSize;		// use this instead of fileStat.st_size, it's valid for streamed input, too
 	bool				fileMapped;
+	bool				fileRead;		// content was read into an allocated buffer (pipe or STDIN)
 };
 
-bool openMemoryMappedFile(struct memoryMappedFile *file, const char *fileName, const char *fileDescription, int openFlags, int prot, int flags);
+bool openMemoryMappedFile(struct memoryMappedFile *file, const char *fileName, const char *fileDescription, int openFlags, int prot, int flags, int hints);
 void closeMemoryMappedFile(struct memoryMappedFile *file);
 
 #endif
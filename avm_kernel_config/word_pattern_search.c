@@ -0,0 +1,307 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "word_pattern_search.h"
+
+//	Aho-Corasick automaton over 32-bit words:
+//
+//	- patterns (DTBs) and the haystack (kernel) are compared as aligned
+//	  32-bit words, so a single pass over the haystack finds all patterns
+//	- the (sparse) goto function is stored in an open addressing hash
+//	  table keyed by the pair (state, word)
+//	- a pattern, whose size isn't a multiple of 4, is entered with its
+//	  complete words only and the remaining bytes are compared after a
+//	  match of this prefix
+
+struct automatonEdge
+{
+	uint32_t			state;		// 0 means unused slot (root has no incoming edges)
+	uint32_t			word;
+	uint32_t			target;
+};
+
+struct automatonState
+{
+	uint32_t			failure;
+	uint32_t			output;		// nearest state with pattern(s) ending there or 0
+	int32_t				pattern;	// index of a pattern ending at this state or -1
+	int32_t				nextSame;	// next pattern with identical word prefix or -1
+	uint32_t			depth;
+};
+
+struct automaton
+{
+	struct automatonState *	states;
+	size_t					stateCount;
+	struct automatonEdge *	edges;
+	size_t					edgeMask;
+	int32_t *				samePrefix;	// chains patterns with identical word prefixes
+};
+
+static size_t hashEdge(uint32_t state, uint32_t word, size_t mask)
+{
+	uint32_t	hash = (state * 0x9E3779B1) ^ (word * 0x85EBCA77);
+
+	hash ^= hash >> 15;
+	return (size_t) hash & mask;
+}
+
+static uint32_t getTransition(struct automaton *ac, uint32_t state, uint32_t word)
+{
+	size_t		slot = hashEdge(state + 1, word, ac->edgeMask);
+
+	while (ac->edges[slot].state != 0)
+	{
+		if (ac->edges[slot].state == state + 1 && ac->edges[slot].word == word)
+			return ac->edges[slot].target;
+
+		slot = (slot + 1) & ac->edgeMask;
+	}
+
+	return 0;
+}
+
+static void setTransition(struct automaton *ac, uint32_t state, uint32_t word, uint32_t target)
+{
+	size_t		slot = hashEdge(state + 1, word, ac->edgeMask);
+
+	while (ac->edges[slot].state != 0)
+		slot = (slot + 1) & ac->edgeMask;
+
+	ac->edges[slot].state = state + 1;
+	ac->edges[slot].word = word;
+	ac->edges[slot].target = target;
+}
+
+static bool buildAutomaton(struct automaton *ac, struct wordPattern *patterns, size_t count)
+{
+	size_t		totalWords = 0;
+	size_t		edgeSlots = 16;
+
+	for (size_t p = 0; p < count; p++)
+		totalWords += patterns[p].size / sizeof(uint32_t);
+
+	while (edgeSlots < totalWords * 2)
+		edgeSlots <<= 1;
+
+	ac->states = calloc(totalWords + 1, sizeof(struct automatonState));
+	ac->edges = calloc(edgeSlots, sizeof(struct automatonEdge));
+	ac->samePrefix = malloc(count * sizeof(int32_t));
+	ac->edgeMask = edgeSlots - 1;
+	ac->stateCount = 1;
+
+	if (ac->states == NULL || ac->edges == NULL || ac->samePrefix == NULL)
+		return false;
+
+	ac->states[0].pattern = -1;
+
+	// goto function
+	for (size_t p = 0; p < count; p++)
+	{
+		const uint32_t *	word = patterns[p].data;
+		size_t				words = patterns[p].size / sizeof(uint32_t);
+		uint32_t			state = 0;
+
+		if (words == 0)
+		{
+			ac->samePrefix[p] = -1;
+			continue;
+		}
+
+		for (size_t w = 0; w < words; w++)
+		{
+			uint32_t	next = getTransition(ac, state, word[w]);
+
+			if (next == 0)
+			{
+				next = ac->stateCount++;
+				ac->states[next].pattern = -1;
+				ac->states[next].depth = ac->states[state].depth + 1;
+				setTransition(ac, state, word[w], next);
+			}
+			state = next;
+		}
+
+		ac->samePrefix[p] = ac->states[state].pattern;
+		ac->states[state].pattern = (int32_t) p;
+	}
+
+	// failure and output links - a state's failure link always points to a state with lower
+	// depth, so processing all states in order of depth (breadth-first) is sufficient and
+	// they're collected per depth with a counting sort
+	{
+		size_t *	depthCount;
+		uint32_t *	byDepth;
+		uint32_t	maxDepth = 0;
+
+		for (size_t s = 1; s < ac->stateCount; s++)
+		{
+			if (ac->states[s].depth > maxDepth)
+				maxDepth = ac->states[s].depth;
+		}
+
+		depthCount = calloc(maxDepth + 2, sizeof(size_t));
+		byDepth = malloc(ac->stateCount * sizeof(uint32_t));
+		if (depthCount == NULL || byDepth == NULL)
+		{
+			free(depthCount);
+			free(byDepth);
+			return false;
+		}
+
+		for (size_t s = 1; s < ac->stateCount; s++)
+			depthCount[ac->states[s].depth + 1]++;
+		for (uint32_t d = 1; d <= maxDepth + 1; d++)
+			depthCount[d] += depthCount[d - 1];
+		for (size_t s = 1; s < ac->stateCount; s++)
+			byDepth[depthCount[ac->states[s].depth]++] = (uint32_t) s;
+
+		free(depthCount);
+
+		// each state got its number while inserting, so its parent and the word leading to
+		// it are found by walking the edge table once
+		for (size_t slot = 0; slot <= ac->edgeMask; slot++)
+		{
+			struct automatonEdge *	edge = &ac->edges[slot];
+
+			if (edge->state == 0)
+				continue;
+
+			// temporarily use 'output' as parent and 'failure' as incoming word storage
+			ac->states[edge->target].output = edge->state - 1;
+			ac->states[edge->target].failure = edge->word;
+		}
+
+		for (size_t i = 0; i < ac->stateCount - 1; i++)
+		{
+			uint32_t	state = byDepth[i];
+			uint32_t	parent = ac->states[state].output;
+			uint32_t	word = ac->states[state].failure;
+			uint32_t	failure = 0;
+
+			if (parent != 0)
+			{
+				uint32_t	candidate = ac->states[parent].failure;
+
+				while (true)
+				{
+					if ((failure = getTransition(ac, candidate, word)) != 0)
+						break;
+					if (candidate == 0)
+						break;
+					candidate = ac->states[candidate].failure;
+				}
+			}
+
+			ac->states[state].failure = failure;
+			ac->states[state].output = (ac->states[failure].pattern >= 0 ? failure : ac->states[failure].output);
+		}
+
+		free(byDepth);
+	}
+
+	return true;
+}
+
+static void freeAutomaton(struct automaton *ac)
+{
+	free(ac->states);
+	free(ac->edges);
+	free(ac->samePrefix);
+}
+
+static size_t reportMatches(struct wordPattern *patterns, struct automaton *ac, int32_t pattern, const uint32_t *end, const uint8_t *haystackEnd)
+{
+	size_t		found = 0;
+
+	for (; pattern >= 0; pattern = ac->samePrefix[pattern])
+	{
+		struct wordPattern *	p = &patterns[pattern];
+		size_t					words = p->size / sizeof(uint32_t);
+		size_t					tail = p->size % sizeof(uint32_t);
+		const uint8_t *			start = (const uint8_t *) (end - words);
+
+		if (p->location != NULL)
+			continue;
+
+		if (tail > 0)
+		{
+			if ((const uint8_t *) end + tail > haystackEnd)
+				continue;
+			if (memcmp(end, (const uint8_t *) p->data + words * sizeof(uint32_t), tail) != 0)
+				continue;
+		}
+
+		p->location = (void *) start;
+		found++;
+	}
+
+	return found;
+}
+
+bool findWordPatterns(const void *haystack, size_t haystackSize, struct wordPattern *patterns, size_t count)
+{
+	struct automaton	ac = { NULL, 0, NULL, 0, NULL };
+	const uint32_t *	sliding = haystack;
+	const uint32_t *	end = sliding + (haystackSize / sizeof(uint32_t));
+	const uint8_t *		haystackEnd = (const uint8_t *) haystack + haystackSize;
+	size_t				remaining = 0;
+	uint32_t			state = 0;
+
+	for (size_t p = 0; p < count; p++)
+	{
+		patterns[p].location = NULL;
+		// patterns shorter than a word can't be entered into the automaton
+		if (patterns[p].size >= sizeof(uint32_t))
+			remaining++;
+	}
+
+	if (!buildAutomaton(&ac, patterns, count))
+	{
+		freeAutomaton(&ac);
+		return false;
+	}
+
+	while (sliding < end && remaining > 0)
+	{
+		uint32_t	word = *sliding++;
+		uint32_t	next;
+
+		while ((next = getTransition(&ac, state, word)) == 0 && state != 0)
+			state = ac.states[state].failure;
+		state = next;
+
+		if (state == 0)
+			continue;
+
+		if (ac.states[state].pattern >= 0)
+			remaining -= reportMatches(patterns, &ac, ac.states[state].pattern, sliding, haystackEnd);
+
+		for (uint32_t out = ac.states[state].output; out != 0 && remaining > 0; out = ac.states[out].output)
+			remaining -= reportMatches(patterns, &ac, ac.states[out].pattern, sliding, haystackEnd);
+	}
+
+	freeAutomaton(&ac);
+	return true;
+}
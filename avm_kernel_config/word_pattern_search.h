@@ -0,0 +1,18 @@
+// vi: set tabstop=4 syntax=c :
+#ifndef WORD_PATTERN_SEARCH_H
+#define WORD_PATTERN_SEARCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+struct wordPattern
+{
+	const void *		data;
+	size_t				size;
+	void *				location;	// first match in haystack or NULL
+};
+
+bool findWordPatterns(const void *haystack, size_t haystackSize, struct wordPattern *patterns, size_t count);
+
+#endif
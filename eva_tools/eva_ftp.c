@@ -0,0 +1,719 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <netdb.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+//	Client for the FTP server in AVM's bootloader (EVA), it supports the
+//	same commands as 'EVA_FTP.cs' and the shell scripts in this folder:
+//
+//	- login with USER/PASS, check the SYST response for "AVM EVA"
+//	- TYPE, MEDIA (SDRAM or FLSH) and P@SW (or PASV) are sent at once,
+//	  their responses are read afterwards (pipelining)
+//	- RETR data is written to a file descriptor (STDOUT for pipes into
+//	  other tools) while it's received
+//	- STOR data is sent from a memory mapped image file
+//	- GETENV, SETENV, UNSETENV and REBOOT for the bootloader environment
+//
+//	The data connection uses large socket buffers, the bootloader is
+//	usually connected directly and the round trip time doesn't matter,
+//	but the number of small segments does.
+//
+//	Build it with 'gcc -O2 -o eva_ftp eva_ftp.c'.
+
+#define DEFAULT_ADDRESS			"192.168.178.1"
+#define DEFAULT_PORT			"21"
+#define DEFAULT_USER			"adam2"
+#define DEFAULT_PASSWORD		"adam2"
+#define DEFAULT_PASSIVE			"P@SW"
+#define SOCKET_BUFFER_SIZE		(4 * 1024 * 1024)
+#define TRANSFER_CHUNK_SIZE		(1024 * 1024)
+#define MAX_RESPONSE_LINES		256
+
+struct evaResponse
+{
+	int						code;
+	char *					lines[MAX_RESPONSE_LINES];
+	int						count;
+};
+
+struct evaConnection
+{
+	const char *			address;
+	const char *			port;
+	int						control;
+	char					buffer[8192];
+	size_t					bufferFill;
+	bool					verbose;
+};
+
+static void freeResponse(struct evaResponse *response)
+{
+	for (int i = 0; i < response->count; i++)
+		free(response->lines[i]);
+	response->count = 0;
+	response->code = 0;
+}
+
+static bool writeAll(int fd, const void *data, size_t size)
+{
+	const uint8_t *	out = data;
+
+	while (size > 0)
+	{
+		ssize_t	written = write(fd, out, size);
+
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		out += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+static int connectTo(const char *address, const char *port, bool dataConnection)
+{
+	struct addrinfo		hints;
+	struct addrinfo *	result;
+	struct addrinfo *	entry;
+	int					fd = -1;
+	int					error;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if ((error = getaddrinfo(address, port, &hints, &result)) != 0)
+	{
+		fprintf(stderr, "Error resolving address '%s', port '%s': %s\n", address, port, gai_strerror(error));
+		return -1;
+	}
+
+	for (entry = result; entry != NULL; entry = entry->ai_next)
+	{
+		if ((fd = socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol)) == -1)
+			continue;
+
+		// buffer sizes have to be set before the connection is established
+		if (dataConnection)
+		{
+			int	size = SOCKET_BUFFER_SIZE;
+
+			setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+			setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+		}
+		else
+		{
+			int	noDelay = 1;
+
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+		}
+
+		if (connect(fd, entry->ai_addr, entry->ai_addrlen) == 0)
+			break;
+
+		close(fd);
+		fd = -1;
+	}
+
+	if (fd == -1)
+		fprintf(stderr, "Error %d connecting to address '%s', port '%s'.\n", errno, address, port);
+
+	freeaddrinfo(result);
+	return fd;
+}
+
+static char * readLine(struct evaConnection *connection)
+{
+	while (true)
+	{
+		char *	end = memchr(connection->buffer, '\n', connection->bufferFill);
+		ssize_t	got;
+
+		if (end != NULL)
+		{
+			size_t	length = end - connection->buffer;
+			char *	line = malloc(length + 1);
+
+			if (line == NULL)
+				return NULL;
+			memcpy(line, connection->buffer, length);
+			line[length] = '\0';
+			if (length > 0 && line[length - 1] == '\r')
+				line[length - 1] = '\0';
+
+			connection->bufferFill -= length + 1;
+			memmove(connection->buffer, end + 1, connection->bufferFill);
+
+			if (connection->verbose)
+				fprintf(stderr, "< %s\n", line);
+			return line;
+		}
+
+		if (connection->bufferFill == sizeof(connection->buffer))
+		{
+			fprintf(stderr, "Response line from server is too long.\n");
+			return NULL;
+		}
+
+		got = read(connection->control, connection->buffer + connection->bufferFill, sizeof(connection->buffer) - connection->bufferFill);
+		if (got == -1 && errno == EINTR)
+			continue;
+		if (got <= 0)
+		{
+			fprintf(stderr, "Control connection closed by server.\n");
+			return NULL;
+		}
+		connection->bufferFill += got;
+	}
+}
+
+//	A response ends with a line starting with three digits and a space, all
+//	lines before (continuation lines with a '-' after the code or the lines
+//	with the values for GETENV) are kept, too.
+
+bool readResponse(struct evaConnection *connection, struct evaResponse *response)
+{
+	freeResponse(response);
+
+	while (true)
+	{
+		char *	line = readLine(connection);
+		bool	last;
+
+		if (line == NULL)
+			return false;
+
+		last = (isdigit((unsigned char) line[0]) && isdigit((unsigned char) line[1]) && isdigit((unsigned char) line[2]) && (line[3] == ' ' || line[3] == '\0'));
+
+		if (last)
+			response->code = (line[0] - '0') * 100 + (line[1] - '0') * 10 + (line[2] - '0');
+
+		// the final line is always kept, it replaces the last one of a very long response
+		if (response->count == MAX_RESPONSE_LINES && last)
+			free(response->lines[--response->count]);
+
+		if (response->count < MAX_RESPONSE_LINES)
+			response->lines[response->count++] = line;
+		else
+			free(line);
+
+		if (last)
+			return true;
+	}
+}
+
+bool sendCommands(struct evaConnection *connection, const char **commands, int count)
+{
+	char	buffer[4096];
+	size_t	size = 0;
+
+	// all commands are sent with a single write to the control connection
+	for (int i = 0; i < count; i++)
+	{
+		int		length = snprintf(buffer + size, sizeof(buffer) - size, "%s\r\n", commands[i]);
+
+		if (length < 0 || (size_t) length >= sizeof(buffer) - size)
+		{
+			fprintf(stderr, "Command line is too long.\n");
+			return false;
+		}
+		size += length;
+
+		if (connection->verbose)
+			fprintf(stderr, "> %s\n", (strncmp(commands[i], "PASS ", 5) == 0 ? "PASS ***" : commands[i]));
+	}
+
+	if (!writeAll(connection->control, buffer, size))
+	{
+		fprintf(stderr, "Error %d sending command(s) to server.\n", errno);
+		return false;
+	}
+
+	return true;
+}
+
+bool command(struct evaConnection *connection, const char *line, int expected, struct evaResponse *response)
+{
+	if (!sendCommands(connection, &line, 1) || !readResponse(connection, response))
+		return false;
+
+	if (response->code != expected)
+	{
+		fprintf(stderr, "Unexpected response to '%.*s': %s\n", (int) strcspn(line, " "), line, response->lines[response->count - 1]);
+		return false;
+	}
+
+	return true;
+}
+
+bool login(struct evaConnection *connection, const char *user, const char *password)
+{
+	struct evaResponse	response = { 0 };
+	char				line[256];
+	bool				result = false;
+
+	if (!readResponse(connection, &response) || response.code != 220)
+	{
+		fprintf(stderr, "Unexpected greeting from server, is it an EVA bootloader?\n");
+		freeResponse(&response);
+		return false;
+	}
+
+	snprintf(line, sizeof(line), "USER %s", user);
+	if (command(connection, line, 331, &response))
+	{
+		snprintf(line, sizeof(line), "PASS %s", password);
+		if (command(connection, line, 230, &response) && command(connection, "SYST", 215, &response))
+		{
+			if (strstr(response.lines[response.count - 1], "AVM EVA") == NULL)
+				fprintf(stderr, "Unexpected system found: %s\n", response.lines[response.count - 1] + 4);
+			else
+			{
+				fprintf(stderr, "Found AVM bootloader: %s\n", response.lines[response.count - 1] + 4);
+				result = true;
+			}
+		}
+		else
+			fprintf(stderr, "Login failed.\n");
+	}
+
+	freeResponse(&response);
+	return result;
+}
+
+//	TYPE, MEDIA and the passive mode command are pipelined, the data
+//	connection is opened before the transfer command is sent (like the
+//	scripts do it), the server's 150 response may be sent before or
+//	after it accepted the connection.
+
+int openDataConnection(struct evaConnection *connection, const char *media, const char *passive)
+{
+	struct evaResponse	response = { 0 };
+	char				mediaCommand[64];
+	const char *		commands[3] = { "TYPE I", mediaCommand, passive };
+	unsigned int		a[6];
+	char				address[32];
+	char				port[8];
+	const char *		parameters;
+	int					fd = -1;
+
+	snprintf(mediaCommand, sizeof(mediaCommand), "MEDIA %s", media);
+	if (!sendCommands(connection, commands, 3))
+		return -1;
+
+	for (int i = 0; i < 3; i++)
+	{
+		int	expected = (i < 2 ? 200 : 227);
+
+		if (!readResponse(connection, &response))
+			return -1;
+
+		if (response.code != expected)
+		{
+			fprintf(stderr, "Unexpected response to '%.*s': %s\n", (int) strcspn(commands[i], " "), commands[i], response.lines[response.count - 1]);
+			// the remaining responses have to be read before the next command
+			while (++i < 3 && readResponse(connection, &response))
+				;
+			freeResponse(&response);
+			return -1;
+		}
+	}
+
+	if ((parameters = strchr(response.lines[response.count - 1], '(')) == NULL ||
+		sscanf(parameters, "(%u,%u,%u,%u,%u,%u)", &a[0], &a[1], &a[2], &a[3], &a[4], &a[5]) != 6)
+	{
+		fprintf(stderr, "Unable to parse passive mode response: %s\n", response.lines[response.count - 1]);
+		freeResponse(&response);
+		return -1;
+	}
+	freeResponse(&response);
+
+	snprintf(address, sizeof(address), "%u.%u.%u.%u", a[0], a[1], a[2], a[3]);
+	snprintf(port, sizeof(port), "%u", a[4] * 256 + a[5]);
+
+	if ((fd = connectTo(address, port, true)) == -1)
+		return -1;
+
+	return fd;
+}
+
+bool retrieveFile(struct evaConnection *connection, const char *media, const char *passive, const char *name, int output)
+{
+	struct evaResponse	response = { 0 };
+	char				line[256];
+	char *				buffer;
+	int					data;
+	uint64_t			total = 0;
+	bool				result = false;
+
+	if ((data = openDataConnection(connection, media, passive)) == -1)
+		return false;
+
+	if ((buffer = malloc(TRANSFER_CHUNK_SIZE)) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory.\n");
+		close(data);
+		return false;
+	}
+
+	snprintf(line, sizeof(line), "RETR %s", name);
+	if (command(connection, line, 150, &response))
+	{
+		result = true;
+		while (true)
+		{
+			ssize_t	got = read(data, buffer, TRANSFER_CHUNK_SIZE);
+
+			if (got == -1 && errno == EINTR)
+				continue;
+			if (got == -1)
+			{
+				fprintf(stderr, "Error %d reading from data connection.\n", errno);
+				result = false;
+				break;
+			}
+			if (got == 0)
+				break;
+			if (!writeAll(output, buffer, got))
+			{
+				fprintf(stderr, "Error %d writing retrieved data.\n", errno);
+				result = false;
+				break;
+			}
+			total += got;
+		}
+		close(data);
+		data = -1;
+
+		if (!readResponse(connection, &response) || response.code != 226)
+		{
+			fprintf(stderr, "Transfer of '%s' failed: %s\n", name, (response.count ? response.lines[response.count - 1] : "connection lost"));
+			result = false;
+		}
+		else if (result)
+			fprintf(stderr, "%" PRIu64 " bytes retrieved from '%s'.\n", total, name);
+	}
+
+	if (data != -1)
+		close(data);
+	free(buffer);
+	freeResponse(&response);
+	return result;
+}
+
+bool storeFile(struct evaConnection *connection, const char *media, const char *passive, const char *name, const char *fileName)
+{
+	struct evaResponse	response = { 0 };
+	char				line[256];
+	struct stat			st;
+	uint8_t *			image = MAP_FAILED;
+	int					input;
+	int					data = -1;
+	bool				result = false;
+
+	if ((input = open(fileName, O_RDONLY)) == -1)
+	{
+		fprintf(stderr, "Error %d opening file '%s'.\n", errno, fileName);
+		return false;
+	}
+
+	if (fstat(input, &st) == -1 || st.st_size == 0)
+	{
+		fprintf(stderr, "Error %d getting file stats for '%s' or file is empty.\n", errno, fileName);
+		close(input);
+		return false;
+	}
+
+	if ((image = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, input, 0)) == MAP_FAILED)
+	{
+		fprintf(stderr, "Error %d mapping file '%s' to memory.\n", errno, fileName);
+		close(input);
+		return false;
+	}
+	madvise(image, st.st_size, MADV_SEQUENTIAL);
+
+	if ((data = openDataConnection(connection, media, passive)) != -1)
+	{
+		snprintf(line, sizeof(line), "STOR %s", name);
+		if (command(connection, line, 150, &response))
+		{
+			result = writeAll(data, image, st.st_size);
+			if (!result)
+				fprintf(stderr, "Error %d sending data of file '%s'.\n", errno, fileName);
+
+			// the server starts writing to flash after the connection was closed
+			shutdown(data, SHUT_WR);
+			close(data);
+			data = -1;
+
+			// EVA answers an upload to SDRAM with 553, even if it was successful
+			if (!readResponse(connection, &response) || (response.code != 226 && !(response.code == 553 && strcmp(media, "SDRAM") == 0)))
+			{
+				fprintf(stderr, "Transfer to '%s' failed: %s\n", name, (response.count ? response.lines[response.count - 1] : "connection lost"));
+				result = false;
+			}
+			else if (result)
+				fprintf(stderr, "%" PRIu64 " bytes stored to '%s'.\n", (uint64_t) st.st_size, name);
+		}
+	}
+
+	if (data != -1)
+		close(data);
+	munmap(image, st.st_size);
+	close(input);
+	freeResponse(&response);
+	return result;
+}
+
+bool getEnvironmentValue(struct evaConnection *connection, const char *name)
+{
+	struct evaResponse	response = { 0 };
+	char				line[256];
+	bool				found = false;
+	size_t				length = strlen(name);
+
+	snprintf(line, sizeof(line), "GETENV %s", name);
+	if (!command(connection, line, 200, &response))
+	{
+		freeResponse(&response);
+		return false;
+	}
+
+	for (int i = 0; i < response.count - 1 && !found; i++)
+	{
+		const char *	value = response.lines[i];
+
+		if (strncmp(value, "200-", 4) == 0)
+			value += 4;
+
+		if (strncmp(value, name, length) == 0 && (value[length] == ' ' || value[length] == '\t' || value[length] == '\0'))
+		{
+			value += length;
+			value += strspn(value, " \t");
+			fprintf(stdout, "%s\n", value);
+			found = true;
+		}
+	}
+
+	freeResponse(&response);
+	return found;
+}
+
+void usage(void)
+{
+	fprintf(stderr, "eva_ftp - access the FTP server in the bootloader of FRITZ!Box devices\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "eva_ftp [ options ] <command> [ <arguments> ]\n");
+	fprintf(stderr, "\nOptions:\n\n");
+	fprintf(stderr, "-a, --address=<address>   address of the device (default %s)\n", DEFAULT_ADDRESS);
+	fprintf(stderr, "-p, --port=<port>         port of the FTP server (default %s)\n", DEFAULT_PORT);
+	fprintf(stderr, "-u, --user=<name>         user name for login (default %s)\n", DEFAULT_USER);
+	fprintf(stderr, "-w, --password=<value>    password for login (default %s)\n", DEFAULT_PASSWORD);
+	fprintf(stderr, "-P, --pasv                use PASV instead of P@SW for passive mode\n");
+	fprintf(stderr, "-v, --verbose             show the FTP dialog on STDERR\n");
+	fprintf(stderr, "\nCommands:\n\n");
+	fprintf(stderr, "retr <media> <name> [ <file> ]   retrieve a file or partition (like 'mtd1') from the\n");
+	fprintf(stderr, "                                 media (SDRAM or FLSH) and write it to the file or to\n");
+	fprintf(stderr, "                                 STDOUT, while it's received\n");
+	fprintf(stderr, "stor <media> <name> <file>       store the content of the file to the media\n");
+	fprintf(stderr, "env [ <name> ]                   retrieve the environment (or another file like 'count')\n");
+	fprintf(stderr, "getenv <name>                    show the value of an environment variable\n");
+	fprintf(stderr, "setenv <name> [ <value> ]        set an environment variable or unset it without a value\n");
+	fprintf(stderr, "reboot                           restart the device\n");
+}
+
+int main(int argc, char * argv[])
+{
+	struct evaConnection	connection;
+	struct evaResponse		response = { 0 };
+	const char *			user = DEFAULT_USER;
+	const char *			password = DEFAULT_PASSWORD;
+	const char *			passive = DEFAULT_PASSIVE;
+	const char *			operation;
+	int						arguments;
+	bool					result = false;
+	int						i = 1;
+
+	memset(&connection, 0, sizeof(connection));
+	connection.address = DEFAULT_ADDRESS;
+	connection.port = DEFAULT_PORT;
+	connection.control = -1;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-')
+	{
+		static const struct { const char *shortName; const char *longName; } valueOptions[] = {
+			{ "-a", "--address=" }, { "-p", "--port=" }, { "-u", "--user=" }, { "-w", "--password=" },
+		};
+		const char **	targets[] = { &connection.address, &connection.port, &user, &password };
+		bool			matched = false;
+
+		if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0)
+		{
+			connection.verbose = true;
+			i++;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-P") == 0 || strcmp(argv[i], "--pasv") == 0)
+		{
+			passive = "PASV";
+			i++;
+			continue;
+		}
+
+		for (size_t o = 0; o < sizeof(valueOptions) / sizeof(valueOptions[0]) && !matched; o++)
+		{
+			size_t	length = strlen(valueOptions[o].longName);
+
+			if (strcmp(argv[i], valueOptions[o].shortName) == 0)
+			{
+				if (i + 1 >= argc)
+				{
+					fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+					exit(2);
+				}
+				*targets[o] = argv[++i];
+				matched = true;
+			}
+			else if (strncmp(argv[i], valueOptions[o].longName, length) == 0)
+			{
+				*targets[o] = argv[i] + length;
+				matched = true;
+			}
+		}
+
+		if (!matched)
+		{
+			usage();
+			exit(2);
+		}
+		i++;
+	}
+
+	if (i >= argc)
+	{
+		usage();
+		exit(2);
+	}
+
+	operation = argv[i++];
+	arguments = argc - i;
+
+	if (!((strcmp(operation, "retr") == 0 && (arguments == 2 || arguments == 3)) ||
+		  (strcmp(operation, "stor") == 0 && arguments == 3) ||
+		  (strcmp(operation, "env") == 0 && arguments <= 1) ||
+		  (strcmp(operation, "getenv") == 0 && arguments == 1) ||
+		  (strcmp(operation, "setenv") == 0 && (arguments == 1 || arguments == 2)) ||
+		  (strcmp(operation, "reboot") == 0 && arguments == 0)))
+	{
+		usage();
+		exit(2);
+	}
+
+	if ((connection.control = connectTo(connection.address, connection.port, false)) == -1)
+		exit(1);
+
+	if (login(&connection, user, password))
+	{
+		if (strcmp(operation, "retr") == 0 || strcmp(operation, "env") == 0)
+		{
+			const char *	media = (strcmp(operation, "env") == 0 ? "SDRAM" : argv[i]);
+			const char *	name = (strcmp(operation, "env") == 0 ? (arguments ? argv[i] : "env") : argv[i + 1]);
+			int				output = 1;
+
+			if (arguments == 3 && strcmp(argv[i + 2], "-") != 0 && (output = open(argv[i + 2], O_WRONLY | O_CREAT | O_TRUNC, 0666)) == -1)
+				fprintf(stderr, "Error %d creating output file '%s'.\n", errno, argv[i + 2]);
+			else if (output == 1 && isatty(1) && strcmp(operation, "retr") == 0)
+				fprintf(stderr, "STDOUT is a terminal device, retrieved data will not be written there.\n");
+			else
+			{
+				result = retrieveFile(&connection, media, passive, name, output);
+				if (output != 1 && close(output) == -1)
+				{
+					fprintf(stderr, "Error %d closing output file '%s'.\n", errno, argv[i + 2]);
+					result = false;
+				}
+			}
+		}
+		else if (strcmp(operation, "stor") == 0)
+			result = storeFile(&connection, argv[i], passive, argv[i + 1], argv[i + 2]);
+		else if (strcmp(operation, "getenv") == 0)
+			result = getEnvironmentValue(&connection, argv[i]);
+		else if (strcmp(operation, "setenv") == 0)
+		{
+			char	line[1024];
+
+			if (arguments == 2 && *argv[i + 1])
+				snprintf(line, sizeof(line), "SETENV %s %s", argv[i], argv[i + 1]);
+			else
+				snprintf(line, sizeof(line), "UNSETENV %s", argv[i]);
+			result = command(&connection, line, 200, &response);
+		}
+		else
+		{
+			// the device restarts after its response
+			result = sendCommands(&connection, (const char *[]) { "REBOOT" }, 1);
+			if (result && readResponse(&connection, &response))
+				result = (response.code / 100 == 2);
+		}
+
+		if (strcmp(operation, "reboot") != 0)
+		{
+			const char *	quit = "QUIT";
+
+			if (sendCommands(&connection, &quit, 1))
+				readResponse(&connection, &response);
+		}
+	}
+
+	freeResponse(&response);
+	close(connection.control);
+
+	exit(result ? 0 : 1);
+}
@@ -1,37 +1,506 @@
 /* simple implementation of CRC32 checksum as short C program */
+/* '--stats' (or YF_TOOL_STATS in the environment) writes timing data as JSON to STDERR */
+/* file and directory arguments are hashed by a pool of threads, '-c' selects the TI/cksum variant */
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
 #include <inttypes.h>
-int main()
-{
-	const uint32_t polynom=0xEDB88320;
-	uint32_t lookupTable[256];
-	uint32_t crcValue=0;
-	ssize_t readBytes=0;
-	uint8_t byte;
-	char buffer[256];
-	char *input;
-	int i;
-	int j;
-	for (i = 0;i < 256;i++) {
-		uint32_t val = (uint32_t) i;
-		for (j = 0;j < 8;j++) {
-			int isOne=((val & 1) == 1);
-			val >>= 1;
-			if (isOne) {
-				val ^= polynom;
-			} 
-		}
-		lookupTable[i] = val;
-	}
-	crcValue = ~crcValue;
-	do {
-		for (input = buffer;input < (buffer+readBytes);input++) {
-			byte = *input;
-			crcValue = (crcValue >> 8) ^ lookupTable[(crcValue & 255) ^ byte];
-		}
-		readBytes = read(0, buffer, sizeof(buffer));
-	} while (readBytes > 0);
-	crcValue = ~crcValue;
-	printf("%08X\n",crcValue);
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "../include/tool_statistics.h"
+
+//	Two variants of the CRC32 are supported:
+//
+//	- the reflected polynomial 0xEDB88320 with an initial value of all ones
+//	  and a complemented result (the same as zlib's crc32), the default
+//	- the MSB-first polynomial 0x04C11DB7 with an initial value of zero,
+//	  the (non-zero) bytes of the data size in little endian order are
+//	  appended and the result is complemented (POSIX cksum and AVM's TI
+//	  checksum)
+//
+//	Both are computed with eight tables ("slicing-by-8"), so 8 bytes are
+//	processed with one step.
+
+struct crcFile
+{
+	char *					name;
+	uint32_t				crc;
+	uint64_t				size;
+	int						error;			// errno value, if the file couldn't be read
+	bool					done;
+};
+
+struct crcJob
+{
+	struct crcFile *		files;
+	size_t					count;
+	size_t					allocated;
+	size_t					next;			// next file to hash
+	pthread_mutex_t			lock;
+	pthread_cond_t			finished;		// signaled for each hashed file
+};
+
+static uint32_t				crcTables[8][256];
+static bool					cksumVariant = false;
+
+void usage(void)
+{
+	fprintf(stderr, "crc32 - compute CRC32 values of files or of STDIN\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "crc32 [ --stats ] [ -c ] < <input>\n");
+	fprintf(stderr, "crc32 [ --stats ] [ -c ] [ -j <threads> ] <file_or_directory> [ ... ]\n");
+	fprintf(stderr, "\nWithout file names, the value for the data from STDIN is written as eight");
+	fprintf(stderr, "\nhexadecimal digits.\n");
+	fprintf(stderr, "\nFiles are hashed by parallel threads (as many as CPUs are online by default)");
+	fprintf(stderr, "\nand directories are searched recursively (in the order of the names). One");
+	fprintf(stderr, "\nline with the name and the value is written for each file, in the order of");
+	fprintf(stderr, "\nthe arguments. The name '-' reads STDIN.\n");
+	fprintf(stderr, "\nThe default is the reflected polynomial 0xEDB88320 (like zlib), -c (--cksum)");
+	fprintf(stderr, "\nselects the MSB-first polynomial 0x04C11DB7 with the data size appended, as");
+	fprintf(stderr, "\nit's used by the 'cksum' command and for AVM's TI checksums.\n");
+}
+
+void initTables(void)
+{
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t val = (cksumVariant ? i << 24 : i);
+
+		for (int j = 0; j < 8; j++)
+		{
+			if (cksumVariant)
+				val = ((val & 0x80000000) ? (val << 1) ^ 0x04C11DB7 : val << 1);
+			else
+				val = ((val & 1) ? (val >> 1) ^ 0xEDB88320 : val >> 1);
+		}
+		crcTables[0][i] = val;
+	}
+
+	for (int k = 1; k < 8; k++)
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			uint32_t val = crcTables[k - 1][i];
+
+			if (cksumVariant)
+				crcTables[k][i] = (val << 8) ^ crcTables[0][val >> 24];
+			else
+				crcTables[k][i] = (val >> 8) ^ crcTables[0][val & 0xFF];
+		}
+	}
+}
+
+uint32_t updateCrc(uint32_t crc, const uint8_t *data, size_t size)
+{
+	if (cksumVariant)
+	{
+		for (; size >= 8; data += 8, size -= 8)
+		{
+			uint32_t low = crc ^ (((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) | ((uint32_t) data[2] << 8) | data[3]);
+			uint32_t high = ((uint32_t) data[4] << 24) | ((uint32_t) data[5] << 16) | ((uint32_t) data[6] << 8) | data[7];
+
+			crc = crcTables[7][low >> 24] ^ crcTables[6][(low >> 16) & 0xFF] ^ crcTables[5][(low >> 8) & 0xFF] ^ crcTables[4][low & 0xFF] ^
+				  crcTables[3][high >> 24] ^ crcTables[2][(high >> 16) & 0xFF] ^ crcTables[1][(high >> 8) & 0xFF] ^ crcTables[0][high & 0xFF];
+		}
+
+		while (size-- > 0)
+			crc = (crc << 8) ^ crcTables[0][((crc >> 24) ^ *data++) & 0xFF];
+	}
+	else
+	{
+		for (; size >= 8; data += 8, size -= 8)
+		{
+			uint32_t low = crc ^ (data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24));
+			uint32_t high = data[4] | ((uint32_t) data[5] << 8) | ((uint32_t) data[6] << 16) | ((uint32_t) data[7] << 24);
+
+			crc = crcTables[7][low & 0xFF] ^ crcTables[6][(low >> 8) & 0xFF] ^ crcTables[5][(low >> 16) & 0xFF] ^ crcTables[4][low >> 24] ^
+				  crcTables[3][high & 0xFF] ^ crcTables[2][(high >> 8) & 0xFF] ^ crcTables[1][(high >> 16) & 0xFF] ^ crcTables[0][high >> 24];
+		}
+
+		while (size-- > 0)
+			crc = (crc >> 8) ^ crcTables[0][(crc ^ *data++) & 0xFF];
+	}
+
+	return crc;
+}
+
+uint32_t startCrc(void)
+{
+	return (cksumVariant ? 0 : 0xFFFFFFFF);
+}
+
+uint32_t finishCrc(uint32_t crc, uint64_t size)
+{
+	// the cksum variant appends the size with as few bytes as needed
+	if (cksumVariant)
+	{
+		for (; size > 0; size >>= 8)
+		{
+			uint8_t byte = (uint8_t) (size & 0xFF);
+
+			crc = updateCrc(crc, &byte, 1);
+		}
+	}
+
+	return ~crc;
+}
+
+int hashStream(int fd, uint32_t *crc, uint64_t *size)
+{
+	uint8_t buffer[64 * 1024];
+	ssize_t readBytes;
+
+	*crc = startCrc();
+	*size = 0;
+
+	while ((readBytes = read(fd, buffer, sizeof(buffer))) != 0)
+	{
+		if (readBytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return errno;
+		}
+		*crc = updateCrc(*crc, buffer, readBytes);
+		*size += readBytes;
+	}
+
+	*crc = finishCrc(*crc, *size);
 	return 0;
 }
+
+void hashFile(struct crcFile *file)
+{
+	int fd;
+	struct stat st;
+	uint8_t *content;
+
+	// the name '-' stands for STDIN, like it does for other checksum utilities
+	if (strcmp(file->name, "-") == 0)
+	{
+		file->error = hashStream(0, &file->crc, &file->size);
+		return;
+	}
+
+	if ((fd = open(file->name, O_RDONLY)) == -1 || fstat(fd, &st) == -1)
+	{
+		file->error = errno;
+		if (fd != -1)
+			close(fd);
+		return;
+	}
+
+	// regular files are mapped into memory, everything else is read
+	if (S_ISREG(st.st_mode) && st.st_size > 0 && (uint64_t) st.st_size <= SIZE_MAX &&
+		(content = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) != MAP_FAILED)
+	{
+		madvise(content, st.st_size, MADV_SEQUENTIAL);
+		file->size = st.st_size;
+		file->crc = finishCrc(updateCrc(startCrc(), content, st.st_size), file->size);
+		munmap(content, st.st_size);
+	}
+	else
+		file->error = hashStream(fd, &file->crc, &file->size);
+
+	close(fd);
+}
+
+void * hashWorker(void *arg)
+{
+	struct crcJob *job = arg;
+
+	while (true)
+	{
+		size_t index;
+
+		pthread_mutex_lock(&job->lock);
+		index = job->next++;
+		pthread_mutex_unlock(&job->lock);
+
+		if (index >= job->count)
+			break;
+
+		hashFile(&job->files[index]);
+
+		pthread_mutex_lock(&job->lock);
+		job->files[index].done = true;
+		pthread_cond_broadcast(&job->finished);
+		pthread_mutex_unlock(&job->lock);
+	}
+
+	return NULL;
+}
+
+bool addFile(struct crcJob *job, char *name)
+{
+	if (job->count == job->allocated)
+	{
+		size_t newAllocated = (job->allocated ? job->allocated * 2 : 256);
+		struct crcFile *newFiles = realloc(job->files, newAllocated * sizeof(struct crcFile));
+
+		if (newFiles == NULL)
+		{
+			fprintf(stderr, "Error allocating memory for the list of files.\n");
+			free(name);
+			return false;
+		}
+
+		job->files = newFiles;
+		job->allocated = newAllocated;
+	}
+
+	memset(&job->files[job->count], 0, sizeof(struct crcFile));
+	job->files[job->count++].name = name;
+	return true;
+}
+
+int compareNames(const void *left, const void *right)
+{
+	return strcmp(*(char * const *) left, *(char * const *) right);
+}
+
+bool addPath(struct crcJob *job, const char *path, bool argument)
+{
+	struct stat st;
+	char *name;
+
+	if (argument && strcmp(path, "-") == 0)
+	{
+		if ((name = strdup(path)) == NULL)
+		{
+			fprintf(stderr, "Error allocating memory for the list of files.\n");
+			return false;
+		}
+		return addFile(job, name);
+	}
+
+	// symbolic links to directories are only followed for arguments
+	if ((argument ? stat(path, &st) : lstat(path, &st)) == -1)
+	{
+		fprintf(stderr, "Error %d accessing '%s'.\n", errno, path);
+		return false;
+	}
+
+	if (S_ISLNK(st.st_mode) && (stat(path, &st) == -1 || !S_ISREG(st.st_mode)))
+		return true;
+
+	if (S_ISDIR(st.st_mode))
+	{
+		DIR *dir;
+		struct dirent *entry;
+		char **names = NULL;
+		size_t count = 0;
+		size_t allocated = 0;
+		bool result = true;
+
+		if ((dir = opendir(path)) == NULL)
+		{
+			fprintf(stderr, "Error %d opening directory '%s'.\n", errno, path);
+			return false;
+		}
+
+		while (result && (entry = readdir(dir)) != NULL)
+		{
+			if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+				continue;
+
+			if (count == allocated)
+			{
+				char **newNames = realloc(names, (allocated = (allocated ? allocated * 2 : 64)) * sizeof(char *));
+
+				if (newNames == NULL)
+				{
+					fprintf(stderr, "Error allocating memory for the content of directory '%s'.\n", path);
+					result = false;
+					break;
+				}
+				names = newNames;
+			}
+
+			if ((names[count] = malloc(strlen(path) + strlen(entry->d_name) + 2)) == NULL)
+			{
+				fprintf(stderr, "Error allocating memory for the content of directory '%s'.\n", path);
+				result = false;
+				break;
+			}
+			sprintf(names[count++], "%s%s%s", path, (path[strlen(path) - 1] == '/' ? "" : "/"), entry->d_name);
+		}
+		closedir(dir);
+
+		if (result)
+			qsort(names, count, sizeof(char *), compareNames);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (result && !addPath(job, names[i], false))
+				result = false;
+			free(names[i]);
+		}
+		free(names);
+
+		return result;
+	}
+
+	if (!S_ISREG(st.st_mode) && !argument)
+		return true;
+
+	if ((name = strdup(path)) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for the list of files.\n");
+		return false;
+	}
+
+	return addFile(job, name);
+}
+
+int hashFiles(struct crcJob *job, long threads, struct toolStatistics *stats)
+{
+	pthread_t *workers = NULL;
+	int started = 0;
+	int returnCode = 0;
+	uint64_t totalBytes = 0;
+
+	pthread_mutex_init(&job->lock, NULL);
+	pthread_cond_init(&job->finished, NULL);
+	job->next = 0;
+
+	if ((size_t) threads > job->count)
+		threads = job->count;
+
+	if (threads > 0 && (workers = calloc(threads, sizeof(pthread_t))) != NULL)
+	{
+		for (started = 0; started < threads; started++)
+		{
+			if (pthread_create(&workers[started], NULL, hashWorker, job) != 0)
+				break;
+		}
+	}
+
+	// the main thread hashes alone, if no thread could be started
+	if (started == 0)
+		hashWorker(job);
+	addToolCounter(stats, "threads", (started ? started : 1));
+
+	// results are written in the order of the arguments, as soon as they're available
+	for (size_t i = 0; i < job->count; i++)
+	{
+		struct crcFile *file = &job->files[i];
+
+		pthread_mutex_lock(&job->lock);
+		while (!file->done)
+			pthread_cond_wait(&job->finished, &job->lock);
+		pthread_mutex_unlock(&job->lock);
+
+		if (file->error)
+		{
+			fprintf(stderr, "Error %d reading file '%s'.\n", file->error, file->name);
+			returnCode = 1;
+			addToolCounter(stats, "errors", 1);
+		}
+		else
+		{
+			printf("%s %08X\n", file->name, file->crc);
+			totalBytes += file->size;
+		}
+		free(file->name);
+	}
+
+	for (int i = 0; i < started; i++)
+		pthread_join(workers[i], NULL);
+	free(workers);
+
+	pthread_cond_destroy(&job->finished);
+	pthread_mutex_destroy(&job->lock);
+
+	addToolCounter(stats, "files", job->count);
+	addToolBytes(stats, totalBytes);
+
+	return returnCode;
+}
+
+int main(int argc, char *argv[])
+{
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+	bool statistics = false;
+	struct toolStatistics stats;
+	struct crcJob job;
+	int returnCode = 0;
+	int i = 1;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0')
+	{
+		if (isToolStatisticsOption(argv[i]))
+			statistics = true;
+		else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--cksum") == 0)
+			cksumVariant = true;
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+		{
+			char *firstInvalidChar;
+
+			threads = strtol(argv[i + 1], &firstInvalidChar, 0);
+			if (*argv[i + 1] == '\0' || *firstInvalidChar != '\0' || threads <= 0)
+			{
+				fprintf(stderr, "Missing or invalid numeric value for option '%s'.\n", argv[i]);
+				exit(2);
+			}
+			i++;
+		}
+		else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+		{
+			usage();
+			exit(1);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option '%s'.\n", argv[i]);
+			exit(2);
+		}
+		i++;
+	}
+
+	initToolStatistics(&stats, "crc32", statistics);
+	initTables();
+
+	if (i == argc)
+	{
+		uint32_t crcValue;
+		uint64_t totalBytes;
+
+		beginToolPhase(&stats, "checksum");
+		if ((returnCode = hashStream(0, &crcValue, &totalBytes)) != 0)
+		{
+			fprintf(stderr, "Error %d reading from STDIN.\n", returnCode);
+			exit(1);
+		}
+		printf("%08X\n", crcValue);
+		addToolBytes(&stats, totalBytes);
+		writeToolStatistics(&stats);
+		return 0;
+	}
+
+	memset(&job, 0, sizeof(job));
+
+	beginToolPhase(&stats, "list");
+	for (; i < argc; i++)
+	{
+		if (!addPath(&job, argv[i], true))
+			returnCode = 1;
+	}
+
+	beginToolPhase(&stats, "checksum");
+	if (hashFiles(&job, (threads < 1 ? 1 : threads), &stats) != 0)
+		returnCode = 1;
+	free(job.files);
+
+	writeToolStatistics(&stats);
+	return returnCode;
+}
@@ -0,0 +1,430 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <fcntl.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "../include/tool_statistics.h"
+
+//	Native replacement for the 'hexdump' and 'testvalue' shell scripts from
+//	this folder, three output formats are supported:
+//
+//	- hexadecimal lines like "hexdump -e '40/1 "%02X" "\n"'", without any
+//	  padding for an incomplete last line (this is the format used for
+//	  the TFFS nodes in the export files)
+//	- assembler lines like the ones from avm_kernel_config.bin2asm, that's
+//	  "\t.byte\t" followed by comma separated values in the form "0x%02x"
+//	- the decimal value of a 1-, 2- or 4-byte integer (in host byte order)
+//	  at a given offset of a file, like AVM's 'testvalue' utility
+//
+//	The hexadecimal digits are taken from a table with two characters for
+//	each byte value, so each input byte is converted with a single 16-bit
+//	store. Complete lines for a whole input block are collected in one
+//	buffer and written with a single call.
+//
+//	Build it with 'gcc -O2 -W -Wall -o hexdump_filter hexdump.c', no other
+//	libraries are needed.
+
+#define DEFAULT_HEX_WIDTH		40
+#define DEFAULT_ASM_WIDTH		16
+#define MAX_WIDTH				4096
+#define INPUT_BLOCK_SIZE		(64 * 1024)
+
+#define ASM_PREFIX				"\t.byte\t"
+
+static uint16_t					upperHexPairs[256];
+static uint16_t					lowerHexPairs[256];
+
+void usage(void)
+{
+	fprintf(stderr, "hexdump_filter - fast hexadecimal dumps of files or STDIN\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "hexdump_filter [ --stats ] [ -a ] [ -w <bytes_per_line> ] [ -p ] [ <file> ]\n");
+	fprintf(stderr, "hexdump_filter -t <file> <1|2|4> <offset> [ <value> ]\n");
+	fprintf(stderr, "testvalue <file> <1|2|4> <offset> [ <value> ]\n");
+	fprintf(stderr, "\nThe input file (or STDIN, if it's missing or '-' was specified) is written");
+	fprintf(stderr, "\nas lines with %u bytes each, every byte as two uppercase hexadecimal digits.", DEFAULT_HEX_WIDTH);
+	fprintf(stderr, "\nThis is the same output as from \"hexdump -e '%u/1 \"%%02X\" \"\\n\"'\", but an", DEFAULT_HEX_WIDTH);
+	fprintf(stderr, "\nincomplete last line isn't padded.\n");
+	fprintf(stderr, "\nWith -a (--asm), assembler lines with '.byte' directives are written like");
+	fprintf(stderr, "\nfrom avm_kernel_config.bin2asm, %u bytes per line.\n", DEFAULT_ASM_WIDTH);
+	fprintf(stderr, "\nThe number of bytes per line may be changed with -w (--width).\n");
+	fprintf(stderr, "\nWith -p (--progress), the percentage of the input processed so far (or the");
+	fprintf(stderr, "\nnumber of bytes, if the input size is unknown) is shown on STDERR, like the");
+	fprintf(stderr, "\n'hexdump' script does it, if it's called with an argument.\n");
+	fprintf(stderr, "\nWith -t (or if the program is called by the name 'testvalue'), it reads a");
+	fprintf(stderr, "\n1-, 2- or 4-byte integer value in host byte order at the specified offset");
+	fprintf(stderr, "\nof the file and writes it as decimal number. If a value is specified, the");
+	fprintf(stderr, "\nexit code shows, whether it's equal (0) or not (1). That's the same calling");
+	fprintf(stderr, "\nconvention as for AVM's 'testvalue' utility.\n");
+	fprintf(stderr, "\nWith --stats (or YF_TOOL_STATS set in the environment), the time needed");
+	fprintf(stderr, "\nfor each phase and some counters are written as a JSON line to STDERR.\n");
+}
+
+void initHexPairs(void)
+{
+	static const char	upperDigits[] = "0123456789ABCDEF";
+	static const char	lowerDigits[] = "0123456789abcdef";
+
+	for (int i = 0; i < 256; i++)
+	{
+		char	pair[2];
+
+		pair[0] = upperDigits[i >> 4];
+		pair[1] = upperDigits[i & 0x0F];
+		memcpy(&upperHexPairs[i], pair, sizeof(pair));
+		pair[0] = lowerDigits[i >> 4];
+		pair[1] = lowerDigits[i & 0x0F];
+		memcpy(&lowerHexPairs[i], pair, sizeof(pair));
+	}
+}
+
+ssize_t readFull(int fd, uint8_t *buffer, size_t size)
+{
+	size_t	offset = 0;
+
+	while (offset < size)
+	{
+		ssize_t	readBytes = read(fd, buffer + offset, size - offset);
+
+		if (readBytes == 0)
+			break;
+		if (readBytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		offset += readBytes;
+	}
+
+	return offset;
+}
+
+bool writeAll(int fd, const char *buffer, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t	written = write(fd, buffer, size);
+
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		buffer += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+char * formatHexLine(char *output, const uint8_t *input, size_t count)
+{
+	while (count--)
+	{
+		memcpy(output, &upperHexPairs[*(input++)], 2);
+		output += 2;
+	}
+	*(output++) = '\n';
+
+	return output;
+}
+
+char * formatAsmLine(char *output, const uint8_t *input, size_t count)
+{
+	memcpy(output, ASM_PREFIX, sizeof(ASM_PREFIX) - 1);
+	output += sizeof(ASM_PREFIX) - 1;
+
+	while (count--)
+	{
+		*(output++) = '0';
+		*(output++) = 'x';
+		memcpy(output, &lowerHexPairs[*(input++)], 2);
+		output += 2;
+		*(output++) = (count ? ',' : '\n');
+	}
+
+	return output;
+}
+
+//	The progress is shown after each input block, 'inputSize' is zero, if
+//	the size isn't known in advance (e.g. for a pipe).
+
+void showProgress(uint64_t processed, uint64_t inputSize)
+{
+	if (inputSize > 0)
+		fprintf(stderr, "\r%u%%", (unsigned int) (processed * 100 / inputSize));
+	else
+		fprintf(stderr, "\r%" PRIu64 " bytes", processed);
+}
+
+int dumpStream(int fd, bool assembler, size_t width, bool progress, uint64_t inputSize, struct toolStatistics *stats)
+{
+	size_t		lineSize = (assembler ? sizeof(ASM_PREFIX) - 1 + width * 5 : width * 2 + 1);
+	size_t		blockSize = (INPUT_BLOCK_SIZE < width ? width : INPUT_BLOCK_SIZE - (INPUT_BLOCK_SIZE % width));
+	char *		(*formatLine)(char *, const uint8_t *, size_t) = (assembler ? formatAsmLine : formatHexLine);
+	uint8_t *	input;
+	char *		output;
+	uint64_t	totalBytes = 0;
+	uint64_t	lines = 0;
+	int			returnCode = 0;
+
+	input = malloc(blockSize);
+	output = malloc((blockSize / width) * lineSize);
+	if (input == NULL || output == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for buffers.\n");
+		free(input);
+		free(output);
+		return 1;
+	}
+
+	while (true)
+	{
+		ssize_t	readBytes = readFull(fd, input, blockSize);
+		char *	position = output;
+
+		if (readBytes < 0)
+		{
+			fprintf(stderr, "Error %d reading input data.\n", errno);
+			returnCode = 1;
+			break;
+		}
+		if (readBytes == 0)
+			break;
+
+		for (size_t offset = 0; offset < (size_t) readBytes; offset += width)
+		{
+			position = formatLine(position, input + offset, ((size_t) readBytes - offset < width ? (size_t) readBytes - offset : width));
+			lines++;
+		}
+
+		if (!writeAll(1, output, position - output))
+		{
+			fprintf(stderr, "Error %d writing output data.\n", errno);
+			returnCode = 1;
+			break;
+		}
+		totalBytes += readBytes;
+
+		if (progress)
+			showProgress(totalBytes, inputSize);
+
+		if ((size_t) readBytes < blockSize)
+			break;
+	}
+
+	// the progress line is cleared at the end, like the script does it
+	if (progress)
+		fprintf(stderr, "\r\x1B[K");
+
+	addToolBytes(stats, totalBytes);
+	addToolCounter(stats, "lines", lines);
+	free(input);
+	free(output);
+	return returnCode;
+}
+
+int testValue(int argc, char *argv[])
+{
+	char *				firstInvalidChar;
+	unsigned long		type;
+	unsigned long long	offset;
+	unsigned long long	expected = 0;
+	uint8_t				data[4];
+	uint32_t			value;
+	int					fd;
+
+	// the same exit code (1) for all errors as AVM's utility uses
+	if (argc < 3 || argc > 4)
+	{
+		usage();
+		return 1;
+	}
+
+	type = strtoul(argv[1], &firstInvalidChar, 10);
+	if (*argv[1] == '\0' || *firstInvalidChar != '\0' || (type != 1 && type != 2 && type != 4))
+	{
+		fprintf(stderr, "Invalid value size '%s', 1, 2 or 4 is expected.\n", argv[1]);
+		return 1;
+	}
+
+	offset = strtoull(argv[2], &firstInvalidChar, 10);
+	if (*argv[2] < '0' || *argv[2] > '9' || *firstInvalidChar != '\0' || offset > INT64_MAX)
+	{
+		fprintf(stderr, "Invalid offset '%s'.\n", argv[2]);
+		return 1;
+	}
+
+	if (argc == 4)
+	{
+		expected = strtoull(argv[3], &firstInvalidChar, 10);
+		if (*argv[3] < '0' || *argv[3] > '9' || *firstInvalidChar != '\0')
+		{
+			fprintf(stderr, "Invalid value '%s' to compare with.\n", argv[3]);
+			return 1;
+		}
+	}
+
+	if ((fd = open(argv[0], O_RDONLY)) == -1)
+	{
+		fprintf(stderr, "Error %d opening file '%s'.\n", errno, argv[0]);
+		return 1;
+	}
+
+	while (true)
+	{
+		ssize_t	readBytes = pread(fd, data, type, (off_t) offset);
+
+		if (readBytes < 0 && errno == EINTR)
+			continue;
+		if (readBytes != (ssize_t) type)
+		{
+			close(fd);
+			return 1; // short read, silently like the original
+		}
+		break;
+	}
+	close(fd);
+
+	if (type == 1)
+		value = data[0];
+	else if (type == 2)
+	{
+		uint16_t	shortValue;
+
+		memcpy(&shortValue, data, sizeof(shortValue));
+		value = shortValue;
+	}
+	else
+		memcpy(&value, data, sizeof(value));
+
+	if (argc == 4)
+		return (value == expected ? 0 : 1);
+
+	printf("%" PRIu32 "\n", value);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *			name = strrchr(argv[0], '/');
+	bool					statistics = false;
+	bool					assembler = false;
+	bool					progress = false;
+	size_t					width = 0;
+	uint64_t				inputSize = 0;
+	struct toolStatistics	stats;
+	struct stat				st;
+	int						returnCode;
+	int						fd = 0;
+	int						i = 1;
+
+	name = (name ? name + 1 : argv[0]);
+	if (strcmp(name, "testvalue") == 0)
+		return testValue(argc - 1, &argv[1]);
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0')
+	{
+		if (isToolStatisticsOption(argv[i]))
+			statistics = true;
+		else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--testvalue") == 0)
+			return testValue(argc - i - 1, &argv[i + 1]);
+		else if (strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--asm") == 0)
+			assembler = true;
+		else if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--progress") == 0)
+			progress = true;
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+		{
+			char *	firstInvalidChar;
+			long	value = strtol(argv[i + 1], &firstInvalidChar, 0);
+
+			if (*argv[i + 1] == '\0' || *firstInvalidChar != '\0' || value <= 0 || value > MAX_WIDTH)
+			{
+				fprintf(stderr, "Missing or invalid numeric value for option '%s', the allowed range is 1 to %u.\n", argv[i], MAX_WIDTH);
+				exit(2);
+			}
+			width = value;
+			i++;
+		}
+		else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+		{
+			usage();
+			exit(1);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option '%s'.\n", argv[i]);
+			exit(2);
+		}
+		i++;
+	}
+
+	if (argc - i > 1)
+	{
+		fprintf(stderr, "Only one input file may be specified.\n");
+		exit(2);
+	}
+
+	if (width == 0)
+		width = (assembler ? DEFAULT_ASM_WIDTH : DEFAULT_HEX_WIDTH);
+
+	initToolStatistics(&stats, "hexdump", statistics);
+	initHexPairs();
+
+	if (i < argc && strcmp(argv[i], "-") != 0)
+	{
+		if ((fd = open(argv[i], O_RDONLY)) == -1)
+		{
+			fprintf(stderr, "Error %d opening input file '%s'.\n", errno, argv[i]);
+			exit(1);
+		}
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	}
+
+	if (progress && fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+		inputSize = st.st_size;
+
+	beginToolPhase(&stats, "dump");
+	returnCode = dumpStream(fd, assembler, width, progress, inputSize, &stats);
+
+	if (fd != 0)
+		close(fd);
+
+	writeToolStatistics(&stats);
+	return returnCode;
+}
@@ -0,0 +1,428 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <fcntl.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+
+//	Native encoder for the form directories created by 'multipart_form':
+//
+//	- the 'content' file contains one line per part with the name of the
+//	  file holding its data, the field name and an optional content type,
+//	  separated by tabs (or by colons, like in the 'helpers' version)
+//	- the 'boundary' file contains the boundary string
+//
+//	The 'Content-Length' value is computed from the sizes of the part files
+//	(fstat) without reading their data and the part data is copied to the
+//	output by the kernel (sendfile), only the part headers are assembled here.
+//	The output is the same as from the shell functions, but 'postdata' writes
+//	it only to STDOUT - the file 'formdata' in the form directory is created
+//	by 'postfile' only.
+//
+//	Build it with 'gcc -O2 -o multipart_encode multipart_encode.c'.
+
+struct formPart
+{
+	char *					header;			// boundary line and part headers
+	size_t					headerSize;
+	int						fd;
+	uint64_t				size;
+	char *					fileName;
+};
+
+struct form
+{
+	const char *			directory;
+	char					boundary[256];
+	struct formPart *		parts;
+	size_t					count;
+	size_t					allocated;
+	char					trailer[300];
+	size_t					trailerSize;
+	uint64_t				contentLength;
+};
+
+static bool writeAll(int fd, const char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t	written = write(fd, data, size);
+
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+static bool copyPart(int output, struct formPart *part)
+{
+	uint64_t	remaining = part->size;
+	off_t		offset = 0;
+	char		buffer[65536];
+
+	// sendfile() may fail for some output files (e.g. opened with O_APPEND),
+	// the remaining data is copied with read() and write() in this case
+	while (remaining > 0)
+	{
+		ssize_t	sent = sendfile(output, part->fd, &offset, (remaining > (1 << 30) ? (1 << 30) : (size_t) remaining));
+
+		if (sent == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EINVAL || errno == ENOSYS)
+				break;
+			return false;
+		}
+		if (sent == 0)
+		{
+			errno = EIO;	// file was truncated meanwhile
+			return false;
+		}
+		remaining -= sent;
+	}
+
+	if (remaining > 0 && lseek(part->fd, offset, SEEK_SET) == -1)
+		return false;
+
+	while (remaining > 0)
+	{
+		ssize_t	got = read(part->fd, buffer, (remaining > sizeof(buffer) ? sizeof(buffer) : (size_t) remaining));
+
+		if (got == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		if (got == 0)
+		{
+			errno = EIO;
+			return false;
+		}
+		if (!writeAll(output, buffer, got))
+			return false;
+		remaining -= got;
+	}
+
+	return true;
+}
+
+static char * splitField(char **line, char separator)
+{
+	char *	field = *line;
+	char *	end;
+
+	if (field == NULL)
+		return "";
+
+	if ((end = strchr(field, separator)) != NULL)
+	{
+		*end = '\0';
+		*line = end + 1;
+	}
+	else
+		*line = NULL;
+
+	return field;
+}
+
+static bool readBoundary(struct form *form)
+{
+	char		fileName[4096];
+	FILE *		file;
+	size_t		length;
+
+	snprintf(fileName, sizeof(fileName), "%s/boundary", form->directory);
+	if ((file = fopen(fileName, "r")) == NULL)
+	{
+		fprintf(stderr, "The specified form directory '%s' does not contain a valid multipart form-data structure.\n", form->directory);
+		return false;
+	}
+
+	if (fgets(form->boundary, sizeof(form->boundary), file) == NULL)
+		form->boundary[0] = '\0';
+	fclose(file);
+
+	length = strcspn(form->boundary, "\r\n");
+	form->boundary[length] = '\0';
+	if (length == 0)
+	{
+		fprintf(stderr, "The boundary file in form directory '%s' is empty.\n", form->directory);
+		return false;
+	}
+
+	return true;
+}
+
+static bool addPart(struct form *form, const char *partName, const char *fieldName, const char *type)
+{
+	struct formPart *	part;
+	char				fileName[8192];
+	struct stat			st;
+	bool				first = (form->count == 0);
+	int					size;
+
+	if (form->count == form->allocated)
+	{
+		size_t				newAllocated = (form->allocated ? form->allocated * 2 : 16);
+		struct formPart *	newParts = realloc(form->parts, newAllocated * sizeof(struct formPart));
+
+		if (newParts == NULL)
+		{
+			fprintf(stderr, "Error allocating memory.\n");
+			return false;
+		}
+		form->parts = newParts;
+		form->allocated = newAllocated;
+	}
+
+	part = memset(&form->parts[form->count++], 0, sizeof(struct formPart));
+	part->fd = -1;
+
+	size = asprintf(&part->header, "%s--%s\r\nContent-Disposition: form-data; name=\"%s\"%s%s\r\n\r\n",
+		(first ? "" : "\r\n"), form->boundary, fieldName, (*type ? "\r\nContent-Type: " : ""), type);
+	if (size == -1)
+	{
+		part->header = NULL;
+		fprintf(stderr, "Error allocating memory.\n");
+		return false;
+	}
+	part->headerSize = size;
+
+	// 'addfield' and 'addfile' create a file for each part, even if it's empty
+	snprintf(fileName, sizeof(fileName), "%s/%s", form->directory, partName);
+	if ((part->fd = open(fileName, O_RDONLY)) == -1)
+	{
+		fprintf(stderr, "Error %d opening part file '%s'.\n", errno, fileName);
+		return false;
+	}
+
+	if (fstat(part->fd, &st) == -1)
+	{
+		fprintf(stderr, "Error %d getting file stats for '%s'.\n", errno, fileName);
+		return false;
+	}
+	part->size = st.st_size;
+	part->fileName = strdup(fileName);
+
+	return true;
+}
+
+static bool loadForm(struct form *form)
+{
+	char		fileName[4096];
+	char		line[4096];
+	FILE *		content;
+	bool		result = true;
+
+	if (!readBoundary(form))
+		return false;
+
+	snprintf(fileName, sizeof(fileName), "%s/content", form->directory);
+	if ((content = fopen(fileName, "r")) == NULL)
+	{
+		fprintf(stderr, "The specified form directory '%s' does not contain a valid multipart form-data structure.\n", form->directory);
+		return false;
+	}
+
+	while (result && fgets(line, sizeof(line), content) != NULL)
+	{
+		char *	remaining = line;
+		char	separator;
+		char *	partName;
+		char *	fieldName;
+		char *	type;
+
+		if (strchr(line, '\n') == NULL && !feof(content))
+		{
+			fprintf(stderr, "Line too long in content file '%s'.\n", fileName);
+			result = false;
+			break;
+		}
+
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0')
+			continue;
+
+		separator = (strchr(line, '\t') != NULL ? '\t' : ':');
+		partName = splitField(&remaining, separator);
+		fieldName = splitField(&remaining, separator);
+		type = splitField(&remaining, separator);
+
+		result = addPart(form, partName, fieldName, type);
+	}
+
+	fclose(content);
+
+	if (!result)
+		return false;
+
+	form->trailerSize = snprintf(form->trailer, sizeof(form->trailer), "\r\n--%s--", form->boundary);
+
+	form->contentLength = form->trailerSize;
+	for (size_t i = 0; i < form->count; i++)
+		form->contentLength += form->parts[i].headerSize + form->parts[i].size;
+
+	return true;
+}
+
+static void freeForm(struct form *form)
+{
+	for (size_t i = 0; i < form->count; i++)
+	{
+		if (form->parts[i].fd != -1)
+			close(form->parts[i].fd);
+		free(form->parts[i].header);
+		free(form->parts[i].fileName);
+	}
+	free(form->parts);
+	form->parts = NULL;
+	form->count = 0;
+}
+
+static bool writeForm(struct form *form, int output)
+{
+	char	headers[512];
+	int		size;
+
+	size = snprintf(headers, sizeof(headers), "Content-Type: multipart/form-data; boundary=%s\r\nContent-Length: %" PRIu64 "\r\n\r\n", form->boundary, form->contentLength);
+	if (!writeAll(output, headers, size))
+		return false;
+
+	for (size_t i = 0; i < form->count; i++)
+	{
+		struct formPart *	part = &form->parts[i];
+
+		if (!writeAll(output, part->header, part->headerSize))
+			return false;
+
+		if (part->size > 0 && !copyPart(output, part))
+		{
+			fprintf(stderr, "Error %d copying data from part file '%s'.\n", errno, part->fileName);
+			return false;
+		}
+	}
+
+	return (writeAll(output, form->trailer, form->trailerSize) && writeAll(output, "\r\n", 2));
+}
+
+void usage(void)
+{
+	fprintf(stderr, "multipart_encode - create a multipart/form-data request body from a form directory\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "multipart_encode length | postdata | postfile <form_dir>\n");
+	fprintf(stderr, "\nThe form directory has to be created with 'multipart_form new' and the");
+	fprintf(stderr, "\nfields and files are added with the 'addfield' and 'addfile' operations");
+	fprintf(stderr, "\nof this script, the operations here have the same meaning as there:\n");
+	fprintf(stderr, "\nlength   - show the value for the 'Content-Length' header");
+	fprintf(stderr, "\npostdata - write the 'Content-Type' and 'Content-Length' headers and the");
+	fprintf(stderr, "\n           request body to STDOUT (which may be a socket or a pipe), unlike the");
+	fprintf(stderr, "\n           script version, the file 'formdata' isn't written");
+	fprintf(stderr, "\npostfile - write the same data to the file 'formdata' in the form directory");
+	fprintf(stderr, "\n           and show its name\n");
+}
+
+int main(int argc, char * argv[])
+{
+	struct form		form;
+	int				returnCode = 0;
+
+	if (argc != 3 || (strcmp(argv[1], "length") && strcmp(argv[1], "postdata") && strcmp(argv[1], "postfile")))
+	{
+		usage();
+		exit(2);
+	}
+
+	memset(&form, 0, sizeof(form));
+	form.directory = argv[2];
+
+	if (!loadForm(&form))
+	{
+		freeForm(&form);
+		exit(1);
+	}
+
+	if (strcmp(argv[1], "length") == 0)
+	{
+		fprintf(stdout, "%" PRIu64 "\n", form.contentLength);
+	}
+	else if (strcmp(argv[1], "postdata") == 0)
+	{
+		if (!writeForm(&form, 1))
+		{
+			fprintf(stderr, "Error %d writing request body to STDOUT.\n", errno);
+			returnCode = 1;
+		}
+	}
+	else
+	{
+		char	fileName[4096];
+		int		output;
+
+		snprintf(fileName, sizeof(fileName), "%s/formdata", form.directory);
+		if ((output = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0666)) == -1)
+		{
+			fprintf(stderr, "Error %d creating output file '%s'.\n", errno, fileName);
+			returnCode = 1;
+		}
+		else
+		{
+			if (!writeForm(&form, output))
+			{
+				fprintf(stderr, "Error %d writing output file '%s'.\n", errno, fileName);
+				returnCode = 1;
+			}
+			if (close(output) == -1 && returnCode == 0)
+			{
+				fprintf(stderr, "Error %d closing output file '%s'.\n", errno, fileName);
+				returnCode = 1;
+			}
+			if (returnCode == 0)
+				fprintf(stdout, "%s\n", fileName);
+		}
+	}
+
+	freeForm(&form);
+
+	exit(returnCode);
+}
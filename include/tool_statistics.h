@@ -0,0 +1,158 @@
+// vi: set tabstop=4 syntax=c :
+#ifndef TOOL_STATISTICS_H
+#define TOOL_STATISTICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+//	Phase timers and counters for the native tools, enabled with a '--stats'
+//	option or by setting YF_TOOL_STATS to a non-empty value other than '0'.
+//	The results are written as a single JSON line to STDERR:
+//
+//	{"tool":"<name>","total_us":<n>,"phases":{"<name>":<us>,...},"counters":{"<name>":<n>,...},"bytes":<n>,"mb_per_s":<x>}
+//
+//	Phase and counter names have to be string literals without characters,
+//	which would need escaping in JSON. Every function returns immediately,
+//	if statistics are disabled, so the calls may stay in the code - but
+//	counters in inner loops should be summed up in local variables and
+//	added once.
+//
+//	The functions are defined here as 'static inline', so a tool built from
+//	a single source file needs no other files than this header. The caller
+//	has to define _GNU_SOURCE (or _POSIX_C_SOURCE), if it's compiled with
+//	a strict '-std=c99' setting, to get the declaration of clock_gettime().
+
+#define TOOL_STATISTICS_OPTION			"--stats"
+#define TOOL_STATISTICS_ENVIRONMENT		"YF_TOOL_STATS"
+#define TOOL_STATISTICS_MAX_VALUES		16
+
+struct toolStatisticsValue
+{
+	const char *				name;
+	uint64_t					value;
+};
+
+struct toolStatistics
+{
+	bool						enabled;
+	const char *				tool;
+	uint64_t					start;
+	const char *				phase;			// currently running phase
+	uint64_t					phaseStart;
+	struct toolStatisticsValue	phases[TOOL_STATISTICS_MAX_VALUES];
+	size_t						phaseCount;
+	struct toolStatisticsValue	counters[TOOL_STATISTICS_MAX_VALUES];
+	size_t						counterCount;
+	uint64_t					bytes;			// processed data for the throughput value
+};
+
+static inline uint64_t toolStatisticsNow(void)
+{
+	struct timespec				now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t) now.tv_sec * 1000000000ULL) + (uint64_t) now.tv_nsec;
+}
+
+static inline void initToolStatistics(struct toolStatistics *stats, const char *tool, bool enabled)
+{
+	const char *				environment = getenv(TOOL_STATISTICS_ENVIRONMENT);
+
+	memset(stats, 0, sizeof(struct toolStatistics));
+	stats->tool = tool;
+	stats->enabled = enabled || (environment != NULL && *environment && strcmp(environment, "0"));
+
+	if (stats->enabled)
+		stats->start = toolStatisticsNow();
+}
+
+static inline bool isToolStatisticsOption(const char *argument)
+{
+	return (strcmp(argument, TOOL_STATISTICS_OPTION) == 0);
+}
+
+static inline struct toolStatisticsValue * toolStatisticsValue(struct toolStatisticsValue *values, size_t *count, const char *name)
+{
+	for (size_t i = 0; i < *count; i++)
+	{
+		if (values[i].name == name || strcmp(values[i].name, name) == 0)
+			return &values[i];
+	}
+
+	// more values than expected are ignored
+	if (*count == TOOL_STATISTICS_MAX_VALUES)
+		return NULL;
+
+	values[*count].name = name;
+	values[*count].value = 0;
+	return &values[(*count)++];
+}
+
+static inline void endToolPhase(struct toolStatistics *stats)
+{
+	struct toolStatisticsValue *	phase;
+
+	if (!stats->enabled || stats->phase == NULL)
+		return;
+
+	// a phase may be entered more than once, the times are summed up
+	if ((phase = toolStatisticsValue(stats->phases, &stats->phaseCount, stats->phase)) != NULL)
+		phase->value += toolStatisticsNow() - stats->phaseStart;
+	stats->phase = NULL;
+}
+
+static inline void beginToolPhase(struct toolStatistics *stats, const char *name)
+{
+	if (!stats->enabled)
+		return;
+
+	endToolPhase(stats);
+	stats->phase = name;
+	stats->phaseStart = toolStatisticsNow();
+}
+
+static inline void addToolCounter(struct toolStatistics *stats, const char *name, uint64_t value)
+{
+	struct toolStatisticsValue *	counter;
+
+	if (!stats->enabled)
+		return;
+
+	if ((counter = toolStatisticsValue(stats->counters, &stats->counterCount, name)) != NULL)
+		counter->value += value;
+}
+
+static inline void addToolBytes(struct toolStatistics *stats, uint64_t bytes)
+{
+	if (stats->enabled)
+		stats->bytes += bytes;
+}
+
+static inline void writeToolStatistics(struct toolStatistics *stats)
+{
+	uint64_t					total;
+
+	if (!stats->enabled)
+		return;
+
+	endToolPhase(stats);
+	total = toolStatisticsNow() - stats->start;
+
+	fprintf(stderr, "{\"tool\":\"%s\",\"total_us\":%" PRIu64 ",\"phases\":{", stats->tool, total / 1000);
+	for (size_t i = 0; i < stats->phaseCount; i++)
+		fprintf(stderr, "%s\"%s\":%" PRIu64, (i ? "," : ""), stats->phases[i].name, stats->phases[i].value / 1000);
+	fprintf(stderr, "},\"counters\":{");
+	for (size_t i = 0; i < stats->counterCount; i++)
+		fprintf(stderr, "%s\"%s\":%" PRIu64, (i ? "," : ""), stats->counters[i].name, stats->counters[i].value);
+	fprintf(stderr, "},\"bytes\":%" PRIu64 ",\"mb_per_s\":%.1f}\n", stats->bytes, (total ? ((double) stats->bytes / (1024.0 * 1024.0)) / ((double) total / 1e9) : 0.0));
+
+	// only one line per run
+	stats->enabled = false;
+}
+
+#endif
@@ -0,0 +1,1326 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <netdb.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+//	Batch version of the 'juis_check' query:
+//
+//	Each line of the input file describes one device with name/value pairs
+//	(the same names as for 'juis_check'), the SOAP requests for all devices
+//	are built in advance and sent over a bounded number of concurrent
+//	connections. Connections are kept open (HTTP/1.1 keep-alive) and reused
+//	for the next device querying the same server, the responses are parsed
+//	while they're received, without storing them as a whole.
+//
+//	Build it with 'gcc -O2 -o juis_batch juis_batch.c'.
+
+#define JUIS_HOST_BASE			"jws.avm.de"
+#define JUIS_PORT				80
+#define JUIS_URL				"/Jason/UpdateInfoService"
+#define JUIS_NAMESPACE			"ns3"
+#define DEFAULT_WINDOW			8
+#define MAX_WINDOW				256
+#define DEFAULT_TIMEOUT			20
+#define MAX_ATTEMPTS			2
+#define MAX_LINE_SIZE			8192
+#define MAX_VALUE_SIZE			1024
+#define MAX_TAG_SIZE			64
+
+static char *	bodyTemplate =
+	"<soap:Envelope xmlns:soap=\"http://schemas.xmlsoap.org/soap/envelope/\" xmlns:soap-enc=\"http://schemas.xmlsoap.org/soap/encoding/\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" xmlns:e=\"http://juis.avm.de/updateinfo\" xmlns:q=\"http://juis.avm.de/request\">\n"
+	"  <soap:Header/>\n"
+	"  <soap:Body>\n"
+	"    <e:BoxFirmwareUpdateCheck>\n"
+	"      <e:RequestHeader>\n"
+	"        <q:Nonce>%s</q:Nonce>\n"
+	"        <q:UserAgent>Box</q:UserAgent>\n"
+	"        <q:ManualRequest>true</q:ManualRequest>\n"
+	"      </e:RequestHeader>\n"
+	"      <e:BoxInfo>\n"
+	"        <q:Name>%s</q:Name>\n"
+	"        <q:HW>%s</q:HW>\n"
+	"        <q:Major>%s</q:Major>\n"
+	"        <q:Minor>%s</q:Minor>\n"
+	"        <q:Patch>%s</q:Patch>\n"
+	"        <q:Buildnumber>%s</q:Buildnumber>\n"
+	"        <q:Buildtype>100%s</q:Buildtype>\n"
+	"        <q:Serial>%s</q:Serial>\n"
+	"        <q:OEM>%s</q:OEM>\n"
+	"        <q:Lang>%s</q:Lang>\n"
+	"        <q:Country>%s</q:Country>\n"
+	"        <q:Annex>%s</q:Annex>\n"
+	"        <q:Flag>%s</q:Flag>\n"
+	"        <q:UpdateConfig>1</q:UpdateConfig>\n"
+	"        <q:Provider>oma_lan</q:Provider>\n"
+	"      </e:BoxInfo>\n"
+	"    </e:BoxFirmwareUpdateCheck>\n"
+	"  </soap:Body>\n"
+	"</soap:Envelope>\n";
+
+static char *	headerTemplate =
+	"POST %s HTTP/1.1\r\n"
+	"Host: %s:%u\r\n"
+	"Content-Length: %u\r\n"
+	"Content-Type: text/xml; charset=\"utf-8\"\r\n"
+	"Connection: keep-alive\r\n"
+	"\r\n";
+
+// the settings of a device, in the order of the parameters for the body template
+
+enum deviceSetting
+{
+	SETTING_NONCE,
+	SETTING_NAME,
+	SETTING_HW,
+	SETTING_MAJOR,
+	SETTING_MINOR,
+	SETTING_PATCH,
+	SETTING_BUILDNUMBER,
+	SETTING_PUBLIC,
+	SETTING_SERIAL,
+	SETTING_OEM,
+	SETTING_LANG,
+	SETTING_COUNTRY,
+	SETTING_ANNEX,
+	SETTING_FLAG,
+	SETTING_COUNT
+};
+
+static char *	settingNames[SETTING_COUNT] = { "Nonce", "Name", "HW", "Major", "Minor", "Patch", "Buildnumber", "Public", "Serial", "OEM", "Lang", "Country", "Annex", "Flag" };
+
+enum deviceResult
+{
+	RESULT_PENDING,
+	RESULT_FOUND,
+	RESULT_NONE,
+	RESULT_ERROR,
+};
+
+struct server
+{
+	char *					name;
+	uint16_t				port;
+	struct addrinfo *		addresses;
+	int						resolveError;
+	size_t					first;			// queue of pending devices for this server
+	size_t					last;
+	struct server *			next;
+};
+
+struct device
+{
+	size_t					lineNumber;
+	char					version[64];
+	struct server *			server;
+	char *					request;
+	size_t					requestSize;
+	size_t					next;			// next device in the queue of its server
+	int						attempts;
+	enum deviceResult		result;
+};
+
+//	The scanner looks only for the values of the three interesting elements
+//	from the response, it's fed with the body data in pieces of any size.
+
+enum xmlState
+{
+	XML_TEXT,
+	XML_TAG,
+};
+
+struct xmlScanner
+{
+	enum xmlState			state;
+	char					tag[MAX_TAG_SIZE];
+	size_t					tagSize;
+	char *					capture;
+	size_t					captureSize;
+	char					found[16];
+	char					url[MAX_VALUE_SIZE];
+	char					version[64];
+};
+
+enum httpState
+{
+	HTTP_STATUS,
+	HTTP_HEADERS,
+	HTTP_BODY_LENGTH,
+	HTTP_BODY_CLOSE,
+	HTTP_CHUNK_SIZE,
+	HTTP_CHUNK_DATA,
+	HTTP_CHUNK_END,
+	HTTP_TRAILER,
+	HTTP_DONE,
+};
+
+struct httpParser
+{
+	enum httpState			state;
+	char					line[MAX_LINE_SIZE];
+	size_t					lineSize;
+	int						status;
+	uint64_t				remaining;
+	bool					chunked;
+	bool					hasLength;
+	bool					keepAlive;
+	char					delay[32];
+};
+
+enum connectionState
+{
+	CONNECTION_CLOSED,
+	CONNECTION_CONNECTING,
+	CONNECTION_SENDING,
+	CONNECTION_RECEIVING,
+	CONNECTION_IDLE,
+};
+
+struct connection
+{
+	int						fd;
+	enum connectionState	state;
+	struct server *			server;
+	struct device *			device;
+	size_t					sent;
+	bool					reused;
+	bool					received;
+	time_t					deadline;
+	struct httpParser		http;
+	struct xmlScanner		xml;
+};
+
+struct batch
+{
+	struct device *			devices;
+	size_t					count;
+	size_t					allocated;
+	struct server *			servers;
+	struct server *			nextServer;		// round robin position for new connections
+	size_t					pending;
+	size_t					completed;
+	struct connection *		connections;
+	size_t					window;
+	int						timeout;
+	char *					serverName;		// fixed server instead of '<HW>.jws.avm.de'
+	uint16_t				serverPort;
+	bool					realSerial;
+	bool					failed;
+};
+
+#define NO_DEVICE				((size_t) -1)
+
+static int randomSource = -1;
+
+static void getRandom(unsigned char *buffer, size_t size)
+{
+	if (randomSource == -1)
+		randomSource = open("/dev/urandom", O_RDONLY);
+
+	if (randomSource != -1 && read(randomSource, buffer, size) == (ssize_t) size)
+		return;
+
+	for (size_t i = 0; i < size; i++)
+		buffer[i] = (unsigned char) rand();
+}
+
+static void getNonce(char *nonce)
+{
+	static char		base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	unsigned char	data[18];
+	char *			output = nonce;
+
+	// 16 random bytes, the last group is padded with '=='
+	getRandom(data, 16);
+	data[16] = data[17] = 0;
+	for (int i = 0; i < 18; i += 3)
+	{
+		uint32_t	value = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+
+		*output++ = base64[(value >> 18) & 0x3F];
+		*output++ = base64[(value >> 12) & 0x3F];
+		*output++ = base64[(value >> 6) & 0x3F];
+		*output++ = base64[value & 0x3F];
+	}
+	nonce[22] = '=';
+	nonce[23] = '=';
+	nonce[24] = '\0';
+}
+
+static void getSerial(char *serial, const char *realSerial)
+{
+	unsigned char	data[3];
+	bool			lower = false;
+
+	// like 'juis_check', only the OUI part of a real value is kept and the
+	// remaining digits are replaced by random ones
+	if (realSerial == NULL || strlen(realSerial) < 6)
+		realSerial = "3CA62F";
+
+	for (int i = 0; realSerial[i]; i++)
+		if (realSerial[i] >= 'a' && realSerial[i] <= 'f')
+			lower = true;
+
+	getRandom(data, sizeof(data));
+	snprintf(serial, 13, (lower ? "%.6s%02x%02x%02x" : "%.6s%02X%02X%02X"), realSerial, data[0], data[1], data[2]);
+}
+
+static struct server * getServer(struct batch *batch, const char *name, uint16_t port)
+{
+	struct server *	server;
+
+	for (server = batch->servers; server; server = server->next)
+	{
+		if (server->port == port && strcmp(server->name, name) == 0)
+			return server;
+	}
+
+	if ((server = calloc(1, sizeof(struct server))) == NULL || (server->name = strdup(name)) == NULL)
+	{
+		free(server);
+		return NULL;
+	}
+	server->port = port;
+	server->first = NO_DEVICE;
+	server->last = NO_DEVICE;
+	server->next = batch->servers;
+	batch->servers = server;
+
+	return server;
+}
+
+static bool splitVersion(char **settings, const char *version)
+{
+	char *		parts[4] = { NULL, NULL, NULL, NULL };
+	char *		copy = strdup(version);
+	char *		current = copy;
+	int			index = 0;
+
+	if (copy == NULL)
+		return false;
+
+	// %Major%.%Minor%.%Patch%[-%Buildnumber%]
+	while (index < 4)
+	{
+		parts[index++] = current;
+		current += strcspn(current, (index < 3 ? "." : "-"));
+		if (*current == '\0')
+			break;
+		*current++ = '\0';
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (parts[i] == NULL)
+			continue;
+		free(settings[SETTING_MAJOR + i]);
+		if ((settings[SETTING_MAJOR + i] = strdup(parts[i])) == NULL)
+		{
+			free(copy);
+			return false;
+		}
+	}
+
+	free(copy);
+	return true;
+}
+
+static char * nextWord(char **line)
+{
+	char *	input = *line;
+	char *	output;
+	char *	word;
+	bool	quoted = false;
+
+	input += strspn(input, " \t");
+	if (*input == '\0' || *input == '#')
+		return NULL;
+
+	// a value may be enclosed in double quotes, if it contains spaces
+	word = output = input;
+	while (*input && (quoted || (*input != ' ' && *input != '\t')))
+	{
+		if (*input == '"')
+			quoted = !quoted;
+		else if (*input == '\\' && *(input + 1))
+			*output++ = *++input;
+		else
+			*output++ = *input;
+		input++;
+	}
+	if (*input)
+		input++;
+	*output = '\0';
+	*line = input;
+
+	return word;
+}
+
+static bool buildRequest(struct batch *batch, struct device *device, char **settings)
+{
+	char		nonce[32];
+	char		serial[16];
+	char		flags[MAX_LINE_SIZE];
+	char		hostName[256];
+	char *		body;
+	char *		header;
+	int			bodySize;
+	int			headerSize;
+	char *		flag;
+	size_t		flagsSize = 0;
+
+	if (settings[SETTING_NONCE] == NULL)
+	{
+		getNonce(nonce);
+		settings[SETTING_NONCE] = strdup(nonce);
+	}
+
+	if (!batch->realSerial || settings[SETTING_SERIAL] == NULL)
+	{
+		getSerial(serial, settings[SETTING_SERIAL]);
+		free(settings[SETTING_SERIAL]);
+		settings[SETTING_SERIAL] = strdup(serial);
+	}
+
+	if (settings[SETTING_PUBLIC] == NULL)
+		settings[SETTING_PUBLIC] = strdup("1");
+
+	// more than one flag is delimited by commas and gets its own element
+	flags[0] = '\0';
+	if (settings[SETTING_FLAG] != NULL)
+	{
+		char *	remaining = settings[SETTING_FLAG];
+
+		while ((flag = strsep(&remaining, ",")) != NULL)
+		{
+			flagsSize += snprintf(flags + flagsSize, sizeof(flags) - flagsSize, "%s%s", (flagsSize ? "</q:Flag><q:Flag>" : ""), flag);
+			if (flagsSize >= sizeof(flags))
+				return false;
+		}
+	}
+
+	for (int i = 0; i < SETTING_COUNT; i++)
+	{
+		if (settings[i] == NULL && (settings[i] = strdup("")) == NULL)
+			return false;
+	}
+
+	snprintf(device->version, sizeof(device->version), "%s.%s.%s%s%s", settings[SETTING_MAJOR], settings[SETTING_MINOR], settings[SETTING_PATCH],
+		(*settings[SETTING_BUILDNUMBER] ? "-" : ""), settings[SETTING_BUILDNUMBER]);
+
+	bodySize = asprintf(&body, bodyTemplate, settings[SETTING_NONCE], settings[SETTING_NAME], settings[SETTING_HW], settings[SETTING_MAJOR],
+		settings[SETTING_MINOR], settings[SETTING_PATCH], settings[SETTING_BUILDNUMBER], settings[SETTING_PUBLIC], settings[SETTING_SERIAL],
+		settings[SETTING_OEM], settings[SETTING_LANG], settings[SETTING_COUNTRY], settings[SETTING_ANNEX], flags);
+	if (bodySize == -1)
+		return false;
+
+	snprintf(hostName, sizeof(hostName), "%s.%s", settings[SETTING_HW], JUIS_HOST_BASE);
+	headerSize = asprintf(&header, headerTemplate, JUIS_URL, hostName, JUIS_PORT, (unsigned int) bodySize);
+	if (headerSize == -1)
+	{
+		free(body);
+		return false;
+	}
+
+	device->requestSize = headerSize + bodySize;
+	if ((device->request = malloc(device->requestSize)) == NULL)
+	{
+		free(header);
+		free(body);
+		return false;
+	}
+	memcpy(device->request, header, headerSize);
+	memcpy(device->request + headerSize, body, bodySize);
+	free(header);
+	free(body);
+
+	if (batch->serverName != NULL)
+		device->server = getServer(batch, batch->serverName, batch->serverPort);
+	else
+		device->server = getServer(batch, hostName, JUIS_PORT);
+
+	return (device->server != NULL);
+}
+
+static bool addDevice(struct batch *batch, size_t lineNumber, char *line)
+{
+	char *			settings[SETTING_COUNT];
+	char *			word;
+	struct device *	device;
+	bool			result = true;
+
+	memset(settings, 0, sizeof(settings));
+
+	while (result && (word = nextWord(&line)) != NULL)
+	{
+		char *	value = strchr(word, '=');
+		int		index;
+
+		if (value == NULL)
+		{
+			fprintf(stderr, "Invalid setting '%s' in line %zu, expected 'name=value'.\n", word, lineNumber);
+			result = false;
+			break;
+		}
+		*value++ = '\0';
+
+		if (strcmp(word, "Version") == 0)
+		{
+			if (!splitVersion(settings, value))
+				result = false;
+			continue;
+		}
+
+		for (index = 0; index < SETTING_COUNT; index++)
+		{
+			if (strcmp(word, settingNames[index]) == 0)
+				break;
+		}
+		if (index == SETTING_COUNT)
+		{
+			fprintf(stderr, "Unknown setting '%s' in line %zu.\n", word, lineNumber);
+			result = false;
+			break;
+		}
+
+		if (index == SETTING_PUBLIC)
+		{
+			if (strcasecmp(value, "true") == 0)
+				value = "1";
+			else if (strcasecmp(value, "false") == 0)
+				value = "0";
+			if (strcmp(value, "0") && strcmp(value, "1"))
+			{
+				fprintf(stderr, "Invalid value '%s' for setting 'Public' in line %zu.\n", value, lineNumber);
+				result = false;
+				break;
+			}
+		}
+
+		free(settings[index]);
+		if ((settings[index] = strdup(value)) == NULL)
+			result = false;
+	}
+
+	if (result && (settings[SETTING_HW] == NULL || *settings[SETTING_HW] == '\0' || settings[SETTING_MAJOR] == NULL))
+	{
+		fprintf(stderr, "Missing 'HW' or 'Version' setting in line %zu.\n", lineNumber);
+		result = false;
+	}
+
+	if (result && batch->count == batch->allocated)
+	{
+		size_t			newAllocated = (batch->allocated ? batch->allocated * 2 : 64);
+		struct device *	newDevices = realloc(batch->devices, newAllocated * sizeof(struct device));
+
+		if (newDevices == NULL)
+			result = false;
+		else
+		{
+			batch->devices = newDevices;
+			batch->allocated = newAllocated;
+		}
+	}
+
+	if (result)
+	{
+		device = memset(&batch->devices[batch->count], 0, sizeof(struct device));
+		device->lineNumber = lineNumber;
+		device->next = NO_DEVICE;
+		if ((result = buildRequest(batch, device, settings)))
+			batch->count++;
+		else
+		{
+			free(device->request);
+			fprintf(stderr, "Error building the request for line %zu.\n", lineNumber);
+		}
+	}
+
+	for (int i = 0; i < SETTING_COUNT; i++)
+		free(settings[i]);
+
+	return result;
+}
+
+static bool readDevices(struct batch *batch, FILE *input)
+{
+	char	line[MAX_LINE_SIZE];
+	size_t	lineNumber = 0;
+
+	while (fgets(line, sizeof(line), input) != NULL)
+	{
+		char *	start;
+
+		lineNumber++;
+		line[strcspn(line, "\r\n")] = '\0';
+		start = line + strspn(line, " \t");
+		if (*start == '\0' || *start == '#')
+			continue;
+
+		if (!addDevice(batch, lineNumber, start))
+			return false;
+	}
+
+	// the queues are built afterwards, the device array isn't moved anymore
+	for (size_t i = 0; i < batch->count; i++)
+	{
+		struct server *	server = batch->devices[i].server;
+
+		if (server->last == NO_DEVICE)
+			server->first = i;
+		else
+			batch->devices[server->last].next = i;
+		server->last = i;
+	}
+	batch->pending = batch->count;
+
+	return true;
+}
+
+static void finishDevice(struct batch *batch, struct device *device, enum deviceResult result, const char *message, struct xmlScanner *xml, const char *delay)
+{
+	device->result = result;
+	batch->completed++;
+
+	switch (result)
+	{
+		case RESULT_FOUND:
+			fprintf(stdout, "%zu\tfound\t%s\t%s\t%s\t%s\n", device->lineNumber, device->version, xml->version, xml->url, (*delay ? delay : "0"));
+			break;
+
+		case RESULT_NONE:
+			fprintf(stdout, "%zu\tnone\t%s\n", device->lineNumber, device->version);
+			break;
+
+		default:
+			fprintf(stdout, "%zu\terror\t%s\t%s\n", device->lineNumber, device->version, message);
+			batch->failed = true;
+			break;
+	}
+	fflush(stdout);
+
+	free(device->request);
+	device->request = NULL;
+}
+
+static size_t dequeueDevice(struct device *devices, struct server *server)
+{
+	size_t	index = server->first;
+
+	if (index != NO_DEVICE)
+	{
+		server->first = devices[index].next;
+		if (server->first == NO_DEVICE)
+			server->last = NO_DEVICE;
+	}
+
+	return index;
+}
+
+static void xmlScan(struct xmlScanner *xml, const char *data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		char	c = data[i];
+
+		if (xml->state == XML_TEXT)
+		{
+			if (c == '<')
+			{
+				xml->state = XML_TAG;
+				xml->tagSize = 0;
+				xml->capture = NULL;
+			}
+			else if (xml->capture != NULL && xml->captureSize > 1)
+			{
+				size_t	length = strlen(xml->capture);
+
+				xml->capture[length] = c;
+				xml->capture[length + 1] = '\0';
+				xml->captureSize--;
+			}
+			continue;
+		}
+
+		if (c != '>')
+		{
+			if (xml->tagSize < sizeof(xml->tag) - 1)
+				xml->tag[xml->tagSize++] = c;
+			continue;
+		}
+
+		// each occurrence of an element replaces the value found before, the last one is used
+		// like the greedy 's|.*<ns:tag>\(.*\)</ns:tag>.*|\1|p' of 'juis_check' does it with a
+		// single line response (nested or unclosed elements aren't handled like 'sed' does)
+		xml->tag[xml->tagSize] = '\0';
+		xml->state = XML_TEXT;
+		if (xml->tagSize > 0 && xml->tag[xml->tagSize - 1] == '/')
+			continue;
+		xml->tag[strcspn(xml->tag, " \t\r\n/")] = '\0';
+
+		if (strncmp(xml->tag, JUIS_NAMESPACE ":", sizeof(JUIS_NAMESPACE)) != 0)
+			continue;
+
+		if (strcmp(xml->tag + sizeof(JUIS_NAMESPACE), "Found") == 0)
+		{
+			xml->found[0] = '\0';
+			xml->capture = xml->found;
+			xml->captureSize = sizeof(xml->found);
+		}
+		else if (strcmp(xml->tag + sizeof(JUIS_NAMESPACE), "DownloadURL") == 0)
+		{
+			xml->url[0] = '\0';
+			xml->capture = xml->url;
+			xml->captureSize = sizeof(xml->url);
+		}
+		else if (strcmp(xml->tag + sizeof(JUIS_NAMESPACE), "Version") == 0)
+		{
+			xml->version[0] = '\0';
+			xml->capture = xml->version;
+			xml->captureSize = sizeof(xml->version);
+		}
+	}
+}
+
+static bool httpHeader(struct httpParser *http, char *line)
+{
+	char *	value = strchr(line, ':');
+
+	if (value == NULL)
+		return true;
+	*value++ = '\0';
+	value += strspn(value, " \t");
+	value[strcspn(value, " \t")] = '\0';
+
+	if (strcasecmp(line, "Content-Length") == 0)
+	{
+		char *	end;
+
+		http->remaining = strtoull(value, &end, 10);
+		http->hasLength = (*end == '\0');
+		return http->hasLength;
+	}
+	else if (strcasecmp(line, "Transfer-Encoding") == 0)
+		http->chunked = (strcasecmp(value, "chunked") == 0);
+	else if (strcasecmp(line, "Connection") == 0)
+		http->keepAlive = (strcasecmp(value, "close") != 0);
+	else if (strcasecmp(line, "Download-Delay") == 0)
+		snprintf(http->delay, sizeof(http->delay), "%s", value);
+
+	return true;
+}
+
+static bool httpLine(struct httpParser *http, char *line)
+{
+	switch (http->state)
+	{
+		case HTTP_STATUS:
+			if (strncmp(line, "HTTP/1.", 7) != 0 || line[8] != ' ')
+				return false;
+			http->status = atoi(line + 9);
+			http->keepAlive = (line[7] == '1');
+			http->state = HTTP_HEADERS;
+			return true;
+
+		case HTTP_HEADERS:
+			if (*line)
+				return httpHeader(http, line);
+			if (http->chunked)
+				http->state = HTTP_CHUNK_SIZE;
+			else if (http->hasLength)
+				http->state = (http->remaining ? HTTP_BODY_LENGTH : HTTP_DONE);
+			else
+			{
+				http->state = HTTP_BODY_CLOSE;
+				http->keepAlive = false;
+			}
+			return true;
+
+		case HTTP_CHUNK_SIZE:
+			{
+				char *	end;
+
+				http->remaining = strtoull(line, &end, 16);
+				if (end == line)
+					return false;
+				http->state = (http->remaining ? HTTP_CHUNK_DATA : HTTP_TRAILER);
+			}
+			return true;
+
+		case HTTP_CHUNK_END:
+			http->state = HTTP_CHUNK_SIZE;
+			return (*line == '\0');
+
+		case HTTP_TRAILER:
+			if (*line == '\0')
+				http->state = HTTP_DONE;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+// returns false on a protocol error, the caller checks 'state' for completion
+
+static bool httpParse(struct httpParser *http, struct xmlScanner *xml, const char *data, size_t size)
+{
+	while (size > 0 && http->state != HTTP_DONE)
+	{
+		if (http->state == HTTP_BODY_CLOSE || http->state == HTTP_BODY_LENGTH || http->state == HTTP_CHUNK_DATA)
+		{
+			size_t	used = size;
+
+			if (http->state != HTTP_BODY_CLOSE && used > http->remaining)
+				used = http->remaining;
+
+			// the body of an error response is not scanned
+			if (http->status == 200)
+				xmlScan(xml, data, used);
+			data += used;
+			size -= used;
+
+			if (http->state != HTTP_BODY_CLOSE && (http->remaining -= used) == 0)
+				http->state = (http->state == HTTP_CHUNK_DATA ? HTTP_CHUNK_END : HTTP_DONE);
+			continue;
+		}
+
+		if (*data == '\n')
+		{
+			if (http->lineSize > 0 && http->line[http->lineSize - 1] == '\r')
+				http->lineSize--;
+			http->line[http->lineSize] = '\0';
+			http->lineSize = 0;
+			if (!httpLine(http, http->line))
+				return false;
+		}
+		else if (http->lineSize < sizeof(http->line) - 1)
+			http->line[http->lineSize++] = *data;
+		else
+			return false;
+
+		data++;
+		size--;
+	}
+
+	return true;
+}
+
+static void closeConnection(struct connection *connection)
+{
+	if (connection->fd != -1)
+		close(connection->fd);
+	connection->fd = -1;
+	connection->state = CONNECTION_CLOSED;
+	connection->server = NULL;
+	connection->device = NULL;
+}
+
+static bool openConnection(struct connection *connection, struct server *server)
+{
+	int		one = 1;
+
+	if (server->addresses == NULL && server->resolveError == 0)
+	{
+		struct addrinfo		hints;
+		char				port[8];
+
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		snprintf(port, sizeof(port), "%u", server->port);
+		if ((server->resolveError = getaddrinfo(server->name, port, &hints, &server->addresses)) != 0)
+			server->addresses = NULL;
+	}
+	if (server->addresses == NULL)
+		return false;
+
+	if ((connection->fd = socket(server->addresses->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1)
+		return false;
+	setsockopt(connection->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	if (connect(connection->fd, server->addresses->ai_addr, server->addresses->ai_addrlen) == -1 && errno != EINPROGRESS)
+	{
+		close(connection->fd);
+		connection->fd = -1;
+		return false;
+	}
+
+	connection->server = server;
+	connection->state = CONNECTION_CONNECTING;
+	connection->reused = false;
+
+	return true;
+}
+
+static void startRequest(struct batch *batch, struct connection *connection, size_t index)
+{
+	struct device *	device = &batch->devices[index];
+
+	batch->pending--;
+	device->attempts++;
+
+	connection->device = device;
+	connection->sent = 0;
+	connection->received = false;
+	connection->deadline = time(NULL) + batch->timeout;
+	memset(&connection->http, 0, sizeof(connection->http));
+	memset(&connection->xml, 0, sizeof(connection->xml));
+
+	if (connection->state == CONNECTION_IDLE)
+	{
+		connection->state = CONNECTION_SENDING;
+		connection->reused = true;
+	}
+	else if (!openConnection(connection, device->server))
+	{
+		char	message[256];
+
+		if (device->server->resolveError)
+			snprintf(message, sizeof(message), "unable to resolve '%s': %s", device->server->name, gai_strerror(device->server->resolveError));
+		else
+			snprintf(message, sizeof(message), "unable to connect to '%s': %s", device->server->name, strerror(errno));
+		finishDevice(batch, device, RESULT_ERROR, message, NULL, NULL);
+		closeConnection(connection);
+	}
+}
+
+static void failRequest(struct batch *batch, struct connection *connection, const char *message, int error)
+{
+	struct device *	device = connection->device;
+	char			text[256];
+
+	// a kept-alive connection may have been closed by the server meanwhile,
+	// the request is repeated once with a new connection in this case
+	if (connection->reused && !connection->received && device->attempts < MAX_ATTEMPTS)
+	{
+		closeConnection(connection);
+		batch->pending++;
+		startRequest(batch, connection, device - batch->devices);
+		return;
+	}
+
+	if (error)
+		snprintf(text, sizeof(text), "%s: %s", message, strerror(error));
+	else
+		snprintf(text, sizeof(text), "%s", message);
+	finishDevice(batch, device, RESULT_ERROR, text, NULL, NULL);
+	closeConnection(connection);
+}
+
+static void completeRequest(struct batch *batch, struct connection *connection)
+{
+	struct httpParser *	http = &connection->http;
+	struct xmlScanner *	xml = &connection->xml;
+	char				message[64];
+
+	if (http->status != 200)
+	{
+		snprintf(message, sizeof(message), "server returned status %d", http->status);
+		finishDevice(batch, connection->device, RESULT_ERROR, message, NULL, NULL);
+	}
+	else if (xml->found[0] == '\0')
+		finishDevice(batch, connection->device, RESULT_ERROR, "malformed response", NULL, NULL);
+	else if (strcmp(xml->found, "true") == 0)
+		finishDevice(batch, connection->device, RESULT_FOUND, NULL, xml, http->delay);
+	else
+		finishDevice(batch, connection->device, RESULT_NONE, NULL, NULL, NULL);
+
+	connection->device = NULL;
+	if (http->keepAlive && http->state == HTTP_DONE)
+		connection->state = CONNECTION_IDLE;
+	else
+		closeConnection(connection);
+}
+
+static void scheduleRequests(struct batch *batch)
+{
+	// idle connections serve the next device for the same server first
+	for (size_t i = 0; i < batch->window && batch->pending > 0; i++)
+	{
+		struct connection *	connection = &batch->connections[i];
+		size_t				index;
+
+		if (connection->state != CONNECTION_IDLE)
+			continue;
+
+		if ((index = dequeueDevice(batch->devices, connection->server)) != NO_DEVICE)
+			startRequest(batch, connection, index);
+	}
+
+	for (size_t i = 0; i < batch->window && batch->pending > 0; i++)
+	{
+		struct connection *	connection = &batch->connections[i];
+		size_t				index = NO_DEVICE;
+
+		if (connection->state != CONNECTION_IDLE && connection->state != CONNECTION_CLOSED)
+			continue;
+
+		// nothing left for the server of an idle connection, it's used for another one
+		while (index == NO_DEVICE)
+		{
+			if (batch->nextServer == NULL)
+				batch->nextServer = batch->servers;
+			index = dequeueDevice(batch->devices, batch->nextServer);
+			batch->nextServer = batch->nextServer->next;
+		}
+
+		if (connection->state == CONNECTION_IDLE)
+			closeConnection(connection);
+		startRequest(batch, connection, index);
+	}
+}
+
+static void handleEvents(struct batch *batch, struct connection *connection, short events)
+{
+	if (connection->state == CONNECTION_CONNECTING && (events & (POLLOUT | POLLERR | POLLHUP)))
+	{
+		int			error = 0;
+		socklen_t	size = sizeof(error);
+
+		if (getsockopt(connection->fd, SOL_SOCKET, SO_ERROR, &error, &size) == -1)
+			error = errno;
+		if (error != 0)
+		{
+			char	message[300];
+
+			snprintf(message, sizeof(message), "unable to connect to '%s'", connection->server->name);
+			failRequest(batch, connection, message, error);
+			return;
+		}
+		connection->state = CONNECTION_SENDING;
+	}
+
+	if (connection->state == CONNECTION_SENDING && (events & (POLLOUT | POLLERR | POLLHUP)))
+	{
+		struct device *	device = connection->device;
+		ssize_t			written = send(connection->fd, device->request + connection->sent, device->requestSize - connection->sent, MSG_NOSIGNAL);
+
+		if (written == -1)
+		{
+			if (errno != EAGAIN && errno != EINTR)
+				failRequest(batch, connection, "error sending request", errno);
+			return;
+		}
+		if ((connection->sent += written) == device->requestSize)
+			connection->state = CONNECTION_RECEIVING;
+		return;
+	}
+
+	if (connection->state == CONNECTION_RECEIVING && (events & (POLLIN | POLLERR | POLLHUP)))
+	{
+		char	buffer[16384];
+		ssize_t	got = recv(connection->fd, buffer, sizeof(buffer), 0);
+
+		if (got == -1)
+		{
+			if (errno != EAGAIN && errno != EINTR)
+				failRequest(batch, connection, "error receiving response", errno);
+			return;
+		}
+
+		if (got == 0)
+		{
+			if (connection->http.state == HTTP_BODY_CLOSE)
+				completeRequest(batch, connection);
+			else
+				failRequest(batch, connection, "connection closed by server", 0);
+			return;
+		}
+
+		connection->received = true;
+		if (!httpParse(&connection->http, &connection->xml, buffer, got))
+			failRequest(batch, connection, "malformed HTTP response", 0);
+		else if (connection->http.state == HTTP_DONE)
+			completeRequest(batch, connection);
+		return;
+	}
+
+	// an idle connection gets readable, if the server closes it
+	if (connection->state == CONNECTION_IDLE && (events & (POLLIN | POLLERR | POLLHUP)))
+		closeConnection(connection);
+}
+
+static void runBatch(struct batch *batch)
+{
+	struct pollfd	fds[MAX_WINDOW];
+
+	while (batch->completed < batch->count)
+	{
+		time_t	now;
+		int		ready;
+
+		scheduleRequests(batch);
+
+		for (size_t i = 0; i < batch->window; i++)
+		{
+			struct connection *	connection = &batch->connections[i];
+
+			fds[i].fd = connection->fd;
+			fds[i].revents = 0;
+			switch (connection->state)
+			{
+				case CONNECTION_CONNECTING:
+				case CONNECTION_SENDING:
+					fds[i].events = POLLOUT;
+					break;
+
+				case CONNECTION_RECEIVING:
+				case CONNECTION_IDLE:
+					fds[i].events = POLLIN;
+					break;
+
+				default:
+					fds[i].fd = -1;
+					fds[i].events = 0;
+					break;
+			}
+		}
+
+		if (batch->completed == batch->count)
+			break;
+
+		ready = poll(fds, batch->window, 1000);
+		if (ready == -1 && errno != EINTR)
+		{
+			fprintf(stderr, "Error %d waiting for network events.\n", errno);
+			exit(1);
+		}
+
+		now = time(NULL);
+		for (size_t i = 0; i < batch->window; i++)
+		{
+			struct connection *	connection = &batch->connections[i];
+
+			if (ready > 0 && fds[i].revents)
+				handleEvents(batch, connection, fds[i].revents);
+
+			if (connection->device != NULL && now > connection->deadline)
+			{
+				connection->reused = false;
+				failRequest(batch, connection, "timeout waiting for server", 0);
+			}
+		}
+	}
+}
+
+static void freeBatch(struct batch *batch)
+{
+	struct server *	server = batch->servers;
+
+	for (size_t i = 0; i < batch->count; i++)
+		free(batch->devices[i].request);
+	free(batch->devices);
+
+	while (server)
+	{
+		struct server *	next = server->next;
+
+		if (server->addresses)
+			freeaddrinfo(server->addresses);
+		free(server->name);
+		free(server);
+		server = next;
+	}
+
+	if (batch->connections)
+	{
+		for (size_t i = 0; i < batch->window; i++)
+			closeConnection(&batch->connections[i]);
+		free(batch->connections);
+	}
+}
+
+static bool numericOption(int argc, char * argv[], int *index, size_t maximum, size_t *number)
+{
+	char *			option = argv[*index];
+	char *			value = NULL;
+	char *			end;
+	unsigned long	result = 0;
+
+	if (option[1] == '-')
+		value = strchr(option, '=') + 1;
+	else if (option[2])
+		value = option + 2;
+	else if (*index + 1 < argc)
+		value = argv[++(*index)];
+
+	if (value != NULL)
+		result = strtoul(value, &end, 10);
+	if (value == NULL || *value == '\0' || *end || result < 1 || result > maximum)
+	{
+		fprintf(stderr, "Invalid value '%s' for option '%s'.\n", (value ? value : ""), option);
+		return false;
+	}
+	*number = result;
+
+	return true;
+}
+
+void usage(void)
+{
+	fprintf(stderr, "juis_batch - check AVM's JUIS for new firmware versions of many devices at once\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "juis_batch [ -j | --jobs=<count> ] [ -t | --timeout=<seconds> ] [ -s | --server=<host>[:<port>] ] [ -r | --use-real-serial ] [ <device_list> ]\n");
+	fprintf(stderr, "\nEach line of the device list (or STDIN, if it's missing or '-') contains the settings of one device");
+	fprintf(stderr, "\nas name/value pairs, with the same names as used by 'juis_check' (Version, Name, HW, OEM, Lang,");
+	fprintf(stderr, "\nAnnex, Country, Serial, Flag, Public and Nonce or Major, Minor, Patch and Buildnumber), values");
+	fprintf(stderr, "\ncontaining spaces have to be enclosed in double quotes. Only 'HW' and 'Version' are mandatory.\n");
+	fprintf(stderr, "\nThe result for each device is written as a line with tab-separated fields to STDOUT, as soon as");
+	fprintf(stderr, "\nit's known - the first field is the line number from the device list, the second one is 'found',");
+	fprintf(stderr, "\n'none' or 'error' and the third one the version used for the query. A found update adds the new");
+	fprintf(stderr, "\nversion, its download URL and the download delay, an error adds a message.\n");
+	fprintf(stderr, "\nUp to <count> (default %u) requests are processed concurrently, the connections are reused for", DEFAULT_WINDOW);
+	fprintf(stderr, "\nfurther requests to the same server. The queries are sent to '<HW>.%s', unless another", JUIS_HOST_BASE);
+	fprintf(stderr, "\nserver is specified.\n");
+	fprintf(stderr, "\nThe exit code is 1, if any device couldn't be checked.\n");
+}
+
+int main(int argc, char * argv[])
+{
+	struct batch	batch;
+	FILE *			input = stdin;
+	int				i = 1;
+
+	memset(&batch, 0, sizeof(batch));
+	batch.window = DEFAULT_WINDOW;
+	batch.timeout = DEFAULT_TIMEOUT;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && *argv[i] == '-' && *(argv[i] + 1))
+	{
+		char *	value = NULL;
+
+		if (!strncmp(argv[i], "-j", 2) || !strncmp(argv[i], "--jobs=", 7))
+		{
+			if (!numericOption(argc, argv, &i, MAX_WINDOW, &batch.window))
+				exit(2);
+		}
+		else if (!strncmp(argv[i], "-t", 2) || !strncmp(argv[i], "--timeout=", 10))
+		{
+			size_t	timeout;
+
+			if (!numericOption(argc, argv, &i, 3600, &timeout))
+				exit(2);
+			batch.timeout = timeout;
+		}
+		else if (!strncmp(argv[i], "-s", 2) || !strncmp(argv[i], "--server=", 9))
+		{
+			char *	port;
+
+			if (argv[i][1] == '-')
+				value = argv[i] + 9;
+			else if (argv[i][2])
+				value = argv[i] + 2;
+			else if (i + 1 < argc)
+				value = argv[++i];
+
+			if (value == NULL || *value == '\0')
+			{
+				fprintf(stderr, "Missing server name for option '%s'.\n", argv[i]);
+				exit(2);
+			}
+
+			batch.serverName = value;
+			batch.serverPort = JUIS_PORT;
+			if ((port = strrchr(value, ':')) != NULL)
+			{
+				*port++ = '\0';
+				batch.serverPort = atoi(port);
+			}
+		}
+		else if (!strcmp(argv[i], "-r") || !strcmp(argv[i], "--use-real-serial"))
+		{
+			batch.realSerial = true;
+		}
+		else if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help"))
+		{
+			usage();
+			exit(2);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option '%s' specified.\n", argv[i]);
+			usage();
+			exit(2);
+		}
+		i++;
+	}
+
+	if (i + 1 < argc)
+	{
+		usage();
+		exit(2);
+	}
+
+	if (i < argc && strcmp(argv[i], "-"))
+	{
+		if ((input = fopen(argv[i], "r")) == NULL)
+		{
+			fprintf(stderr, "Error %d opening device list '%s'.\n", errno, argv[i]);
+			exit(1);
+		}
+	}
+
+	if (!readDevices(&batch, input))
+	{
+		if (input != stdin)
+			fclose(input);
+		freeBatch(&batch);
+		exit(1);
+	}
+	if (input != stdin)
+		fclose(input);
+
+	if ((batch.connections = calloc(batch.window, sizeof(struct connection))) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory.\n");
+		freeBatch(&batch);
+		exit(1);
+	}
+	for (size_t j = 0; j < batch.window; j++)
+		batch.connections[j].fd = -1;
+
+	runBatch(&batch);
+
+	freeBatch(&batch);
+
+	exit(batch.failed ? 1 : 0);
+}
@@ -0,0 +1,340 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "lib_tar_index.h"
+
+//	Index of the members of a TAR file (old 'ustar' format without GNU or
+//	PAX extensions, like AVM's firmware images):
+//
+//	- the file is mapped into memory and only the 512 byte headers are read,
+//	  member data is accessible as a slice of this mapping without copying
+//	- an index may be saved to a text file with one line per member in the
+//	  format used by 'sign_image' (HEADER=... START=... END=... SIZE=...
+//	  BLOCKS=... MEMBER="..."), which may be evaluated by shell scripts and
+//	  is reused (after checking the header at each listed offset) instead
+//	  of walking the archive again
+
+static uint64_t parseOctal(const char *field, size_t size)
+{
+	uint64_t	value = 0;
+
+	while (size > 0 && *field == ' ')
+	{
+		field++;
+		size--;
+	}
+
+	for (; size > 0 && *field >= '0' && *field <= '7'; field++, size--)
+		value = (value << 3) + (*field - '0');
+
+	return value;
+}
+
+static size_t fieldLength(const char *field, size_t size)
+{
+	const char *	end = memchr(field, 0, size);
+
+	return (end == NULL ? size : (size_t) (end - field));
+}
+
+static bool isValidHeader(struct tarIndex *index, uint64_t offset)
+{
+	return (offset + TAR_BLOCK_SIZE <= index->fileSize && memcmp(index->fileBuffer + offset + 257, "ustar", 5) == 0);
+}
+
+static struct tarMember * addMember(struct tarIndex *index)
+{
+	if (index->count == index->allocated)
+	{
+		size_t				newAllocated = (index->allocated ? index->allocated * 2 : 32);
+		struct tarMember *	newMembers = realloc(index->members, newAllocated * sizeof(struct tarMember));
+
+		if (newMembers == NULL)
+		{
+			fprintf(stderr, "Error allocating memory for TAR index.\n");
+			return NULL;
+		}
+		index->members = newMembers;
+		index->allocated = newAllocated;
+	}
+
+	return memset(&index->members[index->count++], 0, sizeof(struct tarMember));
+}
+
+static void setEndOfArchive(struct tarIndex *index)
+{
+	if (index->count > 0)
+		index->eoaOffset = index->members[index->count - 1].headerOffset + index->members[index->count - 1].blocks * TAR_BLOCK_SIZE;
+	else
+		index->eoaOffset = 0;
+
+	index->eoaBlocks = (index->fileSize > index->eoaOffset ? (index->fileSize - index->eoaOffset) / TAR_BLOCK_SIZE : 0);
+}
+
+static bool walkArchive(struct tarIndex *index)
+{
+	uint64_t	offset = 0;
+
+	while (offset + TAR_BLOCK_SIZE <= index->fileSize)
+	{
+		const char *		header = (const char *) index->fileBuffer + offset;
+		struct tarMember *	member;
+
+		if (header[0] == '\0') // end of archive
+			break;
+
+		if (!isValidHeader(index, offset))
+		{
+			fprintf(stderr, "Invalid TAR header at offset 0x%" PRIx64 " in file '%s'.\n", offset, index->fileName);
+			return false;
+		}
+
+		if ((member = addMember(index)) == NULL)
+			return false;
+
+		if (header[345] != '\0')
+		{
+			memcpy(member->name, header + 345, fieldLength(header + 345, 155));
+			strcat(member->name, "/");
+			strncat(member->name, header, 100);
+		}
+		else
+		{
+			memcpy(member->name, header, fieldLength(header, 100));
+		}
+
+		member->type = (header[156] == '\0' ? '0' : header[156]);
+		member->headerOffset = offset;
+		member->dataOffset = offset + TAR_BLOCK_SIZE;
+		member->size = parseOctal(header + 124, 12);
+		member->blocks = 1 + (member->size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE;
+
+		if (member->dataOffset + member->size > index->fileSize)
+		{
+			fprintf(stderr, "Member '%s' exceeds the end of file '%s'.\n", member->name, index->fileName);
+			return false;
+		}
+
+		offset += member->blocks * TAR_BLOCK_SIZE;
+	}
+
+	setEndOfArchive(index);
+	return true;
+}
+
+static bool loadIndexFile(struct tarIndex *index, const char *indexFileName)
+{
+	FILE *		file;
+	char		line[2 * TAR_NAME_SIZE + 160];
+	bool		result = true;
+
+	if ((file = fopen(indexFileName, "r")) == NULL)
+		return false;
+
+	while (result && fgets(line, sizeof(line), file) != NULL)
+	{
+		struct tarMember *	member;
+		uint64_t			header, start, end, size, blocks;
+		int					nameStart = 0;
+		char *				name;
+		char *				out;
+
+		if (sscanf(line, "HEADER=%" SCNu64 " START=%" SCNu64 " END=%" SCNu64 " SIZE=%" SCNu64 " BLOCKS=%" SCNu64 " MEMBER=\"%n", &header, &start, &end, &size, &blocks, &nameStart) != 5 || nameStart == 0)
+		{
+			result = false;
+			break;
+		}
+
+		// each listed header has to be present in the current file
+		if (start != header + TAR_BLOCK_SIZE || end != start + size || !isValidHeader(index, header) || end > index->fileSize ||
+			parseOctal((const char *) index->fileBuffer + header + 124, 12) != size || (member = addMember(index)) == NULL)
+		{
+			result = false;
+			break;
+		}
+
+		member->headerOffset = header;
+		member->dataOffset = start;
+		member->size = size;
+		member->blocks = blocks;
+		member->type = (index->fileBuffer[header + 156] == '\0' ? '0' : (char) index->fileBuffer[header + 156]);
+
+		for (name = line + nameStart, out = member->name; *name != '\0' && *name != '"' && out < member->name + TAR_NAME_SIZE - 1; name++)
+		{
+			if (*name == '\\' && name[1] != '\0')
+				name++;
+			*out++ = *name;
+		}
+		*out = '\0';
+	}
+
+	fclose(file);
+
+	if (result && index->count > 0)
+	{
+		setEndOfArchive(index);
+
+		// members appended after the index was saved would be missing
+		if (index->eoaOffset + TAR_BLOCK_SIZE <= index->fileSize && index->fileBuffer[index->eoaOffset] != '\0')
+			result = false;
+	}
+	else
+		result = false;
+
+	if (!result)
+		index->count = 0;
+
+	return result;
+}
+
+bool openTarIndex(struct tarIndex *index, const char *fileName, const char *indexFileName)
+{
+	struct stat		fileStat;
+
+	memset(index, 0, sizeof(*index));
+	index->fileName = fileName;
+	index->fileBuffer = MAP_FAILED;
+
+	if ((index->fileDescriptor = open(fileName, O_RDONLY)) == -1)
+	{
+		fprintf(stderr, "Error %d opening TAR file '%s'.\n", errno, fileName);
+		return false;
+	}
+
+	if (fstat(index->fileDescriptor, &fileStat) == -1)
+	{
+		fprintf(stderr, "Error %d getting file stats for '%s'.\n", errno, fileName);
+		closeTarIndex(index);
+		return false;
+	}
+
+	index->fileSize = fileStat.st_size;
+	if (index->fileSize > 0 && (index->fileBuffer = mmap(NULL, index->fileSize, PROT_READ, MAP_SHARED, index->fileDescriptor, 0)) == MAP_FAILED)
+	{
+		fprintf(stderr, "Error %d mapping %" PRIu64 " bytes of TAR file '%s' to memory.\n", errno, index->fileSize, fileName);
+		closeTarIndex(index);
+		return false;
+	}
+
+	if (indexFileName != NULL && loadIndexFile(index, indexFileName))
+		return true;
+
+	if (!walkArchive(index))
+	{
+		closeTarIndex(index);
+		return false;
+	}
+
+	if (indexFileName != NULL)
+		saveTarIndex(index, indexFileName);
+
+	return true;
+}
+
+void closeTarIndex(struct tarIndex *index)
+{
+	if (index->fileBuffer != MAP_FAILED && index->fileBuffer != NULL)
+		munmap(index->fileBuffer, index->fileSize);
+	index->fileBuffer = MAP_FAILED;
+
+	if (index->fileDescriptor != -1)
+		close(index->fileDescriptor);
+	index->fileDescriptor = -1;
+
+	free(index->members);
+	index->members = NULL;
+	index->count = 0;
+	index->allocated = 0;
+}
+
+const struct tarMember * findTarMember(struct tarIndex *index, const char *name)
+{
+	// full names are compared first, a base name matches as a fallback
+	for (size_t i = 0; i < index->count; i++)
+	{
+		if (strcmp(index->members[i].name, name) == 0)
+			return &index->members[i];
+	}
+
+	for (size_t i = 0; i < index->count; i++)
+	{
+		const char *	baseName = strrchr(index->members[i].name, '/');
+
+		if (baseName != NULL && strcmp(baseName + 1, name) == 0)
+			return &index->members[i];
+	}
+
+	return NULL;
+}
+
+const uint8_t * getTarMemberData(struct tarIndex *index, const struct tarMember *member)
+{
+	return index->fileBuffer + member->dataOffset;
+}
+
+void printTarMember(FILE *output, const struct tarMember *member)
+{
+	fprintf(output, "HEADER=%" PRIu64 " START=%" PRIu64 " END=%" PRIu64 " SIZE=%" PRIu64 " BLOCKS=%" PRIu64 " MEMBER=\"",
+		member->headerOffset, member->dataOffset, member->dataOffset + member->size, member->size, member->blocks);
+
+	for (const char *name = member->name; *name; name++)
+	{
+		if (*name == '"' || *name == '\\' || *name == '$' || *name == '`')
+			fputc('\\', output);
+		fputc(*name, output);
+	}
+
+	fputs("\"\n", output);
+}
+
+bool saveTarIndex(struct tarIndex *index, const char *indexFileName)
+{
+	FILE *		file;
+	bool		result;
+
+	if ((file = fopen(indexFileName, "w")) == NULL)
+	{
+		fprintf(stderr, "Error %d creating index file '%s'.\n", errno, indexFileName);
+		return false;
+	}
+
+	for (size_t i = 0; i < index->count; i++)
+		printTarMember(file, &index->members[i]);
+
+	result = (ferror(file) == 0);
+	if (fclose(file) != 0)
+		result = false;
+
+	if (!result)
+		fprintf(stderr, "Error %d writing index file '%s'.\n", errno, indexFileName);
+
+	return result;
+}
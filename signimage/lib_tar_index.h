@@ -0,0 +1,44 @@
+// vi: set tabstop=4 syntax=c :
+#ifndef LIB_TAR_INDEX_H
+#define LIB_TAR_INDEX_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+#define TAR_BLOCK_SIZE		512
+#define TAR_NAME_SIZE		260		// prefix (155) + '/' + name (100) + '\0'
+
+struct tarMember
+{
+	char				name[TAR_NAME_SIZE];
+	char				type;
+	uint64_t			headerOffset;
+	uint64_t			dataOffset;
+	uint64_t			size;
+	uint64_t			blocks;			// header and data blocks
+};
+
+struct tarIndex
+{
+	const char *		fileName;
+	int					fileDescriptor;
+	uint8_t *			fileBuffer;
+	uint64_t			fileSize;
+	struct tarMember *	members;
+	size_t				count;
+	size_t				allocated;
+	uint64_t			eoaOffset;		// first block after the last member
+	uint64_t			eoaBlocks;		// number of blocks from there up to the end of file
+};
+
+bool openTarIndex(struct tarIndex *index, const char *fileName, const char *indexFileName);
+void closeTarIndex(struct tarIndex *index);
+
+const struct tarMember * findTarMember(struct tarIndex *index, const char *name);
+const uint8_t * getTarMemberData(struct tarIndex *index, const struct tarMember *member);
+
+void printTarMember(FILE *output, const struct tarMember *member);
+bool saveTarIndex(struct tarIndex *index, const char *indexFileName);
+
+#endif
@@ -0,0 +1,198 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+
+#include <sys/types.h>
+#include <sys/sendfile.h>
+
+#include "lib_tar_index.h"
+
+static bool writeAll(int fd, const uint8_t *data, uint64_t size)
+{
+	while (size > 0)
+	{
+		ssize_t	written = write(fd, data, (size > (1 << 30) ? (1 << 30) : (size_t) size));
+
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+bool extractMember(struct tarIndex *index, const struct tarMember *member, int fd)
+{
+	off_t		offset = (off_t) member->dataOffset;
+	uint64_t	remaining = member->size;
+
+	// the kernel copies the data without a detour through our address space,
+	// if the output doesn't support it, the mapped data is written instead
+	while (remaining > 0)
+	{
+		ssize_t	sent = sendfile(fd, index->fileDescriptor, &offset, (remaining > (1 << 30) ? (1 << 30) : (size_t) remaining));
+
+		if (sent == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EINVAL || errno == ENOSYS)
+				break;
+			return false;
+		}
+		if (sent == 0)
+			return false;
+		remaining -= sent;
+	}
+
+	return writeAll(fd, getTarMemberData(index, member) + (member->size - remaining), remaining);
+}
+
+void usage(void)
+{
+	fprintf(stderr, "tar_index - list or extract members of a firmware image without reading the whole file\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "tar_index [ -i | --index=<index_file> ] [ -e | --eoa ] [ -x | --extract=<member> ] <firmware_image>\n");
+	fprintf(stderr, "\nThe members of the specified firmware image (a TAR file in 'ustar' format)");
+	fprintf(stderr, "\nare listed on STDOUT, one line per member in a format suitable for 'eval':\n");
+	fprintf(stderr, "\nHEADER=<offset> START=<offset> END=<offset> SIZE=<size> BLOCKS=<count> MEMBER=\"<name>\"\n");
+	fprintf(stderr, "\nWith -e the offset of the end of archive and the number of (padding) blocks");
+	fprintf(stderr, "\nfrom there up to the end of file are shown as EOA_OFFSET=<offset> EOA_BLOCKS=<count>.\n");
+	fprintf(stderr, "\nWith -x the data of the specified member (a full name or a base name) is");
+	fprintf(stderr, "\nwritten to STDOUT instead.\n");
+	fprintf(stderr, "\nIf an index file is specified, it's used instead of walking the archive,");
+	fprintf(stderr, "\nas long as it's still valid for the image - otherwise it's (re-)created.\n");
+}
+
+int main(int argc, char * argv[])
+{
+	int							returnCode = 0;
+	const char *				indexFileName = NULL;
+	const char *				extractName = NULL;
+	bool						showEoa = false;
+	struct tarIndex				index;
+	int							i = 1;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-')
+	{
+		const char *	value = NULL;
+
+		if (strcmp(argv[i], "-e") == 0 || strcmp(argv[i], "--eoa") == 0)
+		{
+			showEoa = true;
+			i++;
+			continue;
+		}
+		else if (strncmp(argv[i], "--index=", 8) == 0)
+		{
+			value = argv[i] + 8;
+			indexFileName = value;
+		}
+		else if (strncmp(argv[i], "--extract=", 10) == 0)
+		{
+			value = argv[i] + 10;
+			extractName = value;
+		}
+		else if (strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "-x") == 0)
+		{
+			if (i + 1 >= argc)
+			{
+				fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+				exit(2);
+			}
+			value = argv[++i];
+			if (argv[i - 1][1] == 'i')
+				indexFileName = value;
+			else
+				extractName = value;
+		}
+		else
+		{
+			usage();
+			exit(2);
+		}
+
+		if (*value == '\0')
+		{
+			fprintf(stderr, "Missing value for option '%s'.\n", argv[i]);
+			exit(2);
+		}
+		i++;
+	}
+
+	if (argc - i != 1)
+	{
+		usage();
+		exit(2);
+	}
+
+	if (!openTarIndex(&index, argv[i], indexFileName))
+		exit(1);
+
+	if (extractName != NULL)
+	{
+		const struct tarMember *	member = findTarMember(&index, extractName);
+
+		if (member == NULL)
+		{
+			fprintf(stderr, "Member '%s' not found in file '%s'.\n", extractName, argv[i]);
+			returnCode = 1;
+		}
+		else if (isatty(1))
+		{
+			fprintf(stderr, "STDOUT is a terminal device, member data will not be written there.\n");
+			returnCode = 1;
+		}
+		else if (!extractMember(&index, member, 1))
+		{
+			fprintf(stderr, "Error %d writing member '%s' to STDOUT.\n", errno, member->name);
+			returnCode = 1;
+		}
+	}
+	else
+	{
+		for (size_t m = 0; m < index.count; m++)
+			printTarMember(stdout, &index.members[m]);
+
+		if (showEoa)
+			fprintf(stdout, "EOA_OFFSET=%" PRIu64 " EOA_BLOCKS=%" PRIu64 "\n", index.eoaOffset, index.eoaBlocks);
+	}
+
+	closeTarIndex(&index);
+
+	exit(returnCode);
+}
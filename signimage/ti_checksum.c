@@ -0,0 +1,475 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "lib_tar_index.h"
+
+//	TI checksums in AVM's firmware images (see 'TIcksum' class in FirmwareImage.ps1):
+//
+//	- the CRC uses the "normal" polynomial 0x04C11DB7 (MSB first) with an
+//	  initial remainder of zero
+//	- the non-zero bytes of the data size (little endian order) are added
+//	  after the data and the final value is complemented
+//	- the checksum is stored in the last 8 bytes of the member, a magic
+//	  value (0x23 0xDE 0x53 0xC4) followed by the CRC in little endian order
+//
+//	The CRC is computed with 8 bytes per step (slicing-by-8) and each member
+//	is processed in its own thread.
+
+#define TI_POLYNOMIAL		0x04C11DB7
+
+static const uint8_t		tiMagic[4] = { 0x23, 0xDE, 0x53, 0xC4 };
+static const char *			defaultMembers[] = { "kernel.image", "filesystem.image", NULL };
+static uint32_t				crcTable[8][256];
+
+enum operationMode
+{
+	modeVerify,
+	modeRemove,
+	modeAdd,
+};
+
+struct memberJob
+{
+	struct tarIndex *		file;
+	char					name[TAR_NAME_SIZE];
+	const uint8_t *			data;
+	size_t					size;
+	bool					hasChecksum;
+	uint32_t				stored;
+	uint32_t				computed;
+	bool					failed;
+};
+
+struct jobQueue
+{
+	struct memberJob *		jobs;
+	size_t					count;
+	size_t					next;
+	enum operationMode		mode;
+	const char *			outputDir;
+	pthread_mutex_t			lock;
+};
+
+void initCrcTable(void)
+{
+	for (uint32_t dividend = 0; dividend < 256; dividend++)
+	{
+		uint32_t	remainder = dividend << 24;
+
+		for (int bit = 0; bit < 8; bit++)
+			remainder = (remainder << 1) ^ ((remainder & 0x80000000) ? TI_POLYNOMIAL : 0);
+
+		crcTable[0][dividend] = remainder;
+	}
+
+	for (int slice = 1; slice < 8; slice++)
+	{
+		for (int i = 0; i < 256; i++)
+			crcTable[slice][i] = (crcTable[slice - 1][i] << 8) ^ crcTable[0][crcTable[slice - 1][i] >> 24];
+	}
+}
+
+uint32_t updateCrc(uint32_t crc, const uint8_t *data, size_t size)
+{
+	while (size > 0 && ((uintptr_t) data & 3) != 0)
+	{
+		crc = (crc << 8) ^ crcTable[0][(crc >> 24) ^ *data++];
+		size--;
+	}
+
+	while (size >= 8)
+	{
+		uint32_t	one = crc ^ ((uint32_t) data[0] << 24 | (uint32_t) data[1] << 16 | (uint32_t) data[2] << 8 | data[3]);
+
+		crc =	crcTable[7][one >> 24] ^
+				crcTable[6][(one >> 16) & 0xFF] ^
+				crcTable[5][(one >> 8) & 0xFF] ^
+				crcTable[4][one & 0xFF] ^
+				crcTable[3][data[4]] ^
+				crcTable[2][data[5]] ^
+				crcTable[1][data[6]] ^
+				crcTable[0][data[7]];
+		data += 8;
+		size -= 8;
+	}
+
+	while (size-- > 0)
+		crc = (crc << 8) ^ crcTable[0][(crc >> 24) ^ *data++];
+
+	return crc;
+}
+
+uint32_t computeTIChecksum(const uint8_t *data, size_t size)
+{
+	uint32_t	crc = updateCrc(0, data, size);
+	uint64_t	length = size;
+
+	while (length > 0)
+	{
+		uint8_t	byte = (uint8_t) (length & 0xFF);
+
+		crc = updateCrc(crc, &byte, 1);
+		length >>= 8;
+	}
+
+	return ~crc;
+}
+
+static bool isWantedMember(const char *name, char **members)
+{
+	const char *	baseName = strrchr(name, '/');
+
+	baseName = (baseName ? baseName + 1 : name);
+	for (; *members; members++)
+	{
+		if (strcmp(baseName, *members) == 0 || strcmp(name, *members) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool findMembers(struct tarIndex *file, char **members, struct memberJob **jobs, size_t *count, size_t *allocated)
+{
+	for (size_t i = 0; i < file->count; i++)
+	{
+		const struct tarMember *	member = &file->members[i];
+		struct memberJob *			job;
+
+		if (member->type != '0' || !isWantedMember(member->name, members))
+			continue;
+
+		if (*count == *allocated)
+		{
+			size_t				newAllocated = (*allocated ? *allocated * 2 : 16);
+			struct memberJob *	newJobs = realloc(*jobs, newAllocated * sizeof(struct memberJob));
+
+			if (newJobs == NULL)
+			{
+				fprintf(stderr, "Error allocating memory.\n");
+				return false;
+			}
+			*jobs = newJobs;
+			*allocated = newAllocated;
+		}
+
+		job = &(*jobs)[(*count)++];
+		memset(job, 0, sizeof(*job));
+		job->file = file;
+		strcpy(job->name, member->name);
+		job->data = getTarMemberData(file, member);
+		job->size = member->size;
+	}
+
+	return true;
+}
+
+static bool writeAll(int fd, const uint8_t *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t	written = write(fd, data, size);
+
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+bool writeMember(struct memberJob *job, const char *outputDir, bool addChecksum)
+{
+	const char *	baseName = strrchr(job->name, '/');
+	char			outputName[4096];
+	int				fd;
+	bool			result;
+	size_t			size = job->size - (job->hasChecksum ? 8 : 0);
+
+	baseName = (baseName ? baseName + 1 : job->name);
+	snprintf(outputName, sizeof(outputName), "%s/%s", outputDir, baseName);
+
+	if ((fd = open(outputName, O_WRONLY | O_CREAT | O_TRUNC, 0666)) == -1)
+	{
+		fprintf(stderr, "Error %d creating output file '%s'.\n", errno, outputName);
+		return false;
+	}
+
+	result = writeAll(fd, job->data, size);
+
+	if (result && addChecksum)
+	{
+		uint8_t		trailer[8];
+
+		memcpy(trailer, tiMagic, sizeof(tiMagic));
+		trailer[4] = (uint8_t) job->computed;
+		trailer[5] = (uint8_t) (job->computed >> 8);
+		trailer[6] = (uint8_t) (job->computed >> 16);
+		trailer[7] = (uint8_t) (job->computed >> 24);
+		result = writeAll(fd, trailer, sizeof(trailer));
+	}
+
+	if (close(fd) == -1)
+		result = false;
+
+	if (!result)
+		fprintf(stderr, "Error %d writing output file '%s'.\n", errno, outputName);
+
+	return result;
+}
+
+void processMember(struct memberJob *job, enum operationMode mode, const char *outputDir)
+{
+	size_t	size = job->size;
+
+	if (size >= 8 && memcmp(job->data + size - 8, tiMagic, sizeof(tiMagic)) == 0)
+	{
+		const uint8_t *	value = job->data + size - 4;
+
+		job->hasChecksum = true;
+		job->stored = (uint32_t) value[0] | (uint32_t) value[1] << 8 | (uint32_t) value[2] << 16 | (uint32_t) value[3] << 24;
+		size -= 8;
+	}
+
+	// removing a checksum doesn't need the CRC
+	if (mode != modeRemove)
+		job->computed = computeTIChecksum(job->data, size);
+
+	if (mode == modeRemove)
+		job->failed = !writeMember(job, outputDir, false);
+	else if (mode == modeAdd)
+		job->failed = !writeMember(job, outputDir, true);
+}
+
+void * memberWorker(void *arg)
+{
+	struct jobQueue *	queue = arg;
+
+	while (true)
+	{
+		size_t			job;
+
+		pthread_mutex_lock(&queue->lock);
+		job = queue->next++;
+		pthread_mutex_unlock(&queue->lock);
+
+		if (job >= queue->count)
+			break;
+
+		processMember(&queue->jobs[job], queue->mode, queue->outputDir);
+	}
+
+	return NULL;
+}
+
+void usage(void)
+{
+	fprintf(stderr, "ti_checksum - verify, remove or add TI checksums of firmware image members\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "ti_checksum [ -r <output_dir> | -a <output_dir> ] [ -j <threads> ] [ -m <member> ... ] <firmware_image> ...\n");
+	fprintf(stderr, "\nThe specified firmware images (TAR files) are searched for the members");
+	fprintf(stderr, "\n'kernel.image' and 'filesystem.image' (or the ones specified with -m)");
+	fprintf(stderr, "\nand the TI checksums at the end of these members are verified. The");
+	fprintf(stderr, "\nresult for each member is written to STDOUT.\n");
+	fprintf(stderr, "\nWith -r the member data without a checksum is written to the output");
+	fprintf(stderr, "\ndirectory, with -a the member data gets a new checksum (an existing one");
+	fprintf(stderr, "\nis replaced) - only one firmware image may be specified in both cases.\n");
+	fprintf(stderr, "\nMembers are processed in parallel threads, -j limits their number (the");
+	fprintf(stderr, "\ndefault is the number of online CPUs).\n");
+}
+
+int main(int argc, char * argv[])
+{
+	int						returnCode = 0;
+	enum operationMode		mode = modeVerify;
+	const char *			outputDir = NULL;
+	char **					members = (char **) defaultMembers;
+	char *					memberList[64];
+	int						memberCount = 0;
+	long					threads = sysconf(_SC_NPROCESSORS_ONLN);
+	struct tarIndex *		files;
+	int						fileCount;
+	struct jobQueue			queue = { NULL, 0, 0, modeVerify, NULL, PTHREAD_MUTEX_INITIALIZER };
+	size_t					allocated = 0;
+	pthread_t *				workers;
+	int						started = 0;
+	int						i = 1;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-')
+	{
+		if (i + 1 >= argc)
+		{
+			fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+			exit(2);
+		}
+
+		if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "-a") == 0)
+		{
+			mode = (argv[i][1] == 'r' ? modeRemove : modeAdd);
+			outputDir = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "-m") == 0)
+		{
+			if (memberCount == (int) (sizeof(memberList) / sizeof(memberList[0])) - 1)
+			{
+				fprintf(stderr, "Too many member names specified.\n");
+				exit(2);
+			}
+			memberList[memberCount++] = argv[i + 1];
+			memberList[memberCount] = NULL;
+			members = memberList;
+		}
+		else if (strcmp(argv[i], "-j") == 0)
+		{
+			char *	firstInvalidChar;
+
+			threads = strtol(argv[i + 1], &firstInvalidChar, 0);
+			if (*argv[i + 1] == '\0' || *firstInvalidChar != '\0' || threads < 1)
+			{
+				fprintf(stderr, "Missing or invalid numeric value for option '%s'.\n", argv[i]);
+				exit(2);
+			}
+		}
+		else
+		{
+			usage();
+			exit(2);
+		}
+		i += 2;
+	}
+
+	fileCount = argc - i;
+	if (fileCount < 1 || (mode != modeVerify && fileCount > 1))
+	{
+		usage();
+		exit(2);
+	}
+
+	if ((files = calloc(fileCount, sizeof(struct tarIndex))) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory.\n");
+		exit(1);
+	}
+
+	initCrcTable();
+
+	for (int f = 0; f < fileCount; f++)
+	{
+		if (!openTarIndex(&files[f], argv[i + f], NULL) || !findMembers(&files[f], members, &queue.jobs, &queue.count, &allocated))
+			returnCode = 1;
+	}
+
+	queue.mode = mode;
+	queue.outputDir = outputDir;
+
+	if ((size_t) threads > queue.count)
+		threads = (long) queue.count;
+
+	if (threads > 1 && (workers = calloc(threads, sizeof(pthread_t))) != NULL)
+	{
+		for (started = 0; started < threads; started++)
+		{
+			if (pthread_create(&workers[started], NULL, memberWorker, &queue) != 0)
+				break;
+		}
+		for (int t = 0; t < started; t++)
+			pthread_join(workers[t], NULL);
+		free(workers);
+	}
+
+	// the main thread processes all remaining members, if no threads could be started
+	memberWorker(&queue);
+
+	for (size_t j = 0; j < queue.count; j++)
+	{
+		struct memberJob *	job = &queue.jobs[j];
+		const char *		prefix = (fileCount > 1 ? job->file->fileName : NULL);
+
+		if (job->failed)
+		{
+			returnCode = 1;
+			continue;
+		}
+
+		if (mode == modeVerify)
+		{
+			if (!job->hasChecksum)
+			{
+				fprintf(stdout, "%s%s%s: no TI checksum, computed 0x%08X\n", (prefix ? prefix : ""), (prefix ? ":" : ""), job->name, job->computed);
+				returnCode = 1;
+			}
+			else
+			{
+				bool	valid = (job->stored == job->computed);
+
+				fprintf(stdout, "%s%s%s: TI checksum 0x%08X %s\n", (prefix ? prefix : ""), (prefix ? ":" : ""), job->name, job->stored, (valid ? "OK" : "BAD"));
+				if (!valid)
+				{
+					fprintf(stdout, "%s%s%s: computed 0x%08X\n", (prefix ? prefix : ""), (prefix ? ":" : ""), job->name, job->computed);
+					returnCode = 1;
+				}
+			}
+		}
+		else if (mode == modeRemove)
+		{
+			fprintf(stdout, "%s: %s\n", job->name, (job->hasChecksum ? "TI checksum removed" : "no TI checksum found, copied unchanged"));
+		}
+		else
+		{
+			fprintf(stdout, "%s: TI checksum 0x%08X %s\n", job->name, job->computed, (job->hasChecksum ? "replaced" : "added"));
+		}
+	}
+
+	if (queue.count == 0)
+	{
+		fprintf(stderr, "No matching members found.\n");
+		returnCode = 1;
+	}
+
+	for (int f = 0; f < fileCount; f++)
+		closeTarIndex(&files[f]);
+	free(files);
+	free(queue.jobs);
+
+	exit(returnCode);
+}
@@ -0,0 +1,519 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#include "../include/tool_statistics.h"
+
+//	Create the TFFS nodes for some files with uncompressed content:
+//
+//	- the node ID is taken from the file name, like in 'build_tffs_image' it
+//	  has to start with the 4-character hexadecimal ID, followed by an
+//	  optional suffix (e.g. '001d.bin' or '003c.ar7.cfg')
+//	- the content of files with an ID below 256 is compressed as raw deflate
+//	  stream (like the TFFS driver stores config files), these files are read
+//	  and compressed by parallel threads - all other files are used unchanged
+//	- the nodes are written in the order of their IDs (with a big endian
+//	  header and padded to the next 4-byte boundary), after the content of
+//	  an optional prefix file (e.g. the output of the other scripts from a
+//	  'build_tffs_image' call) and followed by an optional end marker
+//
+//	Nothing is written, if a node can't be built or the result exceeds the
+//	specified segment size.
+//
+//	Build it with 'gcc -O2 -pthread -o build_tffs_nodes build_tffs_nodes.c -lz'.
+
+#define TFFS_END_ID				0xFFFF
+#define TFFS_FIRST_PLAIN_ID		0x0100
+#define TFFS_MAX_NODE_SIZE		0xFFFF
+#define TFFS_HEADER_SIZE		4
+#define ALIGN4(size)			(((size) + 3) & ~((size_t) 3))
+
+struct tffsNodeFile
+{
+	const char *			name;
+	uint16_t				id;
+	uint8_t *				data;			// node header, (compressed) content and padding
+	size_t					size;
+	size_t					contentSize;	// size of the uncompressed file
+	int						error;			// errno value or -1 for deflate errors
+};
+
+struct nodeJob
+{
+	struct tffsNodeFile *	files;
+	size_t					count;
+	size_t					next;			// next file to compress
+	int						level;
+	pthread_mutex_t			lock;
+};
+
+void usage(void)
+{
+	fprintf(stderr, "build_tffs_nodes - create TFFS nodes with deflated content from files\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "build_tffs_nodes [ --stats ] [ -l <level> ] [ -j <threads> ] [ -s <segment_size> ] [ -p <prefix_file> ] [ -e ] <file> [ ... ]\n");
+	fprintf(stderr, "\nThe name of each file has to start with the hexadecimal node ID (4 digits),");
+	fprintf(stderr, "\nlike for 'build_tffs_image'. The content of files with an ID below 256 is");
+	fprintf(stderr, "\ncompressed (as raw deflate stream) with the specified level (0 to 9, the");
+	fprintf(stderr, "\ndefault is 9) by parallel threads (as many as CPUs are online by default),");
+	fprintf(stderr, "\nother files are stored unchanged.\n");
+	fprintf(stderr, "\nThe nodes are written to STDOUT in the order of their IDs. The content of");
+	fprintf(stderr, "\nthe prefix file ('-' for STDIN) is written in front of them and -e appends");
+	fprintf(stderr, "\nthe end marker (0xFFFF).\n");
+	fprintf(stderr, "\nIf a segment size is specified, the complete output (including the prefix");
+	fprintf(stderr, "\nand the end marker) has to fit into it. Nothing is written, if a file can't");
+	fprintf(stderr, "\nbe read or compressed, if an ID is used twice or if the data doesn't fit.\n");
+}
+
+static bool readAll(int fd, uint8_t **data, size_t *size)
+{
+	size_t		allocated = 0;
+
+	*data = NULL;
+	*size = 0;
+
+	while (true)
+	{
+		ssize_t	got;
+
+		if (*size == allocated)
+		{
+			uint8_t *	newData = realloc(*data, (allocated = (allocated ? allocated * 2 : 65536)));
+
+			if (newData == NULL)
+			{
+				free(*data);
+				*data = NULL;
+				errno = ENOMEM;
+				return false;
+			}
+			*data = newData;
+		}
+
+		if ((got = read(fd, *data + *size, allocated - *size)) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			free(*data);
+			*data = NULL;
+			return false;
+		}
+
+		if (got == 0)
+			return true;
+		*size += got;
+	}
+}
+
+void buildNode(struct tffsNodeFile *file, int level)
+{
+	int			fd = open(file->name, O_RDONLY);
+	uint8_t *	content;
+	size_t		size;
+	uLong		dataSize = 0;
+
+	if (fd == -1)
+	{
+		file->error = errno;
+		return;
+	}
+
+	if (!readAll(fd, &content, &size))
+	{
+		file->error = errno;
+		close(fd);
+		return;
+	}
+	close(fd);
+	file->contentSize = size;
+
+	if (file->id < TFFS_FIRST_PLAIN_ID)
+	{
+		z_stream	stream;
+
+		memset(&stream, 0, sizeof(stream));
+
+		if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			file->error = -1;
+		else
+		{
+			dataSize = deflateBound(&stream, size);
+
+			if ((file->data = malloc(TFFS_HEADER_SIZE + ALIGN4(dataSize))) == NULL)
+				file->error = ENOMEM;
+			else
+			{
+				stream.next_in = content;
+				stream.avail_in = size;
+				stream.next_out = file->data + TFFS_HEADER_SIZE;
+				stream.avail_out = dataSize;
+
+				if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+					file->error = -1;
+				dataSize = stream.total_out;
+			}
+			deflateEnd(&stream);
+		}
+		free(content);
+	}
+	else
+	{
+		dataSize = size;
+		if ((file->data = realloc(content, TFFS_HEADER_SIZE + ALIGN4(size))) == NULL)
+		{
+			free(content);
+			file->error = ENOMEM;
+		}
+		else
+			memmove(file->data + TFFS_HEADER_SIZE, file->data, size);
+	}
+
+	if (file->error != 0)
+		return;
+
+	if (dataSize > TFFS_MAX_NODE_SIZE)
+	{
+		file->error = EFBIG;
+		return;
+	}
+
+	file->data[0] = (uint8_t) (file->id >> 8);
+	file->data[1] = (uint8_t) file->id;
+	file->data[2] = (uint8_t) (dataSize >> 8);
+	file->data[3] = (uint8_t) dataSize;
+	memset(file->data + TFFS_HEADER_SIZE + dataSize, 0, ALIGN4(dataSize) - dataSize);
+	file->size = TFFS_HEADER_SIZE + ALIGN4(dataSize);
+}
+
+void * buildWorker(void *arg)
+{
+	struct nodeJob *	job = arg;
+
+	while (true)
+	{
+		size_t	index;
+
+		pthread_mutex_lock(&job->lock);
+		index = job->next++;
+		pthread_mutex_unlock(&job->lock);
+
+		if (index >= job->count)
+			break;
+
+		buildNode(&job->files[index], job->level);
+	}
+
+	return NULL;
+}
+
+static int compareIds(const void *left, const void *right)
+{
+	return (int) ((const struct tffsNodeFile *) left)->id - (int) ((const struct tffsNodeFile *) right)->id;
+}
+
+static bool parseId(const char *name, uint16_t *id)
+{
+	const char *	baseName = strrchr(name, '/');
+	unsigned int	value = 0;
+
+	baseName = (baseName ? baseName + 1 : name);
+
+	for (int i = 0; i < 4; i++)
+	{
+		char	digit = baseName[i];
+
+		if (digit >= '0' && digit <= '9')
+			value = (value << 4) + (digit - '0');
+		else if (digit >= 'a' && digit <= 'f')
+			value = (value << 4) + (digit - 'a' + 10);
+		else if (digit >= 'A' && digit <= 'F')
+			value = (value << 4) + (digit - 'A' + 10);
+		else
+			return false;
+	}
+
+	if (baseName[4] != '\0' && baseName[4] != '.')
+		return false;
+
+	*id = (uint16_t) value;
+	return (value != 0 && value != TFFS_END_ID);
+}
+
+static bool writeAll(int fd, const uint8_t *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t	written = write(fd, data, size);
+
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+int main(int argc, char * argv[])
+{
+	long					threads = sysconf(_SC_NPROCESSORS_ONLN);
+	bool					statistics = false;
+	bool					endMarker = false;
+	const char *			prefixName = NULL;
+	uint8_t *				prefix = NULL;
+	size_t					prefixSize = 0;
+	unsigned long long		segmentSize = 0;
+	struct toolStatistics	stats;
+	struct nodeJob			job;
+	pthread_t *				workers = NULL;
+	int						started = 0;
+	uint64_t				totalSize;
+	uint64_t				contentSize = 0;
+	bool					failed = false;
+	int						i = 1;
+
+	memset(&job, 0, sizeof(job));
+	job.level = Z_BEST_COMPRESSION;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0')
+	{
+		char *	endOfNumber;
+
+		if (isToolStatisticsOption(argv[i]))
+		{
+			statistics = true;
+			i++;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-e") == 0)
+		{
+			endMarker = true;
+			i++;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-l") != 0 && strcmp(argv[i], "-j") != 0 && strcmp(argv[i], "-s") != 0 && strcmp(argv[i], "-p") != 0)
+		{
+			usage();
+			exit(2);
+		}
+
+		if (i + 1 >= argc || *argv[i + 1] == '\0')
+		{
+			fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+			exit(2);
+		}
+
+		switch (argv[i][1])
+		{
+			case 'l':
+				job.level = strtol(argv[i + 1], &endOfNumber, 10);
+				if (*endOfNumber != '\0' || job.level < 0 || job.level > 9)
+				{
+					fprintf(stderr, "Invalid compression level '%s'.\n", argv[i + 1]);
+					exit(2);
+				}
+				break;
+
+			case 'j':
+				threads = strtol(argv[i + 1], &endOfNumber, 10);
+				if (*endOfNumber != '\0' || threads < 1)
+				{
+					fprintf(stderr, "Invalid number of threads '%s'.\n", argv[i + 1]);
+					exit(2);
+				}
+				break;
+
+			case 's':
+				segmentSize = strtoull(argv[i + 1], &endOfNumber, 0);
+				if (*endOfNumber != '\0' || segmentSize == 0)
+				{
+					fprintf(stderr, "Invalid segment size '%s'.\n", argv[i + 1]);
+					exit(2);
+				}
+				break;
+
+			case 'p':
+				prefixName = argv[i + 1];
+				break;
+		}
+		i += 2;
+	}
+
+	if (argc - i < 1)
+	{
+		usage();
+		exit(2);
+	}
+
+	initToolStatistics(&stats, "build_tffs_nodes", statistics);
+
+	beginToolPhase(&stats, "scan");
+	job.count = argc - i;
+	if ((job.files = calloc(job.count, sizeof(struct tffsNodeFile))) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for the list of files.\n");
+		exit(1);
+	}
+
+	for (size_t j = 0; j < job.count; j++)
+	{
+		job.files[j].name = argv[i + j];
+		if (!parseId(job.files[j].name, &job.files[j].id))
+		{
+			fprintf(stderr, "The name of file '%s' doesn't start with a valid node ID.\n", job.files[j].name);
+			exit(1);
+		}
+	}
+
+	// the order of the arguments doesn't matter, the output is sorted by ID
+	qsort(job.files, job.count, sizeof(struct tffsNodeFile), compareIds);
+	for (size_t j = 1; j < job.count; j++)
+	{
+		if (job.files[j].id == job.files[j - 1].id)
+		{
+			fprintf(stderr, "The files '%s' and '%s' use the same node ID 0x%04X.\n", job.files[j - 1].name, job.files[j].name, job.files[j].id);
+			exit(1);
+		}
+	}
+
+	if (prefixName != NULL)
+	{
+		int		fd = (strcmp(prefixName, "-") == 0 ? STDIN_FILENO : open(prefixName, O_RDONLY));
+
+		if (fd == -1 || !readAll(fd, &prefix, &prefixSize))
+		{
+			fprintf(stderr, "Error %d reading prefix file '%s'.\n", errno, prefixName);
+			exit(1);
+		}
+
+		if (fd != STDIN_FILENO)
+			close(fd);
+	}
+
+	beginToolPhase(&stats, "deflate");
+	pthread_mutex_init(&job.lock, NULL);
+
+	if ((size_t) threads > job.count)
+		threads = job.count;
+
+	if ((workers = calloc(threads, sizeof(pthread_t))) != NULL)
+	{
+		for (started = 0; started < threads; started++)
+		{
+			if (pthread_create(&workers[started], NULL, buildWorker, &job) != 0)
+				break;
+		}
+	}
+
+	// the main thread compresses alone, if no thread could be started
+	if (started == 0)
+		buildWorker(&job);
+
+	for (int j = 0; j < started; j++)
+		pthread_join(workers[j], NULL);
+	free(workers);
+	pthread_mutex_destroy(&job.lock);
+	addToolCounter(&stats, "threads", (started ? started : 1));
+
+	totalSize = prefixSize + (endMarker ? 2 : 0);
+	for (size_t j = 0; j < job.count; j++)
+	{
+		struct tffsNodeFile *	file = &job.files[j];
+
+		if (file->error == EFBIG)
+			fprintf(stderr, "The node for file '%s' exceeds the maximum size of %u bytes.\n", file->name, TFFS_MAX_NODE_SIZE);
+		else if (file->error == -1)
+			fprintf(stderr, "Error compressing file '%s'.\n", file->name);
+		else if (file->error != 0)
+			fprintf(stderr, "Error %d reading file '%s'.\n", file->error, file->name);
+
+		if (file->error != 0)
+			failed = true;
+		totalSize += file->size;
+		contentSize += file->contentSize;
+	}
+
+	if (!failed && segmentSize > 0 && totalSize > segmentSize)
+	{
+		fprintf(stderr, "The nodes need %" PRIu64 " bytes, but the segment size is %llu bytes.\n", totalSize, segmentSize);
+		failed = true;
+	}
+
+	beginToolPhase(&stats, "write");
+	if (!failed)
+	{
+		static const uint8_t	end[] = { 0xFF, 0xFF };
+
+		if (!writeAll(STDOUT_FILENO, prefix, prefixSize))
+			failed = true;
+
+		for (size_t j = 0; !failed && j < job.count; j++)
+		{
+			if (!writeAll(STDOUT_FILENO, job.files[j].data, job.files[j].size))
+				failed = true;
+		}
+
+		if (!failed && endMarker && !writeAll(STDOUT_FILENO, end, sizeof(end)))
+			failed = true;
+
+		if (failed)
+			fprintf(stderr, "Error %d writing to STDOUT.\n", errno);
+	}
+
+	for (size_t j = 0; j < job.count; j++)
+		free(job.files[j].data);
+	free(job.files);
+	free(prefix);
+
+	addToolCounter(&stats, "nodes", job.count);
+	addToolCounter(&stats, "content_bytes", contentSize);
+	addToolCounter(&stats, "image_bytes", totalSize);
+	addToolBytes(&stats, contentSize);
+	writeToolStatistics(&stats);
+
+	exit(failed ? 1 : 0);
+}
@@ -0,0 +1,784 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <fcntl.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+//	One-pass extraction of sections from "extended support data" files:
+//
+//	- sections are enclosed by lines starting with "##### BEGIN SECTION <name> <description>"
+//	  and "##### END SECTION <name>"
+//	- a section containing a base64 encoded TAR file (like TFFS_DUMP) is
+//	  decoded line by line, the TAR headers are parsed from the decoded
+//	  stream and the data of the wanted members is written to the output
+//	  directory - members with a name ending in '.gz' are inflated on the fly
+//	- other sections may be written unchanged to the output directory
+//
+//	The input is read only once and no temporary files are created, all
+//	TFFS dumps (and other sections) are extracted while passing by.
+//
+//	Build it with 'gcc -O2 -o supportdata_extract supportdata_extract.c -lz'.
+
+#define BEGIN_MARKER			"##### BEGIN SECTION "
+#define END_MARKER				"##### END SECTION "
+#define DEFAULT_TAR_SECTION		"TFFS_DUMP"
+#define MAX_SELECTIONS			32
+#define LINE_BUFFER_SIZE		16384
+#define TAR_BLOCK_SIZE			512
+#define INVALID_BASE64			0x01000000
+
+enum tarState
+{
+	tarHeader,
+	tarData,
+	tarPadding,
+	tarEnd,
+};
+
+struct base64Decoder
+{
+	uint8_t					pending[4];
+	int						pendingCount;
+	bool					finished;
+};
+
+struct tarStream
+{
+	enum tarState			state;
+	uint8_t					header[TAR_BLOCK_SIZE];
+	size_t					headerFill;
+	uint64_t				remaining;
+	uint64_t				padding;
+	char					name[260];
+	int						output;
+	bool					inflating;
+	bool					inflateDone;
+	z_stream				inflater;
+	uint8_t					inflated[65536];
+};
+
+struct extractor
+{
+	const char *			inputName;
+	const char *			outputDir;
+	bool					listOnly;
+	const char *			tarSections[MAX_SELECTIONS];
+	int						tarSectionCount;
+	const char *			plainSections[MAX_SELECTIONS];
+	int						plainSectionCount;
+	const char *			indices[MAX_SELECTIONS];
+	bool					indexUsed[MAX_SELECTIONS];
+	int						indexCount;
+	bool					verbose;
+	char					section[256];
+	char					description[256];
+	bool					inSection;
+	bool					isTarSection;
+	int						plainOutput;
+	uint64_t				sectionSize;
+	struct base64Decoder	decoder;
+	struct tarStream		tar;
+	int						extracted;
+	bool					failed;
+};
+
+//	The decoder uses four lookup tables with the 6-bit values of each
+//	character already shifted to its position within the 24-bit group,
+//	so a group of four characters needs only four loads and an OR - an
+//	invalid character sets a bit above the 24-bit value.
+
+static uint32_t		base64Table[4][256];
+
+void initBase64Tables(void)
+{
+	static const char	alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	for (int position = 0; position < 4; position++)
+	{
+		for (int i = 0; i < 256; i++)
+			base64Table[position][i] = INVALID_BASE64;
+
+		for (int i = 0; i < 64; i++)
+			base64Table[position][(uint8_t) alphabet[i]] = (uint32_t) i << (18 - 6 * position);
+	}
+}
+
+size_t decodeBase64(struct base64Decoder *decoder, const char *input, size_t size, uint8_t *output, bool *error)
+{
+	const uint8_t *	in = (const uint8_t *) input;
+	const uint8_t *	end = in + size;
+	uint8_t *		out = output;
+
+	while (in < end && !decoder->finished)
+	{
+		// fast path for complete groups, usually the whole line
+		if (decoder->pendingCount == 0)
+		{
+			while (end - in >= 4)
+			{
+				uint32_t	value = base64Table[0][in[0]] | base64Table[1][in[1]] | base64Table[2][in[2]] | base64Table[3][in[3]];
+
+				if (value & INVALID_BASE64)
+					break;
+
+				out[0] = (uint8_t) (value >> 16);
+				out[1] = (uint8_t) (value >> 8);
+				out[2] = (uint8_t) value;
+				out += 3;
+				in += 4;
+			}
+
+			if (in == end)
+				break;
+		}
+
+		// slow path for line ends, padding and groups spanning lines
+		if (*in == '=')
+		{
+			uint32_t	value = 0;
+
+			for (int i = 0; i < decoder->pendingCount; i++)
+				value |= base64Table[i][decoder->pending[i]];
+
+			if (decoder->pendingCount == 2)
+				*out++ = (uint8_t) (value >> 16);
+			else if (decoder->pendingCount == 3)
+			{
+				*out++ = (uint8_t) (value >> 16);
+				*out++ = (uint8_t) (value >> 8);
+			}
+			else
+				*error = true;
+
+			decoder->pendingCount = 0;
+			decoder->finished = true;
+			break;
+		}
+
+		if (base64Table[0][*in] & INVALID_BASE64)
+		{
+			if (*in != '\n' && *in != '\r' && *in != ' ' && *in != '\t')
+				*error = true;
+			in++;
+			continue;
+		}
+
+		decoder->pending[decoder->pendingCount++] = *in++;
+		if (decoder->pendingCount == 4)
+		{
+			uint32_t	value = base64Table[0][decoder->pending[0]] | base64Table[1][decoder->pending[1]] |
+								base64Table[2][decoder->pending[2]] | base64Table[3][decoder->pending[3]];
+
+			out[0] = (uint8_t) (value >> 16);
+			out[1] = (uint8_t) (value >> 8);
+			out[2] = (uint8_t) value;
+			out += 3;
+			decoder->pendingCount = 0;
+		}
+	}
+
+	return (size_t) (out - output);
+}
+
+static bool writeAll(int fd, const uint8_t *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t	written = write(fd, data, size);
+
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+static uint64_t parseOctal(const uint8_t *field, size_t size)
+{
+	uint64_t	value = 0;
+
+	while (size > 0 && *field == ' ')
+	{
+		field++;
+		size--;
+	}
+
+	for (; size > 0 && *field >= '0' && *field <= '7'; field++, size--)
+		value = (value << 3) + (*field - '0');
+
+	return value;
+}
+
+static bool isSelected(const char *name, const char **list, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (strcmp(name, list[i]) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+//	The output name is derived like in 'tffs_from_supportdata': the base name
+//	of the member without a '.gz' suffix and without any parentheses.
+
+static void outputName(const char *memberName, char *name, size_t size)
+{
+	const char *	baseName = strrchr(memberName, '/');
+	size_t			length;
+	char *			out = name;
+
+	baseName = (baseName ? baseName + 1 : memberName);
+	length = strlen(baseName);
+	if (length > 3 && strcmp(baseName + length - 3, ".gz") == 0)
+		length -= 3;
+
+	for (size_t i = 0; i < length && out < name + size - 1; i++)
+	{
+		if (baseName[i] != '(' && baseName[i] != ')')
+			*out++ = baseName[i];
+	}
+	*out = '\0';
+}
+
+static bool isWantedMember(struct extractor *ex, const char *name)
+{
+	if (*name == '\0')
+		return false;
+
+	if (ex->indexCount == 0)
+		return true;
+
+	// like 'tffs_from_supportdata' does it, only the first member containing an
+	// index is extracted
+	for (int i = 0; i < ex->indexCount; i++)
+	{
+		if (!ex->indexUsed[i] && strstr(name, ex->indices[i]) != NULL)
+		{
+			ex->indexUsed[i] = true;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int createOutput(struct extractor *ex, const char *name)
+{
+	char	path[4096];
+	int		fd;
+
+	snprintf(path, sizeof(path), "%s/%s", ex->outputDir, name);
+	if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666)) == -1)
+	{
+		fprintf(stderr, "Error %d creating output file '%s'.\n", errno, path);
+		ex->failed = true;
+	}
+
+	return fd;
+}
+
+static void startMember(struct extractor *ex)
+{
+	struct tarStream *	tar = &ex->tar;
+	const uint8_t *		header = tar->header;
+	char				memberName[260];
+	char				name[256];
+	char				type = (header[156] == '\0' ? '0' : (char) header[156]);
+
+	tar->remaining = parseOctal(header + 124, 12);
+	tar->padding = (TAR_BLOCK_SIZE - (tar->remaining % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE;
+	tar->output = -1;
+	tar->inflating = false;
+	tar->inflateDone = false;
+
+	if (memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0')
+		snprintf(memberName, sizeof(memberName), "%.155s/%.100s", (const char *) header + 345, (const char *) header);
+	else
+		snprintf(memberName, sizeof(memberName), "%.100s", (const char *) header);
+	strcpy(tar->name, memberName);
+
+	if (ex->listOnly)
+	{
+		if (type == '0')
+			fprintf(stdout, "MEMBER\t%s\t%s\t%" PRIu64 "\n", ex->section, memberName, tar->remaining);
+	}
+	else if (type == '0')
+	{
+		outputName(memberName, name, sizeof(name));
+		if (isWantedMember(ex, name) && (tar->output = createOutput(ex, name)) != -1)
+		{
+			size_t	length = strlen(memberName);
+
+			if (length > 3 && strcmp(memberName + length - 3, ".gz") == 0)
+			{
+				memset(&tar->inflater, 0, sizeof(tar->inflater));
+				if (inflateInit2(&tar->inflater, 15 + 32) != Z_OK)
+				{
+					fprintf(stderr, "Error initializing decompression for member '%s'.\n", memberName);
+					close(tar->output);
+					tar->output = -1;
+					ex->failed = true;
+				}
+				else
+					tar->inflating = true;
+			}
+			ex->extracted++;
+			if (ex->verbose)
+				fprintf(stderr, "Member '%s' of section '%s' extracted to '%s/%s'.\n", memberName, ex->section, ex->outputDir, name);
+		}
+	}
+
+	tar->state = (tar->remaining > 0 ? tarData : (tar->padding > 0 ? tarPadding : tarHeader));
+}
+
+static void finishMember(struct extractor *ex)
+{
+	struct tarStream *	tar = &ex->tar;
+
+	if (tar->inflating)
+	{
+		if (!tar->inflateDone)
+		{
+			fprintf(stderr, "Compressed data of member '%s' is incomplete.\n", tar->name);
+			ex->failed = true;
+		}
+		inflateEnd(&tar->inflater);
+		tar->inflating = false;
+	}
+
+	if (tar->output != -1)
+	{
+		if (close(tar->output) == -1)
+		{
+			fprintf(stderr, "Error %d closing output file for member '%s'.\n", errno, tar->name);
+			ex->failed = true;
+		}
+		tar->output = -1;
+	}
+}
+
+static void memberData(struct extractor *ex, const uint8_t *data, size_t size)
+{
+	struct tarStream *	tar = &ex->tar;
+
+	if (tar->output == -1)
+		return;
+
+	if (!tar->inflating)
+	{
+		if (!writeAll(tar->output, data, size))
+		{
+			fprintf(stderr, "Error %d writing data of member '%s'.\n", errno, tar->name);
+			close(tar->output);
+			tar->output = -1;
+			ex->failed = true;
+		}
+		return;
+	}
+
+	tar->inflater.next_in = (Bytef *) data;
+	tar->inflater.avail_in = size;
+
+	while (tar->inflater.avail_in > 0 && !tar->inflateDone)
+	{
+		int		result;
+
+		tar->inflater.next_out = tar->inflated;
+		tar->inflater.avail_out = sizeof(tar->inflated);
+
+		result = inflate(&tar->inflater, Z_NO_FLUSH);
+		if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+		{
+			fprintf(stderr, "Error %d decompressing member '%s'.\n", result, tar->name);
+			inflateEnd(&tar->inflater);
+			tar->inflating = false;
+			close(tar->output);
+			tar->output = -1;
+			ex->failed = true;
+			return;
+		}
+
+		if (!writeAll(tar->output, tar->inflated, sizeof(tar->inflated) - tar->inflater.avail_out))
+		{
+			fprintf(stderr, "Error %d writing data of member '%s'.\n", errno, tar->name);
+			inflateEnd(&tar->inflater);
+			tar->inflating = false;
+			close(tar->output);
+			tar->output = -1;
+			ex->failed = true;
+			return;
+		}
+
+		if (result == Z_STREAM_END)
+			tar->inflateDone = true;
+	}
+}
+
+void processTarData(struct extractor *ex, const uint8_t *data, size_t size)
+{
+	struct tarStream *	tar = &ex->tar;
+
+	while (size > 0 && tar->state != tarEnd)
+	{
+		size_t	used;
+
+		switch (tar->state)
+		{
+			case tarHeader:
+				used = TAR_BLOCK_SIZE - tar->headerFill;
+				if (used > size)
+					used = size;
+				memcpy(tar->header + tar->headerFill, data, used);
+				tar->headerFill += used;
+				if (tar->headerFill == TAR_BLOCK_SIZE)
+				{
+					tar->headerFill = 0;
+					if (tar->header[0] == '\0')
+						tar->state = tarEnd;
+					else
+						startMember(ex);
+				}
+				break;
+
+			case tarData:
+				used = (tar->remaining < size ? (size_t) tar->remaining : size);
+				memberData(ex, data, used);
+				tar->remaining -= used;
+				if (tar->remaining == 0)
+				{
+					finishMember(ex);
+					tar->state = (tar->padding > 0 ? tarPadding : tarHeader);
+				}
+				break;
+
+			case tarPadding:
+				used = (tar->padding < size ? (size_t) tar->padding : size);
+				tar->padding -= used;
+				if (tar->padding == 0)
+					tar->state = tarHeader;
+				break;
+
+			default:
+				used = size;
+				break;
+		}
+
+		data += used;
+		size -= used;
+	}
+}
+
+static void beginSection(struct extractor *ex, const char *line)
+{
+	const char *	name = line + strlen(BEGIN_MARKER);
+	size_t			length = strcspn(name, " \t\r\n");
+	const char *	description = name + length;
+
+	if (length >= sizeof(ex->section))
+		length = sizeof(ex->section) - 1;
+	memcpy(ex->section, name, length);
+	ex->section[length] = '\0';
+
+	description += strspn(description, " \t");
+
+	ex->inSection = true;
+	ex->sectionSize = 0;
+	ex->plainOutput = -1;
+	ex->isTarSection = isSelected(ex->section, ex->tarSections, ex->tarSectionCount);
+
+	if (ex->isTarSection)
+	{
+		memset(&ex->decoder, 0, sizeof(ex->decoder));
+		ex->tar.state = tarHeader;
+		ex->tar.headerFill = 0;
+		ex->tar.output = -1;
+		ex->tar.inflating = false;
+	}
+	else if (!ex->listOnly && isSelected(ex->section, ex->plainSections, ex->plainSectionCount))
+	{
+		ex->plainOutput = createOutput(ex, ex->section);
+		if (ex->plainOutput != -1)
+			ex->extracted++;
+	}
+
+	length = strcspn(description, "\r\n");
+	if (length >= sizeof(ex->description))
+		length = sizeof(ex->description) - 1;
+	memcpy(ex->description, description, length);
+	ex->description[length] = '\0';
+}
+
+static void endSection(struct extractor *ex)
+{
+	if (ex->isTarSection)
+	{
+		if (ex->tar.state == tarData || ex->tar.state == tarPadding || ex->tar.headerFill > 0)
+		{
+			fprintf(stderr, "The TAR file in section '%s' is truncated.\n", ex->section);
+			ex->failed = true;
+		}
+		finishMember(ex);
+	}
+
+	if (ex->plainOutput != -1)
+	{
+		if (close(ex->plainOutput) == -1)
+		{
+			fprintf(stderr, "Error %d closing output file for section '%s'.\n", errno, ex->section);
+			ex->failed = true;
+		}
+		else if (ex->verbose)
+			fprintf(stderr, "Section '%s' extracted to '%s/%s'.\n", ex->section, ex->outputDir, ex->section);
+		ex->plainOutput = -1;
+	}
+
+	if (ex->listOnly)
+		fprintf(stdout, "SECTION\t%s\t%" PRIu64 "\t%s\n", ex->section, ex->sectionSize, ex->description);
+
+	ex->inSection = false;
+}
+
+static void sectionLine(struct extractor *ex, const char *line, size_t length)
+{
+	ex->sectionSize += length;
+
+	if (ex->isTarSection)
+	{
+		uint8_t	decoded[LINE_BUFFER_SIZE];
+		bool	error = false;
+		size_t	size = decodeBase64(&ex->decoder, line, length, decoded, &error);
+
+		if (error)
+		{
+			fprintf(stderr, "Invalid base64 data found in section '%s'.\n", ex->section);
+			ex->failed = true;
+			ex->isTarSection = false;
+			return;
+		}
+
+		processTarData(ex, decoded, size);
+	}
+	else if (ex->plainOutput != -1)
+	{
+		if (!writeAll(ex->plainOutput, (const uint8_t *) line, length))
+		{
+			fprintf(stderr, "Error %d writing section '%s'.\n", errno, ex->section);
+			close(ex->plainOutput);
+			ex->plainOutput = -1;
+			ex->failed = true;
+		}
+	}
+}
+
+bool processInput(struct extractor *ex, FILE *input)
+{
+	char	line[LINE_BUFFER_SIZE];
+	bool	lineStart = true;
+
+	while (fgets(line, sizeof(line), input) != NULL)
+	{
+		size_t	length = strlen(line);
+		bool	atStart = lineStart;
+
+		// a line longer than the buffer is processed in pieces, only the
+		// first one may contain a marker
+		lineStart = (length > 0 && line[length - 1] == '\n');
+
+		if (atStart && line[0] == '#')
+		{
+			if (!ex->inSection && strncmp(line, BEGIN_MARKER, strlen(BEGIN_MARKER)) == 0)
+			{
+				beginSection(ex, line);
+				continue;
+			}
+
+			if (ex->inSection && strncmp(line, END_MARKER, strlen(END_MARKER)) == 0 &&
+				strncmp(line + strlen(END_MARKER), ex->section, strlen(ex->section)) == 0 &&
+				strchr(" \t\r\n", line[strlen(END_MARKER) + strlen(ex->section)]) != NULL)
+			{
+				endSection(ex);
+				continue;
+			}
+		}
+
+		if (ex->inSection)
+			sectionLine(ex, line, length);
+	}
+
+	if (ferror(input))
+	{
+		fprintf(stderr, "Error %d reading input file '%s'.\n", errno, ex->inputName);
+		return false;
+	}
+
+	if (ex->inSection)
+	{
+		fprintf(stderr, "Section '%s' isn't terminated.\n", ex->section);
+		ex->failed = true;
+		endSection(ex);
+	}
+
+	return true;
+}
+
+void usage(void)
+{
+	fprintf(stderr, "supportdata_extract - extract sections and TFFS dumps from support data files\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "supportdata_extract [ -v ] [ -i <tffs_index> ... ] [ -s <section> ... ] [ -t <section> ... ] <support_data_file> <output_dir>\n");
+	fprintf(stderr, "supportdata_extract -l [ -t <section> ... ] <support_data_file>\n");
+	fprintf(stderr, "\nThe 'extended support data' file (or STDIN, if its name is '-') is read once");
+	fprintf(stderr, "\nand the members of the base64 encoded TAR file in section 'TFFS_DUMP' are");
+	fprintf(stderr, "\nwritten to the output directory, compressed members ('.gz') are inflated.\n");
+	fprintf(stderr, "\nThe output name is the base name of the member without '.gz' and without");
+	fprintf(stderr, "\nparentheses, with -i only the first member containing the specified index in");
+	fprintf(stderr, "\nits name (like '1' or '2' for 'mtd1'/'mtd2') is extracted.\n");
+	fprintf(stderr, "\nUse -s to write other sections (without their markers) to the output");
+	fprintf(stderr, "\ndirectory as files named like the section and -t to handle more sections");
+	fprintf(stderr, "\nas base64 encoded TAR files, -v shows each extracted member and section.\n");
+	fprintf(stderr, "\nWith -l all sections ('SECTION <name> <size> <description>') and the members");
+	fprintf(stderr, "\nof the TAR sections ('MEMBER <section> <name> <size>') are listed on STDOUT");
+	fprintf(stderr, "\ninstead (separated by tabs) and an output directory isn't needed.\n");
+}
+
+int main(int argc, char * argv[])
+{
+	static struct extractor	ex;
+	FILE *					input;
+	int						i = 1;
+
+	ex.tarSections[ex.tarSectionCount++] = DEFAULT_TAR_SECTION;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0')
+	{
+		const char **	list;
+		int *			count;
+
+		if (strcmp(argv[i], "-l") == 0)
+		{
+			ex.listOnly = true;
+			i++;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-v") == 0)
+		{
+			ex.verbose = true;
+			i++;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-i") == 0)
+		{
+			list = ex.indices;
+			count = &ex.indexCount;
+		}
+		else if (strcmp(argv[i], "-s") == 0)
+		{
+			list = ex.plainSections;
+			count = &ex.plainSectionCount;
+		}
+		else if (strcmp(argv[i], "-t") == 0)
+		{
+			list = ex.tarSections;
+			count = &ex.tarSectionCount;
+		}
+		else
+		{
+			usage();
+			exit(2);
+		}
+
+		if (i + 1 >= argc || *argv[i + 1] == '\0')
+		{
+			fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+			exit(2);
+		}
+
+		if (*count == MAX_SELECTIONS)
+		{
+			fprintf(stderr, "Too many values specified for option '%s'.\n", argv[i]);
+			exit(2);
+		}
+
+		list[(*count)++] = argv[i + 1];
+		i += 2;
+	}
+
+	if (argc - i != (ex.listOnly ? 1 : 2))
+	{
+		usage();
+		exit(2);
+	}
+
+	ex.inputName = argv[i];
+	ex.outputDir = (ex.listOnly ? NULL : argv[i + 1]);
+	ex.plainOutput = -1;
+	ex.tar.output = -1;
+
+	if (strcmp(ex.inputName, "-") == 0)
+		input = stdin;
+	else if ((input = fopen(ex.inputName, "r")) == NULL)
+	{
+		fprintf(stderr, "Error %d opening input file '%s'.\n", errno, ex.inputName);
+		exit(1);
+	}
+
+	setvbuf(input, NULL, _IOFBF, 1024 * 1024);
+	initBase64Tables();
+
+	if (!processInput(&ex, input))
+		ex.failed = true;
+
+	if (input != stdin)
+		fclose(input);
+
+	if (!ex.listOnly && ex.extracted == 0)
+	{
+		fprintf(stderr, "Nothing was extracted from file '%s'.\n", ex.inputName);
+		ex.failed = true;
+	}
+
+	exit(ex.failed ? 1 : 0);
+}
@@ -0,0 +1,791 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <zlib.h>
+
+#include "../include/tool_statistics.h"
+
+//	Compare the nodes of two or more TFFS dumps:
+//
+//	- each dump is parsed with a single pass over its (memory mapped) content
+//	  by one of some parallel threads, the same way as 'dissect_tffs_dump'
+//	  does it - a node starts with its ID and the length of its data, both
+//	  as 16-bit values, the data is padded to the next 4-byte boundary, ID 0
+//	  marks a deleted node and ID 0xFFFF the end of the used space
+//	- the CRC32 of each node's payload is computed while passing by, nodes
+//	  with an ID below 256 (the deflated config files) are inflated into a
+//	  small buffer first, so a different compression doesn't count as change
+//	- the name table (node 511) of each dump is used to show the names of
+//	  environment variables, names of other nodes may be loaded from a file
+//	  like 'data/tffs.files' - the table itself (and the segment number in
+//	  node 1) is compared by its decoded values, not by the bytes in the
+//	  byte order of the dump
+//
+//	No temporary files are created, the content of a dump isn't kept after
+//	it was parsed - only the ID, size and CRC32 of each node.
+//
+//	Build it with 'gcc -O2 -pthread -o tffs_diff tffs_diff.c -lz'.
+
+#define TFFS_END_ID				0xFFFF
+#define TFFS_DELETED_ID			0x0000
+#define TFFS_SEGMENT_ID			0x0001
+#define TFFS_NAME_TABLE_ID		0x01FF
+#define TFFS_FIRST_PLAIN_ID		0x0100
+#define TFFS_ID_COUNT			0x10000
+#define ALIGN4(size)			(((size) + 3) & ~((size_t) 3))
+#define INFLATE_BUFFER_SIZE		65536
+
+struct tffsNode
+{
+	uint16_t				id;
+	uint16_t				size;			// size of the stored data
+	uint32_t				crc;
+	uint32_t				contentSize;	// size after inflating
+	bool					inflated;
+};
+
+struct tffsName
+{
+	uint16_t				id;
+	char *					name;
+};
+
+struct tffsDump
+{
+	char *					name;
+	struct tffsNode *		nodes;
+	unsigned int			count;
+	struct tffsName *		names;
+	unsigned int			nameCount;
+	unsigned int			duplicates;
+	uint64_t				size;
+	uint64_t				inflatedBytes;
+	bool					littleEndian;
+	bool					parsed;
+	bool					failed;
+};
+
+struct diffJob
+{
+	struct tffsDump *		dumps;
+	size_t					count;
+	size_t					allocated;
+	size_t					next;			// next dump to parse
+	pthread_mutex_t			lock;
+};
+
+struct workerContext
+{
+	z_stream				inflater;
+	bool					inflaterReady;
+	int32_t					lastIndex[TFFS_ID_COUNT];
+	uint8_t					buffer[INFLATE_BUFFER_SIZE];
+};
+
+static const char *			nodeNames[TFFS_ID_COUNT];
+
+void usage(void)
+{
+	fprintf(stderr, "tffs_diff - compare the nodes of TFFS dumps\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "tffs_diff [ --stats ] [ -b ] [ -j <threads> ] [ -n <names_file> ] <dump_or_directory> <dump_or_directory> [ ... ]\n");
+	fprintf(stderr, "\nThe dumps are parsed by parallel threads (as many as CPUs are online by");
+	fprintf(stderr, "\ndefault), a directory is replaced by the files it contains (in the order");
+	fprintf(stderr, "\nof their names). Each dump is compared with the one in front of it, with");
+	fprintf(stderr, "\n-b (--baseline) all dumps are compared with the first one.\n");
+	fprintf(stderr, "\nOne line is written for each added, removed or changed node, the fields are");
+	fprintf(stderr, "\nseparated by tabs:\n");
+	fprintf(stderr, "\n<ADDED|REMOVED|CHANGED> <old_dump> <new_dump> <id> <name> <old_size> <old_crc32> <new_size> <new_crc32>\n");
+	fprintf(stderr, "\nThe size and CRC32 values of nodes with an ID below 256 are computed from");
+	fprintf(stderr, "\nthe inflated content. Names of environment variables are taken from the");
+	fprintf(stderr, "\nname table of the dumps, the names of other nodes may be read from a file");
+	fprintf(stderr, "\nwith an ID (decimal) and a name on each line, like 'data/tffs.files'.\n");
+	fprintf(stderr, "\nThe exit code is 0, if no differences were found, 1 if there are some and");
+	fprintf(stderr, "\n2 on errors.\n");
+}
+
+static uint16_t getTffsWord(struct tffsDump *dump, const uint8_t *data)
+{
+	return (dump->littleEndian ? (data[1] << 8) | data[0] : (data[0] << 8) | data[1]);
+}
+
+static uint32_t getTffsLong(struct tffsDump *dump, const uint8_t *data)
+{
+	if (dump->littleEndian)
+		return ((uint32_t) data[3] << 24) | ((uint32_t) data[2] << 16) | ((uint32_t) data[1] << 8) | data[0];
+	return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) | ((uint32_t) data[2] << 8) | data[3];
+}
+
+//	The node data is inflated as raw deflate stream, if that fails, the
+//	stored data is used - some nodes in this range aren't compressed.
+
+static bool inflateNode(struct workerContext *context, const uint8_t *data, size_t size, struct tffsNode *node)
+{
+	z_stream *	stream = &context->inflater;
+	uint32_t	crc = crc32(0, Z_NULL, 0);
+	uint64_t	contentSize = 0;
+	int			result;
+
+	if (!context->inflaterReady)
+	{
+		memset(stream, 0, sizeof(z_stream));
+		if (inflateInit2(stream, -MAX_WBITS) != Z_OK)
+			return false;
+		context->inflaterReady = true;
+	}
+	else if (inflateReset(stream) != Z_OK)
+		return false;
+
+	stream->next_in = (Bytef *) data;
+	stream->avail_in = size;
+
+	do
+	{
+		stream->next_out = context->buffer;
+		stream->avail_out = sizeof(context->buffer);
+		result = inflate(stream, Z_NO_FLUSH);
+
+		if (result != Z_OK && result != Z_STREAM_END)
+			return false;
+
+		crc = crc32(crc, context->buffer, sizeof(context->buffer) - stream->avail_out);
+		contentSize += sizeof(context->buffer) - stream->avail_out;
+	} while (result != Z_STREAM_END && (stream->avail_in > 0 || stream->avail_out == 0));
+
+	if (result != Z_STREAM_END || contentSize > UINT32_MAX)
+		return false;
+
+	node->crc = crc;
+	node->contentSize = contentSize;
+	node->inflated = true;
+
+	return true;
+}
+
+static bool addNameTable(struct tffsDump *dump, const uint8_t *data, size_t size)
+{
+	size_t		offset = 0;
+
+	// entries contain a 32-bit ID and a NUL terminated name, aligned to 4 bytes
+	while (offset + 5 <= size)
+	{
+		const char *	name = (const char *) data + offset + 4;
+		size_t			length = strnlen(name, size - offset - 4);
+		struct tffsName *	newNames;
+
+		if (offset + 4 + length >= size)
+			break;
+
+		if ((newNames = realloc(dump->names, (dump->nameCount + 1) * sizeof(struct tffsName))) == NULL ||
+			(newNames[dump->nameCount].name = strndup(name, length)) == NULL)
+		{
+			if (newNames != NULL)
+				dump->names = newNames;
+			return false;
+		}
+
+		dump->names = newNames;
+		dump->names[dump->nameCount++].id = (uint16_t) getTffsLong(dump, data + offset);
+		offset += ALIGN4(4 + length + 1);
+	}
+
+	return true;
+}
+
+//	The name table is stored in the byte order of the device, its CRC32 is
+//	computed from the decoded entries (the ID as big endian value and the
+//	NUL terminated name), so dumps with different byte order are equal, if
+//	they contain the same names.
+
+static void hashNameTable(struct tffsDump *dump, struct tffsNode *node)
+{
+	uint32_t	crc = crc32(0, Z_NULL, 0);
+
+	for (unsigned int i = 0; i < dump->nameCount; i++)
+	{
+		uint8_t		id[4] = { 0, 0, dump->names[i].id >> 8, dump->names[i].id & 0xFF };
+
+		crc = crc32(crc, id, sizeof(id));
+		crc = crc32(crc, (const Bytef *) dump->names[i].name, strlen(dump->names[i].name) + 1);
+	}
+
+	node->crc = crc;
+}
+
+static int compareNodes(const void *left, const void *right)
+{
+	return (int) ((const struct tffsNode *) left)->id - (int) ((const struct tffsNode *) right)->id;
+}
+
+//	A node written again later replaces an earlier version with the same
+//	ID - usually the old one was set to ID 0 already, but a dump created
+//	while the TFFS was written may contain both of them.
+
+static bool parseNodes(struct tffsDump *dump, struct workerContext *context, const uint8_t *data, size_t size)
+{
+	size_t		offset = 0;
+	size_t		allocated = 0;
+
+	// the segment header is node 1 with 4 bytes of data, it shows the byte order
+	dump->littleEndian = (size >= 4 && data[0] == 0x01 && data[1] == 0x00 && data[2] == 0x04 && data[3] == 0x00);
+
+	while (offset + 4 <= size)
+	{
+		uint16_t			id = getTffsWord(dump, data + offset);
+		uint16_t			length = getTffsWord(dump, data + offset + 2);
+		const uint8_t *		content = data + offset + 4;
+		struct tffsNode *	node;
+
+		if (id == TFFS_END_ID)
+			break;
+
+		if (length > size - offset - 4)
+		{
+			fprintf(stderr, "Node 0x%04X at offset 0x%zx in dump '%s' exceeds the end of the file.\n", id, offset, dump->name);
+			return false;
+		}
+
+		offset += 4 + ALIGN4((size_t) length);
+		if (id == TFFS_DELETED_ID)
+			continue;
+
+		if (context->lastIndex[id] >= 0)
+		{
+			node = &dump->nodes[context->lastIndex[id]];
+			dump->duplicates++;
+		}
+		else
+		{
+			if (dump->count == allocated)
+			{
+				struct tffsNode *	newNodes = realloc(dump->nodes, (allocated = (allocated ? allocated * 2 : 256)) * sizeof(struct tffsNode));
+
+				if (newNodes == NULL)
+				{
+					fprintf(stderr, "Error allocating memory for the nodes of dump '%s'.\n", dump->name);
+					return false;
+				}
+				dump->nodes = newNodes;
+			}
+			context->lastIndex[id] = dump->count;
+			node = &dump->nodes[dump->count++];
+		}
+
+		memset(node, 0, sizeof(struct tffsNode));
+		node->id = id;
+		node->size = length;
+
+		if (id > TFFS_SEGMENT_ID && id < TFFS_FIRST_PLAIN_ID && inflateNode(context, content, length, node))
+			dump->inflatedBytes += node->contentSize;
+		else if (id == TFFS_SEGMENT_ID && length == 4)
+		{
+			// the segment number is hashed as big endian value, like the IDs in the name table
+			uint32_t	segment = getTffsLong(dump, content);
+			uint8_t		value[4] = { segment >> 24, (segment >> 16) & 0xFF, (segment >> 8) & 0xFF, segment & 0xFF };
+
+			node->crc = crc32(crc32(0, Z_NULL, 0), value, sizeof(value));
+			node->contentSize = length;
+		}
+		else
+		{
+			node->crc = crc32(crc32(0, Z_NULL, 0), content, length);
+			node->contentSize = length;
+		}
+
+		if (id == TFFS_NAME_TABLE_ID)
+		{
+			// a newer name table replaces the old one
+			for (unsigned int i = 0; i < dump->nameCount; i++)
+				free(dump->names[i].name);
+			dump->nameCount = 0;
+
+			if (!addNameTable(dump, content, length))
+			{
+				fprintf(stderr, "Error allocating memory for the name table of dump '%s'.\n", dump->name);
+				return false;
+			}
+			hashNameTable(dump, node);
+		}
+	}
+
+	return true;
+}
+
+void parseDump(struct tffsDump *dump, struct workerContext *context)
+{
+	int				fd = open(dump->name, O_RDONLY);
+	struct stat		st;
+	uint8_t *		content = MAP_FAILED;
+	bool			result;
+
+	if (fd == -1 || fstat(fd, &st) == -1)
+	{
+		fprintf(stderr, "Error %d opening dump '%s'.\n", errno, dump->name);
+		if (fd != -1)
+			close(fd);
+		dump->failed = true;
+		return;
+	}
+
+	dump->size = st.st_size;
+	if (st.st_size > 0 && (content = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+	{
+		fprintf(stderr, "Error %d mapping dump '%s' into memory.\n", errno, dump->name);
+		close(fd);
+		dump->failed = true;
+		return;
+	}
+	close(fd);
+
+	for (size_t i = 0; i < TFFS_ID_COUNT; i++)
+		context->lastIndex[i] = -1;
+
+	if (content != MAP_FAILED)
+	{
+		madvise(content, st.st_size, MADV_SEQUENTIAL);
+		result = parseNodes(dump, context, content, st.st_size);
+		munmap(content, st.st_size);
+	}
+	else
+		result = true;
+
+	if (result)
+		qsort(dump->nodes, dump->count, sizeof(struct tffsNode), compareNodes);
+	dump->failed = !result;
+	dump->parsed = true;
+}
+
+void * parseWorker(void *arg)
+{
+	struct diffJob *		job = arg;
+	struct workerContext *	context = malloc(sizeof(struct workerContext));
+
+	// dumps left by a worker without a context are reported as failed later
+	if (context == NULL)
+		return NULL;
+	context->inflaterReady = false;
+
+	while (true)
+	{
+		size_t	index;
+
+		pthread_mutex_lock(&job->lock);
+		index = job->next++;
+		pthread_mutex_unlock(&job->lock);
+
+		if (index >= job->count)
+			break;
+
+		parseDump(&job->dumps[index], context);
+	}
+
+	if (context->inflaterReady)
+		inflateEnd(&context->inflater);
+	free(context);
+
+	return NULL;
+}
+
+bool addDump(struct diffJob *job, const char *path)
+{
+	if (job->count == job->allocated)
+	{
+		size_t				newAllocated = (job->allocated ? job->allocated * 2 : 64);
+		struct tffsDump *	newDumps = realloc(job->dumps, newAllocated * sizeof(struct tffsDump));
+
+		if (newDumps == NULL)
+		{
+			fprintf(stderr, "Error allocating memory for the list of dumps.\n");
+			return false;
+		}
+
+		job->dumps = newDumps;
+		job->allocated = newAllocated;
+	}
+
+	memset(&job->dumps[job->count], 0, sizeof(struct tffsDump));
+	if ((job->dumps[job->count].name = strdup(path)) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for the list of dumps.\n");
+		return false;
+	}
+	job->count++;
+
+	return true;
+}
+
+int compareNames(const void *left, const void *right)
+{
+	return strcmp(*(char * const *) left, *(char * const *) right);
+}
+
+//	A snapshot directory contains one dump per file, subdirectories and
+//	hidden files are ignored.
+
+bool addPath(struct diffJob *job, const char *path)
+{
+	struct stat		st;
+	DIR *			dir;
+	struct dirent *	entry;
+	char **			names = NULL;
+	size_t			count = 0;
+	size_t			allocated = 0;
+	bool			result = true;
+
+	if (stat(path, &st) == -1)
+	{
+		fprintf(stderr, "Error %d accessing '%s'.\n", errno, path);
+		return false;
+	}
+
+	if (!S_ISDIR(st.st_mode))
+		return addDump(job, path);
+
+	if ((dir = opendir(path)) == NULL)
+	{
+		fprintf(stderr, "Error %d opening directory '%s'.\n", errno, path);
+		return false;
+	}
+
+	while (result && (entry = readdir(dir)) != NULL)
+	{
+		if (entry->d_name[0] == '.')
+			continue;
+
+		if (count == allocated)
+		{
+			char **	newNames = realloc(names, (allocated = (allocated ? allocated * 2 : 64)) * sizeof(char *));
+
+			if (newNames == NULL)
+			{
+				fprintf(stderr, "Error allocating memory for the content of directory '%s'.\n", path);
+				result = false;
+				break;
+			}
+			names = newNames;
+		}
+
+		if (asprintf(&names[count], "%s%s%s", path, (path[strlen(path) - 1] == '/' ? "" : "/"), entry->d_name) == -1)
+		{
+			fprintf(stderr, "Error allocating memory for the content of directory '%s'.\n", path);
+			result = false;
+			break;
+		}
+		count++;
+	}
+	closedir(dir);
+
+	if (result)
+		qsort(names, count, sizeof(char *), compareNames);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (result && stat(names[i], &st) == 0 && S_ISREG(st.st_mode) && !addDump(job, names[i]))
+			result = false;
+		free(names[i]);
+	}
+	free(names);
+
+	return result;
+}
+
+bool loadNames(const char *fileName)
+{
+	FILE *		file = fopen(fileName, "r");
+	char		line[1024];
+
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error %d opening names file '%s'.\n", errno, fileName);
+		return false;
+	}
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		char *			endOfId;
+		unsigned long	id = strtoul(line, &endOfId, 0);
+		char *			name = endOfId + strspn(endOfId, " \t");
+		size_t			length = strcspn(name, " \t\r\n");
+
+		if (endOfId == line || id >= TFFS_ID_COUNT || length == 0 || nodeNames[id] != NULL)
+			continue;
+
+		if ((nodeNames[id] = strndup(name, length)) == NULL)
+		{
+			fprintf(stderr, "Error allocating memory for the node names.\n");
+			fclose(file);
+			return false;
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+static const char * nodeName(struct tffsDump *older, struct tffsDump *newer, uint16_t id)
+{
+	struct tffsDump *	dumps[] = { newer, older };
+
+	if (nodeNames[id] != NULL)
+		return nodeNames[id];
+
+	if (id == TFFS_NAME_TABLE_ID)
+		return "nametable";
+
+	for (unsigned int i = 0; i < 2; i++)
+	{
+		for (unsigned int j = 0; j < dumps[i]->nameCount; j++)
+		{
+			if (dumps[i]->names[j].id == id)
+				return dumps[i]->names[j].name;
+		}
+	}
+
+	return "-";
+}
+
+static void printNode(struct tffsNode *node)
+{
+	if (node != NULL)
+		printf("\t%" PRIu32 "\t%08X", node->contentSize, node->crc);
+	else
+		printf("\t-\t-");
+}
+
+unsigned int compareDumps(struct tffsDump *older, struct tffsDump *newer)
+{
+	unsigned int	differences = 0;
+	unsigned int	i = 0;
+	unsigned int	j = 0;
+
+	// both node lists are sorted by their IDs
+	while (i < older->count || j < newer->count)
+	{
+		struct tffsNode *	oldNode = (i < older->count ? &older->nodes[i] : NULL);
+		struct tffsNode *	newNode = (j < newer->count ? &newer->nodes[j] : NULL);
+		const char *		state;
+
+		if (newNode == NULL || (oldNode != NULL && oldNode->id < newNode->id))
+		{
+			state = "REMOVED";
+			newNode = NULL;
+			i++;
+		}
+		else if (oldNode == NULL || newNode->id < oldNode->id)
+		{
+			state = "ADDED";
+			oldNode = NULL;
+			j++;
+		}
+		else
+		{
+			i++;
+			j++;
+			if (oldNode->crc == newNode->crc && oldNode->contentSize == newNode->contentSize)
+				continue;
+			state = "CHANGED";
+		}
+
+		printf("%s\t%s\t%s\t%u\t%s", state, older->name, newer->name, (oldNode ? oldNode->id : newNode->id), nodeName(older, newer, (oldNode ? oldNode->id : newNode->id)));
+		printNode(oldNode);
+		printNode(newNode);
+		printf("\n");
+		differences++;
+	}
+
+	return differences;
+}
+
+int main(int argc, char * argv[])
+{
+	long					threads = sysconf(_SC_NPROCESSORS_ONLN);
+	bool					baseline = false;
+	bool					statistics = false;
+	const char *			namesFile = NULL;
+	struct toolStatistics	stats;
+	struct diffJob			job;
+	pthread_t *				workers = NULL;
+	int						started = 0;
+	unsigned int			differences = 0;
+	bool					failed = false;
+	uint64_t				totalBytes = 0;
+	uint64_t				totalNodes = 0;
+	uint64_t				inflatedBytes = 0;
+	int						i = 1;
+
+	memset(&job, 0, sizeof(job));
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0')
+	{
+		if (isToolStatisticsOption(argv[i]))
+			statistics = true;
+		else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--baseline") == 0)
+			baseline = true;
+		else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "-n") == 0)
+		{
+			if (i + 1 >= argc || *argv[i + 1] == '\0')
+			{
+				fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+				exit(2);
+			}
+
+			if (argv[i][1] == 'n')
+				namesFile = argv[i + 1];
+			else
+			{
+				char *	endOfNumber;
+
+				threads = strtol(argv[i + 1], &endOfNumber, 10);
+				if (*endOfNumber != '\0' || threads < 1)
+				{
+					fprintf(stderr, "Invalid number of threads '%s'.\n", argv[i + 1]);
+					exit(2);
+				}
+			}
+			i++;
+		}
+		else
+		{
+			usage();
+			exit(2);
+		}
+		i++;
+	}
+
+	if (argc - i < 1)
+	{
+		usage();
+		exit(2);
+	}
+
+	initToolStatistics(&stats, "tffs_diff", statistics);
+
+	beginToolPhase(&stats, "scan");
+	if (namesFile != NULL && !loadNames(namesFile))
+		exit(2);
+
+	for (; i < argc; i++)
+	{
+		if (!addPath(&job, argv[i]))
+			exit(2);
+	}
+
+	if (job.count < 2)
+	{
+		fprintf(stderr, "At least two dumps are needed for a comparison.\n");
+		exit(2);
+	}
+
+	beginToolPhase(&stats, "parse");
+	pthread_mutex_init(&job.lock, NULL);
+
+	if ((size_t) threads > job.count)
+		threads = job.count;
+
+	if ((workers = calloc(threads, sizeof(pthread_t))) != NULL)
+	{
+		for (started = 0; started < threads; started++)
+		{
+			if (pthread_create(&workers[started], NULL, parseWorker, &job) != 0)
+				break;
+		}
+	}
+
+	// the main thread parses alone, if no thread could be started
+	if (started == 0)
+		parseWorker(&job);
+
+	for (int j = 0; j < started; j++)
+		pthread_join(workers[j], NULL);
+	free(workers);
+	pthread_mutex_destroy(&job.lock);
+	addToolCounter(&stats, "threads", (started ? started : 1));
+
+	for (size_t j = 0; j < job.count; j++)
+	{
+		struct tffsDump *	dump = &job.dumps[j];
+
+		if (!dump->parsed)
+			fprintf(stderr, "Error allocating memory to parse dump '%s'.\n", dump->name);
+
+		if (dump->failed || !dump->parsed)
+			failed = true;
+		totalBytes += dump->size;
+		totalNodes += dump->count;
+		inflatedBytes += dump->inflatedBytes;
+
+		if (dump->duplicates > 0)
+			fprintf(stderr, "Dump '%s' contains %u nodes more than once, the last version of each node was used.\n", dump->name, dump->duplicates);
+	}
+
+	beginToolPhase(&stats, "compare");
+	if (!failed)
+	{
+		for (size_t j = 1; j < job.count; j++)
+			differences += compareDumps(&job.dumps[baseline ? 0 : j - 1], &job.dumps[j]);
+	}
+
+	for (size_t j = 0; j < job.count; j++)
+	{
+		for (unsigned int k = 0; k < job.dumps[j].nameCount; k++)
+			free(job.dumps[j].names[k].name);
+		free(job.dumps[j].names);
+		free(job.dumps[j].nodes);
+		free(job.dumps[j].name);
+	}
+	free(job.dumps);
+
+	addToolCounter(&stats, "dumps", job.count);
+	addToolCounter(&stats, "nodes", totalNodes);
+	addToolCounter(&stats, "inflated_bytes", inflatedBytes);
+	addToolCounter(&stats, "differences", differences);
+	addToolBytes(&stats, totalBytes);
+	writeToolStatistics(&stats);
+
+	if (fflush(stdout) != 0)
+	{
+		fprintf(stderr, "Error %d writing to STDOUT.\n", errno);
+		failed = true;
+	}
+
+	exit(failed ? 2 : (differences > 0 ? 1 : 0));
+}
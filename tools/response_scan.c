@@ -0,0 +1,1012 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <fcntl.h>
+
+//	Scanner for responses from FRITZ!OS devices, a replacement for the
+//	regular expressions in the 'fb_xml_extract' and 'fb_xml_insert'
+//	functions of 'export/fritzbox' and for the 'parseJSON' script:
+//
+//	xml_extract <tag> [ <file> ]
+//		- show the content of the last element with the specified name (compared
+//		  case-insensitive)
+//	xml_insert <before> <tag> <new> [ <file> ]
+//		- insert the string <new> before (<before> is 1) or after (0) the last
+//		  element with the specified name
+//	json [ <parseJSON options> ] <file> [ <name> ... ]
+//		- create shell assignments from the output of 'query.lua', the options
+//		  and the output format are the same as for 'parseJSON'
+//
+//	The element is located like the greedy expression '^(.*)<tag>(.*)</tag>(.*)$'
+//	of the shell functions does it: the last opening tag, which is followed by a
+//	closing one, up to the last closing tag. Only tags without attributes are
+//	found and nested elements with the same name aren't taken into account, e.g.
+//	'<a>1<a>2</a>3</a>' yields '2</a>3'.
+//
+//	The input is read into memory and scanned once, no tree of the document
+//	is built - the JSON scanner keeps only the scalar members of the top
+//	level object and of the objects in its arrays.
+//
+//	Build it with 'gcc -O2 -o response_scan response_scan.c'.
+
+#define EXIT_NOT_FOUND			1
+#define EXIT_FILE_ERROR			4
+#define EXIT_MISSING_PARAMETER	8
+#define EXIT_USAGE				32
+
+struct inputBuffer
+{
+	char *					data;
+	size_t					size;
+};
+
+struct jsonValue
+{
+	char *					name;
+	char *					value;
+	struct jsonArray *		array;			// arrays in a result list
+};
+
+struct jsonValues
+{
+	struct jsonValue *		values;
+	size_t					count;
+	size_t					allocated;
+};
+
+struct jsonArray
+{
+	char *					name;
+	struct jsonValues *		entries;
+	size_t					count;
+	size_t					allocated;
+};
+
+struct jsonDocument
+{
+	struct jsonValues		scalars;
+	struct jsonArray *		arrays;
+	size_t					count;
+	size_t					allocated;
+};
+
+struct jsonScanner
+{
+	const char *			data;
+	const char *			end;
+	const char *			position;
+	bool					failed;
+};
+
+struct jsonOptions
+{
+	bool					debug;
+	bool					quiet;
+	bool					scalar;
+	const char *			oneValue;
+	const char *			dictionary;
+	const char *			count;
+	const char *			array;
+	const char *			index;
+};
+
+static void * allocate(void *memory, size_t size)
+{
+	void *	newMemory = realloc(memory, size);
+
+	if (newMemory == NULL)
+	{
+		fprintf(stderr, "Error allocating memory.\n");
+		exit(64);
+	}
+
+	return newMemory;
+}
+
+static char * duplicate(const char *string, size_t length)
+{
+	char *	copy = allocate(NULL, length + 1);
+
+	memcpy(copy, string, length);
+	copy[length] = '\0';
+
+	return copy;
+}
+
+bool readInput(const char *fileName, struct inputBuffer *input)
+{
+	int		fd = 0;
+	size_t	allocated = 65536;
+
+	if (fileName != NULL && strcmp(fileName, "-") != 0 && (fd = open(fileName, O_RDONLY)) == -1)
+		return false;
+
+	input->data = allocate(NULL, allocated);
+	input->size = 0;
+
+	while (true)
+	{
+		ssize_t	got;
+
+		if (input->size + 1 >= allocated)
+		{
+			allocated *= 2;
+			input->data = allocate(input->data, allocated);
+		}
+
+		got = read(fd, input->data + input->size, allocated - input->size - 1);
+		if (got == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			if (fd != 0)
+				close(fd);
+			return false;
+		}
+		if (got == 0)
+			break;
+		input->size += got;
+	}
+
+	input->data[input->size] = '\0';
+	if (fd != 0)
+		close(fd);
+
+	return true;
+}
+
+//	XML elements
+
+static const char * findLastTag(const char *data, const char *end, const char *tag, size_t tagLength, bool closing)
+{
+	size_t			length = tagLength + (closing ? 3 : 2);
+	const char *	position = end;
+
+	while ((size_t) (position - data) >= length)
+	{
+		const char *	candidate = --position - length + 1;
+
+		if (*position != '>' || *candidate != '<')
+			continue;
+		if (closing && candidate[1] != '/')
+			continue;
+		if (strncasecmp(candidate + (closing ? 2 : 1), tag, tagLength) == 0)
+			return candidate;
+	}
+
+	return NULL;
+}
+
+static const char * findElement(const char *data, const char *end, const char *tag, size_t tagLength, const char **contentStart, const char **contentEnd, const char **elementEnd)
+{
+	const char *	closingTag = findLastTag(data, end, tag, tagLength, true);
+	const char *	openingTag;
+
+	if (closingTag == NULL)
+		return NULL;
+
+	// the opening tag has to end in front of the closing one
+	if ((openingTag = findLastTag(data, closingTag, tag, tagLength, false)) == NULL)
+		return NULL;
+
+	*contentStart = openingTag + tagLength + 2;
+	*contentEnd = closingTag;
+	*elementEnd = closingTag + tagLength + 3;
+	return openingTag;
+}
+
+int xmlExtract(const char *tag, struct inputBuffer *input)
+{
+	const char *	contentStart;
+	const char *	contentEnd;
+	const char *	elementEnd;
+
+	if (findElement(input->data, input->data + input->size, tag, strlen(tag), &contentStart, &contentEnd, &elementEnd) == NULL)
+		return EXIT_NOT_FOUND;
+
+	fwrite(contentStart, 1, contentEnd - contentStart, stdout);
+	fputc('\n', stdout);
+	return 0;
+}
+
+int xmlInsert(bool before, const char *tag, const char *newValue, struct inputBuffer *input)
+{
+	const char *	end = input->data + input->size;
+	const char *	start;
+	const char *	contentStart;
+	const char *	contentEnd;
+	const char *	elementEnd;
+	const char *	split;
+
+	if ((start = findElement(input->data, end, tag, strlen(tag), &contentStart, &contentEnd, &elementEnd)) == NULL)
+		return EXIT_NOT_FOUND;
+
+	split = (before ? start : elementEnd);
+	fwrite(input->data, 1, split - input->data, stdout);
+	fputs(newValue, stdout);
+	fwrite(split, 1, end - split, stdout);
+	fputc('\n', stdout);
+
+	return 0;
+}
+
+//	JSON scanner
+
+static void skipWhitespace(struct jsonScanner *scanner)
+{
+	while (scanner->position < scanner->end && isspace((unsigned char) *scanner->position))
+		scanner->position++;
+}
+
+static bool expect(struct jsonScanner *scanner, char character)
+{
+	skipWhitespace(scanner);
+	if (scanner->position < scanner->end && *scanner->position == character)
+	{
+		scanner->position++;
+		return true;
+	}
+
+	if (!scanner->failed)
+		fprintf(stderr, "Invalid JSON data at offset %zu, expected '%c'.\n", (size_t) (scanner->position - scanner->data), character);
+	scanner->failed = true;
+	return false;
+}
+
+static void appendUtf8(char **out, uint32_t code)
+{
+	char *	o = *out;
+
+	if (code < 0x80)
+		*o++ = (char) code;
+	else if (code < 0x800)
+	{
+		*o++ = (char) (0xC0 | (code >> 6));
+		*o++ = (char) (0x80 | (code & 0x3F));
+	}
+	else if (code < 0x10000)
+	{
+		*o++ = (char) (0xE0 | (code >> 12));
+		*o++ = (char) (0x80 | ((code >> 6) & 0x3F));
+		*o++ = (char) (0x80 | (code & 0x3F));
+	}
+	else
+	{
+		*o++ = (char) (0xF0 | (code >> 18));
+		*o++ = (char) (0x80 | ((code >> 12) & 0x3F));
+		*o++ = (char) (0x80 | ((code >> 6) & 0x3F));
+		*o++ = (char) (0x80 | (code & 0x3F));
+	}
+
+	*out = o;
+}
+
+static char * scanString(struct jsonScanner *scanner)
+{
+	const char *	start;
+	const char *	in;
+	char *			value;
+	char *			out;
+
+	if (!expect(scanner, '"'))
+		return NULL;
+
+	// the decoded string is never longer than its encoded form
+	for (start = in = scanner->position; in < scanner->end && *in != '"'; in++)
+	{
+		if (*in == '\\')
+			in++;
+	}
+
+	if (in >= scanner->end)
+	{
+		fprintf(stderr, "Unterminated JSON string at offset %zu.\n", (size_t) (start - scanner->data));
+		scanner->failed = true;
+		return NULL;
+	}
+
+	value = out = allocate(NULL, (in - start) + 1);
+	scanner->position = in + 1;
+
+	for (in = start; *in != '"'; in++)
+	{
+		if (*in != '\\')
+		{
+			*out++ = *in;
+			continue;
+		}
+
+		switch (*++in)
+		{
+			case 'b': *out++ = '\b'; break;
+			case 'f': *out++ = '\f'; break;
+			case 'n': *out++ = '\n'; break;
+			case 'r': *out++ = '\r'; break;
+			case 't': *out++ = '\t'; break;
+
+			case 'u':
+			{
+				uint32_t	code = 0;
+				int			digits;
+
+				for (digits = 0; digits < 4 && isxdigit((unsigned char) in[1]); digits++, in++)
+					code = (code << 4) | (isdigit((unsigned char) *(in + 1)) ? in[1] - '0' : (tolower((unsigned char) in[1]) - 'a' + 10));
+
+				if (code >= 0xD800 && code < 0xDC00 && in[1] == '\\' && in[2] == 'u')
+				{
+					uint32_t	low = 0;
+					const char *	l = in + 3;
+
+					for (digits = 0; digits < 4 && isxdigit((unsigned char) *l); digits++, l++)
+						low = (low << 4) | (isdigit((unsigned char) *l) ? *l - '0' : (tolower((unsigned char) *l) - 'a' + 10));
+
+					if (digits == 4 && low >= 0xDC00 && low < 0xE000)
+					{
+						code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+						in = l - 1;
+					}
+				}
+
+				appendUtf8(&out, code);
+				break;
+			}
+
+			default:
+				*out++ = *in;
+				break;
+		}
+	}
+
+	*out = '\0';
+	return value;
+}
+
+static char * scanLiteral(struct jsonScanner *scanner)
+{
+	const char *	start = scanner->position;
+
+	while (scanner->position < scanner->end && (isalnum((unsigned char) *scanner->position) || strchr("+-.", *scanner->position) != NULL))
+		scanner->position++;
+
+	if (scanner->position == start)
+	{
+		fprintf(stderr, "Invalid JSON data at offset %zu.\n", (size_t) (start - scanner->data));
+		scanner->failed = true;
+		return NULL;
+	}
+
+	// null is an empty value for the shell
+	if (scanner->position - start == 4 && strncmp(start, "null", 4) == 0)
+		return duplicate("", 0);
+
+	return duplicate(start, scanner->position - start);
+}
+
+static void skipValue(struct jsonScanner *scanner);
+
+static void skipContainer(struct jsonScanner *scanner, char open, char close)
+{
+	if (!expect(scanner, open))
+		return;
+
+	skipWhitespace(scanner);
+	if (scanner->position < scanner->end && *scanner->position == close)
+	{
+		scanner->position++;
+		return;
+	}
+
+	while (!scanner->failed)
+	{
+		if (open == '{')
+		{
+			free(scanString(scanner));
+			if (!expect(scanner, ':'))
+				return;
+		}
+
+		skipValue(scanner);
+		skipWhitespace(scanner);
+
+		if (scanner->position < scanner->end && *scanner->position == ',')
+		{
+			scanner->position++;
+			continue;
+		}
+
+		expect(scanner, close);
+		return;
+	}
+}
+
+static void skipValue(struct jsonScanner *scanner)
+{
+	skipWhitespace(scanner);
+	if (scanner->position >= scanner->end)
+	{
+		fprintf(stderr, "Unexpected end of JSON data.\n");
+		scanner->failed = true;
+		return;
+	}
+
+	if (*scanner->position == '{')
+		skipContainer(scanner, '{', '}');
+	else if (*scanner->position == '[')
+		skipContainer(scanner, '[', ']');
+	else if (*scanner->position == '"')
+		free(scanString(scanner));
+	else
+		free(scanLiteral(scanner));
+}
+
+static char * scanScalar(struct jsonScanner *scanner)
+{
+	skipWhitespace(scanner);
+	if (scanner->position < scanner->end && *scanner->position == '"')
+		return scanString(scanner);
+
+	return scanLiteral(scanner);
+}
+
+static void addValue(struct jsonValues *values, char *name, char *value)
+{
+	if (values->count == values->allocated)
+	{
+		values->allocated = (values->allocated ? values->allocated * 2 : 16);
+		values->values = allocate(values->values, values->allocated * sizeof(struct jsonValue));
+	}
+
+	values->values[values->count].name = name;
+	values->values[values->count].value = value;
+	values->values[values->count].array = NULL;
+	values->count++;
+}
+
+//	Each member of an object is dispatched by the first character of its
+//	value, objects nested deeper than the caller wants are skipped.
+
+static void scanObject(struct jsonScanner *scanner, struct jsonValues *values, struct jsonDocument *document);
+
+static void scanArray(struct jsonScanner *scanner, struct jsonArray *array)
+{
+	if (!expect(scanner, '['))
+		return;
+
+	skipWhitespace(scanner);
+	if (scanner->position < scanner->end && *scanner->position == ']')
+	{
+		scanner->position++;
+		return;
+	}
+
+	while (!scanner->failed)
+	{
+		skipWhitespace(scanner);
+		if (scanner->position < scanner->end && *scanner->position == '{')
+		{
+			if (array->count == array->allocated)
+			{
+				array->allocated = (array->allocated ? array->allocated * 2 : 16);
+				array->entries = allocate(array->entries, array->allocated * sizeof(struct jsonValues));
+			}
+			memset(&array->entries[array->count], 0, sizeof(struct jsonValues));
+			scanObject(scanner, &array->entries[array->count++], NULL);
+		}
+		else
+			skipValue(scanner);
+
+		skipWhitespace(scanner);
+		if (scanner->position < scanner->end && *scanner->position == ',')
+		{
+			scanner->position++;
+			continue;
+		}
+
+		expect(scanner, ']');
+		return;
+	}
+}
+
+static void scanObject(struct jsonScanner *scanner, struct jsonValues *values, struct jsonDocument *document)
+{
+	if (!expect(scanner, '{'))
+		return;
+
+	skipWhitespace(scanner);
+	if (scanner->position < scanner->end && *scanner->position == '}')
+	{
+		scanner->position++;
+		return;
+	}
+
+	while (!scanner->failed)
+	{
+		char *	name = scanString(scanner);
+
+		if (name == NULL || !expect(scanner, ':'))
+		{
+			free(name);
+			return;
+		}
+
+		skipWhitespace(scanner);
+		if (scanner->position < scanner->end && *scanner->position == '[' && document != NULL)
+		{
+			struct jsonArray *	array;
+
+			if (document->count == document->allocated)
+			{
+				document->allocated = (document->allocated ? document->allocated * 2 : 16);
+				document->arrays = allocate(document->arrays, document->allocated * sizeof(struct jsonArray));
+			}
+			array = memset(&document->arrays[document->count++], 0, sizeof(struct jsonArray));
+			array->name = name;
+			scanArray(scanner, array);
+		}
+		else if (scanner->position < scanner->end && (*scanner->position == '[' || *scanner->position == '{'))
+		{
+			free(name);
+			skipValue(scanner);
+		}
+		else
+		{
+			char *	value = scanScalar(scanner);
+
+			if (value == NULL)
+			{
+				free(name);
+				return;
+			}
+			addValue(values, name, value);
+		}
+
+		skipWhitespace(scanner);
+		if (scanner->position < scanner->end && *scanner->position == ',')
+		{
+			scanner->position++;
+			continue;
+		}
+
+		expect(scanner, '}');
+		return;
+	}
+}
+
+//	output in the format of 'parseJSON'
+
+static int compareValues(const void *left, const void *right)
+{
+	return strcmp(((const struct jsonValue *) left)->name, ((const struct jsonValue *) right)->name);
+}
+
+static void printEncoded(FILE *output, const char *value)
+{
+	const char *	special = "$\"`\\'";
+	bool			plain = true;
+
+	for (const unsigned char *c = (const unsigned char *) value; *c; c++)
+	{
+		if (*c < 0x20 || *c == 0x7F || strchr(special, *c) != NULL)
+		{
+			plain = false;
+			break;
+		}
+	}
+
+	if (plain)
+	{
+		fprintf(output, "\"%s\"", value);
+		return;
+	}
+
+	fputs("$'", output);
+	for (const unsigned char *c = (const unsigned char *) value; *c; c++)
+	{
+		if (*c < 0x20 || *c == 0x7F || strchr(special, *c) != NULL)
+			fprintf(output, "\\x%02x", *c);
+		else
+			fputc(*c, output);
+	}
+	fputc('\'', output);
+}
+
+static void printAssociative(FILE *output, const char *name, struct jsonValues *values)
+{
+	qsort(values->values, values->count, sizeof(struct jsonValue), compareValues);
+
+	fprintf(output, "declare -A %s=( ", name);
+	for (size_t i = 0; i < values->count; i++)
+	{
+		fprintf(output, "['%s']=", values->values[i].name);
+		printEncoded(output, values->values[i].value);
+		fputc(' ', output);
+	}
+	fputs(")\n", output);
+}
+
+static void printArray(FILE *output, struct jsonArray *array)
+{
+	fprintf(output, "declare -i %s_count=%zu\n", array->name, array->count);
+	for (size_t i = 0; i < array->count; i++)
+	{
+		char	name[1024];
+
+		snprintf(name, sizeof(name), "%s_%zu", array->name, i);
+		printAssociative(output, name, &array->entries[i]);
+	}
+}
+
+static struct jsonValue * findScalar(struct jsonValues *values, const char *name)
+{
+	for (size_t i = 0; i < values->count; i++)
+	{
+		if (strcmp(values->values[i].name, name) == 0)
+			return &values->values[i];
+	}
+
+	return NULL;
+}
+
+static struct jsonArray * findArray(struct jsonDocument *document, const char *name)
+{
+	for (size_t i = 0; i < document->count; i++)
+	{
+		if (strcmp(document->arrays[i].name, name) == 0)
+			return &document->arrays[i];
+	}
+
+	return NULL;
+}
+
+void jsonUsage(void)
+{
+	fprintf(stderr, "response_scan json - parse JSON output from queries to AVM Fritz!OS web server\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "response_scan json [ option [...] ] JSONFILE [ NAME ... ]\n\n");
+	fprintf(stderr, "The options are the same as for 'parseJSON':\n");
+	fprintf(stderr, "-h, --help\n    + display that help\n");
+	fprintf(stderr, "-d, --debug\n    + display some debug messages\n");
+	fprintf(stderr, "-q, --quiet\n    + do not display error messages\n");
+	fprintf(stderr, "-s, --scalar\n    + ignore JSON arrays\n");
+	fprintf(stderr, "-o, --one-value NAME\n    + return only the single scalar value for entry NAME, implies -s option\n");
+	fprintf(stderr, "-c, --count NAME\n    + count only the number of entries of array NAME\n");
+	fprintf(stderr, "-a, --array NAME\n    + parse only the array with the specified NAME\n");
+	fprintf(stderr, "-i, --index N\n    + parse only the Nth single entry of an array and handle it like a scalar list\n");
+	fprintf(stderr, "-D, --dictionary NAME\n    + create a dictionary (associative array) with the specified NAME instead of a simple list of\n");
+	fprintf(stderr, "      key/value assignment, implies -s\n");
+}
+
+#define jsonError(options, ...)		do { if (!(options)->quiet) fprintf(stderr, __VA_ARGS__); } while (0)
+
+int jsonMain(int argc, char * argv[])
+{
+	struct jsonOptions		options;
+	struct jsonDocument		document;
+	struct jsonScanner		scanner;
+	struct inputBuffer		input;
+	struct jsonValues		result;
+	const char *			fileName;
+	int						returnCode = 0;
+	int						i = 0;
+
+	memset(&options, 0, sizeof(options));
+	memset(&document, 0, sizeof(document));
+	memset(&result, 0, sizeof(result));
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0')
+	{
+		const char *	option = argv[i];
+		const char **	target = NULL;
+
+		if (strcmp(option, "--") == 0)
+		{
+			i++;
+			break;
+		}
+		else if (strcmp(option, "-h") == 0 || strcmp(option, "--help") == 0)
+		{
+			jsonUsage();
+			return EXIT_USAGE;
+		}
+		else if (strcmp(option, "-d") == 0 || strcmp(option, "--debug") == 0)
+			options.debug = true;
+		else if (strcmp(option, "-q") == 0 || strcmp(option, "--quiet") == 0)
+			options.quiet = true;
+		else if (strcmp(option, "-s") == 0 || strcmp(option, "--scalar") == 0)
+			options.scalar = true;
+		else if (strcmp(option, "-o") == 0 || strcmp(option, "--one-value") == 0)
+		{
+			target = &options.oneValue;
+			options.scalar = true;
+		}
+		else if (strcmp(option, "-D") == 0 || strcmp(option, "--dictionary") == 0)
+		{
+			target = &options.dictionary;
+			options.scalar = true;
+		}
+		else if (strcmp(option, "-c") == 0 || strcmp(option, "--count") == 0)
+			target = &options.count;
+		else if (strcmp(option, "-a") == 0 || strcmp(option, "--array") == 0)
+			target = &options.array;
+		else if (strcmp(option, "-i") == 0 || strcmp(option, "--index") == 0)
+			target = &options.index;
+		else
+		{
+			fprintf(stderr, "response_scan: unrecognized option '%s'\n\n", option);
+			jsonUsage();
+			return EXIT_USAGE;
+		}
+
+		if (target != NULL)
+		{
+			if (i + 1 >= argc)
+			{
+				fprintf(stderr, "response_scan: option '%s' requires an argument\n\n", option);
+				jsonUsage();
+				return EXIT_USAGE;
+			}
+			*target = argv[++i];
+		}
+		i++;
+	}
+
+	if (i >= argc)
+	{
+		jsonError(&options, "Missing JSONFILE parameter !\n");
+		return EXIT_MISSING_PARAMETER;
+	}
+	fileName = argv[i++];
+
+	if (options.debug)
+	{
+		fprintf(stderr, "Debug display: command line parameters and options\n");
+		fprintf(stderr, "JSON-file=%s\n", fileName);
+		fprintf(stderr, "onevalue=%s\n", (options.oneValue ? "true" : "false"));
+		if (options.oneValue)
+			fprintf(stderr, "onevalue-name=%s\n", options.oneValue);
+		fprintf(stderr, "scalar=%s\n", (options.scalar ? "true" : "false"));
+		fprintf(stderr, "dictionary=%s\n", (options.dictionary ? "true" : "false"));
+		if (options.dictionary)
+			fprintf(stderr, "dictionary-name=%s\n", options.dictionary);
+		fprintf(stderr, "count=%s\n", (options.count ? "true" : "false"));
+		if (options.count)
+			fprintf(stderr, "array-name=%s\n", options.count);
+		fprintf(stderr, "array=%s\n", (options.array ? "true" : "false"));
+		if (options.array)
+			fprintf(stderr, "array-name=%s\n", options.array);
+		fprintf(stderr, "index=%s\n", (options.index ? "true" : "false"));
+		if (options.index)
+			fprintf(stderr, "array-index=%s\n", options.index);
+		fprintf(stderr, "quiet=%s\n", (options.quiet ? "true" : "false"));
+		fprintf(stderr, "Debug display: end of parameters and options\n");
+		fprintf(stderr, "============================================\n");
+	}
+
+	if ((options.dictionary && *options.dictionary == '\0') || (options.count && *options.count == '\0') ||
+		(options.array && *options.array == '\0') || (options.index && *options.index == '\0'))
+	{
+		jsonError(&options, "Missing name or index value after option !\n");
+		return EXIT_MISSING_PARAMETER;
+	}
+
+	if (options.oneValue && i < argc)
+	{
+		jsonError(&options, "Ambigious value name(s) while using -o option !\n");
+		return EXIT_MISSING_PARAMETER;
+	}
+
+	if (options.array && (options.scalar || options.count))
+	{
+		jsonError(&options, "Options -s, -o and -c are incompatible with -a option !\n");
+		return EXIT_MISSING_PARAMETER;
+	}
+
+	if (options.count && (options.scalar || options.array || options.dictionary))
+	{
+		jsonError(&options, "Options -s, -o, -D and -a are incompatible with -c option !\n");
+		return EXIT_MISSING_PARAMETER;
+	}
+
+	if (options.index)
+	{
+		if (!options.array)
+		{
+			jsonError(&options, "Option -i is only valid in combination with -a option !\n");
+			return EXIT_MISSING_PARAMETER;
+		}
+		if (strspn(options.index, "0123456789") != strlen(options.index))
+		{
+			jsonError(&options, "Array index value after -i option needs to be a positive number !\n");
+			return EXIT_MISSING_PARAMETER;
+		}
+	}
+
+	if (!readInput(fileName, &input))
+	{
+		jsonError(&options, "File '%s' not found or access is denied !\n", fileName);
+		return EXIT_FILE_ERROR;
+	}
+
+	scanner.data = scanner.position = input.data;
+	scanner.end = input.data + input.size;
+	scanner.failed = false;
+	scanObject(&scanner, &document.scalars, &document);
+	if (scanner.failed)
+		return 64;
+
+	if (options.count || options.array)
+	{
+		const char *		name = (options.count ? options.count : options.array);
+		struct jsonArray *	array = findArray(&document, name);
+
+		if (array == NULL)
+		{
+			jsonError(&options, "Array with name '%s' not found !\n", name);
+			return EXIT_NOT_FOUND;
+		}
+
+		if (options.count)
+		{
+			fprintf(stdout, "%zu\n", array->count);
+			return 0;
+		}
+
+		if (!options.index)
+		{
+			printArray(stdout, array);
+			return 0;
+		}
+
+		if (strtoul(options.index, NULL, 10) >= array->count)
+		{
+			jsonError(&options, "Array index '%s' is out of bounds !\n", options.index);
+			return EXIT_NOT_FOUND;
+		}
+
+		// a single entry is handled like the list of scalars
+		result = array->entries[strtoul(options.index, NULL, 10)];
+	}
+	else
+	{
+		const char *	oneName[1] = { options.oneValue };
+		const char **	names = (options.oneValue ? oneName : (const char **) argv + i);
+		size_t			count = (options.oneValue ? 1 : (size_t) (argc - i));
+		bool			all = (count == 0);
+
+		if (all)
+			count = document.scalars.count + (options.scalar ? 0 : document.count);
+
+		for (size_t n = 0; n < count; n++)
+		{
+			const char *		name;
+			struct jsonArray *	array = NULL;
+			struct jsonValue *	scalar = NULL;
+
+			if (all)
+				name = (n < document.scalars.count ? document.scalars.values[n].name : document.arrays[n - document.scalars.count].name);
+			else
+				name = names[n];
+
+			if (!options.scalar && (array = findArray(&document, name)) != NULL)
+			{
+				char	arrayName[1024];
+
+				snprintf(arrayName, sizeof(arrayName), "%s_JSON_ARRAY", name);
+				addValue(&result, duplicate(arrayName, strlen(arrayName)), NULL);
+				result.values[result.count - 1].array = array;
+				continue;
+			}
+
+			if ((scalar = findScalar(&document.scalars, name)) == NULL)
+			{
+				jsonError(&options, "Value with name '%s' not found !\n", name);
+				returnCode = EXIT_NOT_FOUND;
+				continue;
+			}
+
+			if (options.oneValue)
+			{
+				fprintf(stdout, "%s\n", scalar->value);
+				return 0;
+			}
+
+			addValue(&result, duplicate(name, strlen(name)), scalar->value);
+		}
+	}
+
+	if (options.dictionary)
+	{
+		printAssociative(stdout, options.dictionary, &result);
+		return returnCode;
+	}
+
+	qsort(result.values, result.count, sizeof(struct jsonValue), compareValues);
+	for (size_t n = 0; n < result.count; n++)
+	{
+		if (result.values[n].array != NULL)
+		{
+			printArray(stdout, result.values[n].array);
+			continue;
+		}
+
+		fprintf(stdout, "%s=", result.values[n].name);
+		printEncoded(stdout, result.values[n].value);
+		fputc('\n', stdout);
+	}
+
+	return returnCode;
+}
+
+void usage(void)
+{
+	fprintf(stderr, "response_scan - extract data from XML or JSON responses of FRITZ!OS devices\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "response_scan xml_extract <tag> [ <file> ]\n");
+	fprintf(stderr, "response_scan xml_insert <before> <tag> <new> [ <file> ]\n");
+	fprintf(stderr, "response_scan json [ <options> ] <file> [ <name> ... ]\n");
+	fprintf(stderr, "\nThe XML operations read STDIN, if no file is specified, and work like the");
+	fprintf(stderr, "\nfunctions 'fb_xml_extract' and 'fb_xml_insert' from 'export/fritzbox', the");
+	fprintf(stderr, "\nJSON operation works like 'parseJSON' - use 'json -h' for its options.\n");
+}
+
+int main(int argc, char * argv[])
+{
+	struct inputBuffer	input;
+
+	if (argc >= 2 && strcmp(argv[1], "json") == 0)
+		exit(jsonMain(argc - 2, argv + 2));
+
+	if (argc >= 3 && argc <= 4 && strcmp(argv[1], "xml_extract") == 0 && *argv[2])
+	{
+		if (!readInput(argc == 4 ? argv[3] : NULL, &input))
+		{
+			fprintf(stderr, "Error %d reading input data.\n", errno);
+			exit(EXIT_FILE_ERROR);
+		}
+		exit(xmlExtract(argv[2], &input));
+	}
+
+	if (argc >= 5 && argc <= 6 && strcmp(argv[1], "xml_insert") == 0 && *argv[3] && *argv[4])
+	{
+		if (!readInput(argc == 6 ? argv[5] : NULL, &input))
+		{
+			fprintf(stderr, "Error %d reading input data.\n", errno);
+			exit(EXIT_FILE_ERROR);
+		}
+		exit(xmlInsert(strcmp(argv[2], "0") != 0, argv[3], argv[4], &input));
+	}
+
+	usage();
+	exit(EXIT_USAGE);
+}
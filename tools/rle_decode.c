@@ -17,13 +17,496 @@
  *                                                                     *
  ***********************************************************************/
 
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
 #include <errno.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <fcntl.h>
+#include <pthread.h>
 
-int main(int argc, char * argv[])
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "../include/tool_statistics.h"
+
+//	AVM's recovery images use a simple run-length encoding, each opcode
+//	byte is followed by its parameters:
+//
+//	0x00 <n>			n zero bytes, n == 0 marks the end of the content
+//	0x01 - 0x7F			copy the number of bytes given by the opcode
+//	0x80 <n> <c>		n times byte c
+//	0x81 <lo> <hi> <c>	(hi * 256 + lo) times byte c
+//	0x82 <n>			n space characters
+//	0x83 - 0xFF <c>		(opcode - 0x80) times byte c
+//
+//	As the output length of each opcode is known from its header bytes,
+//	a file may be decoded in two phases: a fast scan computes the output
+//	offsets at opcode boundaries (checkpoints) and worker threads decode
+//	the chunks between these checkpoints into the memory mapped output.
+
+#define DEFAULT_CHECKPOINT_INTERVAL	(4 * 1024 * 1024)
+#define INDEX_FILE_MAGIC			"RLEINDEX"
+#define INDEX_FILE_VERSION			1
+#define INDEX_FILE_SUFFIX			".rleindex"
+
+struct rleCheckpoint
+{
+	uint64_t				input;
+	uint64_t				output;
+};
+
+struct rleIndexHeader
+{
+	char					magic[8];
+	uint32_t				version;
+	uint32_t				reserved;
+	uint64_t				inputSize;
+	int64_t					inputTime;
+	uint64_t				interval;
+	uint64_t				count;
+};
+
+struct rleIndex
+{
+	struct rleIndexHeader	header;
+	struct rleCheckpoint *	checkpoints;	// the last one is the end of the content
+	bool					truncated;		// an error was found while scanning
+};
+
+struct rleDecodeJob
+{
+	const uint8_t *			input;
+	uint8_t *				output;
+	struct rleIndex *		index;
+	uint64_t				nextChunk;
+	pthread_mutex_t			lock;
+};
+
+//	Digests of the decoded content are computed from the opcodes, so the
+//	output doesn't need to be read again. Both CRCs are linear functions
+//	of their register, a run of n equal bytes is folded in with the powers
+//	of the "append a zero byte" operator M (as 32x32 bit matrices) and the
+//	sums of these powers:
+//
+//	register' = M^n * register + (M^(n-1) + ... + M + 1) * table[byte]
+//
+//	SHA-256 has no such shortcut, runs are hashed from a filled buffer.
+
+#define CRC_RUN_LEVELS				16		// runs of an opcode are shorter than 2^16
+#define CRC_RUN_THRESHOLD			32		// shorter runs are processed byte by byte
+#define DIGEST_RUN_BUFFER			4096
+
+enum rleDigestType
+{
+	rleDigestCrc32,							// the same as export/crc32
+	rleDigestCksum,							// POSIX cksum, used for TI checksums by AVM
+	rleDigestSha256,
+	rleDigestCount
+};
+
+static const char *			digestNames[rleDigestCount] = { "crc32", "cksum", "sha256" };
+
+struct crcEngine
+{
+	bool					reflected;
+	uint32_t				table[256];
+	uint32_t				zeroPowers[CRC_RUN_LEVELS][32];		// M^(2^k) as column vectors
+	uint32_t				runSums[CRC_RUN_LEVELS][32];		// M^0 + ... + M^(2^k - 1)
+};
+
+struct sha256Context
+{
+	uint32_t				state[8];
+	uint64_t				length;
+	uint8_t					block[64];
+	size_t					used;
+};
+
+struct rleDigests
+{
+	bool					selected[rleDigestCount];
+	const char *			expected[rleDigestCount];
+	char					values[rleDigestCount][65];
+	uint32_t				crc32;
+	uint32_t				cksum;
+	uint64_t				length;
+	struct sha256Context	sha256;
+	uint8_t					runBuffer[DIGEST_RUN_BUFFER];
+	int						runValue;
+};
+
+static struct crcEngine		crc32Engine;
+static struct crcEngine		cksumEngine;
+
+static inline uint32_t crcUpdate(const struct crcEngine *engine, uint32_t crc, uint8_t value)
+{
+	if (engine->reflected)
+		return (crc >> 8) ^ engine->table[(crc ^ value) & 0xFF];
+	else
+		return (crc << 8) ^ engine->table[((crc >> 24) ^ value) & 0xFF];
+}
+
+static uint32_t crcApplyMatrix(const uint32_t *matrix, uint32_t vector)
+{
+	uint32_t				result = 0;
+
+	for (int i = 0; vector != 0; i++, vector >>= 1)
+	{
+		if (vector & 1)
+			result ^= matrix[i];
+	}
+
+	return result;
+}
+
+static void initCrcEngine(struct crcEngine *engine, bool reflected, uint32_t polynomial)
+{
+	engine->reflected = reflected;
+
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t			value = (reflected ? i : i << 24);
+
+		for (int j = 0; j < 8; j++)
+		{
+			if (reflected)
+				value = (value & 1 ? (value >> 1) ^ polynomial : value >> 1);
+			else
+				value = (value & 0x80000000 ? (value << 1) ^ polynomial : value << 1);
+		}
+		engine->table[i] = value;
+	}
+
+	for (int i = 0; i < 32; i++)
+	{
+		engine->zeroPowers[0][i] = crcUpdate(engine, (uint32_t) 1 << i, 0);
+		engine->runSums[0][i] = (uint32_t) 1 << i;
+	}
+
+	for (int k = 1; k < CRC_RUN_LEVELS; k++)
+	{
+		for (int i = 0; i < 32; i++)
+		{
+			engine->zeroPowers[k][i] = crcApplyMatrix(engine->zeroPowers[k - 1], engine->zeroPowers[k - 1][i]);
+			engine->runSums[k][i] = engine->runSums[k - 1][i] ^ crcApplyMatrix(engine->zeroPowers[k - 1], engine->runSums[k - 1][i]);
+		}
+	}
+}
+
+static uint32_t crcBytes(const struct crcEngine *engine, uint32_t crc, const uint8_t *data, size_t size)
+{
+	while (size-- > 0)
+		crc = crcUpdate(engine, crc, *data++);
+
+	return crc;
+}
+
+static uint32_t crcRun(const struct crcEngine *engine, uint32_t crc, uint8_t value, uint64_t count)
+{
+	while (count >= CRC_RUN_THRESHOLD)
+	{
+		uint64_t			part = (count >= ((uint64_t) 1 << CRC_RUN_LEVELS) ? ((uint64_t) 1 << CRC_RUN_LEVELS) - 1 : count);
+
+		count -= part;
+
+		// the powers of M commute, so the order of the parts doesn't matter
+		for (int k = 0; part != 0; k++, part >>= 1)
+		{
+			if (part & 1)
+				crc = crcApplyMatrix(engine->zeroPowers[k], crc) ^ crcApplyMatrix(engine->runSums[k], engine->table[value]);
+		}
+	}
+
+	while (count-- > 0)
+		crc = crcUpdate(engine, crc, value);
+
+	return crc;
+}
+
+static const uint32_t		sha256Constants[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR32(value, bits)		(((value) >> (bits)) | ((value) << (32 - (bits))))
+
+static void sha256Block(struct sha256Context *context, const uint8_t *block)
+{
+	uint32_t				w[64];
+	uint32_t				s[8];
+
+	for (int i = 0; i < 16; i++)
+		w[i] = ((uint32_t) block[i * 4] << 24) | ((uint32_t) block[i * 4 + 1] << 16) | ((uint32_t) block[i * 4 + 2] << 8) | block[i * 4 + 3];
+
+	for (int i = 16; i < 64; i++)
+		w[i] = w[i - 16] + (ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3)) + w[i - 7] + (ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10));
+
+	memcpy(s, context->state, sizeof(s));
+
+	for (int i = 0; i < 64; i++)
+	{
+		uint32_t			t1 = s[7] + (ROTR32(s[4], 6) ^ ROTR32(s[4], 11) ^ ROTR32(s[4], 25)) + ((s[4] & s[5]) ^ (~s[4] & s[6])) + sha256Constants[i] + w[i];
+		uint32_t			t2 = (ROTR32(s[0], 2) ^ ROTR32(s[0], 13) ^ ROTR32(s[0], 22)) + ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+
+		memmove(s + 1, s, 7 * sizeof(uint32_t));
+		s[4] += t1;
+		s[0] = t1 + t2;
+	}
+
+	for (int i = 0; i < 8; i++)
+		context->state[i] += s[i];
+}
+
+static void sha256Init(struct sha256Context *context)
+{
+	static const uint32_t	initial[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+	memcpy(context->state, initial, sizeof(initial));
+	context->length = 0;
+	context->used = 0;
+}
+
+static void sha256Update(struct sha256Context *context, const uint8_t *data, size_t size)
+{
+	context->length += size;
+
+	if (context->used > 0)
+	{
+		size_t				part = sizeof(context->block) - context->used;
+
+		if (part > size)
+			part = size;
+		memcpy(context->block + context->used, data, part);
+		context->used += part;
+		data += part;
+		size -= part;
+
+		if (context->used < sizeof(context->block))
+			return;
+		sha256Block(context, context->block);
+		context->used = 0;
+	}
+
+	for (; size >= sizeof(context->block); data += sizeof(context->block), size -= sizeof(context->block))
+		sha256Block(context, data);
+
+	memcpy(context->block, data, size);
+	context->used = size;
+}
+
+static void sha256Final(struct sha256Context *context, char *hex)
+{
+	uint64_t				bits = context->length * 8;
+	uint8_t					padding[72] = { 0x80 };
+	size_t					padSize = (context->used < 56 ? 56 - context->used : 120 - context->used);
+
+	for (int i = 0; i < 8; i++)
+		padding[padSize + i] = (uint8_t) (bits >> (56 - (i * 8)));
+	sha256Update(context, padding, padSize + 8);
+
+	for (int i = 0; i < 8; i++)
+		sprintf(hex + (i * 8), "%08x", context->state[i]);
+}
+
+void initDigests(struct rleDigests *digests)
+{
+	memset(digests, 0, sizeof(struct rleDigests));
+	digests->runValue = -1;
+}
+
+bool isDigestSelected(struct rleDigests *digests)
+{
+	for (int i = 0; i < rleDigestCount; i++)
+	{
+		if (digests->selected[i])
+			return true;
+	}
+
+	return false;
+}
+
+bool selectDigests(struct rleDigests *digests, const char *list)
+{
+	// comma separated names
+	while (*list)
+	{
+		size_t				length = strcspn(list, ",");
+		int					i;
+
+		for (i = 0; i < rleDigestCount; i++)
+		{
+			if (strlen(digestNames[i]) == length && strncmp(list, digestNames[i], length) == 0)
+				break;
+		}
+
+		// AVM's name for the cksum value
+		if (i == rleDigestCount && length == 2 && strncmp(list, "ti", 2) == 0)
+			i = rleDigestCksum;
+
+		if (i == rleDigestCount)
+		{
+			fprintf(stderr, "Unknown digest '%.*s', use one of crc32, cksum (or ti) and sha256.\n", (int) length, list);
+			return false;
+		}
+
+		digests->selected[i] = true;
+		list += length;
+		if (*list == ',')
+			list++;
+	}
+
+	return true;
+}
+
+bool expectDigest(struct rleDigests *digests, const char *expectation)
+{
+	// <name>:<value>, the digest is selected, too
+	const char *			value = strchr(expectation, ':');
+	char					name[16];
+
+	if (value == NULL || value == expectation || (size_t) (value - expectation) >= sizeof(name) || *(value + 1) == '\0')
+	{
+		fprintf(stderr, "Invalid expected value '%s', use <digest>:<value>.\n", expectation);
+		return false;
+	}
+
+	memcpy(name, expectation, value - expectation);
+	name[value - expectation] = '\0';
+
+	if (!selectDigests(digests, name))
+		return false;
+
+	for (int i = 0; i < rleDigestCount; i++)
+	{
+		if (strcmp(name, digestNames[i]) == 0 || (i == rleDigestCksum && strcmp(name, "ti") == 0))
+			digests->expected[i] = value + 1;
+	}
+
+	return true;
+}
+
+void startDigests(struct rleDigests *digests)
+{
+	if (digests->selected[rleDigestCrc32])
+		initCrcEngine(&crc32Engine, true, 0xEDB88320);
+	if (digests->selected[rleDigestCksum])
+		initCrcEngine(&cksumEngine, false, 0x04C11DB7);
+	if (digests->selected[rleDigestSha256])
+		sha256Init(&digests->sha256);
+
+	digests->crc32 = 0xFFFFFFFF;
+	digests->cksum = 0;
+	digests->length = 0;
+}
+
+void digestBytes(struct rleDigests *digests, const uint8_t *data, size_t size)
+{
+	if (digests == NULL)
+		return;
+
+	if (digests->selected[rleDigestCrc32])
+		digests->crc32 = crcBytes(&crc32Engine, digests->crc32, data, size);
+	if (digests->selected[rleDigestCksum])
+		digests->cksum = crcBytes(&cksumEngine, digests->cksum, data, size);
+	if (digests->selected[rleDigestSha256])
+		sha256Update(&digests->sha256, data, size);
+	digests->length += size;
+}
+
+void digestRun(struct rleDigests *digests, uint8_t value, uint64_t count)
+{
+	if (digests == NULL)
+		return;
+
+	if (digests->selected[rleDigestCrc32])
+		digests->crc32 = crcRun(&crc32Engine, digests->crc32, value, count);
+	if (digests->selected[rleDigestCksum])
+		digests->cksum = crcRun(&cksumEngine, digests->cksum, value, count);
+	if (digests->selected[rleDigestSha256])
+	{
+		uint64_t			remaining = count;
+
+		if (digests->runValue != value)
+		{
+			memset(digests->runBuffer, value, sizeof(digests->runBuffer));
+			digests->runValue = value;
+		}
+
+		while (remaining > 0)
+		{
+			size_t			part = (remaining > sizeof(digests->runBuffer) ? sizeof(digests->runBuffer) : (size_t) remaining);
+
+			sha256Update(&digests->sha256, digests->runBuffer, part);
+			remaining -= part;
+		}
+	}
+	digests->length += count;
+}
+
+bool finishDigests(struct rleDigests *digests, FILE *output)
+{
+	bool					result = true;
+
+	// the cksum value includes the length (as little endian number with as few bytes as needed)
+	if (digests->selected[rleDigestCksum])
+	{
+		for (uint64_t length = digests->length; length > 0; length >>= 8)
+			digests->cksum = crcUpdate(&cksumEngine, digests->cksum, (uint8_t) length);
+	}
+
+	snprintf(digests->values[rleDigestCrc32], sizeof(digests->values[0]), "%08X", ~digests->crc32);
+	snprintf(digests->values[rleDigestCksum], sizeof(digests->values[0]), "%u", ~digests->cksum);
+	if (digests->selected[rleDigestSha256])
+		sha256Final(&digests->sha256, digests->values[rleDigestSha256]);
+
+	for (int i = 0; i < rleDigestCount; i++)
+	{
+		if (!digests->selected[i])
+			continue;
+
+		if (i == rleDigestCksum)
+			fprintf(output, "%s %s %" PRIu64 "\n", digestNames[i], digests->values[i], digests->length);
+		else
+			fprintf(output, "%s %s\n", digestNames[i], digests->values[i]);
+
+		if (digests->expected[i] != NULL && strcasecmp(digests->expected[i], digests->values[i]) != 0)
+		{
+			fprintf(stderr, "The %s value %s doesn't match the expected value %s.\n", digestNames[i], digests->values[i], digests->expected[i]);
+			result = false;
+		}
+	}
+
+	return result;
+}
+
+static void streamRun(int value, int count, bool write, struct rleDigests *digests)
+{
+	digestRun(digests, (uint8_t) value, count);
+
+	if (!write)
+		return;
+
+	while (count > 0)
+	{
+		putchar(value);
+		count--;
+	}
+}
+
+int decodeStream(bool write, struct rleDigests *digests, struct toolStatistics *stats)
 {
 	int c, cl;
 	int ioffset = 0;
@@ -43,12 +526,8 @@ int main(int argc, char * argv[])
 			ioffset++;
 			if (c == 0) break; // end of compressed content before end of file
 //			fprintf(stderr, "input=0x%08x output=0x%08x repeating %d zero bytes\n", ioffset, ooffset, c);
-			while (c > 0)
-			{
-				putchar(0);
-				ooffset++;
-				c--;
-			}
+			streamRun(0, c, write, digests);
+			ooffset += c;
 		}
 		else if (c == 128)
 		{
@@ -66,12 +545,8 @@ int main(int argc, char * argv[])
 			}
 			ioffset++;
 //			fprintf(stderr, "input=0x%08x output=0x%08x repeating %d bytes of %02x\n", ioffset, ooffset, cnt, c);
-			while (cnt > 0)
-			{
-				putchar(c);
-				ooffset++;
-				cnt--;
-			}
+			streamRun(c, cnt, write, digests);
+			ooffset += cnt;
 		}
 		else if (c == 129)
 		{
@@ -99,12 +574,8 @@ int main(int argc, char * argv[])
 			}
 			ioffset++;
 //			fprintf(stderr, "input=0x%08x output=0x%08x repeating %d bytes of %02x\n", ioffset, ooffset, cnt, c);
-			while (cnt > 0)
-			{
-				putchar(c);
-				ooffset++;
-				cnt--;
-			}
+			streamRun(c, cnt, write, digests);
+			ooffset += cnt;
 		}
 		else if (c == 130)
 		{
@@ -117,12 +588,8 @@ int main(int argc, char * argv[])
 			ioffset++;
 			c = 0x20;
 //			fprintf(stderr, "input=0x%08x output=0x%08x repeating %d bytes of %02x\n", ioffset, ooffset, cnt, c);
-			while (cnt > 0)
-			{
-				putchar(c);
-				ooffset++;
-				cnt--;
-			}
+			streamRun(c, cnt, write, digests);
+			ooffset += cnt;
 		}
 		else if (c > 130)
 		{
@@ -134,17 +601,15 @@ int main(int argc, char * argv[])
 			}
 			ioffset++;
 //			fprintf(stderr, "input=0x%08x output=0x%08x repeating %d bytes of %02x\n", ioffset, ooffset, cnt, c);
-			while (cnt > 0)
-			{
-				putchar(c);
-				ooffset++;
-				cnt--;
-			}
+			streamRun(c, cnt, write, digests);
+			ooffset += cnt;
 		}
 		else // (c <= 127) is the last possibility here
 		{
 //			fprintf(stderr, "input=0x%08x output=0x%08x copying %d bytes: ", ioffset, ooffset, c);
 			int ilog = ioffset;
+			int cnt = c;
+			uint8_t literal[127];
 			while (c > 0)
 			{
 				int chr;
@@ -156,12 +621,926 @@ int main(int argc, char * argv[])
 				}
 				ioffset++;
 //				fprintf(stderr, "%02x", chr);	
-				putchar(chr);
+				if (write)
+					putchar(chr);
+				literal[cnt - c] = (uint8_t) chr;
 				ooffset++;
 				c--;
 			}
+			digestBytes(digests, literal, cnt);
 //			fprintf(stderr, "\n");
 		}
 	}
-	exit(0);
+	addToolCounter(stats, "input_bytes", ioffset);
+	addToolCounter(stats, "output_bytes", ooffset);
+	addToolBytes(stats, ooffset);
+	return 0;
+}
+
+static bool addCheckpoint(struct rleIndex *index, uint64_t *allocated, uint64_t input, uint64_t output)
+{
+	if (index->header.count == *allocated)
+	{
+		uint64_t				newAllocated = (*allocated ? *allocated * 2 : 256);
+		struct rleCheckpoint *	newCheckpoints = realloc(index->checkpoints, newAllocated * sizeof(struct rleCheckpoint));
+
+		if (newCheckpoints == NULL)
+		{
+			fprintf(stderr, "Error allocating memory for the checkpoint index.\n");
+			return false;
+		}
+
+		index->checkpoints = newCheckpoints;
+		*allocated = newAllocated;
+	}
+
+	index->checkpoints[index->header.count].input = input;
+	index->checkpoints[index->header.count].output = output;
+	index->header.count++;
+
+	return true;
+}
+
+bool scanInput(const uint8_t *input, uint64_t size, struct rleIndex *index)
+{
+	// same error messages (and offsets) as decodeStream(), the content
+	// in front of an error is still indexed and may be decoded
+	uint64_t	allocated = 0;
+	uint64_t	ioffset = 0;
+	uint64_t	ooffset = 0;
+	uint64_t	lastCheckpoint = 0;
+
+	index->checkpoints = NULL;
+	index->header.count = 0;
+	index->truncated = false;
+
+	if (!addCheckpoint(index, &allocated, 0, 0))
+		return false;
+
+	while (ioffset < size)
+	{
+		uint64_t	start = ioffset;
+		uint64_t	remaining = size - ioffset - 1;
+		int			cl = input[ioffset++];
+		uint64_t	length = 0;
+
+		if (ooffset - lastCheckpoint >= index->header.interval)
+		{
+			if (!addCheckpoint(index, &allocated, start, ooffset))
+				return false;
+			lastCheckpoint = ooffset;
+		}
+
+		if (cl == 0)
+		{
+			if (remaining < 1)
+			{
+				fprintf(stderr, "Unexpected end of file while reading number of consecutive zero bytes (0x%x -> %02x).\n\n", (int) ioffset, cl);
+				index->truncated = true;
+				ioffset = start;
+				break;
+			}
+			if (input[ioffset] == 0)
+			{
+				ioffset = start; // end of compressed content before end of file
+				break;
+			}
+			length = input[ioffset++];
+		}
+		else if (cl == 128)
+		{
+			if (remaining < 2)
+			{
+				if (remaining == 0)
+					fprintf(stderr, "Unexpected end of file while reading repetition length (0x%x -> %02x).\n\n", (int) ioffset, cl);
+				else
+					fprintf(stderr, "Unexpected end of file while reading byte value to repeat (0x%x -> %02x %02x).\n\n", (int) ioffset + 1, cl, input[ioffset]);
+				index->truncated = true;
+				ioffset = start;
+				break;
+			}
+			length = input[ioffset];
+			ioffset += 2;
+		}
+		else if (cl == 129)
+		{
+			if (remaining < 3)
+			{
+				if (remaining < 2)
+					fprintf(stderr, "Unexpected end of file while reading repetition length (0x%x -> %02x).\n\n", (int) (ioffset + remaining), cl);
+				else
+					fprintf(stderr, "Unexpected end of file while reading byte value to repeat (0x%x -> %02x %04x).\n\n", (int) ioffset + 2, cl, input[ioffset] + (input[ioffset + 1] << 8));
+				index->truncated = true;
+				ioffset = start;
+				break;
+			}
+			length = input[ioffset] + (input[ioffset + 1] << 8);
+			ioffset += 3;
+		}
+		else if (cl == 130)
+		{
+			if (remaining < 1)
+			{
+				fprintf(stderr, "Unexpected end of file while reading repetition length (0x%x -> %02x).\n\n", (int) ioffset, cl);
+				index->truncated = true;
+				ioffset = start;
+				break;
+			}
+			length = input[ioffset++];
+		}
+		else if (cl > 130)
+		{
+			if (remaining < 1)
+			{
+				fprintf(stderr, "Unexpected end of file while reading byte value to repeat (0x%x -> %02x).\n\n", (int) ioffset, cl);
+				index->truncated = true;
+				ioffset = start;
+				break;
+			}
+			length = cl - 128;
+			ioffset++;
+		}
+		else // (c <= 127) is the last possibility here
+		{
+			if (remaining < (uint64_t) cl)
+			{
+				fprintf(stderr, "Unexpected end of file while reading consecutive unique bytes (0x%x -> %02x -> 0x%d).\n\n", (int) ioffset, cl, (int) remaining);
+				index->truncated = true;
+				ioffset = start;
+				break;
+			}
+			length = cl;
+			ioffset += cl;
+		}
+
+		ooffset += length;
+	}
+
+	return addCheckpoint(index, &allocated, ioffset, ooffset);
+}
+
+void decodeChunk(const uint8_t *input, uint64_t inputStart, uint64_t inputEnd, uint8_t *output)
+{
+	// the chunk was validated while scanning and the output is zero-filled
+	// (a new file extended with ftruncate), so zero runs are only skipped
+	const uint8_t *	in = input + inputStart;
+	const uint8_t *	end = input + inputEnd;
+	uint8_t *		out = output;
+
+	while (in < end)
+	{
+		int			c = *in++;
+
+		if (c == 0)
+		{
+			out += *in++;
+		}
+		else if (c == 128)
+		{
+			memset(out, in[1], in[0]);
+			out += in[0];
+			in += 2;
+		}
+		else if (c == 129)
+		{
+			int		cnt = in[0] + (in[1] << 8);
+
+			memset(out, in[2], cnt);
+			out += cnt;
+			in += 3;
+		}
+		else if (c == 130)
+		{
+			memset(out, 0x20, in[0]);
+			out += in[0];
+			in++;
+		}
+		else if (c > 130)
+		{
+			memset(out, in[0], c - 128);
+			out += c - 128;
+			in++;
+		}
+		else
+		{
+			memcpy(out, in, c);
+			out += c;
+			in += c;
+		}
+	}
+}
+
+void digestChunk(const uint8_t *input, uint64_t inputStart, uint64_t inputEnd, struct rleDigests *digests)
+{
+	// the same walk through the validated opcodes as in decodeChunk()
+	const uint8_t *	in = input + inputStart;
+	const uint8_t *	end = input + inputEnd;
+
+	while (in < end)
+	{
+		int			c = *in++;
+
+		if (c == 0)
+		{
+			digestRun(digests, 0, in[0]);
+			in++;
+		}
+		else if (c == 128)
+		{
+			digestRun(digests, in[1], in[0]);
+			in += 2;
+		}
+		else if (c == 129)
+		{
+			digestRun(digests, in[2], in[0] + (in[1] << 8));
+			in += 3;
+		}
+		else if (c == 130)
+		{
+			digestRun(digests, 0x20, in[0]);
+			in++;
+		}
+		else if (c > 130)
+		{
+			digestRun(digests, in[0], c - 128);
+			in++;
+		}
+		else
+		{
+			digestBytes(digests, in, c);
+			in += c;
+		}
+	}
+}
+
+void * decodeWorker(void *arg)
+{
+	struct rleDecodeJob *	job = arg;
+
+	while (true)
+	{
+		uint64_t			chunk;
+
+		pthread_mutex_lock(&job->lock);
+		chunk = job->nextChunk++;
+		pthread_mutex_unlock(&job->lock);
+
+		if (chunk + 1 >= job->index->header.count)
+			break;
+
+		decodeChunk(job->input, job->index->checkpoints[chunk].input, job->index->checkpoints[chunk + 1].input, job->output + job->index->checkpoints[chunk].output);
+	}
+
+	return NULL;
+}
+
+bool readIndex(const char *fileName, struct stat *inputStat, uint64_t interval, struct rleIndex *index)
+{
+	FILE *		file;
+	bool		result = false;
+
+	index->checkpoints = NULL;
+	index->truncated = false;
+
+	if ((file = fopen(fileName, "rb")) == NULL)
+		return false;
+
+	if (fread(&index->header, sizeof(index->header), 1, file) == 1 &&
+		memcmp(index->header.magic, INDEX_FILE_MAGIC, sizeof(index->header.magic)) == 0 &&
+		index->header.version == INDEX_FILE_VERSION &&
+		index->header.inputSize == (uint64_t) inputStat->st_size &&
+		index->header.inputTime == (int64_t) inputStat->st_mtime &&
+		index->header.interval == interval &&
+		index->header.count >= 1 && index->header.count <= (uint64_t) inputStat->st_size + 1)
+	{
+		if ((index->checkpoints = malloc(index->header.count * sizeof(struct rleCheckpoint))) != NULL)
+		{
+			if (fread(index->checkpoints, sizeof(struct rleCheckpoint), index->header.count, file) == index->header.count &&
+				index->checkpoints[index->header.count - 1].input <= index->header.inputSize)
+				result = true;
+			else
+			{
+				free(index->checkpoints);
+				index->checkpoints = NULL;
+			}
+		}
+	}
+
+	fclose(file);
+	return result;
+}
+
+bool writeIndex(const char *fileName, struct stat *inputStat, struct rleIndex *index)
+{
+	FILE *		file;
+	bool		result;
+
+	memcpy(index->header.magic, INDEX_FILE_MAGIC, sizeof(index->header.magic));
+	index->header.version = INDEX_FILE_VERSION;
+	index->header.reserved = 0;
+	index->header.inputSize = inputStat->st_size;
+	index->header.inputTime = inputStat->st_mtime;
+
+	if ((file = fopen(fileName, "wb")) == NULL)
+	{
+		fprintf(stderr, "Error %d creating index file '%s'.\n", errno, fileName);
+		return false;
+	}
+
+	result = (fwrite(&index->header, sizeof(index->header), 1, file) == 1 &&
+			  fwrite(index->checkpoints, sizeof(struct rleCheckpoint), index->header.count, file) == index->header.count);
+
+	if (fclose(file) != 0)
+		result = false;
+
+	if (!result)
+		fprintf(stderr, "Error %d writing index file '%s'.\n", errno, fileName);
+
+	return result;
+}
+
+bool mapInput(const char *inputName, int *inputFd, struct stat *inputStat, uint8_t **input)
+{
+	if ((*inputFd = open(inputName, O_RDONLY)) == -1)
+	{
+		fprintf(stderr, "Error %d opening input file '%s'.\n", errno, inputName);
+		return false;
+	}
+
+	if (fstat(*inputFd, inputStat) == -1 || inputStat->st_size == 0)
+	{
+		fprintf(stderr, "Error %d getting file stats for '%s' or file is empty.\n", errno, inputName);
+		close(*inputFd);
+		return false;
+	}
+
+	if ((*input = mmap(NULL, inputStat->st_size, PROT_READ, MAP_SHARED, *inputFd, 0)) == MAP_FAILED)
+	{
+		fprintf(stderr, "Error %d mapping %" PRIu64 " bytes of input file '%s' to memory.\n", errno, (uint64_t) inputStat->st_size, inputName);
+		close(*inputFd);
+		return false;
+	}
+
+	return true;
+}
+
+bool loadIndex(const uint8_t *input, struct stat *inputStat, const char *indexName, struct rleIndex *index, struct toolStatistics *stats)
+{
+	uint64_t	interval = index->header.interval;
+
+	// use a valid index file or scan the input (and store the result)
+	beginToolPhase(stats, "index");
+	if (indexName != NULL && readIndex(indexName, inputStat, interval, index))
+	{
+		addToolCounter(stats, "index_reused", 1);
+		return true;
+	}
+
+	// a rejected index file may have overwritten the header
+	index->header.interval = interval;
+
+	beginToolPhase(stats, "scan");
+	madvise((void *) input, inputStat->st_size, MADV_SEQUENTIAL);
+	if (!scanInput(input, inputStat->st_size, index))
+		return false;
+
+	if (indexName != NULL && !index->truncated)
+		writeIndex(indexName, inputStat, index);
+
+	return true;
+}
+
+int decodeFile(const char *inputName, const char *outputName, const char *indexName, uint64_t interval, int threads, struct rleDigests *digests, struct toolStatistics *stats)
+{
+	int						returnCode = 1;
+	int						inputFd;
+	int						outputFd;
+	struct stat				inputStat;
+	uint8_t *				input = MAP_FAILED;
+	uint8_t *				output = MAP_FAILED;
+	uint64_t				outputSize;
+	struct rleIndex			index;
+	struct rleDecodeJob		job;
+	pthread_t *				workers = NULL;
+	int						started = 0;
+	bool					digestsMatch = true;
+
+	index.checkpoints = NULL;
+	index.header.interval = interval;
+
+	beginToolPhase(stats, "mmap");
+	if (!mapInput(inputName, &inputFd, &inputStat, &input))
+		return 1;
+	madvise(input, inputStat.st_size, MADV_SEQUENTIAL);
+	addToolCounter(stats, "input_bytes", inputStat.st_size);
+
+	// phase 1: use a valid index file or scan the input
+	if (!loadIndex(input, &inputStat, indexName, &index, stats))
+		goto cleanup;
+
+	outputSize = index.checkpoints[index.header.count - 1].output;
+	addToolCounter(stats, "output_bytes", outputSize);
+	addToolBytes(stats, outputSize);
+	addToolCounter(stats, "checkpoints", index.header.count);
+
+	// phase 2: decode chunks in parallel into the pre-sized output file
+	beginToolPhase(stats, "decode");
+	if (outputName != NULL)
+	{
+		if ((outputFd = open(outputName, O_RDWR | O_CREAT | O_TRUNC, 0666)) == -1)
+		{
+			fprintf(stderr, "Error %d creating output file '%s'.\n", errno, outputName);
+			goto cleanup;
+		}
+
+		if (ftruncate(outputFd, outputSize) == -1)
+		{
+			fprintf(stderr, "Error %d setting size of output file '%s' to %" PRIu64 " bytes.\n", errno, outputName, outputSize);
+			close(outputFd);
+			goto cleanup;
+		}
+
+		if (outputSize > 0 && (output = mmap(NULL, outputSize, PROT_READ | PROT_WRITE, MAP_SHARED, outputFd, 0)) == MAP_FAILED)
+		{
+			fprintf(stderr, "Error %d mapping %" PRIu64 " bytes of output file '%s' to memory.\n", errno, outputSize, outputName);
+			close(outputFd);
+			goto cleanup;
+		}
+		close(outputFd);
+
+		job.input = input;
+		job.output = output;
+		job.index = &index;
+		job.nextChunk = 0;
+		pthread_mutex_init(&job.lock, NULL);
+
+		if (threads > 1 && (workers = calloc(threads, sizeof(pthread_t))) != NULL)
+		{
+			for (started = 0; started < threads; started++)
+			{
+				if (pthread_create(&workers[started], NULL, decodeWorker, &job) != 0)
+					break;
+			}
+		}
+
+		// the main thread decodes alone, if no thread could be started
+		if (started == 0)
+			decodeWorker(&job);
+		addToolCounter(stats, "threads", (started ? started : 1));
+	}
+
+	// the digests are computed from the opcodes, while the threads are decoding
+	if (digests != NULL)
+	{
+		beginToolPhase(stats, "digest");
+		digestChunk(input, index.checkpoints[0].input, index.checkpoints[index.header.count - 1].input, digests);
+		digestsMatch = finishDigests(digests, stdout);
+		beginToolPhase(stats, "decode");
+	}
+
+	if (outputName != NULL)
+	{
+		for (int i = 0; i < started; i++)
+			pthread_join(workers[i], NULL);
+		free(workers);
+
+		pthread_mutex_destroy(&job.lock);
+
+		beginToolPhase(stats, "write");
+		if (output != MAP_FAILED && munmap(output, outputSize) == -1)
+		{
+			fprintf(stderr, "Error %d writing output file '%s'.\n", errno, outputName);
+			goto cleanup;
+		}
+	}
+
+	if (!digestsMatch)
+		goto cleanup;
+
+	returnCode = (index.truncated ? 1 : 0);
+
+cleanup:
+	free(index.checkpoints);
+	munmap(input, inputStat.st_size);
+	close(inputFd);
+
+	return returnCode;
+}
+
+struct rangeOutput
+{
+	FILE *					file;
+	uint8_t					buffer[64 * 1024];
+	size_t					used;
+};
+
+static bool flushRangeOutput(struct rangeOutput *output)
+{
+	// nothing is written in verification mode
+	if (output->used > 0 && output->file != NULL && fwrite(output->buffer, 1, output->used, output->file) != output->used)
+		return false;
+
+	output->used = 0;
+	return true;
+}
+
+static bool appendRangeOutput(struct rangeOutput *output, const uint8_t *data, int value, uint64_t count)
+{
+	// copies 'count' bytes from 'data' or repeats 'value', if 'data' is NULL
+	while (count > 0)
+	{
+		size_t	chunk = sizeof(output->buffer) - output->used;
+
+		if (chunk > count)
+			chunk = (size_t) count;
+
+		if (data != NULL)
+		{
+			memcpy(output->buffer + output->used, data, chunk);
+			data += chunk;
+		}
+		else
+			memset(output->buffer + output->used, value, chunk);
+
+		output->used += chunk;
+		count -= chunk;
+
+		if (output->used == sizeof(output->buffer) && !flushRangeOutput(output))
+			return false;
+	}
+
+	return true;
+}
+
+bool decodeRange(const uint8_t *input, struct rleIndex *index, uint64_t start, uint64_t length, struct rangeOutput *output, struct rleDigests *digests, uint64_t *opcodes)
+{
+	// the opcodes up to the last checkpoint were validated while scanning,
+	// decoding starts at the last checkpoint in front of the range
+	uint64_t		low = 0;
+	uint64_t		high = index->header.count - 1;
+	uint64_t		end = start + length;
+	uint64_t		ioffset;
+	uint64_t		ooffset;
+	uint64_t		inputEnd = index->checkpoints[index->header.count - 1].input;
+
+	while (low < high)
+	{
+		uint64_t	middle = (low + high + 1) / 2;
+
+		if (index->checkpoints[middle].output <= start)
+			low = middle;
+		else
+			high = middle - 1;
+	}
+
+	ioffset = index->checkpoints[low].input;
+	ooffset = index->checkpoints[low].output;
+
+	while (ooffset < end && ioffset < inputEnd)
+	{
+		int				c = input[ioffset++];
+		const uint8_t *	data = NULL;
+		int				value = 0;
+		uint64_t		count;
+
+		if (c == 0)
+		{
+			count = input[ioffset++];
+		}
+		else if (c == 128)
+		{
+			count = input[ioffset];
+			value = input[ioffset + 1];
+			ioffset += 2;
+		}
+		else if (c == 129)
+		{
+			count = input[ioffset] + (input[ioffset + 1] << 8);
+			value = input[ioffset + 2];
+			ioffset += 3;
+		}
+		else if (c == 130)
+		{
+			count = input[ioffset++];
+			value = 0x20;
+		}
+		else if (c > 130)
+		{
+			count = c - 128;
+			value = input[ioffset++];
+		}
+		else
+		{
+			count = c;
+			data = input + ioffset;
+			ioffset += c;
+		}
+
+		(*opcodes)++;
+
+		if (ooffset + count > start)
+		{
+			uint64_t	skip = (start > ooffset ? start - ooffset : 0);
+			uint64_t	used = (end < ooffset + count ? end - ooffset : count) - skip;
+
+			if (data != NULL)
+				digestBytes(digests, data + skip, used);
+			else
+				digestRun(digests, (uint8_t) value, used);
+
+			if (!appendRangeOutput(output, (data ? data + skip : NULL), value, used))
+				return false;
+		}
+
+		ooffset += count;
+	}
+
+	return flushRangeOutput(output);
+}
+
+int extractRange(const char *inputName, const char *outputName, const char *indexName, uint64_t interval, uint64_t start, uint64_t length, bool toEnd, bool write, struct rleDigests *digests, struct toolStatistics *stats)
+{
+	int						returnCode = 1;
+	int						inputFd;
+	struct stat				inputStat;
+	uint8_t *				input = MAP_FAILED;
+	uint64_t				outputSize;
+	struct rleIndex			index;
+	struct rangeOutput *	output = NULL;
+	uint64_t				opcodes = 0;
+
+	index.checkpoints = NULL;
+	index.header.interval = interval;
+
+	beginToolPhase(stats, "mmap");
+	if (!mapInput(inputName, &inputFd, &inputStat, &input))
+		return 1;
+	addToolCounter(stats, "input_bytes", inputStat.st_size);
+
+	if (!loadIndex(input, &inputStat, indexName, &index, stats))
+		goto cleanup;
+
+	// only a small part of the input is needed now
+	madvise(input, inputStat.st_size, MADV_RANDOM);
+
+	outputSize = index.checkpoints[index.header.count - 1].output;
+	addToolCounter(stats, "checkpoints", index.header.count);
+
+	if (toEnd && start <= outputSize)
+		length = outputSize - start;
+
+	if (start > outputSize || length > outputSize - start)
+	{
+		fprintf(stderr, "The range 0x%" PRIx64 ":0x%" PRIx64 " exceeds the decoded size (0x%" PRIx64 ") of '%s'.\n", start, length, outputSize, inputName);
+		goto cleanup;
+	}
+
+	beginToolPhase(stats, "decode");
+	if ((output = malloc(sizeof(struct rangeOutput))) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for the output buffer.\n");
+		goto cleanup;
+	}
+	output->used = 0;
+
+	if (!write)
+		output->file = NULL;
+	else if (outputName == NULL || strcmp(outputName, "-") == 0)
+		output->file = stdout;
+	else if ((output->file = fopen(outputName, "wb")) == NULL)
+	{
+		fprintf(stderr, "Error %d creating output file '%s'.\n", errno, outputName);
+		goto cleanup;
+	}
+
+	if (decodeRange(input, &index, start, length, output, digests, &opcodes))
+		returnCode = 0;
+
+	beginToolPhase(stats, "write");
+	if (output->file != NULL && (output->file == stdout ? fflush(stdout) != 0 : fclose(output->file) != 0))
+		returnCode = 1;
+
+	if (returnCode != 0)
+		fprintf(stderr, "Error %d writing output file '%s'.\n", errno, (output->file == stdout ? "STDOUT" : outputName));
+
+	// the digests go to STDERR, if the content is written to STDOUT
+	if (digests != NULL && !finishDigests(digests, (output->file == stdout ? stderr : stdout)))
+		returnCode = 1;
+
+	addToolCounter(stats, "opcodes", opcodes);
+	addToolCounter(stats, "output_bytes", length);
+	addToolBytes(stats, length);
+
+cleanup:
+	free(output);
+	free(index.checkpoints);
+	munmap(input, inputStat.st_size);
+	close(inputFd);
+
+	return returnCode;
+}
+
+void usage(void)
+{
+	fprintf(stderr, "rle_decode - decode AVM's run-length encoded recovery images\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "rle_decode [ --stats ] [ <digest options> ] < <input> > <output>\n");
+	fprintf(stderr, "rle_decode [ --stats ] [ <digest options> ] [ -j <threads> ] [ -x <index_file> ] [ -c <checkpoint interval in KByte> ] <input> <output>\n");
+	fprintf(stderr, "rle_decode [ --stats ] [ <digest options> ] [ -x <index_file> ] [ -c <checkpoint interval in KByte> ] --range <start>:[<length>] <input> [ <output> ]\n");
+	fprintf(stderr, "\nDigest options: [ -d <digest>[,<digest>...] ] [ -e <digest>:<expected value> ... ] [ -V ]\n");
+	fprintf(stderr, "\nWithout file names, the encoded data is read from STDIN and decoded to STDOUT.\n");
+	fprintf(stderr, "\nWith file names, the input is scanned first to find the output offsets of");
+	fprintf(stderr, "\nthe opcodes at chunk boundaries (every 4 MByte of output by default) and");
+	fprintf(stderr, "\nthe chunks are decoded in parallel threads (as many as CPUs are online");
+	fprintf(stderr, "\nby default) into the output file. If an index file is specified, the");
+	fprintf(stderr, "\nscan results are stored there and reused for the same input file.\n");
+	fprintf(stderr, "\nWith --range, only the specified part of the decoded content is written");
+	fprintf(stderr, "\nto the output file (or to STDOUT, if it's missing or '-'). Decoding starts");
+	fprintf(stderr, "\nat the last checkpoint in front of the range and the index is stored in");
+	fprintf(stderr, "\n'<input>" INDEX_FILE_SUFFIX "', if no other file was specified. Without a length,");
+	fprintf(stderr, "\nthe range ends with the decoded content. Both values may be specified as");
+	fprintf(stderr, "\nhexadecimal numbers with a '0x' prefix.\n");
+	fprintf(stderr, "\nThe digests selected with -d (--digest=) are computed from the decoded");
+	fprintf(stderr, "\ncontent while it's written, possible names are 'crc32' (the same value as");
+	fprintf(stderr, "\nfrom export/crc32), 'cksum' (or 'ti', the value and the length like from");
+	fprintf(stderr, "\nthe cksum command) and 'sha256'. They're written to STDOUT (or to STDERR,");
+	fprintf(stderr, "\nif the decoded content goes to STDOUT) as '<digest> <value>' lines. Each");
+	fprintf(stderr, "\n-e (--expect=) option selects a digest, too, and the exit code is 1, if");
+	fprintf(stderr, "\nthe value differs. With -V (--verify), the content is only decoded and");
+	fprintf(stderr, "\nnothing is written, the output file has to be omitted then.\n");
+	fprintf(stderr, "\nWith --stats (or YF_TOOL_STATS set in the environment), the time needed");
+	fprintf(stderr, "\nfor each phase and some counters are written as a JSON line to STDERR.\n");
+}
+
+int main(int argc, char * argv[])
+{
+	const char *	indexName = NULL;
+	uint64_t		interval = DEFAULT_CHECKPOINT_INTERVAL;
+	long			threads = sysconf(_SC_NPROCESSORS_ONLN);
+	bool			statistics = false;
+	const char *	range = NULL;
+	bool			write = true;
+	struct rleDigests	digests;
+	struct rleDigests *	digestsUsed = &digests;
+	struct toolStatistics	stats;
+	int				returnCode;
+	int				i = 1;
+
+	initDigests(&digests);
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0')
+	{
+		char *	firstInvalidChar;
+		long	value;
+
+		if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+		{
+			usage();
+			exit(1);
+		}
+
+		if (isToolStatisticsOption(argv[i]))
+		{
+			statistics = true;
+			i += 1;
+			continue;
+		}
+
+		if (strncmp(argv[i], "--range=", 8) == 0)
+		{
+			range = argv[i] + 8;
+			i += 1;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-V") == 0 || strcmp(argv[i], "--verify") == 0)
+		{
+			write = false;
+			i += 1;
+			continue;
+		}
+
+		if (strncmp(argv[i], "--digest=", 9) == 0 || strncmp(argv[i], "--expect=", 9) == 0)
+		{
+			if (!(argv[i][2] == 'd' ? selectDigests(&digests, argv[i] + 9) : expectDigest(&digests, argv[i] + 9)))
+				exit(2);
+			i += 1;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+		{
+			fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+			exit(2);
+		}
+
+		value = strtol(argv[i + 1], &firstInvalidChar, 0);
+
+		if (strcmp(argv[i], "-x") == 0)
+		{
+			indexName = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "--range") == 0)
+		{
+			range = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "-d") == 0)
+		{
+			if (!selectDigests(&digests, argv[i + 1]))
+				exit(2);
+		}
+		else if (strcmp(argv[i], "-e") == 0)
+		{
+			if (!expectDigest(&digests, argv[i + 1]))
+				exit(2);
+		}
+		else if (*argv[i + 1] == '\0' || *firstInvalidChar != '\0' || value <= 0)
+		{
+			fprintf(stderr, "Missing or invalid numeric value for option '%s'.\n", argv[i]);
+			exit(2);
+		}
+		else if (strcmp(argv[i], "-j") == 0)
+		{
+			threads = value;
+		}
+		else if (strcmp(argv[i], "-c") == 0)
+		{
+			interval = (uint64_t) value * 1024;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option '%s'.\n", argv[i]);
+			exit(2);
+		}
+		i += 2;
+	}
+
+	initToolStatistics(&stats, "rle_decode", statistics);
+
+	if (isDigestSelected(&digests))
+		startDigests(&digests);
+	else
+		digestsUsed = NULL;
+
+	if (range != NULL)
+	{
+		uint64_t	start;
+		uint64_t	length = 0;
+		char *		next;
+		char *		defaultIndex = NULL;
+
+		start = strtoull(range, &next, 0);
+		if (next == range || *next != ':' || (*(next + 1) != '\0' && ((length = strtoull(next + 1, &next, 0)) == 0 || *next != '\0')))
+		{
+			fprintf(stderr, "Invalid range '%s', expected <start>:[<length>].\n", range);
+			exit(2);
+		}
+
+		if (!(argc - i == 1 || (argc - i == 2 && write)))
+		{
+			usage();
+			exit(1);
+		}
+
+		// the index is kept next to the image by default
+		if (indexName == NULL)
+		{
+			if ((defaultIndex = malloc(strlen(argv[i]) + sizeof(INDEX_FILE_SUFFIX))) == NULL)
+			{
+				fprintf(stderr, "Error allocating memory for the index file name.\n");
+				exit(1);
+			}
+			strcat(strcpy(defaultIndex, argv[i]), INDEX_FILE_SUFFIX);
+			indexName = defaultIndex;
+		}
+
+		returnCode = extractRange(argv[i], (argc - i == 2 ? argv[i + 1] : NULL), indexName, interval, start, length, (length == 0), write, digestsUsed, &stats);
+		free(defaultIndex);
+		writeToolStatistics(&stats);
+		exit(returnCode);
+	}
+
+	if (argc == i)
+	{
+		beginToolPhase(&stats, "decode");
+		returnCode = decodeStream(write, digestsUsed, &stats);
+		if (digestsUsed != NULL && !finishDigests(digestsUsed, (write ? stderr : stdout)))
+			returnCode = 1;
+		writeToolStatistics(&stats);
+		exit(returnCode);
+	}
+
+	if (argc - i != (write ? 2 : 1))
+	{
+		usage();
+		exit(1);
+	}
+
+	if (threads < 1)
+		threads = 1;
+
+	returnCode = decodeFile(argv[i], (write ? argv[i + 1] : NULL), indexName, interval, (int) threads, digestsUsed, &stats);
+	writeToolStatistics(&stats);
+	exit(returnCode);
 }
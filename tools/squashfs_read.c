@@ -0,0 +1,1446 @@
+/***********************************************************************
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pwd.h>
+#include <grp.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <zlib.h>
+#include <lzma.h>
+
+#include "../include/tool_statistics.h"
+
+//	A read-only SquashFS 4 reader, only the metadata and data blocks needed
+//	for the requested files are decompressed:
+//
+//	- the image is mapped into memory (or read from a pipe), the superblock
+//	  may be found at offset 0 or behind AVM's 256 byte dummy header of
+//	  'filesystem.image' files for devices with a wrapper partition
+//	- little endian images and the big endian variant used by AVM for MIPS
+//	  based devices are supported, all values are converted while reading
+//	- paths are resolved with the directory table, starting at the root
+//	  inode, the index of extended directories is used to skip metadata
+//	  blocks in front of the wanted name
+//	- decompressed metadata and data blocks are kept in small LRU caches,
+//	  gzip, lzma and xz compressed images are supported
+
+#define SQUASHFS_MAGIC				0x73717368
+#define SQUASHFS_MAGIC_SWAPPED		0x68737173
+#define SQUASHFS_SUPERBLOCK_SIZE	96
+#define SQUASHFS_METADATA_SIZE		8192
+#define SQUASHFS_INVALID_FRAGMENT	0xFFFFFFFF
+#define SQUASHFS_BLOCK_UNCOMPRESSED	0x01000000
+#define SQUASHFS_FRAGMENT_ENTRIES	(SQUASHFS_METADATA_SIZE / 16)
+#define SQUASHFS_ID_ENTRIES			(SQUASHFS_METADATA_SIZE / 4)
+#define SQUASHFS_DIRECTORY_ENTRIES	256
+#define AVM_DUMMY_HEADER_SIZE		256
+
+#define METADATA_CACHE_ENTRIES		64
+#define DATA_CACHE_ENTRIES			4
+#define MAX_SYMLINK_FOLLOWS			40
+#define MAX_DIRECTORY_DEPTH			256		// a damaged image may contain loops
+#define LISTING_TOTAL_CHARS			25		// the same as TOTALCHARS in 'unsquashfs'
+#define DEFAULT_DESTINATION			"squashfs-root"
+
+enum squashfsCompression
+{
+	squashfsGzip = 1,
+	squashfsLzma = 2,
+	squashfsLzo = 3,
+	squashfsXz = 4,
+	squashfsLz4 = 5,
+	squashfsZstd = 6,
+};
+
+enum squashfsInodeType
+{
+	squashfsDirectory = 1,
+	squashfsFile,
+	squashfsSymlink,
+	squashfsBlockDevice,
+	squashfsCharDevice,
+	squashfsFifo,
+	squashfsSocket,
+	squashfsExtendedDirectory,
+	squashfsExtendedFile,
+	squashfsExtendedSymlink,
+	squashfsExtendedBlockDevice,
+	squashfsExtendedCharDevice,
+	squashfsExtendedFifo,
+	squashfsExtendedSocket,
+};
+
+struct squashfsSuperblock
+{
+	uint32_t				inodeCount;
+	uint32_t				modificationTime;
+	uint32_t				blockSize;
+	uint32_t				fragmentCount;
+	uint16_t				compression;
+	uint16_t				blockLog;
+	uint16_t				flags;
+	uint16_t				idCount;
+	uint16_t				major;
+	uint16_t				minor;
+	uint64_t				rootInode;
+	uint64_t				bytesUsed;
+	uint64_t				idTable;
+	uint64_t				xattrTable;
+	uint64_t				inodeTable;
+	uint64_t				directoryTable;
+	uint64_t				fragmentTable;
+	uint64_t				exportTable;
+};
+
+struct cacheEntry
+{
+	uint64_t				position;
+	uint64_t				lastUse;
+	size_t					size;
+	uint8_t *				data;
+	bool					valid;
+};
+
+struct blockCache
+{
+	struct cacheEntry *		entries;
+	unsigned int			count;
+	size_t					blockSize;
+	uint64_t				useCounter;
+};
+
+struct squashfsImage
+{
+	const char *			name;
+	uint8_t *				file;
+	size_t					fileSize;
+	bool					mapped;
+	const uint8_t *			base;			// start of the superblock, all positions are relative to it
+	uint64_t				size;
+	bool					bigEndian;
+	bool					metadataBigEndian;	// AVM's big endian images use little endian block headers
+	struct squashfsSuperblock	super;
+	uint32_t *				ids;
+	struct blockCache		metadata;
+	struct blockCache		data;
+	uint64_t				metadataBlocks;
+	uint64_t				dataBlocks;
+	uint64_t				cacheHits;
+};
+
+struct metadataPosition
+{
+	uint64_t				block;			// start of the metadata block, relative to the superblock
+	uint32_t				offset;			// offset within the uncompressed block
+};
+
+struct squashfsInode
+{
+	uint16_t				type;
+	mode_t					mode;
+	uint32_t				uid;
+	uint32_t				gid;
+	uint32_t				modificationTime;
+	uint64_t				size;			// file size, directory listing size (+3) or symlink length
+	uint32_t				directoryBlock;
+	uint16_t				directoryOffset;
+	uint16_t				indexCount;
+	struct metadataPosition	indexPosition;
+	uint64_t				blocksStart;
+	uint32_t				fragment;
+	uint32_t				fragmentOffset;
+	uint64_t				blockCount;
+	struct metadataPosition	blockListPosition;
+	char *					target;
+	uint32_t				device;
+};
+
+struct directoryReader
+{
+	struct metadataPosition	position;
+	uint64_t				remaining;
+	uint32_t				entriesLeft;	// in the current header
+	uint32_t				start;
+	uint32_t				inodeNumber;
+};
+
+struct directoryEntry
+{
+	char					name[SQUASHFS_DIRECTORY_ENTRIES + 1];
+	uint16_t				type;
+	uint64_t				inode;
+};
+
+struct listingOptions
+{
+	bool					list;
+	FILE *					pseudo;
+	bool					numeric;
+	const char *			destination;
+	uint32_t				lastUid;
+	uint32_t				lastGid;
+	char					lastUser[64];
+	char					lastGroup[64];
+};
+
+static uint16_t get16(struct squashfsImage *image, const uint8_t *data)
+{
+	return (image->bigEndian ? (data[0] << 8) | data[1] : (data[1] << 8) | data[0]);
+}
+
+static uint32_t get32(struct squashfsImage *image, const uint8_t *data)
+{
+	if (image->bigEndian)
+		return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) | ((uint32_t) data[2] << 8) | data[3];
+	return ((uint32_t) data[3] << 24) | ((uint32_t) data[2] << 16) | ((uint32_t) data[1] << 8) | data[0];
+}
+
+static uint64_t get64(struct squashfsImage *image, const uint8_t *data)
+{
+	if (image->bigEndian)
+		return ((uint64_t) get32(image, data) << 32) | get32(image, data + 4);
+	return ((uint64_t) get32(image, data + 4) << 32) | get32(image, data);
+}
+
+static const uint8_t * imageData(struct squashfsImage *image, uint64_t position, uint64_t size)
+{
+	if (position > image->size || size > image->size - position)
+		return NULL;
+	return image->base + position;
+}
+
+bool loadImage(struct squashfsImage *image, const char *name)
+{
+	int			fd = (strcmp(name, "-") == 0 ? STDIN_FILENO : open(name, O_RDONLY));
+	struct stat	st;
+	size_t		allocated = 1024 * 1024;
+
+	memset(image, 0, sizeof(struct squashfsImage));
+	image->name = (fd == STDIN_FILENO ? "STDIN" : name);
+
+	if (fd == -1 || fstat(fd, &st) == -1)
+	{
+		fprintf(stderr, "Error %d opening image file '%s'.\n", errno, image->name);
+		return false;
+	}
+
+	if (S_ISREG(st.st_mode) && st.st_size > 0 && (uint64_t) st.st_size <= SIZE_MAX)
+	{
+		if ((image->file = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) != MAP_FAILED)
+		{
+			image->fileSize = st.st_size;
+			image->mapped = true;
+			close(fd);
+			return true;
+		}
+		image->file = NULL;
+	}
+
+	// pipes (e.g. from 'tar -x -O') are read completely, the image is accessed randomly
+	while (true)
+	{
+		ssize_t		got;
+
+		if (image->file == NULL || image->fileSize == allocated)
+		{
+			uint8_t *	newFile = realloc(image->file, (image->file == NULL ? allocated : (allocated *= 2)));
+
+			if (newFile == NULL)
+			{
+				fprintf(stderr, "Error allocating %zu bytes for image file '%s'.\n", allocated, image->name);
+				free(image->file);
+				image->file = NULL;
+				close(fd);
+				return false;
+			}
+			image->file = newFile;
+		}
+
+		if ((got = read(fd, image->file + image->fileSize, allocated - image->fileSize)) == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "Error %d reading image file '%s'.\n", errno, image->name);
+			free(image->file);
+			image->file = NULL;
+			close(fd);
+			return false;
+		}
+		if (got == 0)
+			break;
+		image->fileSize += got;
+	}
+
+	if (fd != STDIN_FILENO)
+		close(fd);
+	return true;
+}
+
+static bool initCache(struct blockCache *cache, unsigned int count, size_t blockSize)
+{
+	cache->count = count;
+	cache->blockSize = blockSize;
+	cache->useCounter = 0;
+	if ((cache->entries = calloc(count, sizeof(struct cacheEntry))) == NULL)
+		return false;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if ((cache->entries[i].data = malloc(blockSize)) == NULL)
+			return false;
+	}
+
+	return true;
+}
+
+static void freeCache(struct blockCache *cache)
+{
+	if (cache->entries == NULL)
+		return;
+
+	for (unsigned int i = 0; i < cache->count; i++)
+		free(cache->entries[i].data);
+	free(cache->entries);
+	cache->entries = NULL;
+}
+
+void closeImage(struct squashfsImage *image)
+{
+	freeCache(&image->metadata);
+	freeCache(&image->data);
+	free(image->ids);
+
+	if (image->mapped)
+		munmap(image->file, image->fileSize);
+	else
+		free(image->file);
+	image->file = NULL;
+}
+
+static bool parseSuperblock(struct squashfsImage *image, uint64_t offset)
+{
+	const uint8_t *				data = image->file + offset;
+	struct squashfsSuperblock *	super = &image->super;
+	uint32_t					magic;
+
+	if (offset > image->fileSize || image->fileSize - offset < SQUASHFS_SUPERBLOCK_SIZE)
+		return false;
+
+	magic = ((uint32_t) data[3] << 24) | ((uint32_t) data[2] << 16) | ((uint32_t) data[1] << 8) | data[0];
+	if (magic != SQUASHFS_MAGIC && magic != SQUASHFS_MAGIC_SWAPPED)
+		return false;
+
+	image->bigEndian = (magic == SQUASHFS_MAGIC_SWAPPED);
+	image->base = data;
+	image->size = image->fileSize - offset;
+
+	super->inodeCount = get32(image, data + 4);
+	super->modificationTime = get32(image, data + 8);
+	super->blockSize = get32(image, data + 12);
+	super->fragmentCount = get32(image, data + 16);
+	super->compression = get16(image, data + 20);
+	super->blockLog = get16(image, data + 22);
+	super->flags = get16(image, data + 24);
+	super->idCount = get16(image, data + 26);
+	super->major = get16(image, data + 28);
+	super->minor = get16(image, data + 30);
+	super->rootInode = get64(image, data + 32);
+	super->bytesUsed = get64(image, data + 40);
+	super->idTable = get64(image, data + 48);
+	super->xattrTable = get64(image, data + 56);
+	super->inodeTable = get64(image, data + 64);
+	super->directoryTable = get64(image, data + 72);
+	super->fragmentTable = get64(image, data + 80);
+	super->exportTable = get64(image, data + 88);
+
+	// AVM's dummy header contains only the magic value and zeros
+	if (super->major != 4 || super->blockLog < 12 || super->blockLog > 20 || super->blockSize != (1U << super->blockLog))
+		return false;
+
+	if (super->bytesUsed > image->size || super->inodeTable >= super->bytesUsed || super->directoryTable >= super->bytesUsed || super->directoryTable < super->inodeTable)
+		return false;
+
+	// the image may be followed by padding, it's not used at all
+	image->size = super->bytesUsed;
+
+	// AVM's big endian images swap the superblock and the table contents, but
+	// the headers of metadata blocks may still be stored as little endian
+	// values - the first header of the inode table has to specify a length up
+	// to 8 KByte, the swapped value of a little endian header doesn't do this
+	image->metadataBigEndian = false;
+	if (image->bigEndian && super->inodeTable + 2 <= super->bytesUsed)
+	{
+		const uint8_t *	header = data + super->inodeTable;
+		uint16_t		length = (header[0] << 8) | header[1];
+
+		image->metadataBigEndian = ((length & 0x7FFF) > 0 && (length & 0x7FFF) <= SQUASHFS_METADATA_SIZE);
+	}
+	return true;
+}
+
+static bool decompressBlock(struct squashfsImage *image, const uint8_t *input, size_t inputSize, uint8_t *output, size_t outputSize, size_t *produced)
+{
+	switch (image->super.compression)
+	{
+		case squashfsGzip:
+		{
+			uLongf		size = outputSize;
+
+			if (uncompress(output, &size, input, inputSize) != Z_OK)
+				return false;
+			*produced = size;
+			return true;
+		}
+
+		case squashfsLzma:
+		{
+			lzma_stream	stream = LZMA_STREAM_INIT;
+			lzma_ret	result;
+
+			if (lzma_alone_decoder(&stream, UINT64_MAX) != LZMA_OK)
+				return false;
+
+			stream.next_in = input;
+			stream.avail_in = inputSize;
+			stream.next_out = output;
+			stream.avail_out = outputSize;
+			result = lzma_code(&stream, LZMA_FINISH);
+			*produced = outputSize - stream.avail_out;
+			lzma_end(&stream);
+
+			return (result == LZMA_STREAM_END || (result == LZMA_OK && stream.avail_in == 0));
+		}
+
+		case squashfsXz:
+		{
+			uint64_t	memoryLimit = UINT64_MAX;
+			size_t		inputPosition = 0;
+
+			*produced = 0;
+			return (lzma_stream_buffer_decode(&memoryLimit, 0, NULL, input, &inputPosition, inputSize, output, produced, outputSize) == LZMA_OK);
+		}
+	}
+
+	return false;
+}
+
+static const char * compressionName(uint16_t compression)
+{
+	switch (compression)
+	{
+		case squashfsGzip:
+			return "gzip";
+
+		case squashfsLzma:
+			return "lzma";
+
+		case squashfsLzo:
+			return "lzo";
+
+		case squashfsXz:
+			return "xz";
+
+		case squashfsLz4:
+			return "lz4";
+
+		case squashfsZstd:
+			return "zstd";
+	}
+
+	return "unknown";
+}
+
+//	Returns the decompressed content of a block, the pointer is valid until
+//	the next call for the same cache.
+
+static const uint8_t * cachedBlock(struct squashfsImage *image, struct blockCache *cache, uint64_t position, size_t diskSize, bool compressed, size_t *size)
+{
+	struct cacheEntry *		entry = NULL;
+	const uint8_t *			input;
+
+	for (unsigned int i = 0; i < cache->count; i++)
+	{
+		struct cacheEntry *	candidate = &cache->entries[i];
+
+		if (candidate->valid && candidate->position == position)
+		{
+			candidate->lastUse = ++cache->useCounter;
+			image->cacheHits++;
+			*size = candidate->size;
+			return candidate->data;
+		}
+
+		if (entry == NULL || !candidate->valid || (entry->valid && candidate->lastUse < entry->lastUse))
+			entry = candidate;
+	}
+
+	if ((input = imageData(image, position, diskSize)) == NULL)
+	{
+		fprintf(stderr, "Block at offset 0x%" PRIx64 " exceeds the image size.\n", position);
+		return NULL;
+	}
+
+	entry->valid = false;
+	if (compressed)
+	{
+		if (!decompressBlock(image, input, diskSize, entry->data, cache->blockSize, &entry->size))
+		{
+			fprintf(stderr, "Error decompressing block at offset 0x%" PRIx64 ".\n", position);
+			return NULL;
+		}
+	}
+	else
+	{
+		if (diskSize > cache->blockSize)
+		{
+			fprintf(stderr, "Uncompressed block at offset 0x%" PRIx64 " is too large.\n", position);
+			return NULL;
+		}
+		memcpy(entry->data, input, diskSize);
+		entry->size = diskSize;
+	}
+
+	if (cache == &image->metadata)
+		image->metadataBlocks++;
+	else
+		image->dataBlocks++;
+
+	entry->position = position;
+	entry->lastUse = ++cache->useCounter;
+	entry->valid = true;
+	*size = entry->size;
+
+	return entry->data;
+}
+
+static const uint8_t * metadataBlock(struct squashfsImage *image, uint64_t block, size_t *size, uint64_t *next)
+{
+	const uint8_t *	header = imageData(image, block, 2);
+	uint16_t		length;
+
+	if (header == NULL)
+	{
+		fprintf(stderr, "Metadata block at offset 0x%" PRIx64 " exceeds the image size.\n", block);
+		return NULL;
+	}
+
+	length = (image->metadataBigEndian ? (header[0] << 8) | header[1] : (header[1] << 8) | header[0]);
+	*next = block + 2 + (length & 0x7FFF);
+
+	return cachedBlock(image, &image->metadata, block + 2, length & 0x7FFF, !(length & 0x8000), size);
+}
+
+bool readMetadata(struct squashfsImage *image, struct metadataPosition *position, void *buffer, size_t size)
+{
+	uint8_t *		output = buffer;
+
+	while (size > 0)
+	{
+		size_t			blockSize;
+		uint64_t		next;
+		const uint8_t *	block = metadataBlock(image, position->block, &blockSize, &next);
+		size_t			count;
+
+		if (block == NULL)
+			return false;
+
+		if (position->offset >= blockSize)
+		{
+			// the last byte of a block was read before
+			if (position->offset > blockSize || blockSize == 0)
+			{
+				fprintf(stderr, "Invalid metadata position 0x%" PRIx64 ":%u.\n", position->block, position->offset);
+				return false;
+			}
+			position->block = next;
+			position->offset = 0;
+			continue;
+		}
+
+		count = blockSize - position->offset;
+		if (count > size)
+			count = size;
+
+		if (output != NULL)
+		{
+			memcpy(output, block + position->offset, count);
+			output += count;
+		}
+		position->offset += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+static bool readTableEntry(struct squashfsImage *image, uint64_t table, uint32_t index, uint32_t entriesPerBlock, size_t entrySize, void *buffer)
+{
+	const uint8_t *			pointer = imageData(image, table + ((uint64_t) (index / entriesPerBlock) * 8), 8);
+	struct metadataPosition	position;
+
+	if (pointer == NULL)
+	{
+		fprintf(stderr, "Lookup table at offset 0x%" PRIx64 " exceeds the image size.\n", table);
+		return false;
+	}
+
+	position.block = get64(image, pointer);
+	position.offset = (index % entriesPerBlock) * entrySize;
+
+	return readMetadata(image, &position, buffer, entrySize);
+}
+
+bool openImage(struct squashfsImage *image, int64_t offset)
+{
+	if (offset >= 0 ? !parseSuperblock(image, offset) : (!parseSuperblock(image, 0) && !parseSuperblock(image, AVM_DUMMY_HEADER_SIZE)))
+	{
+		fprintf(stderr, "No valid SquashFS 4 superblock found in image file '%s'.\n", image->name);
+		return false;
+	}
+
+	if (image->super.compression != squashfsGzip && image->super.compression != squashfsLzma && image->super.compression != squashfsXz)
+	{
+		fprintf(stderr, "The image file '%s' uses an unsupported compression (%s).\n", image->name, compressionName(image->super.compression));
+		return false;
+	}
+
+	if (!initCache(&image->metadata, METADATA_CACHE_ENTRIES, SQUASHFS_METADATA_SIZE) || !initCache(&image->data, DATA_CACHE_ENTRIES, image->super.blockSize) ||
+		(image->ids = calloc(image->super.idCount + 1, sizeof(uint32_t))) == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for the block caches.\n");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < image->super.idCount; i++)
+	{
+		uint8_t		value[4];
+
+		if (!readTableEntry(image, image->super.idTable, i, SQUASHFS_ID_ENTRIES, sizeof(value), value))
+			return false;
+		image->ids[i] = get32(image, value);
+	}
+
+	return true;
+}
+
+static uint32_t lookupId(struct squashfsImage *image, uint16_t index)
+{
+	return (index < image->super.idCount ? image->ids[index] : 0);
+}
+
+void freeInode(struct squashfsInode *inode)
+{
+	free(inode->target);
+	inode->target = NULL;
+}
+
+bool readInode(struct squashfsImage *image, uint64_t reference, struct squashfsInode *inode)
+{
+	struct metadataPosition	position = { image->super.inodeTable + (reference >> 16), reference & 0xFFFF };
+	uint8_t					header[16];
+	uint8_t					data[40];
+	static const mode_t		types[] = { 0, S_IFDIR, S_IFREG, S_IFLNK, S_IFBLK, S_IFCHR, S_IFIFO, S_IFSOCK };
+
+	memset(inode, 0, sizeof(struct squashfsInode));
+
+	if (!readMetadata(image, &position, header, sizeof(header)))
+		return false;
+
+	inode->type = get16(image, header);
+	if (inode->type < squashfsDirectory || inode->type > squashfsExtendedSocket)
+	{
+		fprintf(stderr, "Invalid inode type %u at 0x%" PRIx64 ".\n", inode->type, reference);
+		return false;
+	}
+	inode->mode = (get16(image, header + 2) & 07777) | types[(inode->type - 1) % 7 + 1];
+	inode->uid = lookupId(image, get16(image, header + 4));
+	inode->gid = lookupId(image, get16(image, header + 6));
+	inode->modificationTime = get32(image, header + 8);
+
+	switch (inode->type)
+	{
+		case squashfsDirectory:
+			if (!readMetadata(image, &position, data, 16))
+				return false;
+			inode->directoryBlock = get32(image, data);
+			inode->size = get16(image, data + 8);
+			inode->directoryOffset = get16(image, data + 10);
+			break;
+
+		case squashfsExtendedDirectory:
+			if (!readMetadata(image, &position, data, 24))
+				return false;
+			inode->size = get32(image, data + 4);
+			inode->directoryBlock = get32(image, data + 8);
+			inode->indexCount = get16(image, data + 16);
+			inode->directoryOffset = get16(image, data + 18);
+			inode->indexPosition = position;
+			break;
+
+		case squashfsFile:
+		case squashfsExtendedFile:
+			if (inode->type == squashfsFile)
+			{
+				if (!readMetadata(image, &position, data, 16))
+					return false;
+				inode->blocksStart = get32(image, data);
+				inode->fragment = get32(image, data + 4);
+				inode->fragmentOffset = get32(image, data + 8);
+				inode->size = get32(image, data + 12);
+			}
+			else
+			{
+				if (!readMetadata(image, &position, data, 40))
+					return false;
+				inode->blocksStart = get64(image, data);
+				inode->size = get64(image, data + 8);
+				inode->fragment = get32(image, data + 28);
+				inode->fragmentOffset = get32(image, data + 32);
+			}
+			inode->blockCount = (inode->fragment == SQUASHFS_INVALID_FRAGMENT ? (inode->size + image->super.blockSize - 1) : inode->size) >> image->super.blockLog;
+			inode->blockListPosition = position;
+			break;
+
+		case squashfsSymlink:
+		case squashfsExtendedSymlink:
+			if (!readMetadata(image, &position, data, 8))
+				return false;
+			inode->size = get32(image, data + 4);
+			if (inode->size > 65535 || (inode->target = malloc(inode->size + 1)) == NULL || !readMetadata(image, &position, inode->target, inode->size))
+			{
+				fprintf(stderr, "Unable to read the target of the symbolic link at 0x%" PRIx64 ".\n", reference);
+				return false;
+			}
+			inode->target[inode->size] = 0;
+			break;
+
+		case squashfsBlockDevice:
+		case squashfsCharDevice:
+		case squashfsExtendedBlockDevice:
+		case squashfsExtendedCharDevice:
+			if (!readMetadata(image, &position, data, 8))
+				return false;
+			inode->device = get32(image, data + 4);
+			break;
+
+		default:
+			break;
+	}
+
+	return true;
+}
+
+static bool isDirectory(struct squashfsInode *inode)
+{
+	return (inode->type == squashfsDirectory || inode->type == squashfsExtendedDirectory);
+}
+
+//	The listing of a directory consists of headers (count - 1, the inode
+//	table block and the base inode number) followed by up to 256 entries
+//	(offset in the inode block, inode number difference, type, name size
+//	- 1 and the name). The size in the inode is 3 bytes larger than the
+//	listing. If a name is specified and the directory has an index, the
+//	reader starts at the last index entry with a name in front of it.
+
+bool openDirectory(struct squashfsImage *image, struct squashfsInode *inode, const char *name, struct directoryReader *reader)
+{
+	uint32_t		skipped = 0;
+
+	memset(reader, 0, sizeof(struct directoryReader));
+	reader->position.block = image->super.directoryTable + inode->directoryBlock;
+
+	if (name != NULL && inode->indexCount > 0)
+	{
+		struct metadataPosition	position = inode->indexPosition;
+
+		for (uint16_t i = 0; i < inode->indexCount; i++)
+		{
+			uint8_t		index[12];
+			char		indexName[SQUASHFS_DIRECTORY_ENTRIES + 1];
+			uint32_t	nameSize;
+
+			if (!readMetadata(image, &position, index, sizeof(index)))
+				return false;
+			if ((nameSize = get32(image, index + 8) + 1) > SQUASHFS_DIRECTORY_ENTRIES || !readMetadata(image, &position, indexName, nameSize))
+				return false;
+			indexName[nameSize] = 0;
+
+			if (strcmp(indexName, name) > 0)
+				break;
+			skipped = get32(image, index);
+			reader->position.block = image->super.directoryTable + get32(image, index + 4);
+		}
+	}
+
+	if (inode->size < 3 || skipped > inode->size - 3)
+	{
+		fprintf(stderr, "Invalid directory size %" PRIu64 ".\n", inode->size);
+		return false;
+	}
+
+	reader->position.offset = (inode->directoryOffset + skipped) % SQUASHFS_METADATA_SIZE;
+	reader->remaining = inode->size - 3 - skipped;
+
+	return true;
+}
+
+bool readDirectory(struct squashfsImage *image, struct directoryReader *reader, struct directoryEntry *entry, bool *found)
+{
+	uint8_t			data[12];
+	uint32_t		nameSize;
+
+	*found = false;
+
+	if (reader->entriesLeft == 0)
+	{
+		if (reader->remaining < 12)
+			return true;
+		if (!readMetadata(image, &reader->position, data, 12))
+			return false;
+		reader->entriesLeft = get32(image, data) + 1;
+		reader->start = get32(image, data + 4);
+		reader->inodeNumber = get32(image, data + 8);
+		reader->remaining -= 12;
+
+		if (reader->entriesLeft > SQUASHFS_DIRECTORY_ENTRIES)
+		{
+			fprintf(stderr, "Invalid directory header with %u entries.\n", reader->entriesLeft);
+			return false;
+		}
+	}
+
+	if (reader->remaining < 8 || !readMetadata(image, &reader->position, data, 8))
+	{
+		fprintf(stderr, "Directory listing is truncated.\n");
+		return false;
+	}
+
+	nameSize = get16(image, data + 6) + 1;
+	if (nameSize > SQUASHFS_DIRECTORY_ENTRIES || reader->remaining < 8 + nameSize || !readMetadata(image, &reader->position, entry->name, nameSize))
+	{
+		fprintf(stderr, "Invalid directory entry.\n");
+		return false;
+	}
+	entry->name[nameSize] = 0;
+	entry->type = get16(image, data + 4);
+	entry->inode = ((uint64_t) reader->start << 16) | get16(image, data);
+
+	reader->remaining -= 8 + nameSize;
+	reader->entriesLeft--;
+	*found = true;
+
+	return true;
+}
+
+static bool findEntry(struct squashfsImage *image, struct squashfsInode *directory, const char *name, uint64_t *reference, bool *found)
+{
+	struct directoryReader	reader;
+	struct directoryEntry	entry;
+
+	*found = false;
+
+	if (!openDirectory(image, directory, name, &reader))
+		return false;
+
+	// the entries are sorted, the search ends at the first name behind the wanted one
+	while (true)
+	{
+		bool	valid;
+		int		comparison;
+
+		if (!readDirectory(image, &reader, &entry, &valid))
+			return false;
+		if (!valid || (comparison = strcmp(entry.name, name)) > 0)
+			return true;
+		if (comparison == 0)
+		{
+			*reference = entry.inode;
+			*found = true;
+			return true;
+		}
+	}
+}
+
+//	Resolves a path from the root directory, symbolic links are followed,
+//	if they're in the middle of the path or if 'followLast' is set. The
+//	references of all parent directories are kept to handle '..' entries.
+//	Returns 0 on success or an errno value.
+
+int lookupPath(struct squashfsImage *image, const char *path, bool followLast, struct squashfsInode *inode)
+{
+	uint64_t		stack[PATH_MAX / 2];
+	unsigned int	depth = 1;
+	uint64_t		current = image->super.rootInode;
+	char *			remaining = strdup(path);
+	char *			component;
+	unsigned int	follows = 0;
+	int				error = 0;
+
+	if (remaining == NULL)
+		return ENOMEM;
+
+	stack[0] = current;
+	component = remaining;
+
+	while (error == 0 && *component != 0)
+	{
+		char *		next;
+		bool		last;
+		bool		found;
+		uint64_t	reference;
+		struct squashfsInode	directory;
+
+		if (*component == '/')
+		{
+			component++;
+			continue;
+		}
+
+		if ((next = strchr(component, '/')) != NULL)
+			*next++ = 0;
+		else
+			next = component + strlen(component);
+		last = (strspn(next, "/") == strlen(next));
+
+		if (strcmp(component, ".") == 0)
+		{
+			current = stack[depth - 1];
+			component = next;
+			continue;
+		}
+
+		if (strcmp(component, "..") == 0)
+		{
+			if (depth > 1)
+				depth--;
+			current = stack[depth - 1];
+			component = next;
+			continue;
+		}
+
+		if (!readInode(image, stack[depth - 1], &directory))
+		{
+			error = EIO;
+			break;
+		}
+
+		if (!isDirectory(&directory))
+			error = ENOTDIR;
+		else if (!findEntry(image, &directory, component, &reference, &found))
+			error = EIO;
+		else if (!found)
+			error = ENOENT;
+		freeInode(&directory);
+		if (error != 0)
+			break;
+
+		if (!readInode(image, reference, inode))
+		{
+			error = EIO;
+			break;
+		}
+
+		if ((inode->type == squashfsSymlink || inode->type == squashfsExtendedSymlink) && (!last || followLast))
+		{
+			char *	expanded;
+
+			if (++follows > MAX_SYMLINK_FOLLOWS)
+				error = ELOOP;
+			else if (asprintf(&expanded, "%s/%s", inode->target, next) == -1)
+				error = ENOMEM;
+			else
+			{
+				if (*inode->target == '/')
+					depth = 1;
+				current = stack[depth - 1];
+				free(remaining);
+				remaining = component = expanded;
+			}
+			freeInode(inode);
+			continue;
+		}
+
+		if (isDirectory(inode))
+		{
+			if (depth == sizeof(stack) / sizeof(stack[0]))
+				error = ENAMETOOLONG;
+			else
+				stack[depth++] = reference;
+		}
+		else if (!last)
+			error = ENOTDIR;
+
+		current = reference;
+		freeInode(inode);
+		component = next;
+	}
+
+	free(remaining);
+
+	if (error == 0 && !readInode(image, current, inode))
+		error = EIO;
+
+	return error;
+}
+
+bool writeFileContent(struct squashfsImage *image, struct squashfsInode *inode, FILE *output)
+{
+	struct metadataPosition	position = inode->blockListPosition;
+	uint64_t				blockStart = inode->blocksStart;
+	uint64_t				remaining = inode->size;
+	uint32_t				blockSize = image->super.blockSize;
+	static uint8_t			zeros[1 << 20];
+
+	for (uint64_t i = 0; i < inode->blockCount; i++)
+	{
+		uint8_t			value[4];
+		uint32_t		diskSize;
+		size_t			wanted = (remaining < blockSize ? remaining : blockSize);
+		const uint8_t *	content;
+		size_t			size;
+
+		if (!readMetadata(image, &position, value, sizeof(value)))
+			return false;
+		diskSize = get32(image, value);
+
+		if ((diskSize & ~SQUASHFS_BLOCK_UNCOMPRESSED) == 0)
+		{
+			// sparse block
+			content = zeros;
+			size = wanted;
+		}
+		else if (diskSize & SQUASHFS_BLOCK_UNCOMPRESSED)
+		{
+			// uncompressed blocks are written directly from the image
+			diskSize &= ~SQUASHFS_BLOCK_UNCOMPRESSED;
+			content = imageData(image, blockStart, diskSize);
+			size = diskSize;
+			blockStart += diskSize;
+		}
+		else
+		{
+			content = cachedBlock(image, &image->data, blockStart, diskSize, true, &size);
+			blockStart += diskSize;
+		}
+
+		if (content == NULL || size < wanted)
+		{
+			fprintf(stderr, "Data block %" PRIu64 " of a file is invalid.\n", i);
+			return false;
+		}
+
+		if (fwrite(content, 1, wanted, output) != wanted)
+		{
+			fprintf(stderr, "Error %d writing file content.\n", errno);
+			return false;
+		}
+		remaining -= wanted;
+	}
+
+	if (remaining > 0)
+	{
+		uint8_t			entry[16];
+		uint32_t		diskSize;
+		const uint8_t *	content;
+		size_t			size;
+
+		if (inode->fragment == SQUASHFS_INVALID_FRAGMENT || inode->fragment >= image->super.fragmentCount)
+		{
+			fprintf(stderr, "The file's tail isn't stored in a fragment, the image seems to be damaged.\n");
+			return false;
+		}
+
+		if (!readTableEntry(image, image->super.fragmentTable, inode->fragment, SQUASHFS_FRAGMENT_ENTRIES, sizeof(entry), entry))
+			return false;
+		diskSize = get32(image, entry + 8);
+
+		content = cachedBlock(image, &image->data, get64(image, entry), diskSize & ~SQUASHFS_BLOCK_UNCOMPRESSED, !(diskSize & SQUASHFS_BLOCK_UNCOMPRESSED), &size);
+		if (content == NULL || inode->fragmentOffset > size || size - inode->fragmentOffset < remaining)
+		{
+			fprintf(stderr, "Fragment %u is invalid.\n", inode->fragment);
+			return false;
+		}
+
+		if (fwrite(content + inode->fragmentOffset, 1, remaining, output) != remaining)
+		{
+			fprintf(stderr, "Error %d writing file content.\n", errno);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static char * modeString(char *string, mode_t mode)
+{
+	static const struct { mode_t mask; mode_t value; int position; char mode; } table[] = {
+		{ S_IFMT, S_IFSOCK, 0, 's' }, { S_IFMT, S_IFLNK, 0, 'l' }, { S_IFMT, S_IFBLK, 0, 'b' },
+		{ S_IFMT, S_IFDIR, 0, 'd' }, { S_IFMT, S_IFCHR, 0, 'c' }, { S_IFMT, S_IFIFO, 0, 'p' },
+		{ S_IRUSR, S_IRUSR, 1, 'r' }, { S_IWUSR, S_IWUSR, 2, 'w' }, { S_IRGRP, S_IRGRP, 4, 'r' },
+		{ S_IWGRP, S_IWGRP, 5, 'w' }, { S_IROTH, S_IROTH, 7, 'r' }, { S_IWOTH, S_IWOTH, 8, 'w' },
+		{ S_IXUSR | S_ISUID, S_IXUSR, 3, 'x' }, { S_IXUSR | S_ISUID, S_ISUID, 3, 'S' }, { S_IXUSR | S_ISUID, S_IXUSR | S_ISUID, 3, 's' },
+		{ S_IXGRP | S_ISGID, S_IXGRP, 6, 'x' }, { S_IXGRP | S_ISGID, S_ISGID, 6, 'S' }, { S_IXGRP | S_ISGID, S_IXGRP | S_ISGID, 6, 's' },
+		{ S_IXOTH | S_ISVTX, S_IXOTH, 9, 'x' }, { S_IXOTH | S_ISVTX, S_ISVTX, 9, 'T' }, { S_IXOTH | S_ISVTX, S_IXOTH | S_ISVTX, 9, 't' },
+	};
+
+	strcpy(string, "----------");
+	for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++)
+	{
+		if ((mode & table[i].mask) == table[i].value)
+			string[table[i].position] = table[i].mode;
+	}
+
+	return string;
+}
+
+static unsigned int deviceMajor(uint32_t device)
+{
+	return (device & 0xFFF00) >> 8;
+}
+
+static unsigned int deviceMinor(uint32_t device)
+{
+	return (device & 0xFF) | ((device >> 12) & 0xFFF00);
+}
+
+static const char * ownerName(struct listingOptions *options, uint32_t id, bool group)
+{
+	uint32_t *		lastId = (group ? &options->lastGid : &options->lastUid);
+	char *			lastName = (group ? options->lastGroup : options->lastUser);
+	const char *	name = NULL;
+
+	// the names are looked up on the host, like 'unsquashfs' does it
+	if (*lastName != 0 && *lastId == id)
+		return lastName;
+
+	if (!options->numeric)
+	{
+		if (group)
+		{
+			struct group *	entry = getgrgid(id);
+
+			name = (entry ? entry->gr_name : NULL);
+		}
+		else
+		{
+			struct passwd *	entry = getpwuid(id);
+
+			name = (entry ? entry->pw_name : NULL);
+		}
+	}
+
+	if (name != NULL && strlen(name) < sizeof(options->lastUser))
+		strcpy(lastName, name);
+	else
+		snprintf(lastName, sizeof(options->lastUser), "%u", id);
+	*lastId = id;
+
+	return lastName;
+}
+
+void listInode(struct listingOptions *options, const char *pathname, struct squashfsInode *inode)
+{
+	if (options->list)
+	{
+		char		mode[11];
+		const char *user = ownerName(options, inode->uid, false);
+		const char *group = ownerName(options, inode->gid, true);
+		int			padding = LISTING_TOTAL_CHARS - (int) strlen(user) - (int) strlen(group);
+		time_t		modificationTime = inode->modificationTime;
+		struct tm *	t = localtime(&modificationTime);
+
+		printf("%s %s/%s ", modeString(mode, inode->mode), user, group);
+
+		if (S_ISCHR(inode->mode) || S_ISBLK(inode->mode))
+			printf("%*s%3u,%3u ", (padding - 7 > 0 ? padding - 7 : 0), " ", deviceMajor(inode->device), deviceMinor(inode->device));
+		else
+			printf("%*" PRIu64 " ", (padding > 0 ? padding : 0), inode->size);
+
+		printf("%d-%02d-%02d %02d:%02d %s", t->tm_year + 1900, t->tm_mon + 1, t->tm_mday, t->tm_hour, t->tm_min, pathname);
+		if (S_ISLNK(inode->mode))
+			printf(" -> %s", inode->target);
+		printf("\n");
+	}
+
+	// the same format as the '-pseudo' option of the patched 'unsquashfs' (see '../squashfs')
+	if (options->pseudo != NULL && (S_ISCHR(inode->mode) || S_ISBLK(inode->mode)))
+	{
+		fprintf(options->pseudo, "%s %c %3o %u %u %u %u\n", pathname + strlen(options->destination), (S_ISCHR(inode->mode) ? 'c' : 'b'),
+				(unsigned int) (inode->mode & 0777), inode->uid, inode->gid, deviceMajor(inode->device), deviceMinor(inode->device));
+	}
+}
+
+bool listTree(struct squashfsImage *image, struct listingOptions *options, const char *pathname, struct squashfsInode *inode, unsigned int depth)
+{
+	struct directoryReader	reader;
+	struct directoryEntry	entry;
+	bool					result = true;
+
+	listInode(options, pathname, inode);
+
+	if (!isDirectory(inode))
+		return true;
+
+	if (depth >= MAX_DIRECTORY_DEPTH)
+	{
+		fprintf(stderr, "Directory '%s' is nested too deeply.\n", pathname);
+		return false;
+	}
+
+	if (!openDirectory(image, inode, NULL, &reader))
+		return false;
+
+	while (result)
+	{
+		struct squashfsInode	child;
+		char *					childName;
+		bool					found;
+
+		if (!readDirectory(image, &reader, &entry, &found))
+			return false;
+		if (!found)
+			break;
+
+		if (asprintf(&childName, "%s/%s", pathname, entry.name) == -1)
+		{
+			fprintf(stderr, "Error allocating memory for a path name.\n");
+			return false;
+		}
+
+		if (readInode(image, entry.inode, &child))
+			result = listTree(image, options, childName, &child, depth + 1);
+		else
+			result = false;
+
+		freeInode(&child);
+		free(childName);
+	}
+
+	return result;
+}
+
+void usage(void)
+{
+	fprintf(stderr, "squashfs_read - read files from a SquashFS 4 image without unpacking it\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "squashfs_read [ --stats ] [ -o <offset> ] <image> <path> [ <path> ... ]\n");
+	fprintf(stderr, "squashfs_read [ --stats ] [ -o <offset> ] [ -l ] [ -n ] [ -p <pseudo_file> ] [ -d <dest> ] <image> [ <path> ... ]\n");
+	fprintf(stderr, "\nThe content of the specified files is written to STDOUT, symbolic links");
+	fprintf(stderr, "\nare followed. Only the needed metadata and data blocks are read and");
+	fprintf(stderr, "\ndecompressed, images with gzip, lzma and xz compression are supported.\n");
+	fprintf(stderr, "\nThe superblock is expected at the start of the image or behind AVM's");
+	fprintf(stderr, "\ndummy header (256 bytes), -o (--offset=) specifies another location. The");
+	fprintf(stderr, "\nimage may be read from STDIN, if '-' is used as its name, e.g. with");
+	fprintf(stderr, "\n'tar -x -O -f firmware.image ./var/tmp/filesystem.image | squashfs_read - /etc/version'.\n");
+	fprintf(stderr, "\nWith -l (--list), the specified paths (or the whole image) are listed");
+	fprintf(stderr, "\nrecursively like with 'unsquashfs -lls' and -p (--pseudo=) writes pseudo");
+	fprintf(stderr, "\nfile definitions for device nodes to the specified file ('-' for STDOUT),");
+	fprintf(stderr, "\nlike the '-pseudo' option of the patched 'unsquashfs' does it. Owners are");
+	fprintf(stderr, "\nshown with the names from the host, use -n (--numeric) to get the IDs. The");
+	fprintf(stderr, "\nnames in the listing start with 'squashfs-root', -d (--dest=) changes this.\n");
+	fprintf(stderr, "\nWith --stats (or YF_TOOL_STATS set in the environment), the time needed");
+	fprintf(stderr, "\nfor each phase and some counters are written as a JSON line to STDERR.\n");
+}
+
+int main(int argc, char * argv[])
+{
+	struct squashfsImage	image;
+	struct listingOptions	options;
+	const char *			pseudoName = NULL;
+	int64_t					offset = -1;
+	bool					statistics = false;
+	struct toolStatistics	stats;
+	int						returnCode = 0;
+	int						i = 1;
+
+	memset(&options, 0, sizeof(options));
+	options.destination = DEFAULT_DESTINATION;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0')
+	{
+		const char *	value = NULL;
+		char			option = 0;
+
+		if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+		{
+			usage();
+			exit(1);
+		}
+
+		if (isToolStatisticsOption(argv[i]))
+			statistics = true;
+		else if (strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "--list") == 0)
+			options.list = true;
+		else if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--numeric") == 0)
+			options.numeric = true;
+		else if (strncmp(argv[i], "--offset=", 9) == 0 || strncmp(argv[i], "--pseudo=", 9) == 0 || strncmp(argv[i], "--dest=", 7) == 0)
+		{
+			option = argv[i][2];
+			value = strchr(argv[i], '=') + 1;
+		}
+		else if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "-d") == 0)
+		{
+			if (i + 1 >= argc)
+			{
+				fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+				exit(2);
+			}
+			option = argv[i][1];
+			value = argv[++i];
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option '%s'.\n", argv[i]);
+			exit(2);
+		}
+
+		if (option == 'o')
+		{
+			char *	firstInvalidChar;
+
+			offset = strtoll(value, &firstInvalidChar, 0);
+			if (*value == '\0' || *firstInvalidChar != '\0' || offset < 0)
+			{
+				fprintf(stderr, "Missing or invalid numeric value for the image offset.\n");
+				exit(2);
+			}
+		}
+		else if (option == 'p')
+			pseudoName = value;
+		else if (option == 'd')
+			options.destination = value;
+		i++;
+	}
+
+	if (i >= argc || (i + 1 == argc && !options.list && pseudoName == NULL))
+	{
+		usage();
+		exit(1);
+	}
+
+	initToolStatistics(&stats, "squashfs_read", statistics);
+
+	beginToolPhase(&stats, "load");
+	if (!loadImage(&image, argv[i]))
+		exit(1);
+	addToolCounter(&stats, "image_bytes", image.fileSize);
+
+	beginToolPhase(&stats, "superblock");
+	if (!openImage(&image, offset))
+	{
+		closeImage(&image);
+		exit(1);
+	}
+
+	if (pseudoName != NULL && (options.pseudo = (strcmp(pseudoName, "-") == 0 ? stdout : fopen(pseudoName, "w"))) == NULL)
+	{
+		fprintf(stderr, "Error %d creating pseudo definitions file '%s'.\n", errno, pseudoName);
+		closeImage(&image);
+		exit(1);
+	}
+
+	beginToolPhase(&stats, (options.list || options.pseudo ? "list" : "read"));
+	for (int path = i + 1; path < argc || (path == i + 1 && path == argc); path++)
+	{
+		struct squashfsInode	inode;
+		const char *			name = (path < argc ? argv[path] : "/");
+		int						error = lookupPath(&image, name, !(options.list || options.pseudo), &inode);
+
+		if (error != 0)
+		{
+			if (error != EIO)
+				fprintf(stderr, "Unable to find '%s' in the image: %s.\n", name, strerror(error));
+			returnCode = 1;
+			continue;
+		}
+
+		addToolCounter(&stats, "files", 1);
+
+		if (options.list || options.pseudo)
+		{
+			char *	pathname;
+			size_t	length = strlen(name);
+
+			while (length > 0 && name[length - 1] == '/')
+				length--;
+
+			if (asprintf(&pathname, "%s%s%.*s", options.destination, (*name == '/' || length == 0 ? "" : "/"), (int) length, name) == -1)
+			{
+				fprintf(stderr, "Error allocating memory for a path name.\n");
+				returnCode = 1;
+			}
+			else
+			{
+				if (!listTree(&image, &options, pathname, &inode, 0))
+					returnCode = 1;
+				free(pathname);
+			}
+		}
+		else if (S_ISREG(inode.mode))
+		{
+			if (writeFileContent(&image, &inode, stdout))
+				addToolBytes(&stats, inode.size);
+			else
+				returnCode = 1;
+		}
+		else
+		{
+			fprintf(stderr, "'%s' isn't a regular file.\n", name);
+			returnCode = 1;
+		}
+
+		freeInode(&inode);
+	}
+
+	if (fflush(stdout) != 0)
+	{
+		fprintf(stderr, "Error %d writing to STDOUT.\n", errno);
+		returnCode = 1;
+	}
+
+	if (options.pseudo != NULL && options.pseudo != stdout && fclose(options.pseudo) != 0)
+	{
+		fprintf(stderr, "Error %d writing pseudo definitions file '%s'.\n", errno, pseudoName);
+		returnCode = 1;
+	}
+
+	addToolCounter(&stats, "metadata_blocks", image.metadataBlocks);
+	addToolCounter(&stats, "data_blocks", image.dataBlocks);
+	addToolCounter(&stats, "cache_hits", image.cacheHits);
+
+	closeImage(&image);
+	writeToolStatistics(&stats);
+
+	exit(returnCode);
+}
@@ -0,0 +1,429 @@
+// vi: set tabstop=4 syntax=c :
+/***********************************************************************
+ *                                                                     *
+ *                                                                     *
+ * Copyright (C) 2026 YourFritz contributors                           *
+ *                                                                     *
+ * This program is free software; you can redistribute it and/or       *
+ * modify it under the terms of the GNU General Public License         *
+ * as published by the Free Software Foundation; either version 2      *
+ * of the License, or (at your option) any later version.              *
+ *                                                                     *
+ * This program is distributed in the hope that it will be useful,     *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of      *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       *
+ * GNU General Public License for more details.                        *
+ *                                                                     *
+ * You should have received a copy of the GNU General Public License   *
+ * along with this program, please look for the file COPYING.          *
+ *                                                                     *
+ ***********************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <fcntl.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+//	Copy an image file to a (flash) filesystem and verify the written data:
+//
+//	- the source is read with a small buffer and each chunk is written to the
+//	  target, a CRC32 of the data is computed while passing by
+//	- after each chunk the target is synced and the pages of both files are
+//	  dropped from the page cache with posix_fadvise(), so a multi-MB image
+//	  doesn't push everything else out of the small memory of a FRITZ!Box
+//	- the target is read again afterwards - with O_DIRECT, if the filesystem
+//	  supports it, otherwise after its pages were dropped from the cache - and
+//	  the CRC32 and size of its content are compared with the source values
+//	- the free space on the target filesystem is checked first, the space used
+//	  by an existing target file is counted as available
+//
+//	The exit code is 0 only, if the verification was successful, so a caller
+//	may switch the system selector (linux_fs_start) depending on it.
+//
+//	Build it for the device, e.g. with 'mips-linux-gcc -Os -static -o verified_copy
+//	verified_copy.c' - it doesn't need any libraries.
+
+#define DEFAULT_BUFFER_SIZE		(64 * 1024)
+#define MINIMUM_BUFFER_SIZE		4096
+#define MAXIMUM_BUFFER_SIZE		(16 * 1024 * 1024)
+#define DIRECT_IO_ALIGNMENT		4096
+
+static uint32_t				crcTable[256];
+
+void usage(void)
+{
+	fprintf(stderr, "verified_copy - copy a file to flash memory and verify the written data\n\n");
+	fprintf(stderr, "(C) 2026 YourFritz contributors\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Licensed under GPLv2, see LICENSE file from source repository.\n\n");
+	fprintf(stderr, "Usage:\n\n");
+	fprintf(stderr, "verified_copy [ -b <buffer_size> ] [ -f ] [ -v ] <source> <target>\n");
+	fprintf(stderr, "\nThe source file is copied with a fixed buffer (64 KByte by default, -b");
+	fprintf(stderr, "\naccepts 4096 bytes to 16 MByte), each chunk is synced to the target and");
+	fprintf(stderr, "\ndropped from the page cache. The target is read again afterwards (with");
+	fprintf(stderr, "\nO_DIRECT, where it's supported) and its CRC32 is compared with the value");
+	fprintf(stderr, "\nfor the source data.\n");
+	fprintf(stderr, "\nThe free space on the target filesystem is checked first (the space used");
+	fprintf(stderr, "\nby an existing target file is added), -f skips this check.\n");
+	fprintf(stderr, "\nThe mode and the time stamps of the source are copied to the target, -v");
+	fprintf(stderr, "\nwrites the size and CRC32 of the verified file to STDOUT. The exit code");
+	fprintf(stderr, "\nis 0 only, if the copy was verified successfully.\n");
+}
+
+void initCrcTable(void)
+{
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t	value = i;
+
+		for (int j = 0; j < 8; j++)
+			value = (value & 1) ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+
+		crcTable[i] = value;
+	}
+}
+
+static uint32_t updateCrc(uint32_t crc, const uint8_t *data, size_t size)
+{
+	while (size--)
+		crc = crcTable[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+static bool writeAll(int fd, const uint8_t *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t	written = write(fd, data, size);
+
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+static ssize_t readFull(int fd, uint8_t *buffer, size_t size)
+{
+	size_t		got = 0;
+
+	while (got < size)
+	{
+		ssize_t	count = read(fd, buffer + got, size - got);
+
+		if (count == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (count == 0)
+			break;
+		got += count;
+	}
+
+	return got;
+}
+
+bool checkSpace(const char *sourceName, struct stat *source, const char *targetName)
+{
+	char *			directory = strdup(targetName);
+	char *			slash;
+	struct statvfs	fs;
+	struct stat		target;
+	uint64_t		available;
+
+	if (directory == NULL)
+	{
+		fprintf(stderr, "Error allocating memory.\n");
+		return false;
+	}
+
+	if ((slash = strrchr(directory, '/')) == NULL)
+		strcpy(directory, ".");
+	else if (slash == directory)
+		slash[1] = '\0';
+	else
+		*slash = '\0';
+
+	if (statvfs(directory, &fs) == -1)
+	{
+		fprintf(stderr, "Error %d reading the free space of the filesystem containing '%s'.\n", errno, directory);
+		free(directory);
+		return false;
+	}
+	free(directory);
+
+	available = (uint64_t) fs.f_bavail * fs.f_bsize;
+
+	// an existing target file will be replaced
+	if (stat(targetName, &target) == 0 && S_ISREG(target.st_mode))
+		available += (uint64_t) target.st_blocks * 512;
+
+	if (available <= (uint64_t) source->st_size)
+	{
+		fprintf(stderr, "There are only %" PRIu64 " bytes available for '%s', but '%s' needs %" PRIu64 " bytes.\n", available, targetName, sourceName, (uint64_t) source->st_size);
+		return false;
+	}
+
+	return true;
+}
+
+bool copyFile(int source, int target, const char *targetName, uint8_t *buffer, size_t bufferSize, uint32_t *crc, uint64_t *size)
+{
+	off_t		offset = 0;
+
+	*crc = 0xFFFFFFFF;
+	*size = 0;
+
+	while (true)
+	{
+		ssize_t	count = readFull(source, buffer, bufferSize);
+
+		if (count == -1)
+		{
+			fprintf(stderr, "Error %d reading the source file.\n", errno);
+			return false;
+		}
+		if (count == 0)
+			break;
+
+		*crc = updateCrc(*crc, buffer, count);
+
+		if (!writeAll(target, buffer, count))
+		{
+			fprintf(stderr, "Error %d writing to '%s'.\n", errno, targetName);
+			return false;
+		}
+
+		// written pages can't be dropped, before they're clean
+		if (fdatasync(target) == -1 && errno != EINVAL && errno != EROFS)
+		{
+			fprintf(stderr, "Error %d syncing '%s'.\n", errno, targetName);
+			return false;
+		}
+
+		posix_fadvise(source, offset, count, POSIX_FADV_DONTNEED);
+		posix_fadvise(target, offset, count, POSIX_FADV_DONTNEED);
+
+		offset += count;
+		*size += count;
+
+		if ((size_t) count < bufferSize)
+			break;
+	}
+
+	*crc = ~*crc;
+	return true;
+}
+
+//	The target is opened again with O_DIRECT, some filesystems (e.g. yaffs2
+//	on older kernels) don't support it - the pages are dropped from the cache
+//	then (the file was synced already), so they're read from the device again.
+
+bool verifyFile(const char *targetName, uint8_t *buffer, size_t bufferSize, uint32_t *crc, uint64_t *size, bool *direct)
+{
+	int			fd = open(targetName, O_RDONLY | O_DIRECT);
+
+	*direct = (fd != -1);
+	if (fd == -1 && (errno != EINVAL || (fd = open(targetName, O_RDONLY)) == -1))
+	{
+		fprintf(stderr, "Error %d opening '%s' for verification.\n", errno, targetName);
+		return false;
+	}
+
+	if (!*direct)
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+
+	*crc = 0xFFFFFFFF;
+	*size = 0;
+
+	while (true)
+	{
+		ssize_t	count = readFull(fd, buffer, bufferSize);
+
+		// a filesystem may accept O_DIRECT while opening the file, but not while reading it
+		if (count == -1 && errno == EINVAL && *direct && *size == 0)
+		{
+			close(fd);
+			if ((fd = open(targetName, O_RDONLY)) == -1)
+			{
+				fprintf(stderr, "Error %d opening '%s' for verification.\n", errno, targetName);
+				return false;
+			}
+			posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			*direct = false;
+			continue;
+		}
+
+		if (count == -1)
+		{
+			fprintf(stderr, "Error %d reading '%s' for verification.\n", errno, targetName);
+			close(fd);
+			return false;
+		}
+		if (count == 0)
+			break;
+
+		*crc = updateCrc(*crc, buffer, count);
+		if (!*direct)
+			posix_fadvise(fd, *size, count, POSIX_FADV_DONTNEED);
+		*size += count;
+
+		if ((size_t) count < bufferSize)
+			break;
+	}
+
+	close(fd);
+	*crc = ~*crc;
+
+	return true;
+}
+
+int main(int argc, char * argv[])
+{
+	size_t				bufferSize = DEFAULT_BUFFER_SIZE;
+	bool				checkFreeSpace = true;
+	bool				verbose = false;
+	const char *		sourceName;
+	const char *		targetName;
+	struct stat			st;
+	int					source;
+	int					target;
+	void *				buffer;
+	uint32_t			writtenCrc;
+	uint64_t			writtenSize;
+	uint32_t			readCrc;
+	uint64_t			readSize;
+	bool				direct;
+	struct timespec		times[2];
+	int					i = 1;
+
+	/* no reason to use a getopt implementation for our simple calling convention */
+	while (i < argc && argv[i][0] == '-' && argv[i][1] != '\0')
+	{
+		if (strcmp(argv[i], "-f") == 0)
+			checkFreeSpace = false;
+		else if (strcmp(argv[i], "-v") == 0)
+			verbose = true;
+		else if (strcmp(argv[i], "-b") == 0)
+		{
+			char *	endOfNumber;
+
+			if (i + 1 >= argc || *argv[i + 1] == '\0')
+			{
+				fprintf(stderr, "Missing value after option '%s'.\n", argv[i]);
+				exit(2);
+			}
+
+			bufferSize = strtoul(argv[++i], &endOfNumber, 0);
+			if (*endOfNumber != '\0' || bufferSize < MINIMUM_BUFFER_SIZE || bufferSize > MAXIMUM_BUFFER_SIZE)
+			{
+				fprintf(stderr, "Invalid buffer size '%s'.\n", argv[i]);
+				exit(2);
+			}
+
+			// O_DIRECT needs a multiple of the block size
+			bufferSize &= ~((size_t) DIRECT_IO_ALIGNMENT - 1);
+		}
+		else
+		{
+			usage();
+			exit(2);
+		}
+		i++;
+	}
+
+	if (argc - i != 2)
+	{
+		usage();
+		exit(2);
+	}
+
+	sourceName = argv[i];
+	targetName = argv[i + 1];
+
+	if ((source = open(sourceName, O_RDONLY)) == -1 || fstat(source, &st) == -1)
+	{
+		fprintf(stderr, "Error %d opening source file '%s'.\n", errno, sourceName);
+		exit(1);
+	}
+
+	if (!S_ISREG(st.st_mode))
+	{
+		fprintf(stderr, "The source '%s' isn't a regular file.\n", sourceName);
+		exit(1);
+	}
+
+	if (checkFreeSpace && !checkSpace(sourceName, &st, targetName))
+		exit(1);
+
+	if (posix_memalign(&buffer, DIRECT_IO_ALIGNMENT, bufferSize) != 0)
+	{
+		fprintf(stderr, "Error allocating a buffer of %zu bytes.\n", bufferSize);
+		exit(1);
+	}
+
+	initCrcTable();
+	posix_fadvise(source, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	if ((target = open(targetName, O_WRONLY | O_CREAT | O_TRUNC, st.st_mode & 07777)) == -1)
+	{
+		fprintf(stderr, "Error %d creating target file '%s'.\n", errno, targetName);
+		exit(1);
+	}
+
+	if (!copyFile(source, target, targetName, buffer, bufferSize, &writtenCrc, &writtenSize))
+	{
+		close(target);
+		exit(1);
+	}
+	close(source);
+
+	// like 'cp -a' does it, the owner may only be set by the superuser
+	fchmod(target, st.st_mode & 07777);
+	if (fchown(target, st.st_uid, st.st_gid) == -1 && errno != EPERM)
+		fprintf(stderr, "Error %d setting the owner of '%s'.\n", errno, targetName);
+	times[0] = st.st_atim;
+	times[1] = st.st_mtim;
+	futimens(target, times);
+
+	if (fsync(target) == -1 || close(target) == -1)
+	{
+		fprintf(stderr, "Error %d closing target file '%s'.\n", errno, targetName);
+		exit(1);
+	}
+
+	if (!verifyFile(targetName, buffer, bufferSize, &readCrc, &readSize, &direct))
+		exit(1);
+	free(buffer);
+
+	if (readSize != writtenSize || readCrc != writtenCrc || writtenSize != (uint64_t) st.st_size)
+	{
+		fprintf(stderr, "Verification of '%s' failed, %" PRIu64 " bytes with CRC32 %08X were written, but %" PRIu64 " bytes with CRC32 %08X were read%s.\n",
+				targetName, writtenSize, writtenCrc, readSize, readCrc, (direct ? " (O_DIRECT)" : ""));
+		exit(1);
+	}
+
+	if (verbose)
+		printf("%" PRIu64 " %08X\n", readSize, readCrc);
+
+	exit(0);
+}